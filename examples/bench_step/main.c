@@ -0,0 +1,145 @@
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_STEPS          100000
+#define DEFAULT_CURRENT_BUDGET 32
+#define DEFAULT_ODE_BUDGET     8
+
+// Latency of every step of a run, in nanoseconds
+typedef struct bench_run {
+  const char *name;
+  double     *latency;
+  size_t      steps;
+  size_t      degraded;
+  uint64_t    max_evaluations;
+} bench_run_t;
+
+static double now_ns(void) {
+  struct timespec t;
+#if defined(CLOCK_MONOTONIC) && !defined(_WIN32)
+  clock_gettime(CLOCK_MONOTONIC, &t);
+#else
+  timespec_get(&t, TIME_UTC);
+#endif
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double *sorted, size_t n, double p) {
+  size_t rank = (size_t)ceil(p / 100.0 * (double)n);
+  return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+// Charge and discharge around zero mean power with periodic spikes, so long
+// runs stay within the usable state of charge
+static double profile(size_t i) {
+  double spike = (i % 97 == 0) ? ((i % 194 == 0) ? 8.0 : -8.0) : 0.0;
+  return 6.0 * sin((double)i / 50.0) + spike;
+}
+
+static lion_status_t bench(lion_sim_config_t *conf, lion_params_t *params, bench_run_t *run) {
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(conf, params, &sim), "Failed creating simulation");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing simulation");
+
+  // Warm up caches and the stepper before measuring
+  for (size_t i = 0; i < 100; i++) {
+    LION_CALL(lion_sim_step(&sim, profile(i), 298.0), "Failed warming up simulation");
+  }
+  LION_CALL(lion_sim_reset(&sim), "Failed resetting simulation");
+
+  for (size_t i = 0; i < run->steps; i++) {
+    double        start  = now_ns();
+    lion_status_t status = lion_sim_step(&sim, profile(i), 298.0);
+    double        end    = now_ns();
+    LION_VCALL(status, "Failed at step %zu", i);
+    run->latency[i] = end - start;
+    if (sim.state.step_flags & (LION_STEP_CURRENT_ANALYTIC | LION_STEP_CURRENT_HOLD | LION_STEP_ODE_FALLBACK)) {
+      run->degraded++;
+    }
+    if (sim.state.step_evaluations > run->max_evaluations) {
+      run->max_evaluations = sim.state.step_evaluations;
+    }
+  }
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up simulation");
+
+  qsort(run->latency, run->steps, sizeof(double), &compare_double);
+  return LION_STATUS_SUCCESS;
+}
+
+static void report(const bench_run_t *run) {
+  printf(
+      "%-10s p50 = %9.0f ns  p99 = %9.0f ns  p99.9 = %9.0f ns  max = %9.0f ns  max evaluations = %4" PRIu64 "  degraded steps = %zu\n",
+      run->name,
+      percentile(run->latency, run->steps, 50.0),
+      percentile(run->latency, run->steps, 99.0),
+      percentile(run->latency, run->steps, 99.9),
+      run->latency[run->steps - 1],
+      run->max_evaluations,
+      run->degraded
+  );
+}
+
+int main(int argc, char *argv[]) {
+  // Usage: ex.bench_step [steps] [current budget] [ode budget]
+  size_t   steps          = (argc > 1) ? strtoull(argv[1], NULL, 10) : DEFAULT_STEPS;
+  uint64_t current_budget = (argc > 2) ? strtoull(argv[2], NULL, 10) : DEFAULT_CURRENT_BUDGET;
+  uint64_t ode_budget     = (argc > 3) ? strtoull(argv[3], NULL, 10) : DEFAULT_ODE_BUDGET;
+  if (steps == 0) {
+    log_error("Number of steps must be positive");
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_sim_config_t conf = lion_sim_config_default();
+  conf.log_stdlvl        = LOG_WARN;
+  conf.log_filelvl       = LOG_WARN;
+  conf.sim_step_seconds  = 1.0;
+  conf.sim_min_maxiter   = 10000;
+
+  lion_params_t params = lion_params_default();
+  params.init.soc      = 0.9;
+
+  bench_run_t unbounded = {.name = "unbounded", .steps = steps};
+  bench_run_t bounded   = {.name = "bounded", .steps = steps};
+  bench_run_t native    = {.name = "native", .steps = steps};
+  unbounded.latency     = malloc(steps * sizeof(double));
+  bounded.latency       = malloc(steps * sizeof(double));
+  native.latency        = malloc(steps * sizeof(double));
+  if (unbounded.latency == NULL || bounded.latency == NULL || native.latency == NULL) {
+    log_error("Failed allocating latency samples");
+    return LION_STATUS_FAILURE;
+  }
+
+  LION_CALL(bench(&conf, &params, &unbounded), "Failed running unbounded benchmark");
+  conf.sim_current_budget = current_budget;
+  conf.sim_ode_budget     = ode_budget;
+  LION_CALL(bench(&conf, &params, &bounded), "Failed running bounded benchmark");
+  // Same order as the default stepper, without the GSL driver
+  conf.sim_current_budget = 0;
+  conf.sim_ode_budget     = 0;
+  conf.sim_stepper        = LION_STEPPER_NATIVE_RK45;
+  LION_CALL(bench(&conf, &params, &native), "Failed running native benchmark");
+
+  printf("Step latency over %zu steps (current budget = %" PRIu64 ", ode budget = %" PRIu64 ")\n", steps, current_budget, ode_budget);
+  report(&unbounded);
+  report(&bounded);
+  report(&native);
+
+  free(unbounded.latency);
+  free(bounded.latency);
+  free(native.latency);
+  return LION_STATUS_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/// @file
+/// @brief Identification of the parameters of a cell from measured data.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+#include "vector.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// Description of a parameter estimation problem.
+typedef struct lion_estimate {
+  const char *const *names;              ///< Names of the estimated parameters, as accepted by `lion_params_field`.
+  size_t             n_params;           ///< Number of estimated parameters.
+  double             voltage_weight;     ///< Weight of the voltage residuals.
+  double             temperature_weight; ///< Weight of the surface temperature residuals.
+  size_t             max_iter;           ///< Maximum number of Levenberg-Marquardt iterations.
+  double             xtol;               ///< Tolerance on the step size.
+  double             gtol;               ///< Tolerance on the gradient.
+  double             ftol;               ///< Tolerance on the change of the cost.
+} lion_estimate_t;
+
+/// Summary of a parameter estimation.
+typedef struct lion_estimate_result {
+  double initial_cost; ///< Cost at the initial parameters.
+  double final_cost;   ///< Cost at the estimated parameters.
+  size_t iterations;   ///< Number of iterations of the solver.
+  size_t simulations;  ///< Number of simulations run, including the ones with sensitivities.
+  int    info;         ///< Reason for convergence as reported by GSL, 0 when it did not converge.
+} lion_estimate_result_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// Get the default estimation settings, without any parameter selected.
+lion_estimate_t lion_estimate_default(void);
+
+/// @brief Estimate parameters of a cell from measured data.
+///
+/// Minimizes the weighted sum of squared errors between the simulated and measured terminal
+/// voltage and surface temperature using GSL's Levenberg-Marquardt solver. The Jacobian of the
+/// residuals is built from forward sensitivities of the state with respect to the parameters,
+/// which are integrated next to the state dynamics, so each iteration needs a single simulation
+/// instead of one per parameter.
+///
+/// Measurements are compared with the simulation following the indexing of `lion_sim_run`, so
+/// the first sample of every vector is skipped. NaN measurements are ignored, and
+/// `temperature` may be NULL to fit the voltage only.
+///
+/// The simulation runs on a fork of `sim` starting from the initial conditions of the
+/// parameters, and the estimated values are written to the parameters of `sim` at the end.
+/// Hooks of `sim` are not called. Every simulation reseeds the random number generator of the
+/// fork, so models with noise see the same draws for every guess of the parameters.
+/// @param[in,out] sim                  Initialized simulation holding the initial guess.
+/// @param[in]     est                  Description of the estimation problem.
+/// @param[in]     power                Power extracted from the cell at each time step.
+/// @param[in]     ambient_temperature  Ambient temperature around the cell at each time step.
+/// @param[in]     voltage              Measured terminal voltage at each time step.
+/// @param[in]     temperature          Measured surface temperature at each time step, or NULL.
+/// @param[out]    out                  Summary of the estimation, or NULL.
+lion_status_t lion_estimate_run(
+    lion_sim_t             *sim,
+    const lion_estimate_t  *est,
+    lion_vector_t          *power,
+    lion_vector_t          *ambient_temperature,
+    lion_vector_t          *voltage,
+    lion_vector_t          *temperature,
+    lion_estimate_result_t *out
+);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+/// @file
+/// @brief Events on the state of a simulation, and early termination.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Maximum iterations used to locate the time of a crossing inside a step.
+#define LION_EVENT_MAXITER 50
+
+/// @addtogroup types
+/// @{
+
+/// Condition that fires an event.
+typedef enum lion_event_kind {
+  LION_EVENT_ABOVE    = 0, ///< The field goes above the threshold, or starts above it.
+  LION_EVENT_BELOW    = 1, ///< The field goes below the threshold, or starts below it.
+  LION_EVENT_CROSSING = 2, ///< The field crosses the threshold in either direction.
+} lion_event_kind_t;
+
+/// What the simulation does when an event fires.
+typedef enum lion_event_action {
+  LION_EVENT_STOP    = 0, ///< Stop the simulation at the event.
+  LION_EVENT_TRIGGER = 1, ///< Record the event and keep going.
+} lion_event_action_t;
+
+/// Reason why `lion_sim_should_close` asks to close the simulation.
+typedef enum lion_close_reason {
+  LION_CLOSE_NONE      = 0, ///< The simulation can keep going.
+  LION_CLOSE_EVENT     = 1, ///< A stop event fired.
+  LION_CLOSE_CANCELLED = 2, ///< `lion_sim_cancel` was called.
+} lion_close_reason_t;
+
+/// Configuration of an event.
+typedef struct lion_event_config {
+  const char         *field;                            ///< Field of the state, as accepted by `lion_sim_state_field`.
+  lion_event_kind_t   kind;                             ///< Condition that fires the event.
+  double              threshold;                          ///< Threshold of the condition.
+  lion_event_action_t action;                             ///< What to do when the event fires.
+  lion_status_t (*hook)(lion_sim_t *sim, size_t event); ///< Hook called when the event fires, can be NULL.
+} lion_event_config_t;
+
+/// Event watched by a simulation.
+typedef struct lion_event {
+  lion_event_kind_t   kind;                             ///< Condition that fires the event.
+  size_t              offset;                             ///< Offset of the field inside `lion_sim_state_t`.
+  double              threshold;                          ///< Threshold of the condition.
+  lion_event_action_t action;                             ///< What to do when the event fires.
+  lion_status_t (*hook)(lion_sim_t *sim, size_t event); ///< Hook called when the event fires.
+
+  uint64_t count;      ///< Number of times the event fired.
+  double   first_time; ///< Time at which the event fired first, NaN if it never did.
+  double   last_time;  ///< Time at which the event fired last, NaN if it never did.
+  int      fired;      ///< Whether the event fired in the last step.
+} lion_event_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Add an event to a simulation.
+///
+/// Events are checked by `lion_sim_step` once the outputs of the step are known. When the field
+/// was on the other side of the threshold at the previous step, the time of the crossing is
+/// located inside the previous step by integrating it again over a fraction of its length, with
+/// the inputs of that step, until the field meets the threshold. Crossings caused by a jump of
+/// the inputs fire at the start of the step.
+///
+/// When a stop event fires the step ends at the earliest event, before being integrated: the
+/// state is moved back to the crossing when one was located, the update hook is called and
+/// `lion_sim_should_close` returns `LION_CLOSE_EVENT` until the simulation is reset, which makes
+/// `lion_sim_run` finish early. Events are cleared on init and reset, and forks start with a copy of them.
+/// @param[in,out] sim   Simulation to watch.
+/// @param[in]     conf  Configuration of the event.
+/// @param[out]    out   Index of the new event, can be NULL.
+lion_status_t lion_sim_events_add(lion_sim_t *sim, const lion_event_config_t *conf, size_t *out);
+
+/// @brief Get an event of a simulation.
+///
+/// @returns The event at `index`, or NULL if there is none.
+const lion_event_t *lion_sim_event(const lion_sim_t *sim, size_t index);
+
+/// Clear the occurrences of every event and the close request of a simulation.
+void lion_sim_events_reset(lion_sim_t *sim);
+
+/// @brief Remove an event of a simulation.
+///
+/// The events after it move down by one index.
+/// @param[in,out] sim    Simulation to stop watching.
+/// @param[in]     index  Index of the event.
+lion_status_t lion_sim_events_remove(lion_sim_t *sim, size_t index);
+
+/// Remove every event of a simulation.
+lion_status_t lion_sim_events_cleanup(lion_sim_t *sim);
+
+/// @brief Ask a simulation to stop.
+///
+/// Can be called from any thread while the simulation runs in another one. The running loop
+/// finishes the step in progress and returns, and `lion_sim_should_close` returns
+/// `LION_CLOSE_CANCELLED` until the simulation is reset.
+void lion_sim_cancel(lion_sim_t *sim);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
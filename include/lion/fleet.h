@@ -0,0 +1,107 @@
+/// @file
+/// @brief Batches of independent cells stepped together in single or double precision.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+#include "vector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// Precision of the state and arithmetic of a fleet.
+typedef enum lion_fleet_precision {
+  LION_FLEET_F64 = 0, ///< States and kernels in double precision.
+  LION_FLEET_F32 = 1, ///< States and kernels in single precision.
+} lion_fleet_precision_t;
+
+/// @brief Batch of independent cells sharing the parameters of a simulation.
+///
+/// Every cell has its own state and power input, and the state of every cell is stored as one
+/// vector per variable, with doubles or floats depending on the precision of the fleet.
+typedef struct lion_fleet {
+  lion_sim_t            *sim;       ///< Simulation providing the parameters and the initial state.
+  size_t                 n_cells;   ///< Number of cells.
+  lion_fleet_precision_t precision; ///< Precision of the states and kernels.
+
+  lion_vector_t soc;         ///< Nominal state of charge of each cell.
+  lion_vector_t temperature; ///< Internal temperature of each cell.
+  lion_vector_t current;     ///< Current of each cell in the last step.
+
+  double   time; ///< Time since the last reset.
+  uint64_t step; ///< Steps since the last reset.
+
+  void *_scratch; ///< Intermediate results of a step.
+} lion_fleet_t;
+
+/// Drift of a fleet with respect to stepping each cell with `lion_sim_step`.
+typedef struct lion_fleet_drift {
+  double soc_max;         ///< Maximum absolute drift of the state of charge.
+  double soc_rms;         ///< Root mean square drift of the state of charge.
+  double temperature_max; ///< Maximum absolute drift of the internal temperature.
+  double temperature_rms; ///< Root mean square drift of the internal temperature.
+  size_t worst_cell;      ///< Cell with the largest drift of the state of charge.
+} lion_fleet_drift_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Create a fleet.
+///
+/// Every cell starts from the state the next call to `lion_sim_step` on `sim` would start from.
+/// Each step follows the same stripped down model as `lion_rollout`, with the temperature
+/// integrated exactly and degradation frozen, so in `LION_FLEET_F64` a fleet tracks
+/// `lion_sim_step` closely. `LION_FLEET_F32` halves the memory traffic and doubles the width
+/// of the vector kernels, at the cost of a drift that `lion_fleet_validate` measures.
+/// @param[in]  sim        Initialized simulation providing the parameters and the initial state.
+/// @param[in]  n_cells    Number of cells.
+/// @param[in]  precision  Precision of the states and kernels.
+/// @param[out] out        Created fleet.
+lion_status_t lion_fleet_new(lion_sim_t *sim, size_t n_cells, lion_fleet_precision_t precision, lion_fleet_t *out);
+
+/// Restart every cell from the current state of the simulation of the fleet.
+lion_status_t lion_fleet_reset(lion_fleet_t *fleet);
+
+/// @brief Step every cell of the fleet.
+///
+/// @param[in,out] fleet                Fleet to step.
+/// @param[in]     power                Power drawn from each cell, doubles or floats matching the
+///                                     precision of the fleet.
+/// @param[in]     ambient_temperature  Ambient temperature around every cell.
+lion_status_t lion_fleet_step(lion_fleet_t *fleet, const lion_vector_t *power, double ambient_temperature);
+
+/// @brief Measure the drift of a fleet against `lion_sim_step`.
+///
+/// Each cell is stepped through its power profile both by the fleet and by a fork of the
+/// simulation of the fleet, comparing their states after every step. The fleet is reset first
+/// and is left at the end of the profile, while the simulation is not modified.
+/// @param[in,out] fleet                Fleet to validate.
+/// @param[in]     power                Power drawn from each cell at each step, `n_cells` values per step.
+/// @param[in]     n_steps              Number of steps.
+/// @param[in]     ambient_temperature  Ambient temperature around every cell.
+/// @param[out]    out                  Drift of the fleet.
+lion_status_t lion_fleet_validate(lion_fleet_t *fleet, const double *power, size_t n_steps, double ambient_temperature, lion_fleet_drift_t *out);
+
+/// Nominal state of charge of a cell of the fleet.
+double lion_fleet_soc(const lion_fleet_t *fleet, size_t cell);
+
+/// Internal temperature of a cell of the fleet.
+double lion_fleet_temperature(const lion_fleet_t *fleet, size_t cell);
+
+/// Free the resources of a fleet.
+lion_status_t lion_fleet_cleanup(lion_fleet_t *fleet);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
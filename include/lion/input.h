@@ -0,0 +1,93 @@
+/// @file
+/// @brief Input channels sampled at their own rate and interpolated while stepping.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+#include "vector.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// Interpolation between the samples of a channel.
+typedef enum lion_interp {
+  LION_INTERP_ZOH    = 0, ///< Zero-order hold, each sample holds until the next one.
+  LION_INTERP_LINEAR = 1, ///< Linear interpolation between neighbouring samples.
+  LION_INTERP_CUBIC  = 2, ///< Cubic Hermite interpolation, with Catmull-Rom tangents.
+} lion_interp_t;
+
+/// @brief Input channel over a sampled signal.
+///
+/// A channel reads its samples in place, either taken every `period` seconds from `start` or at
+/// the times in `times`. Lookups keep a cursor on the last sample used, so sweeping the channel
+/// forward in time costs O(1) amortized per lookup. Before the first sample and after the last
+/// one the channel holds the value of the closest sample.
+typedef struct lion_input_channel {
+  const double *values; ///< Samples of the signal.
+  const double *times;  ///< Increasing time of every sample, NULL for a fixed rate.
+  size_t        n;      ///< Number of samples.
+  double        start;  ///< Time of the first sample.
+  double        period; ///< Time between samples at a fixed rate.
+  lion_interp_t interp; ///< Interpolation between samples.
+  size_t        cursor; ///< Sample at or right before the last lookup.
+} lion_input_channel_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Create a channel over samples taken at a fixed rate.
+///
+/// @param[in]  sim     Simulation context, can be NULL.
+/// @param[in]  values  Vector of doubles with the samples, must outlive the channel.
+/// @param[in]  start   Time of the first sample.
+/// @param[in]  period  Time between samples, must be positive.
+/// @param[in]  interp  Interpolation between samples.
+/// @param[out] out     Pointer to where the channel will be created.
+lion_status_t lion_input_channel_new(lion_sim_t *sim, const lion_vector_t *values, double start, double period, lion_interp_t interp, lion_input_channel_t *out);
+
+/// @brief Create a channel over timestamped samples.
+///
+/// @param[in]  sim     Simulation context, can be NULL.
+/// @param[in]  values  Vector of doubles with the samples, must outlive the channel.
+/// @param[in]  times   Vector of doubles with the strictly increasing time of every sample, must outlive the channel.
+/// @param[in]  interp  Interpolation between samples.
+/// @param[out] out     Pointer to where the channel will be created.
+lion_status_t lion_input_channel_new_timed(
+    lion_sim_t *sim, const lion_vector_t *values, const lion_vector_t *times, lion_interp_t interp, lion_input_channel_t *out
+);
+
+/// @brief Value of a channel at some time.
+///
+/// Moves the cursor of the channel to the sample at or right before `time`.
+double lion_input_channel_at(lion_input_channel_t *channel, double time);
+
+/// Time of the last sample of a channel.
+double lion_input_channel_end(const lion_input_channel_t *channel);
+
+/// Move the cursor of a channel back to its first sample.
+void lion_input_channel_rewind(lion_input_channel_t *channel);
+
+/// @brief Runs the simulation over input channels.
+///
+/// Like `lion_sim_run`, but each step takes its inputs from the channels at the time the step
+/// ends, which matches the samples `lion_sim_run` uses when the channels are aligned with the
+/// simulation step. The simulation runs until either channel runs out of samples, and the
+/// upsampled inputs are never stored.
+/// @param[in]  sim                  Simulation to run.
+/// @param[in]  power                Power extracted from the cell.
+/// @param[in]  ambient_temperature  Ambient temperature around the cell.
+lion_status_t lion_sim_run_inputs(lion_sim_t *sim, lion_input_channel_t *power, lion_input_channel_t *ambient_temperature);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,8 +2,21 @@
 /// @brief Header with every definition.
 #pragma once
 
+#include "estimate.h"
+#include "events.h"
+#include "fleet.h"
+#include "input.h"
 #include "names.h"
+#include "pack.h"
+#include "parareal.h"
 #include "params.h"
+#include "profile.h"
+#include "protocol.h"
+#include "realtime.h"
+#include "rollout.h"
 #include "sim.h"
+#include "stats.h"
 #include "status.h"
+#include "sweep.h"
+#include "thermal.h"
 #include "vector.h"
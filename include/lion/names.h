@@ -3,6 +3,7 @@
 #pragma once
 
 #include "sim.h"
+#include "sweep.h"
 
 /// @addtogroup functions
 /// @{
@@ -22,10 +23,19 @@ const char *lion_gsl_errno_name(const int num);
 /// Get the name of a jacobian calculation method.
 const char *lion_jacobian_name(lion_jacobian_method_t jacobian);
 
+/// Get the name of an input hold.
+const char *lion_input_hold_name(lion_input_hold_t hold);
+
+/// Get the name of the intervals jumped by `lion_sim_run`.
+const char *lion_jump_name(lion_jump_t jump);
+
 /// Get the name of the internal resistance model.
 const char *lion_params_rint_get_name(lion_rint_model_t model);
 
 /// Get the name of the degradation model.
 const char *lion_params_soh_get_name(lion_soh_model_t model);
 
+/// Get the name of a sweep metric.
+const char *lion_sweep_metric_name(lion_sweep_metric_t metric);
+
 /// @}
@@ -0,0 +1,117 @@
+/// @file
+/// @brief Simulation of battery packs built from many cells.
+#pragma once
+
+#include "params.h"
+#include "sim.h"
+#include "status.h"
+#include "thermal.h"
+#include "vector.h"
+
+#include <gsl/gsl_odeiv2.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// Cell-to-cell variation of a parameter.
+typedef struct lion_pack_variation {
+  const char *name;   ///< Name of the parameter, as accepted by `lion_params_field`.
+  double      spread; ///< Relative standard deviation of the parameter between cells.
+} lion_pack_variation_t;
+
+/// Layout of a pack.
+///
+/// The pack is made of `n_parallel` strings connected in parallel, each of them with `n_series`
+/// cells connected in series, so a 96s4p pack has `n_series = 96` and `n_parallel = 4`.
+typedef struct lion_pack_config {
+  size_t                       n_series;    ///< Number of cells in series in each string.
+  size_t                       n_parallel;  ///< Number of strings in parallel.
+  const lion_pack_variation_t *variation;   ///< Variation of the parameters between cells.
+  size_t                       n_variation; ///< Number of varying parameters.
+  const lion_thermal_config_t *thermal;     ///< Thermal network, required by the `LION_ONLYAIR` and `LION_BOTH` regimes.
+} lion_pack_config_t;
+
+/// @brief Inputs to the solver of a pack.
+///
+/// Same as `lion_slv_inputs_t`, for a block of consecutive cells of a pack. The pack integrates
+/// every cell on its own, so its blocks hold a single cell.
+typedef struct lion_slv_pack_inputs {
+  size_t            n_cells; ///< Number of cells.
+  lion_sim_state_t *cells;   ///< State of each cell.
+  lion_params_t    *params;  ///< Parameters of each cell.
+} lion_slv_pack_inputs_t;
+
+/// Pack of cells sharing a simulation setup.
+typedef struct lion_pack {
+  lion_sim_t *sim;        ///< Simulation providing the configuration, logging and random numbers.
+  size_t      n_series;   ///< Number of cells in series in each string.
+  size_t      n_parallel; ///< Number of strings in parallel.
+  size_t      n_cells;    ///< Total number of cells.
+
+  lion_params_t    *params;         ///< Parameters of each cell, string by string.
+  lion_sim_state_t *cells;          ///< State of each cell, string by string.
+  double           *string_current; ///< Current flowing through each string.
+  double           *_newton;        ///< Scratch space for the current sharing solve.
+
+  double   time;    ///< Simulation time.
+  uint64_t step;    ///< Simulation step index.
+  double   power;   ///< Power drawn from the pack.
+  double   voltage; ///< Voltage in the terminals of the pack.
+  double   current; ///< Current drawn from the pack.
+
+  lion_thermal_t thermal; ///< Thermal network, only used outside of the `LION_ONLYSF` regime.
+
+  // GSL objects, one per cell since the cells only interact through the
+  // current sharing, which is frozen during the step
+  lion_slv_pack_inputs_t *inputs;  ///< Inputs to the solver of each cell.
+  gsl_odeiv2_system      *sys;     ///< System of each cell.
+  gsl_odeiv2_driver     **drivers; ///< Driver of each cell.
+  double                 *y;       ///< States of every cell, as seen by the drivers.
+} lion_pack_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Create a pack.
+///
+/// Every cell starts from the parameters of `sim`, and each varying parameter is drawn for each
+/// cell from a normal distribution around its nominal value using the generator of `sim`.
+/// @param[in]  sim   Initialized simulation providing the configuration and the nominal parameters.
+/// @param[in]  conf  Layout of the pack.
+/// @param[out] out   Created pack.
+lion_status_t lion_pack_new(lion_sim_t *sim, const lion_pack_config_t *conf, lion_pack_t *out);
+
+/// Restart every cell from the initial conditions of its parameters.
+lion_status_t lion_pack_reset(lion_pack_t *pack);
+
+/// @brief Step the pack.
+///
+/// The power is shared between strings by solving the current of each string and the terminal
+/// voltage of the pack with a single Newton system. Each cell is then integrated over the step by
+/// its own driver, one after the other. The current sharing is frozen during the step, so the
+/// cells are independent and a stacked system of the whole pack would only add a dense Jacobian
+/// of `2 * n_cells` states for the implicit steppers to factor, where each cell needs a 2x2 block.
+/// @param[in,out] pack                 Pack to step.
+/// @param[in]     power                Power drawn from the pack.
+/// @param[in]     ambient_temperature  Ambient temperature around the pack.
+lion_status_t lion_pack_step(lion_pack_t *pack, double power, double ambient_temperature);
+
+/// Run the pack over a power and ambient temperature profile.
+lion_status_t lion_pack_run(lion_pack_t *pack, lion_vector_t *power, lion_vector_t *ambient_temperature);
+
+/// Free the resources of a pack.
+lion_status_t lion_pack_cleanup(lion_pack_t *pack);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,6 +12,7 @@
 #define LION_FUZZY_SETS_DEGREE  4
 #define LION_SOH_TABLE_COUNT    11
 #define LION_SOH_TEMP_POLYCOUNT 7
+#define LION_RC_MAX_BRANCHES    3
 
 #ifdef __cplusplus
 extern "C" {
@@ -140,6 +141,31 @@ typedef struct lion_params_soh {
   } params; ///< Model parameters.
 } lion_params_soh_t;
 
+/// @brief Polarization model made of RC branches in series with the internal resistance.
+///
+/// Each branch adds its voltage as a state of the system, so a second order (2RC) model uses
+/// `n_branches = 2`. The default has no branches, which keeps the original two state model. The
+/// number of branches sets the dimension of the system, so it must be chosen before
+/// `lion_sim_init`.
+typedef struct lion_params_rc {
+  uint32_t n_branches;                        ///< Number of RC branches, at most `LION_RC_MAX_BRANCHES`.
+  double   resistance[LION_RC_MAX_BRANCHES];  ///< Resistance of each branch.
+  double   capacitance[LION_RC_MAX_BRANCHES]; ///< Capacitance of each branch.
+} lion_params_rc_t;
+
+/// @brief Calendar aging, which degrades the cell over time whether it is used or not.
+///
+/// The state of health decays as d(soh)/dt = -k soh, with
+/// k = rate * exp(Ea / R * (1 / Tref - 1 / T)) * exp(soc_sensitivity * (soc - reference_soc)),
+/// on top of the cycle aging of the degradation model. The default rate of 0 disables it.
+typedef struct lion_params_calendar {
+  double rate;                  ///< Fraction of the state of health lost per second at the reference conditions.
+  double activation_energy;     ///< Activation energy of the temperature dependence, in J/mol.
+  double reference_temperature; ///< Temperature at which `rate` is given.
+  double soc_sensitivity;       ///< Exponential sensitivity of the rate on the nominal state of charge.
+  double reference_soc;         ///< State of charge at which `rate` is given.
+} lion_params_calendar_t;
+
 /// @brief Parameters of the system.
 typedef struct lion_params {
   lion_params_init_t init; ///< Initial conditions.
@@ -149,6 +175,9 @@ typedef struct lion_params {
   lion_params_temp_t temp; ///< Temperature model.
   lion_params_rint_t rint; ///< Internal resistance model.
   lion_params_soh_t  soh;  ///< Degradation model.
+  lion_params_rc_t   rc;   ///< Polarization model.
+
+  lion_params_calendar_t calendar; ///< Calendar aging.
 } lion_params_t;
 
 /// @}
@@ -189,9 +218,24 @@ lion_params_soh_masserano_t lion_params_default_soh_masserano(void);
 /// Get default degradation model parameters.
 lion_params_soh_t lion_params_default_soh(void);
 
+/// Get default polarization model parameters.
+lion_params_rc_t lion_params_default_rc(void);
+
+/// Get default calendar aging parameters.
+lion_params_calendar_t lion_params_default_calendar(void);
+
 /// Get default system parameters.
 lion_params_t lion_params_default(void);
 
+/// @brief Get a scalar parameter by name.
+///
+/// Names follow the path of the field inside `lion_params_t`, e.g. `"temp.cp"`, `"ocv.v0"` or
+/// `"rint.params.fixed.internal_resistance"`, and elements of arrays are indexed like `"rc.resistance[0]"`.
+/// @param[in]  params  Parameters to look into.
+/// @param[in]  name    Name of the parameter.
+/// @returns Pointer to the parameter inside `params`, or NULL if there is no parameter with that name.
+double *lion_params_field(lion_params_t *params, const char *name);
+
 /// @}
 
 #ifdef __cplusplus
@@ -0,0 +1,71 @@
+/// @file
+/// @brief Parallel-in-time runs of a single cell.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+#include "vector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// Setup of a parallel-in-time run.
+typedef struct lion_parareal {
+  size_t   n_slices;       ///< Number of time slices, 0 uses one per thread.
+  uint64_t coarse_steps;   ///< Steps of the simulation in each step of the coarse propagator, 0 for one per slice.
+  size_t   max_iterations; ///< Most corrections to take, 0 for one per slice, after which the run is exact.
+  double   tolerance;      ///< Largest change of the states at the slice boundaries that ends the corrections.
+  int      n_threads;      ///< Number of threads to use, 0 uses every available thread.
+} lion_parareal_t;
+
+/// Summary of a parallel-in-time run.
+typedef struct lion_parareal_result {
+  size_t iterations; ///< Corrections taken.
+  double defect;     ///< Largest change of the states at the slice boundaries in the last correction.
+  int    converged;  ///< Whether the defect went below the tolerance.
+} lion_parareal_result_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Runs the simulation in parallel in time.
+///
+/// Same as `lion_sim_run`, but the input is split in time slices that are run at once with the
+/// Parareal scheme. A coarse propagator seeds the state at the start of every slice, taking steps
+/// of `coarse_steps` samples over which the power and ambient temperature are averaged, with the
+/// resistance fixed at the current of the previous step and the states propagated in closed
+/// form like `lion_sim_jump`. Each correction then runs every slice that is not settled yet on a
+/// fork of the simulation, in parallel, and moves the state at the start of the next slice by the
+/// difference between the coarse propagation from the corrected and the previous states.
+///
+/// The states of the ODE at the slice boundaries, along with the state of health, are corrected.
+/// Everything else, such as the cycle bookkeeping, is taken from the fine run of the previous
+/// slice. After `k` corrections the first `k` slices match `lion_sim_run` exactly, so the run
+/// ends either when the states at the boundaries change by less than `tolerance` or after one
+/// correction per slice. The simulation is left at the end of the run.
+///
+/// The slices do not call the update hook, and simulations with events, statistics or
+/// `sim_jump` other than `LION_JUMP_NONE` must be run serially. Models that draw random numbers get a different stream in each slice.
+/// @param[in]  sim                  Simulation to run.
+/// @param[in]  parareal             Setup of the run.
+/// @param[in]  power                Power extracted from the cell at each time step.
+/// @param[in]  ambient_temperature  Ambient temperature around the cell at each time step.
+/// @param[out] out                  Summary of the run, can be NULL.
+lion_status_t lion_sim_run_parareal(
+    lion_sim_t *sim, const lion_parareal_t *parareal, lion_vector_t *power, lion_vector_t *ambient_temperature, lion_parareal_result_t *out
+);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
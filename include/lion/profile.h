@@ -0,0 +1,108 @@
+/// @file
+/// @brief Binary input profiles that can be mapped into memory.
+#pragma once
+
+#include "status.h"
+#include "vector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Version of the profile format written by this build.
+#define LION_PROFILE_VERSION 1
+/// Maximum number of columns in a profile.
+#define LION_PROFILE_MAX_COLUMNS 16
+/// Maximum length of a column name, including the terminator.
+#define LION_PROFILE_NAME_MAX 32
+/// Maximum length of a column unit, including the terminator.
+#define LION_PROFILE_UNIT_MAX 16
+/// Alignment in bytes of the first sample of every column.
+#define LION_PROFILE_ALIGNMENT 64
+
+/// @addtogroup types
+/// @{
+
+/// Type of the samples stored in a profile.
+typedef enum lion_profile_dtype {
+  LION_PROFILE_F64 = 0, ///< 64-bit floating point samples.
+  LION_PROFILE_F32 = 1, ///< 32-bit floating point samples.
+} lion_profile_dtype_t;
+
+/// Description of a column of a profile.
+typedef struct lion_profile_column {
+  char name[LION_PROFILE_NAME_MAX]; ///< Name of the column.
+  char unit[LION_PROFILE_UNIT_MAX]; ///< Unit of the samples, empty if unknown.
+} lion_profile_column_t;
+
+/// Description of a profile.
+///
+/// A profile holds `count` samples of every column, taken every `sample_period` seconds. The
+/// samples of each column are stored contiguously and aligned to `LION_PROFILE_ALIGNMENT`
+/// bytes, so a mapped column can be used directly as the data of a vector.
+typedef struct lion_profile_info {
+  double                sample_period;                     ///< Time between samples in seconds.
+  uint64_t              count;                             ///< Number of samples in every column.
+  uint32_t              n_columns;                         ///< Number of columns.
+  lion_profile_dtype_t  dtype;                             ///< Type of the samples.
+  lion_profile_column_t columns[LION_PROFILE_MAX_COLUMNS]; ///< Description of every column.
+} lion_profile_info_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Write a profile file.
+///
+/// @param[in]  sim        Simulation context, can be NULL.
+/// @param[in]  filename   Name of the file to write.
+/// @param[in]  info       Description of the profile.
+/// @param[in]  columns    Samples of every column, `info->count` each. Converted to
+///                        `info->dtype` when written.
+lion_status_t lion_profile_write(lion_sim_t *sim, const char *filename, const lion_profile_info_t *info, const double *const columns[]);
+
+/// @brief Convert a CSV file into a profile file.
+///
+/// The first line of the CSV file names the columns, optionally followed by their unit in
+/// brackets, as in `power [W]`. Every other line holds one sample of every column.
+///
+/// @param[in]  sim            Simulation context, can be NULL.
+/// @param[in]  csv_filename   Name of the CSV file.
+/// @param[in]  filename       Name of the profile file to write.
+/// @param[in]  sample_period  Time between samples in seconds.
+/// @param[in]  dtype          Type of the samples to write.
+lion_status_t lion_profile_from_csv(lion_sim_t *sim, const char *csv_filename, const char *filename, double sample_period, lion_profile_dtype_t dtype);
+
+/// @brief Read the description of a profile file.
+///
+/// @param[in]  sim        Simulation context, can be NULL.
+/// @param[in]  filename   Name of the profile file.
+/// @param[out] out        Description of the profile.
+lion_status_t lion_profile_read_info(lion_sim_t *sim, const char *filename, lion_profile_info_t *out);
+
+/// @brief Map a column of a profile file into a read-only vector.
+///
+/// The samples are not copied nor parsed: the vector points straight into a shared read-only
+/// mapping of the file, so every process and thread mapping the same profile shares a single
+/// copy of it. The elements are doubles or floats depending on the type of the profile. The
+/// vector is marked as mapped, so setting, pushing, resizing and cleaning it up fail. It must
+/// be released with `lion_vector_unmap` instead.
+///
+/// @param[in]  sim        Simulation context, can be NULL.
+/// @param[in]  filename   Name of the profile file.
+/// @param[in]  column     Name of the column to map.
+/// @param[out] out        Vector over the samples of the column.
+lion_status_t lion_vector_map_file(lion_sim_t *sim, const char *filename, const char *column, lion_vector_t *out);
+
+/// @brief Release a vector created by `lion_vector_map_file`.
+lion_status_t lion_vector_unmap(lion_sim_t *sim, lion_vector_t *vec);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,81 @@
+/// @file
+/// @brief Charge and discharge protocols made of controlled steps.
+#pragma once
+
+#include "events.h"
+#include "sim.h"
+#include "status.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Number of steps of a constant current, constant voltage charge.
+#define LION_PROTOCOL_CCCV_STEPS 2
+
+/// @addtogroup types
+/// @{
+
+/// Step of a protocol, which holds a quantity of the cell until a condition is met.
+typedef struct lion_protocol_step {
+  lion_input_mode_t mode;      ///< Quantity controlled during the step.
+  double            value;     ///< Setpoint of the controlled quantity.
+  const char       *field;     ///< Field of the state that ends the step, NULL to end it on its duration.
+  lion_event_kind_t kind;      ///< Condition on `field` that ends the step.
+  double            threshold; ///< Threshold of the condition.
+  double            duration;  ///< Longest duration of the step in seconds, 0 for no limit.
+} lion_protocol_step_t;
+
+/// Sequence of steps run one after the other.
+typedef struct lion_protocol {
+  const lion_protocol_step_t *steps;               ///< Steps of the protocol.
+  size_t                      n_steps;             ///< Number of steps.
+  double                      ambient_temperature; ///< Ambient temperature around the cell.
+
+  size_t active;     ///< Step being run, `n_steps` once the protocol finished.
+  double start_time; ///< Time at which the active step started.
+} lion_protocol_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Create a new protocol.
+///
+/// Every step must end, either on its condition or after its duration.
+/// @param[in]  steps                Steps of the protocol, must outlive it.
+/// @param[in]  n_steps              Number of steps.
+/// @param[in]  ambient_temperature  Ambient temperature around the cell.
+/// @param[out] out                  Pointer to where the protocol will be created.
+lion_status_t lion_protocol_new(const lion_protocol_step_t *steps, size_t n_steps, double ambient_temperature, lion_protocol_t *out);
+
+/// @brief Fill the steps of a constant current, constant voltage charge.
+///
+/// The cell is charged at `charge_current` until its voltage goes above `max_voltage`, and then
+/// held at `max_voltage` until the charge current falls below `cutoff_current`.
+/// @param[in]  charge_current  Magnitude of the charge current.
+/// @param[in]  max_voltage     Voltage at which the charge switches to constant voltage.
+/// @param[in]  cutoff_current  Magnitude of the charge current that ends the charge.
+/// @param[out] out             Steps of the charge.
+void lion_protocol_cccv(double charge_current, double max_voltage, double cutoff_current, lion_protocol_step_t out[LION_PROTOCOL_CCCV_STEPS]);
+
+/// @brief Run a protocol on a simulation.
+///
+/// Continues an initialized simulation from its current state with `lion_sim_step_input`. The
+/// condition of the active step is watched as a stop event, appended to the events of the
+/// simulation while the step runs, so steps end at the located crossing and the next one starts
+/// from there. Stop events of the simulation and cancellations end the protocol early.
+/// @param[in,out] sim        Simulation to run.
+/// @param[in,out] protocol   Protocol to run, restarted from its first step.
+/// @param[in]     max_steps  Most steps of the simulation to take, 0 for no limit.
+lion_status_t lion_sim_run_protocol(lion_sim_t *sim, lion_protocol_t *protocol, uint64_t max_steps);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
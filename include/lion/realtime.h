@@ -0,0 +1,147 @@
+/// @file
+/// @brief Wall-clock paced simulation for hardware-in-the-loop setups.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// @brief Lock-free queue with a single producer and a single consumer.
+///
+/// Every slot is allocated when the queue is created, so pushing and popping never allocate,
+/// lock or log. The indices are only accessed through atomic operations.
+typedef struct lion_rt_queue {
+  size_t         capacity;  ///< Number of slots, always a power of two.
+  size_t         elem_size; ///< Size of each element in bytes.
+  unsigned char *buffer;    ///< Storage for the elements.
+  size_t         head;      ///< Number of elements popped so far, written by the consumer.
+  size_t         tail;      ///< Number of elements pushed so far, written by the producer.
+} lion_rt_queue_t;
+
+/// Input of a real-time step.
+typedef struct lion_rt_input {
+  double power;               ///< Power drawn from the cell.
+  double ambient_temperature; ///< Ambient temperature around the cell.
+} lion_rt_input_t;
+
+/// Output of a real-time step.
+typedef struct lion_rt_output {
+  uint64_t step;                 ///< Simulation step index.
+  double   power;                ///< Power used in the step.
+  double   voltage;              ///< Voltage in the terminals of the cell.
+  double   current;              ///< Current drawn from the cell.
+  double   soc;                  ///< Nominal state of charge.
+  double   internal_temperature; ///< Internal temperature of the cell.
+  double   surface_temperature;  ///< Surface temperature of the cell.
+  int64_t  elapsed_ns;           ///< Wall-clock time spent in the step.
+  int      missed;               ///< Whether the step finished after its deadline.
+} lion_rt_output_t;
+
+/// Configuration of a real-time runner.
+typedef struct lion_rt_config {
+  int64_t period_ns;      ///< Period of the steps in nanoseconds.
+  int     cpu;            ///< CPU the stepping thread is pinned to, negative to let the scheduler choose.
+  int     priority;       ///< `SCHED_FIFO` priority of the stepping thread, 0 to keep the default policy.
+  int     max_iter;       ///< Cap on the iterations of the current optimization, 0 to keep the simulation setting.
+  size_t  queue_capacity; ///< Capacity of the input and output queues.
+  int     mute_logs;      ///< Whether to drop the log events of the stepping thread.
+} lion_rt_config_t;
+
+/// Timing statistics of a real-time runner.
+typedef struct lion_rt_stats {
+  uint64_t steps;           ///< Number of steps taken.
+  uint64_t deadline_misses; ///< Number of steps that finished after their deadline.
+  uint64_t stale_inputs;    ///< Number of steps without a new input, which reuse the previous one.
+  uint64_t dropped_outputs; ///< Number of outputs lost because the output queue was full.
+  int64_t  max_elapsed_ns;  ///< Longest step.
+  int64_t  max_late_ns;     ///< Largest delay past a deadline.
+} lion_rt_stats_t;
+
+/// Real-time runner stepping a simulation on a dedicated thread.
+typedef struct lion_rt {
+  lion_sim_t      *sim;     ///< Simulation being stepped.
+  lion_rt_config_t conf;    ///< Configuration of the runner.
+  lion_rt_queue_t  inputs;  ///< Inputs pushed by the rig and consumed by the stepping thread.
+  lion_rt_queue_t  outputs; ///< Outputs pushed by the stepping thread and consumed by the rig.
+  lion_rt_input_t  hold;    ///< Input applied while no new input arrives.
+  lion_rt_stats_t  stats;   ///< Timing statistics, read them with `lion_rt_get_stats`.
+
+  int                _running;     ///< Whether the stepping thread should keep running.
+  int                _status;      ///< Status of the stepping thread.
+  lion_sim_config_t  _sim_conf;    ///< Configuration of the simulation while running, with the iteration cap.
+  lion_sim_config_t *_caller_conf; ///< Configuration of the simulation before the runner started.
+  void              *_thread;      ///< Handle of the stepping thread.
+} lion_rt_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Create a single producer, single consumer queue.
+/// @param[in]  sim        Simulation used for allocation and logging.
+/// @param[in]  capacity   Minimum number of elements, rounded up to a power of two.
+/// @param[in]  elem_size  Size of each element in bytes.
+/// @param[out] out        Created queue.
+lion_status_t lion_rt_queue_new(lion_sim_t *sim, size_t capacity, size_t elem_size, lion_rt_queue_t *out);
+
+/// Copy an element into the queue, returns 0 without copying when the queue is full.
+int lion_rt_queue_push(lion_rt_queue_t *queue, const void *elem);
+
+/// Copy the oldest element out of the queue, returns 0 when the queue is empty.
+int lion_rt_queue_pop(lion_rt_queue_t *queue, void *elem);
+
+/// Number of elements waiting in the queue.
+size_t lion_rt_queue_size(const lion_rt_queue_t *queue);
+
+/// Free the storage of a queue.
+lion_status_t lion_rt_queue_cleanup(lion_sim_t *sim, lion_rt_queue_t *queue);
+
+/// Get the default real-time configuration, with a 1 kHz rate.
+lion_rt_config_t lion_rt_config_default(void);
+
+/// @brief Create a real-time runner.
+///
+/// The queues are allocated here, so nothing is allocated once the runner starts.
+/// @param[in]  sim   Initialized simulation to step.
+/// @param[in]  conf  Configuration of the runner.
+/// @param[out] out   Created runner.
+lion_status_t lion_rt_new(lion_sim_t *sim, const lion_rt_config_t *conf, lion_rt_t *out);
+
+/// @brief Start stepping the simulation on a dedicated thread.
+///
+/// Every period the thread takes the newest input of `rt->inputs`, steps the simulation and
+/// pushes the result to `rt->outputs`, then sleeps until the next period on an absolute
+/// monotonic clock so the pacing does not drift. A step that overruns its period is counted as
+/// a deadline miss and the schedule restarts from its end instead of bursting to catch up.
+///
+/// The iteration cap of the configuration bounds the worst-case step time. The simulation
+/// steps with a copy of its configuration holding the cap until the runner stops, so the
+/// configuration of the caller is left untouched.
+/// The simulation must not be used by other threads while the runner is active. Only
+/// available on Linux.
+lion_status_t lion_rt_start(lion_rt_t *rt);
+
+/// Stop the stepping thread, failing if the simulation failed while running.
+lion_status_t lion_rt_stop(lion_rt_t *rt);
+
+/// Get a snapshot of the timing statistics, safe to call while the runner is active.
+lion_rt_stats_t lion_rt_get_stats(const lion_rt_t *rt);
+
+/// Stop the runner if needed and free its resources.
+lion_status_t lion_rt_cleanup(lion_rt_t *rt);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,66 @@
+/// @file
+/// @brief Fast evaluation of candidate power trajectories from the state of a simulation.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Number of candidates advanced together by `lion_rollout`.
+#define LION_ROLLOUT_LANES 8
+
+/// @addtogroup types
+/// @{
+
+/// Summary of the rollout of one candidate.
+typedef struct lion_rollout_result {
+  double final_soc;         ///< Nominal state of charge at the end of the horizon.
+  double final_temperature; ///< Internal temperature at the end of the horizon.
+  double max_temperature;   ///< Maximum internal temperature over the horizon.
+  double min_voltage;       ///< Minimum terminal voltage over the horizon.
+  double max_current;       ///< Maximum absolute current over the horizon.
+  double energy;            ///< Energy drawn from the cell over the horizon.
+  int    feasible;          ///< Whether the cell could deliver the power at every step.
+} lion_rollout_result_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Evaluate candidate power trajectories from the current state of a simulation.
+///
+/// Each candidate starts from the state the next call to `lion_sim_step` would start from, and
+/// is advanced with the same model under the ambient temperature of the last step. The
+/// simulation itself is not modified, no hooks are called and nothing is allocated or logged,
+/// so the rollout can run inside a control loop.
+///
+/// The loop is stripped down compared to `lion_sim_step`. With the inputs frozen over each
+/// step the state equations are linear, so they are integrated exactly instead of through the
+/// GSL driver. The current comes from a few fixed-point iterations of the closed-form solution,
+/// which is exact with a fixed internal resistance, and degradation is not updated over the
+/// horizon. Candidates advance in groups of `LION_ROLLOUT_LANES` with their state laid out as
+/// arrays, so the arithmetic of a step vectorizes across candidates.
+///
+/// When a candidate draws more power than the cell can deliver, the step runs at the maximum
+/// power point instead and the candidate is marked as infeasible.
+///
+/// Only the `LION_ONLYSF` regime with the temperature updated at every step is supported, other
+/// thermal configurations are rejected.
+/// @param[in]  sim               Initialized simulation providing the initial state.
+/// @param[in]  power_candidates  Power of each candidate at each step, `horizon` values per candidate.
+/// @param[in]  n_candidates      Number of candidates.
+/// @param[in]  horizon           Number of steps of each candidate.
+/// @param[out] out               Summary of each candidate, `n_candidates` elements.
+lion_status_t lion_rollout(lion_sim_t *sim, const double *power_candidates, size_t n_candidates, size_t horizon, lion_rollout_result_t *out);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,12 +8,16 @@
 
 #include <gsl/gsl_min.h>
 #include <gsl/gsl_odeiv2.h>
+#include <gsl/gsl_rng.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <time.h>
 
 #define _LION_LOGFILE_MAX 64
 
+/// Version of the binary layout used by `lion_sim_checkpoint`.
+#define LION_CHECKPOINT_VERSION 4
+
 /// @defgroup types Types
 /// @defgroup functions Functions
 
@@ -49,30 +53,37 @@ size_t               heapinfo_count(lion_sim_t *sim);
 
 /// @brief Regime in which the simulation operates.
 ///
-/// This enum indicates which domains the temperature model considers. Currently
-/// only surface simulation is allowed, but air considerations are planned.
+/// This enum indicates which domains the temperature model considers. Single cells
+/// always exchange heat with the ambient through their surface, while packs can
+/// route that heat through a thermal network of air or coolant nodes.
 typedef enum lion_regime {
-  LION_ONLYSF,  ///< Surface temperature.
-  LION_ONLYAIR, ///< Air temperature.
-  LION_BOTH,    ///< Surface and air temperature.
+  LION_ONLYSF,  ///< Surface temperature, each cell exchanges heat with the ambient.
+  LION_ONLYAIR, ///< Air temperature, cells exchange heat with the nodes of a thermal network.
+  LION_BOTH,    ///< Surface and air temperature, like `LION_ONLYAIR` plus conduction between cells.
 } lion_regime_t;
 
 /// @brief Stepper algorithm for the ode solver.
 ///
 /// The types of steppers allowed are those allowed by GSL, and considers
-/// both explicit and implicit solvers.
+/// both explicit and implicit solvers. The native steppers integrate the cell
+/// without going through the GSL driver, with the derivatives and Jacobian
+/// called directly and every stage kept on the stack. Systems other than a
+/// single cell, like packs and estimators, use the GSL stepper of the same order.
 typedef enum lion_stepper {
-  LION_STEPPER_RK2,     ///< Explicit Runge-Kutta (2, 3).
-  LION_STEPPER_RK4,     ///< Explicit Runge-Kutta 4.
-  LION_STEPPER_RKF45,   ///< Explicit Runge-Kutta-Fehlberg (4, 5).
-  LION_STEPPER_RKCK,    ///< Explicit Runge-Kutta Cash-Karp (4, 5).
-  LION_STEPPER_RK8PD,   ///< Explicit Runge-Kutta Prince-Dormand (8, 9).
-  LION_STEPPER_RK1IMP,  ///< Implicit Euler.
-  LION_STEPPER_RK2IMP,  ///< Implicit Runge-Kutta 2.
-  LION_STEPPER_RK4IMP,  ///< Implicit Runge-Kutta 4.
-  LION_STEPPER_BSIMP,   ///< Implicit Bulirsch-Stoer.
-  LION_STEPPER_MSADAMS, ///< Multistep Adams.
-  LION_STEPPER_MSBDF,   ///< Multistep backwards differentiation.
+  LION_STEPPER_RK2,         ///< Explicit Runge-Kutta (2, 3).
+  LION_STEPPER_RK4,         ///< Explicit Runge-Kutta 4.
+  LION_STEPPER_RKF45,       ///< Explicit Runge-Kutta-Fehlberg (4, 5).
+  LION_STEPPER_RKCK,        ///< Explicit Runge-Kutta Cash-Karp (4, 5).
+  LION_STEPPER_RK8PD,       ///< Explicit Runge-Kutta Prince-Dormand (8, 9).
+  LION_STEPPER_RK1IMP,      ///< Implicit Euler.
+  LION_STEPPER_RK2IMP,      ///< Implicit Runge-Kutta 2.
+  LION_STEPPER_RK4IMP,      ///< Implicit Runge-Kutta 4.
+  LION_STEPPER_BSIMP,       ///< Implicit Bulirsch-Stoer.
+  LION_STEPPER_MSADAMS,     ///< Multistep Adams.
+  LION_STEPPER_MSBDF,       ///< Multistep backwards differentiation.
+  LION_STEPPER_NATIVE_RK4,  ///< Native explicit Runge-Kutta 4.
+  LION_STEPPER_NATIVE_RK45, ///< Native explicit Runge-Kutta Dormand-Prince (5, 4), advancing with the fifth order solution.
+  LION_STEPPER_NATIVE_ROS2, ///< Native L-stable Rosenbrock 2, one Jacobian per step.
 } lion_stepper_t;
 
 /// @brief Minimizer algorithm for the optimization problem.
@@ -94,6 +105,48 @@ typedef enum lion_jacobian_method {
   LION_JACOBIAN_2POINT,     ///< Central differences method.
 } lion_jacobian_method_t;
 
+/// @brief Degradations taken by a step to stay within its evaluation budget.
+///
+/// Flags are combined in `lion_sim_state_t.step_flags`, which is cleared at the start of every step.
+typedef enum lion_step_flag {
+  LION_STEP_CURRENT_UNCONVERGED = 1 << 0, ///< The current optimization stopped before converging.
+  LION_STEP_CURRENT_ANALYTIC    = 1 << 1, ///< The current is a one-shot analytic estimate at the previous resistance.
+  LION_STEP_CURRENT_HOLD        = 1 << 2, ///< The current of the previous step was kept.
+  LION_STEP_ODE_FALLBACK        = 1 << 3, ///< The states were advanced with a single explicit Euler step.
+} lion_step_flag_t;
+
+/// @brief Quantity controlled by the input of a step.
+///
+/// The controlled quantity is taken as given and the others are derived from it: power control
+/// solves the implicit current equation, voltage control solves the terminal voltage equation for
+/// the current, and current control needs no solve at all.
+typedef enum lion_input_mode {
+  LION_INPUT_POWER   = 0, ///< The input is the power drawn from the cell.
+  LION_INPUT_CURRENT = 1, ///< The input is the current drawn from the cell.
+  LION_INPUT_VOLTAGE = 2, ///< The input is the voltage in the terminals of the cell.
+} lion_input_mode_t;
+
+/// @brief Interpolation of the inputs inside each step.
+///
+/// With a first-order hold the inputs ramp linearly from the values of the previous step to
+/// those of the current one, and the current drawn at each stage of the stepper follows them,
+/// linearized around the current solved for the step. Changing the controlled quantity, and the
+/// first step after initializing, hold the inputs instead.
+typedef enum lion_input_hold {
+  LION_HOLD_ZERO  = 0, ///< Inputs are constant over the whole step.
+  LION_HOLD_FIRST = 1, ///< Inputs ramp linearly across the step.
+} lion_input_hold_t;
+
+/// @brief Intervals of constant inputs that `lion_sim_run` propagates in one jump.
+///
+/// Runs of at least `sim_jump_min_steps` samples with the same power and ambient temperature are
+/// handed to `lion_sim_jump` instead of being stepped one by one.
+typedef enum lion_jump {
+  LION_JUMP_NONE     = 0, ///< Every sample is stepped.
+  LION_JUMP_REST     = 1, ///< Rest intervals, with zero power, are jumped.
+  LION_JUMP_CONSTANT = 2, ///< Rest and constant power intervals are jumped.
+} lion_jump_t;
+
 /// @brief Simulation metaparameters and hyperparameters.
 ///
 /// These parameters are not associated to the runtime of the sim itself, but rather
@@ -114,6 +167,23 @@ typedef struct lion_sim_config {
   double                 sim_epsabs;       ///< Absolute epsilon for update.
   double                 sim_epsrel;       ///< Relative epsilon for update.
   uint64_t               sim_min_maxiter;  ///< Maximum iterations of each minimization problem.
+  lion_input_hold_t      sim_input_hold;   ///< Interpolation of the inputs inside each step.
+
+  /* Closed form propagation of constant inputs */
+
+  lion_jump_t sim_jump;             ///< Intervals of constant inputs jumped by `lion_sim_run`.
+  uint64_t    sim_jump_min_steps;   ///< Shortest interval that is jumped, in steps.
+  double      sim_jump_max_seconds; ///< Longest stretch with frozen coefficients under constant power.
+
+  /* Multirate integration, in steps of the electrical states per step of each slow subsystem */
+
+  uint64_t sim_thermal_steps; ///< Steps per update of the internal temperature and the capacity it drives, 0 or 1 for every step.
+  uint64_t sim_aging_steps;   ///< Steps per update of calendar aging, 0 or 1 for every step.
+
+  /* Evaluation budget of each step, 0 leaves the stage unbounded */
+
+  uint64_t sim_current_budget; ///< Maximum evaluations of the current residual, then the current falls back to an estimate. Below 3 only the estimate is used.
+  uint64_t sim_ode_budget;     ///< Maximum evaluations of the state derivatives, then the states fall back to an Euler step.
 
   /* Logging configuration */
 
@@ -131,15 +201,18 @@ typedef struct lion_sim_state {
   uint64_t step; ///< Simulation step index (starts at 1).
 
   // System inputs
-  double power;               ///< Power being drawn from the cell.
-  double ambient_temperature; ///< Ambient temperature around the cell.
+  double            power;               ///< Power being drawn from the cell.
+  double            ambient_temperature; ///< Ambient temperature around the cell.
+  lion_input_mode_t input_mode;          ///< Quantity set by the input, the others are outputs of the step.
 
   // Electrical state
-  double voltage;                  ///< Voltage in the terminals of the cell.
-  double current;                  ///< Current drawn from the cell.
-  double ref_open_circuit_voltage; ///< Reference open circuit voltage of the cell.
-  double open_circuit_voltage;     ///< Temperature aware open circuit voltage of the cell.
-  double internal_resistance;      ///< Internal resistance of the cell.
+  double voltage;                          ///< Voltage in the terminals of the cell.
+  double current;                          ///< Current drawn from the cell.
+  double ref_open_circuit_voltage;         ///< Reference open circuit voltage of the cell.
+  double open_circuit_voltage;             ///< Temperature aware open circuit voltage of the cell.
+  double internal_resistance;              ///< Internal resistance of the cell.
+  double rc_voltage[LION_RC_MAX_BRANCHES]; ///< Voltage across each RC branch of the polarization model.
+  double polarization_voltage;             ///< Total voltage across the RC branches.
 
   // Degradation state
   uint64_t cycle;          ///< Number of cycles the battery has been through
@@ -164,8 +237,22 @@ typedef struct lion_sim_state {
   double capacity_use;     ///< Usable capacity considering temperature.
 
   // Next state placeholders
-  double _next_soc_nominal;          ///< Placeholder for the next nominal state of charge.
-  double _next_internal_temperature; ///< Placeholder for the next internal temperature.
+  double _next_soc_nominal;                      ///< Placeholder for the next nominal state of charge.
+  double _next_internal_temperature;             ///< Placeholder for the next internal temperature.
+  double _next_rc_voltage[LION_RC_MAX_BRANCHES]; ///< Placeholder for the next voltage across each RC branch.
+
+  // Inputs at the start of the step
+  double _hold_input;               ///< Controlled input at the start of the step, used by the first-order hold.
+  double _hold_ambient_temperature; ///< Ambient temperature at the start of the step, used by the first-order hold.
+
+  // Multirate placeholders
+  uint64_t _thermal_step;        ///< Steps integrated since the internal temperature was last updated.
+  double   _thermal_temperature; ///< Internal temperature reached over the steps of the current thermal step.
+  uint64_t _aging_step;          ///< Steps taken since calendar aging was last applied.
+
+  // Solver diagnostics
+  uint32_t step_flags;       ///< Degradations taken by the last step, as `lion_step_flag_t` flags.
+  uint64_t step_evaluations; ///< Function evaluations used by the last step.
 } lion_sim_state_t;
 
 /// @brief Inputs for the solver.
@@ -173,8 +260,13 @@ typedef struct lion_sim_state {
 /// Both the current state and the parameters of the system are passed at each iteration of the solver,
 /// to be used for the update function as well as the Jacobian calculation.
 typedef struct lion_slv_inputs {
-  lion_sim_state_t *sys_inputs; ///< System state.
-  lion_params_t    *sys_params; ///< System parameters.
+  lion_sim_state_t *sys_inputs;      ///< System state.
+  lion_params_t    *sys_params;      ///< System parameters.
+  uint64_t          evaluations;     ///< Evaluations of the system in the current step.
+  uint64_t          max_evaluations; ///< Evaluations allowed in the current step, 0 for no limit.
+  double            hold_span;       ///< Length of the step the inputs ramp over, 0 to hold them.
+  int               thermal_frozen;  ///< Whether the internal temperature is held, as the thermal steps advance it.
+  double            thermal_decay;   ///< Decay of the internal temperature towards equilibrium over one step.
 } lion_slv_inputs_t;
 
 /// @brief Simulation runtime, used for setup and simulation.
@@ -197,6 +289,16 @@ typedef struct lion_sim {
   gsl_min_fminimizer            *sys_min;               ///< Handle to the minimizer.
   const gsl_odeiv2_step_type    *step_type;             ///< Stepper used by the ode system.
   const gsl_min_fminimizer_type *minimizer;             ///< Minimizer used by the optimizer.
+  gsl_rng                       *rng;                   ///< Random number generator used by stochastic models.
+  unsigned long                  _seed;                 ///< Seed of the random number generator.
+  uint64_t                       _forks;                ///< Number of forks taken, which seeds the next one.
+  const lion_sim_t              *parent;                ///< Simulation this one was forked from, NULL if it owns the parameter tables.
+  struct lion_stat              *stats;                 ///< Accumulators updated on every step.
+  size_t                         n_stats;               ///< Number of accumulators.
+  struct lion_event             *events;                ///< Events checked on every step.
+  size_t                         n_events;              ///< Number of events.
+  int                            _close;                ///< Reason to close the simulation, as a `lion_close_reason_t`.
+  double                         _events_span;          ///< Length of the last integrated step, 0 after a stop.
 
   char  log_filename[FILENAME_MAX + _LION_LOGFILE_MAX]; ///< Name of the log file.
   FILE *log_file;                                       ///< Handle to the log file.
@@ -230,6 +332,14 @@ lion_status_t lion_sim_config_new(lion_sim_config_t *out);
 /// Create a default configuration.
 lion_sim_config_t lion_sim_config_default(void);
 
+/// @brief Get a numeric configuration value by name.
+///
+/// Valid names are `"sim_time_seconds"`, `"sim_step_seconds"`, `"sim_epsabs"` and `"sim_epsrel"`.
+/// @param[in]  conf  Configuration to look into.
+/// @param[in]  name  Name of the field.
+/// @returns Pointer to the field inside `conf`, or NULL if there is no field with that name.
+double *lion_sim_config_field(lion_sim_config_t *conf, const char *name);
+
 /// @brief Create a new simulation.
 ///
 /// Sets up the simulation with a set of configuration and parameters.
@@ -244,6 +354,15 @@ lion_status_t lion_sim_init(lion_sim_t *sim);
 /// Reset the simulation.
 lion_status_t lion_sim_reset(lion_sim_t *sim);
 
+/// @brief Find a field of the state by name.
+///
+/// Only floating point fields can be looked up, using the name of the member in
+/// `lion_sim_state_t`, such as `internal_temperature` or `rc_voltage[0]`.
+/// @param[in]  state   State to look into.
+/// @param[in]  name    Name of the field.
+/// @returns Pointer to the field inside `state`, or NULL if there is no field with that name.
+double *lion_sim_state_field(lion_sim_state_t *state, const char *name);
+
 /// @brief Step the simulation in time.
 ///
 /// Steps the simulation forward considering some power and ambient temperature values.
@@ -252,6 +371,33 @@ lion_status_t lion_sim_reset(lion_sim_t *sim);
 /// @param[in]  ambient_temperature  Ambient temperature around the cell.
 lion_status_t lion_sim_step(lion_sim_t *sim, double power, double ambient_temperature);
 
+/// @brief Step the simulation in time with a controlled quantity.
+///
+/// Like `lion_sim_step`, but the input sets the quantity chosen by `mode`, which is stored in
+/// the matching field of the state. The power drawn from the cell is then an output of the step.
+/// @param[in]  sim                  Simulation to step forward.
+/// @param[in]  mode                 Quantity set by `value`.
+/// @param[in]  value                Power, current or voltage of the cell during the step.
+/// @param[in]  ambient_temperature  Ambient temperature around the cell.
+lion_status_t lion_sim_step_input(lion_sim_t *sim, lion_input_mode_t mode, double value, double ambient_temperature);
+
+/// @brief Step the simulation over an interval of constant inputs in closed form.
+///
+/// Leaves the simulation like `steps` calls to `lion_sim_step` with the same inputs. The first
+/// step is taken normally, and the rest are propagated in closed form with the current, heat and
+/// ambient temperature held, which is exact at rest, where the current is taken as zero. Under
+/// constant power the coefficients are refreshed every `sim_jump_max_seconds` and at the end of
+/// every cycle, and rests are split at the same interval while the statistics are kept. Calendar
+/// aging, the degradation state and the statistics are updated over the whole interval, and the
+/// update hook runs once per stretch. The statistics sum the steps of each stretch with the
+/// trapezoidal rule. Simulations with events are stepped instead, since crossings are located by
+/// integrating the steps.
+/// @param[in]  sim                  Simulation to step forward.
+/// @param[in]  power                Power extracted from the cell.
+/// @param[in]  ambient_temperature  Ambient temperature around the cell.
+/// @param[in]  steps                Number of steps of the interval.
+lion_status_t lion_sim_jump(lion_sim_t *sim, double power, double ambient_temperature, uint64_t steps);
+
 /// @brief Runs the simulation.
 ///
 /// Runs the simulation considering a vector of values.
@@ -260,15 +406,48 @@ lion_status_t lion_sim_step(lion_sim_t *sim, double power, double ambient_temper
 /// @param[in]  ambient_temperature  Ambient temperature around the cell at each time step.
 lion_status_t lion_sim_run(lion_sim_t *sim, lion_vector_t *power, lion_vector_t *ambient_temperature);
 
+/// @brief Save the simulation state.
+///
+/// Serializes the state of the simulation, and the state of its random number generator, into a
+/// versioned binary blob. The blob uses the native byte order and is only meant to be restored by
+/// the same build of the simulator. Events and statistics are not saved.
+/// @param[in]  sim  Simulation to save.
+/// @param[out] out  Byte vector where the checkpoint is created, must be cleaned up by the caller.
+lion_status_t lion_sim_checkpoint(lion_sim_t *sim, lion_vector_t *out);
+
+/// @brief Restore the simulation state.
+///
+/// Loads a checkpoint created by `lion_sim_checkpoint` into an initialized simulation with the
+/// same models, and resets the ode driver. The occurrences of the events, the close request and
+/// the statistics are cleared, so a branch that was stopped or cancelled can run again.
+/// @param[in]  sim  Simulation to restore, must have been initialized.
+/// @param[in]  buf  Byte vector containing the checkpoint.
+lion_status_t lion_sim_restore(lion_sim_t *sim, const lion_vector_t *buf);
+
 /// Get the version of the simulator.
 lion_version_t lion_sim_get_version(lion_sim_t *sim);
 
-/// Check whether the simulation should close.
+/// @brief Check whether the simulation should close.
+///
+/// @returns A `lion_close_reason_t`, nonzero after a stop event fired or `lion_sim_cancel` was called.
 int lion_sim_should_close(lion_sim_t *sim);
 
 /// Get the max number of iterations.
 uint64_t lion_sim_max_iters(lion_sim_t *sim);
 
+/// @brief Fork a running simulation.
+///
+/// Creates a new simulation that continues from the current state of `src`. The configuration,
+/// the parameters and the trained tables of the degradation model are shared read-only, while the
+/// ode driver, the minimizer and the random number generator are owned by the fork. The generator
+/// is seeded from the seed of `src` and the number of forks taken from it, so forks sample
+/// independent noise without drawing from the stream of `src`. The events and accumulators of
+/// `src` are copied along with their counts, and a closed simulation forks closed. `src` must
+/// outlive its forks, and forks must be cleaned up with `lion_sim_cleanup`.
+/// @param[in]  src  Initialized simulation to fork.
+/// @param[out] dst  Pointer to where the fork will be created.
+lion_status_t lion_sim_fork(lion_sim_t *src, lion_sim_t *dst);
+
 /// Clean up the simulation.
 lion_status_t lion_sim_cleanup(lion_sim_t *sim);
 
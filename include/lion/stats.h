@@ -0,0 +1,99 @@
+/// @file
+/// @brief Streaming statistics of the state of a simulation.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// Summary kept by an accumulator on top of its moments.
+typedef enum lion_stat_kind {
+  LION_STAT_MOMENTS   = 0, ///< Only the count, mean, variance, minimum and maximum.
+  LION_STAT_HISTOGRAM = 1, ///< Fixed-width histogram between `low` and `high`.
+  LION_STAT_INTEGRAL  = 2, ///< Integral over time in units of the field times seconds, split into its positive and negative parts.
+  LION_STAT_DWELL     = 3, ///< Time spent above and below the threshold `low`.
+} lion_stat_kind_t;
+
+/// Configuration of an accumulator.
+typedef struct lion_stat_config {
+  lion_stat_kind_t kind;   ///< Summary to keep.
+  const char      *field;  ///< Field of the state, as accepted by `lion_sim_state_field`.
+  double           low;    ///< Lower edge of the histogram, or threshold of the dwell time.
+  double           high;   ///< Upper edge of the histogram.
+  size_t           n_bins; ///< Number of bins of the histogram.
+} lion_stat_config_t;
+
+/// @brief Streaming accumulator over a field of the state.
+///
+/// Every accumulator keeps the moments of its field, updated with Welford's algorithm, and the
+/// summary chosen by its kind. Integrals and dwell times treat the field as constant over each step.
+/// Integrals are kept in seconds, so the integral of the current is a charge in A·s (coulombs) and
+/// the one of the power an energy in W·s (joules); divide by 3600 for Ah or Wh.
+typedef struct lion_stat {
+  lion_stat_kind_t kind;   ///< Summary kept on top of the moments.
+  size_t           offset; ///< Offset of the field inside `lion_sim_state_t`.
+  double           low;    ///< Lower edge of the histogram, or threshold of the dwell time.
+  double           high;   ///< Upper edge of the histogram.
+  size_t           n_bins; ///< Number of bins of the histogram.
+
+  uint64_t count; ///< Number of steps accumulated.
+  double   mean;  ///< Mean of the field.
+  double   m2;    ///< Sum of squared deviations from the mean.
+  double   min;   ///< Minimum of the field.
+  double   max;   ///< Maximum of the field.
+
+  double integral; ///< Integral of the field over time, in units of the field times seconds.
+  double positive; ///< Integral of the positive part of the field, in units of the field times seconds.
+  double negative; ///< Integral of the negative part of the field, in units of the field times seconds.
+
+  double above; ///< Time spent above the threshold.
+  double below; ///< Time spent at or below the threshold.
+
+  uint64_t *bins;      ///< Steps that fell into each bin of the histogram.
+  uint64_t  underflow; ///< Steps below the lower edge of the histogram.
+  uint64_t  overflow;  ///< Steps at or above the upper edge of the histogram.
+  uint64_t  nan;       ///< Steps where the field was NaN, which fall in no bin.
+} lion_stat_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// @brief Add an accumulator to a simulation.
+///
+/// Accumulators are updated at the end of every `lion_sim_step`, before the update hook, and
+/// cleared whenever the simulation is initialized or reset. Forks start with a copy of them.
+/// @param[in,out] sim   Simulation to summarize.
+/// @param[in]     conf  Configuration of the accumulator.
+/// @param[out]    out   Index of the new accumulator, can be NULL.
+lion_status_t lion_sim_stats_add(lion_sim_t *sim, const lion_stat_config_t *conf, size_t *out);
+
+/// @brief Get an accumulator of a simulation.
+///
+/// @returns The accumulator at `index`, or NULL if there is none.
+const lion_stat_t *lion_sim_stat(const lion_sim_t *sim, size_t index);
+
+/// Clear every accumulator of a simulation, keeping their configuration.
+void lion_sim_stats_reset(lion_sim_t *sim);
+
+/// Remove every accumulator of a simulation.
+lion_status_t lion_sim_stats_cleanup(lion_sim_t *sim);
+
+/// Sample variance of an accumulator, NaN with less than two steps.
+double lion_stat_variance(const lion_stat_t *stat);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+/// @file
+/// @brief Parameter sweeps over many variants of a simulation.
+#pragma once
+
+#include "sim.h"
+#include "status.h"
+#include "vector.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// Sampling of the parameter space.
+typedef enum lion_sweep_method {
+  LION_SWEEP_GRID, ///< Cartesian product of evenly spaced values of each axis.
+  LION_SWEEP_LHS,  ///< Latin hypercube sampling.
+} lion_sweep_method_t;
+
+/// Output metrics computed for each variant.
+typedef enum lion_sweep_metric {
+  LION_SWEEP_FINAL_SOC,         ///< Nominal state of charge at the end of the run.
+  LION_SWEEP_FINAL_SOH,         ///< State of health at the end of the run.
+  LION_SWEEP_FINAL_TEMPERATURE, ///< Internal temperature at the end of the run.
+  LION_SWEEP_MAX_TEMPERATURE,   ///< Maximum internal temperature.
+  LION_SWEEP_MIN_VOLTAGE,       ///< Minimum terminal voltage.
+  LION_SWEEP_MAX_VOLTAGE,       ///< Maximum terminal voltage.
+  LION_SWEEP_MEAN_VOLTAGE,      ///< Mean terminal voltage.
+  LION_SWEEP_CHARGE_THROUGHPUT, ///< Total charge that went through the cell.
+  LION_SWEEP_CYCLES,            ///< Number of completed cycles.
+} lion_sweep_metric_t;
+
+/// Range of a swept parameter.
+typedef struct lion_sweep_axis {
+  const char *name; ///< Name of the parameter, as accepted by `lion_params_field` or `lion_sim_config_field`.
+  double      low;  ///< Lower bound.
+  double      high; ///< Upper bound.
+  size_t      num;  ///< Number of values in the grid, ignored by Latin hypercube sampling.
+} lion_sweep_axis_t;
+
+/// Description of a parameter sweep.
+typedef struct lion_sweep {
+  lion_sweep_method_t        method;    ///< Sampling of the parameter space.
+  const lion_sweep_axis_t   *axes;      ///< Swept parameters.
+  size_t                     n_axes;    ///< Number of swept parameters.
+  size_t                     n_samples; ///< Number of variants for Latin hypercube sampling.
+  unsigned long              seed;      ///< Seed for the sampling and for the random number generators of the variants.
+  const lion_sweep_metric_t *metrics;   ///< Metrics to compute for each variant.
+  size_t                     n_metrics; ///< Number of metrics.
+  int                        n_threads; ///< Number of threads to use, 0 uses every available thread.
+} lion_sweep_t;
+
+/// @}
+
+/// @addtogroup functions
+/// @{
+
+/// Get the number of variants of a sweep.
+size_t lion_sweep_variants(const lion_sweep_t *sweep);
+
+/// @brief Run a parameter sweep.
+///
+/// Each variant is a fork of `base` with its own copy of the configuration and parameters, so the
+/// logging setup and the initialization of the degradation model only happen once. Variants start
+/// from the initial conditions of their parameters and run over the whole input, which is shared
+/// between every variant. Hooks of `base` are not called by the variants, while its events are,
+/// and a stop event ends the variant like it ends `lion_sim_run`. Every sample is stepped, so
+/// bases with `sim_jump` other than `LION_JUMP_NONE` are rejected.
+///
+/// The results are stored as a row-major table of doubles with one row per variant, where the
+/// first `n_axes` columns hold the parameter values and the next `n_metrics` columns hold the
+/// metrics. Metrics of variants that fail are set to NaN.
+/// @param[in]  base                 Initialized simulation used as a base for every variant.
+/// @param[in]  sweep                Description of the sweep.
+/// @param[in]  power                Power extracted from the cell at each time step.
+/// @param[in]  ambient_temperature  Ambient temperature around the cell at each time step.
+/// @param[out] out                  Vector where the results table is created.
+lion_status_t lion_sweep_run(
+    lion_sim_t *base, const lion_sweep_t *sweep, lion_vector_t *power, lion_vector_t *ambient_temperature, lion_vector_t *out
+);
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,72 @@
+/// @file
+/// @brief Lumped thermal network coupling the cells of a pack.
+#pragma once
+
+#include "sim.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup types
+/// @{
+
+/// Thermal node other than a cell, such as a volume of air or coolant.
+typedef struct lion_thermal_node {
+  double heat_capacity;       ///< Heat capacity of the node in J/K.
+  double ambient_conductance; ///< Thermal conductance between the node and the ambient in W/K.
+  double initial_temperature; ///< Initial temperature of the node in K.
+} lion_thermal_node_t;
+
+/// @brief Thermal conductance between two nodes.
+///
+/// Nodes are numbered with the cells of the pack first, followed by the nodes of the network, so
+/// with `n_cells` cells the node `k` of the network has index `n_cells + k`.
+typedef struct lion_thermal_link {
+  size_t a;           ///< First node.
+  size_t b;           ///< Second node.
+  double conductance; ///< Thermal conductance in W/K.
+} lion_thermal_link_t;
+
+/// @brief Description of a thermal network.
+///
+/// The surface of each cell exchanges heat with one node of the network through the thermal
+/// resistances `temp.rin + temp.rout` of the cell, which takes the place of the ambient of the
+/// single cell model. Links between two cells model conduction and are only used in the
+/// `LION_BOTH` regime.
+typedef struct lion_thermal_config {
+  const lion_thermal_node_t *nodes;     ///< Nodes of the network.
+  size_t                     n_nodes;   ///< Number of nodes.
+  const lion_thermal_link_t *links;     ///< Links between nodes.
+  size_t                     n_links;   ///< Number of links.
+  const size_t              *cell_node; ///< Node of the network faced by each cell, NULL to use the first node for every cell.
+  double                     tolerance; ///< Relative tolerance of the linear solver, 0 uses the default.
+} lion_thermal_config_t;
+
+/// Sparse solver of the implicit step of a thermal network, private to the library.
+typedef struct lion_thermal_solver lion_thermal_solver_t;
+
+/// State of a thermal network.
+typedef struct lion_thermal {
+  lion_sim_t   *sim;     ///< Simulation providing the time step.
+  lion_regime_t regime;  ///< Regime of the network.
+  size_t        n_cells; ///< Number of cells.
+  size_t        n_total; ///< Number of cells and nodes.
+
+  double *temperature;         ///< Temperature of every node, cells first.
+  double *initial_temperature; ///< Initial temperature of every node.
+  double *capacity;            ///< Heat capacity of every node.
+  double *ambient_conductance; ///< Thermal conductance between every node and the ambient.
+  size_t *cell_node;           ///< Index of the node faced by each cell.
+  double  tolerance;           ///< Relative tolerance of the linear solver.
+
+  lion_thermal_solver_t *solver; ///< Solver of the implicit step, NULL without a network.
+} lion_thermal_t;
+
+/// @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,8 +22,25 @@ typedef struct lion_vector {
   size_t data_size; ///< Size of each element.
   size_t len;       ///< Length of the vector.
   size_t capacity;  ///< Capacity of the vector.
+  int    mapped;    ///< Whether the data is a read-only mapping of a file, which cannot be modified.
 } lion_vector_t;
 
+/// Non-owning view over contiguous doubles.
+///
+/// Views are plain pointers into the storage of a vector, so loops over
+/// `data` compile to direct loads the compiler can vectorize. A view is
+/// invalidated by anything that reallocates the vector it comes from.
+typedef struct lion_vector_view_d {
+  double *data; ///< First element of the view.
+  size_t  len;  ///< Number of elements in the view.
+} lion_vector_view_d_t;
+
+/// Non-owning view over contiguous floats.
+typedef struct lion_vector_view_f {
+  float *data; ///< First element of the view.
+  size_t len;  ///< Number of elements in the view.
+} lion_vector_view_f_t;
+
 /// @}
 
 /// @addtogroup functions
@@ -134,15 +151,33 @@ void         *lion_vector_get_p(lion_sim_t *sim, const lion_vector_t *vec, const
 /// @param[in] out          Pointer to the location to copy into the vector.
 lion_status_t lion_vector_set(lion_sim_t *sim, lion_vector_t *vec, const size_t i, const void *src);
 
-// TODO: See what happens when `new_capacity` < `old_capacity`
-
 /// Resizes the vector.
 ///
+/// Shrinking below the length of the vector drops the trailing elements,
+/// and a capacity of zero releases the storage altogether.
+///
 /// @param[in]  sim           Simulation context, can be NULL.
 /// @param[in]  vec           Vector to resize.
 /// @param[in]  new_capacity  New capacity for the vector.
 lion_status_t lion_vector_resize(lion_sim_t *sim, lion_vector_t *vec, const size_t new_capacity);
 
+/// Makes room for at least `additional` more elements.
+///
+/// Capacity grows geometrically, at least doubling on every reallocation,
+/// so a sequence of pushes or extensions costs amortized constant time
+/// per element.
+///
+/// @param[in]  sim           Simulation context, can be NULL.
+/// @param[in]  vec           Vector to grow.
+/// @param[in]  additional    Number of elements that must fit after the current ones.
+lion_status_t lion_vector_reserve(lion_sim_t *sim, lion_vector_t *vec, const size_t additional);
+
+/// Releases the capacity beyond the length of the vector.
+///
+/// @param[in]  sim           Simulation context, can be NULL.
+/// @param[in]  vec           Vector to shrink.
+lion_status_t lion_vector_shrink_to_fit(lion_sim_t *sim, lion_vector_t *vec);
+
 /// Pushes an element into the vector.
 ///
 /// @param[in]  sim           Simulation context, can be NULL.
@@ -172,6 +207,66 @@ size_t lion_vector_total_size(lion_sim_t *sim, const lion_vector_t *vec);
 /// @param[in]  vec           Vector to fetch.
 size_t lion_vector_alloc_size(lion_sim_t *sim, const lion_vector_t *vec);
 
+/* Vector views */
+
+/// View over the whole vector.
+///
+/// @param[in]  sim           Simulation context, can be NULL.
+/// @param[in]  vec           Vector of doubles.
+/// @param[out] out           View over every element.
+lion_status_t lion_vector_view_d(lion_sim_t *sim, const lion_vector_t *vec, lion_vector_view_d_t *out);
+lion_status_t lion_vector_view_f(lion_sim_t *sim, const lion_vector_t *vec, lion_vector_view_f_t *out);
+
+/// View over a range of the vector, without copying.
+///
+/// @param[in]  sim           Simulation context, can be NULL.
+/// @param[in]  vec           Vector of doubles.
+/// @param[in]  start         Index of the first element.
+/// @param[in]  len           Number of elements.
+/// @param[out] out           View over the range.
+lion_status_t lion_vector_slice_d(lion_sim_t *sim, const lion_vector_t *vec, const size_t start, const size_t len, lion_vector_view_d_t *out);
+lion_status_t lion_vector_slice_f(lion_sim_t *sim, const lion_vector_t *vec, const size_t start, const size_t len, lion_vector_view_f_t *out);
+
+/// Sets every element of the view to a value.
+void lion_vector_fill_d(lion_sim_t *sim, lion_vector_view_d_t x, double value);
+
+/// Multiplies every element of the view by a value.
+void lion_vector_scale_d(lion_sim_t *sim, lion_vector_view_d_t x, double alpha);
+
+/// Computes `y = alpha * x + y` element-wise.
+///
+/// @param[in]  sim           Simulation context, can be NULL.
+/// @param[in]  alpha         Scale of `x`.
+/// @param[in]  x             Input view.
+/// @param[in]  y             View updated in place, same length as `x`.
+lion_status_t lion_vector_axpy_d(lion_sim_t *sim, double alpha, lion_vector_view_d_t x, lion_vector_view_d_t y);
+
+/// Applies a function to every element, `out[i] = fn(x[i], ctx)`.
+///
+/// @param[in]  sim           Simulation context, can be NULL.
+/// @param[in]  fn            Function to apply.
+/// @param[in]  ctx           Context passed to every call, can be NULL.
+/// @param[in]  x             Input view.
+/// @param[in]  out           Output view, same length as `x`. Can be `x` itself.
+lion_status_t lion_vector_map_d(lion_sim_t *sim, double (*fn)(double, void *), void *ctx, lion_vector_view_d_t x, lion_vector_view_d_t out);
+
+/// Sum of the elements, zero for an empty view.
+double lion_vector_sum_d(lion_sim_t *sim, lion_vector_view_d_t x);
+
+/// Smallest element, NaN for an empty view.
+double lion_vector_min_d(lion_sim_t *sim, lion_vector_view_d_t x);
+
+/// Largest element, NaN for an empty view.
+double lion_vector_max_d(lion_sim_t *sim, lion_vector_view_d_t x);
+
+/// Dot product of two views.
+///
+/// @param[in]  sim           Simulation context, can be NULL.
+/// @param[in]  x             First view.
+/// @param[in]  y             Second view, same length as `x`.
+/// @param[out] out           Dot product.
+lion_status_t lion_vector_dot_d(lion_sim_t *sim, lion_vector_view_d_t x, lion_vector_view_d_t y, double *out);
+
 /// @}
 
 #ifdef __cplusplus
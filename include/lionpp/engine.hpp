@@ -0,0 +1,451 @@
+/// @file
+/// @brief Header-only simulation engine specialized at compile time.
+///
+/// `lion::Engine` takes the internal resistance model, the degradation model and
+/// the stepper as template parameters, so that the whole step (update, current
+/// solve, right hand side and Jacobian) gets inlined into a single specialized
+/// loop. The model equations are the same as the ones in `lion_math`, but they
+/// operate on parameter structs held by value instead of dispatching on the
+/// model enums of `lion_params_t`.
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <lion/params.h>
+#include <lion/sim.h>
+#include <lionpp/status.hpp>
+#include <span>
+#include <stdexcept>
+
+namespace lion {
+
+/// Inline versions of the `lion_math` model equations.
+namespace model {
+
+inline constexpr double current_optmin = -1e3; ///< Lower bound for the current, same as `LION_CURRENT_OPTMIN`.
+inline constexpr double current_optmax = 1e3;  ///< Upper bound for the current, same as `LION_CURRENT_OPTMAX`.
+
+inline double kappa(double internal_temperature, lion_params_vft_t const &p) {
+  double left  = p.k1 / (internal_temperature - p.k2);
+  double right = p.k1 / (p.tref - p.k2);
+  return std::exp(left - right);
+}
+
+inline double kappa_grad(double internal_temperature, lion_params_vft_t const &p) {
+  double delta = internal_temperature - p.k2;
+  return -p.k1 / (delta * delta) * kappa(internal_temperature, p);
+}
+
+constexpr double soc_usable(double soc, double kappa) { return 1.0 + (soc - 1.0) / kappa; }
+
+constexpr double capacity_usable(double capacity, double kappa) { return kappa * capacity; }
+
+constexpr double capacity_nominal(double capacity, double soh) { return soh * capacity; }
+
+inline double ehc(double soc, lion_params_ehc_t const &p) {
+  constexpr double sqrt1_2 = 0.70710678118654752440;
+  constexpr double sqrtpi  = 1.77245385090551602730;
+
+  double delta       = soc - p.mu;
+  double exp_term    = -(delta * delta) / (2.0 * p.sigma * p.sigma);
+  double first_term  = std::exp(exp_term) * sqrt1_2 / (sqrtpi * p.sigma);
+  double second_term = p.l * std::exp(-p.kappa * soc);
+  return p.a * (first_term - second_term) + p.b;
+}
+
+inline double voc(double soc, lion_params_ocv_t const &p) {
+  double term1 = (p.v0 - p.vl) * std::exp(p.gamma * (soc - 1.0));
+  double term2 = p.alpha * p.vl * (soc - 1.0);
+  double term3 = (1.0 - p.alpha) * p.vl * (std::exp(-p.beta) - std::exp(-p.beta * std::sqrt(soc)));
+  return p.vl + term1 + term2 + term3;
+}
+
+inline double voc_grad(double soc, lion_params_ocv_t const &p) {
+  double sqrt_soc = std::sqrt(soc);
+  double term1    = p.gamma * (p.v0 - p.vl) * std::exp(p.gamma * (soc - 1.0));
+  double term2    = p.alpha * p.vl;
+  double term3    = (1.0 - p.alpha) * p.vl * p.beta * std::exp(-p.beta * sqrt_soc) / (2.0 * sqrt_soc);
+  return term1 + term2 + term3;
+}
+
+inline double current(double power, double open_circuit_voltage, double internal_resistance) {
+  double half = open_circuit_voltage / (2.0 * internal_resistance);
+  return half - std::sqrt(half * half - power / internal_resistance);
+}
+
+inline double current_grad_voc(double power, double open_circuit_voltage, double internal_resistance) {
+  double half = open_circuit_voltage / (2.0 * internal_resistance);
+  double term = open_circuit_voltage / (4.0 * internal_resistance * internal_resistance);
+  return 1.0 / (2.0 * internal_resistance) - term / std::sqrt(half * half - power / internal_resistance);
+}
+
+constexpr double generated_heat(double current, double internal_temperature, double internal_resistance, double ehc) {
+  double qgen = internal_resistance * current * current - current * internal_temperature * ehc;
+  return (qgen > 0.0) ? qgen : 0.0;
+}
+
+constexpr double internal_temperature_d(double internal_temperature, double heat, double ambient_temperature, lion_params_temp_t const &p) {
+  return ((ambient_temperature - internal_temperature) / (p.rin + p.rout) + heat) / p.cp;
+}
+
+constexpr double surface_temperature(double internal_temperature, double ambient_temperature, lion_params_temp_t const &p) {
+  double rt = p.rin + p.rout;
+  return internal_temperature * p.rout / rt + ambient_temperature * p.rin / rt;
+}
+
+} // namespace model
+
+/// Internal resistance models.
+namespace rint {
+
+/// Fixed internal resistance, the current can be solved in closed form.
+struct Fixed {
+  static constexpr bool current_dependent = false;
+
+  lion_params_rint_fixed_t p;
+
+  constexpr double operator()(double soc, double current, double soh) const { return p.internal_resistance / soh; }
+
+  static Fixed from(lion_params_rint_t const &params) {
+    if (params.model != LION_RINT_MODEL_FIXED) {
+      throw std::invalid_argument("Expected fixed internal resistance model");
+    }
+    return Fixed{params.params.fixed};
+  }
+};
+
+/// Current and state of charge dependent internal resistance, solved iteratively.
+struct Polarization {
+  static constexpr bool current_dependent = true;
+
+  lion_params_rint_polarization_t p;
+
+  double operator()(double soc, double current, double soh) const {
+    double memberships[LION_FUZZY_SETS_COUNT] = {
+      sigmoid(current, p.c40),
+      gaussian(current, p.c20),
+      gaussian(current, p.c10),
+      gaussian(current, p.c4),
+      gaussian(current, p.d5),
+      gaussian(current, p.d10),
+      gaussian(current, p.d15),
+      sigmoid(current, p.d30),
+    };
+
+    double num = 0.0;
+    double den = 0.0;
+    for (std::size_t i = 0; i < LION_FUZZY_SETS_COUNT; i++) {
+      double poly = 0.0;
+      double x    = 1.0;
+      for (std::size_t j = 0; j < LION_FUZZY_SETS_DEGREE; j++) {
+        poly += p.poly[i][j] * x;
+        x    *= soc;
+      }
+      num += memberships[i] * poly;
+      den += memberships[i];
+    }
+    return num / den / soh;
+  }
+
+  static Polarization from(lion_params_rint_t const &params) {
+    if (params.model != LION_RINT_MODEL_POLARIZATION) {
+      throw std::invalid_argument("Expected polarization internal resistance model");
+    }
+    return Polarization{params.params.polarization};
+  }
+
+private:
+  static double gaussian(double x, lion_mf_gaussian_params_t const &mf) {
+    double delta = x - mf.mean;
+    return std::exp(-0.5 * delta * delta / (mf.sigma * mf.sigma));
+  }
+
+  static double sigmoid(double x, lion_mf_sigmoid_params_t const &mf) { return 1.0 / (1.0 + std::exp(-mf.a * (x - mf.c))); }
+};
+
+} // namespace rint
+
+/// Degradation models.
+namespace soh {
+
+/// Degradation is ignored, useful for short horizons.
+struct Frozen {
+  constexpr double next(double soh, double soc_mean, double soc_max, double soc_min, double internal_temperature) const { return soh; }
+};
+
+/// Simple vendor model, with the per-cycle rate computed once.
+struct Vendor {
+  double rate; ///< Degradation rate per cycle.
+
+  static Vendor from(lion_params_soh_vendor_t const &p) { return Vendor{std::exp(std::log(p.final_soh) / static_cast<double>(p.total_cycles))}; }
+
+  static Vendor from(lion_params_soh_t const &params) {
+    if (params.model != LION_SOH_MODEL_VENDOR) {
+      throw std::invalid_argument("Expected vendor degradation model");
+    }
+    return from(params.params.vendor);
+  }
+
+  constexpr double next(double soh, double soc_mean, double soc_max, double soc_min, double internal_temperature) const { return rate * soh; }
+};
+
+} // namespace soh
+
+/// Steppers for the two-state cell system.
+///
+/// Each stepper advances `y = {soc, internal_temperature}` through one step of
+/// size `h`, given the right hand side `f(y, dydt)` and, for implicit steppers,
+/// the Jacobian `jac(y, dfdy)` in row-major order.
+namespace stepper {
+
+/// Explicit Euler.
+struct Euler {
+  template <class F, class J> static void step(F const &f, J const &, double h, double y[2]) {
+    double k[2];
+    f(y, k);
+    y[0] += h * k[0];
+    y[1] += h * k[1];
+  }
+};
+
+/// Explicit Runge-Kutta 4.
+struct RK4 {
+  template <class F, class J> static void step(F const &f, J const &, double h, double y[2]) {
+    double k1[2], k2[2], k3[2], k4[2], yt[2];
+    f(y, k1);
+    yt[0] = y[0] + 0.5 * h * k1[0];
+    yt[1] = y[1] + 0.5 * h * k1[1];
+    f(yt, k2);
+    yt[0] = y[0] + 0.5 * h * k2[0];
+    yt[1] = y[1] + 0.5 * h * k2[1];
+    f(yt, k3);
+    yt[0] = y[0] + h * k3[0];
+    yt[1] = y[1] + h * k3[1];
+    f(yt, k4);
+    y[0] += h / 6.0 * (k1[0] + 2.0 * k2[0] + 2.0 * k3[0] + k4[0]);
+    y[1] += h / 6.0 * (k1[1] + 2.0 * k2[1] + 2.0 * k3[1] + k4[1]);
+  }
+};
+
+/// Implicit Euler, solved with Newton iterations on the analytical Jacobian.
+template <int Iterations = 3> struct ImplicitEuler {
+  template <class F, class J> static void step(F const &f, J const &jac, double h, double y[2]) {
+    double y0[2] = {y[0], y[1]};
+    double k[2], m[4];
+    for (int i = 0; i < Iterations; i++) {
+      f(y, k);
+      jac(y, m);
+      // Solve (I - h J) dy = y0 + h f(y) - y
+      double a   = 1.0 - h * m[0];
+      double b   = -h * m[1];
+      double c   = -h * m[2];
+      double d   = 1.0 - h * m[3];
+      double r0  = y0[0] + h * k[0] - y[0];
+      double r1  = y0[1] + h * k[1] - y[1];
+      double det = a * d - b * c;
+      y[0]      += (d * r0 - b * r1) / det;
+      y[1]      += (a * r1 - c * r0) / det;
+    }
+  }
+};
+
+} // namespace stepper
+
+/// Cell parameters that do not depend on the model choice.
+struct CellParams {
+  lion_params_init_t init;
+  lion_params_ehc_t  ehc;
+  lion_params_ocv_t  ocv;
+  lion_params_vft_t  vft;
+  lion_params_temp_t temp;
+
+  static constexpr CellParams from(lion_params_t const &params) { return CellParams{params.init, params.ehc, params.ocv, params.vft, params.temp}; }
+};
+
+/// Solver settings, mirroring the relevant fields of `lion_sim_config_t`.
+struct EngineConfig {
+  double   step_seconds; ///< Time of each simulation step in seconds.
+  double   epsabs;       ///< Absolute epsilon for the current solve.
+  double   epsrel;       ///< Relative epsilon for the current solve.
+  uint64_t maxiter;      ///< Maximum iterations of the current solve.
+
+  static constexpr EngineConfig from(lion_sim_config_t const &conf) {
+    return EngineConfig{conf.sim_step_seconds, conf.sim_epsabs, conf.sim_epsrel, conf.sim_min_maxiter};
+  }
+};
+
+/// Simulation engine specialized for a given set of models.
+///
+/// The state is kept as a `lion_sim_state_t` with the same update logic as
+/// `lion_sim_step`, so results can be compared directly with the C runtime.
+/// @tparam Rint     Internal resistance model, e.g. `rint::Fixed`.
+/// @tparam Soh      Degradation model, e.g. `soh::Vendor`.
+/// @tparam Stepper  Stepper used for the ode system, e.g. `stepper::RK4`.
+template <class Rint, class Soh, class Stepper> class Engine {
+public:
+  constexpr Engine(EngineConfig conf, CellParams cell, Rint rint, Soh soh) : conf_(conf), cell_(cell), rint_(rint), soh_(soh), state_() { reset(); }
+
+  /// Build an engine from the C configuration, checking the models match.
+  static Engine from(lion_sim_config_t const &conf, lion_params_t const &params) {
+    return Engine(EngineConfig::from(conf), CellParams::from(params), Rint::from(params.rint), Soh::from(params.soh));
+  }
+
+  /// Reset the state to the initial conditions.
+  constexpr void reset() {
+    state_                            = lion_sim_state_t{};
+    state_._next_soc_nominal          = cell_.init.soc;
+    state_._next_internal_temperature = cell_.init.temp_in;
+    state_._soc_min                   = 1.0;
+    state_.soh                        = cell_.init.soh;
+    state_.current                    = cell_.init.current_guess;
+  }
+
+  /// Step the simulation forward, same semantics as `lion_sim_step`.
+  /// @return `Status::FAILURE` when the outputs or the next states are not finite, in which case
+  ///         the state is left as it was before the step.
+  Status step(double power, double ambient_temperature) {
+    lion_sim_state_t s = state_;
+
+    s.soc_nominal          = s._next_soc_nominal;
+    s.internal_temperature = s._next_internal_temperature;
+    s.power                = power;
+    s.ambient_temperature  = ambient_temperature;
+    update(s);
+    if (!std::isfinite(s.current) || !std::isfinite(s.voltage) || !std::isfinite(s.generated_heat)) {
+      return Status::FAILURE;
+    }
+
+    double y[2] = {s.soc_nominal, s.internal_temperature};
+    auto   f    = [this, &s](double const *x, double *dxdt) { rhs(s, x, dxdt); };
+    auto   jac  = [this, &s](double const *x, double *dfdx) { jacobian(s, x, dfdx); };
+    Stepper::step(f, jac, conf_.step_seconds, y);
+    if (!std::isfinite(y[0]) || !std::isfinite(y[1])) {
+      return Status::FAILURE;
+    }
+    s.time                      += conf_.step_seconds;
+    s._next_soc_nominal          = y[0];
+    s._next_internal_temperature = y[1];
+
+    // Degradation bookkeeping, same as `lion_sim_step`
+    s._soc_mean = (static_cast<double>(s._cycle_step) * s._soc_mean + s.soc_nominal) / static_cast<double>(s._cycle_step + 1);
+    if (s.soc_nominal > s._soc_max)
+      s._soc_max = s.soc_nominal;
+    if (s.soc_nominal < s._soc_min)
+      s._soc_min = s.soc_nominal;
+
+    double discharge  = s.current * conf_.step_seconds;
+    s._acc_discharge += (discharge > 0.0) ? discharge : 0.0;
+    if (s._acc_discharge >= s.capacity_nominal) {
+      s._acc_discharge = std::fmod(s._acc_discharge, s.capacity_nominal);
+      s.soh            = soh_.next(s.soh, s._soc_mean, s._soc_max, s._soc_min, s.internal_temperature);
+      s._soc_mean      = 0.0;
+      s._soc_max       = 0.0;
+      s._soc_min       = 1.0;
+      s._cycle_step    = 0;
+      s.cycle++;
+    } else {
+      s._cycle_step++;
+    }
+    s.step++;
+    state_ = s;
+    return Status::SUCCESS;
+  }
+
+  /// Run over a whole profile, skipping the first sample like `lion_sim_run`.
+  Status run(std::span<double const> power, std::span<double const> ambient_temperature) {
+    std::size_t max_iters = (power.size() < ambient_temperature.size()) ? power.size() : ambient_temperature.size();
+    for (std::size_t i = 1; i < max_iters; i++) {
+      if (step(power[i], ambient_temperature[i]) != Status::SUCCESS) {
+        return Status::FAILURE;
+      }
+    }
+    return Status::SUCCESS;
+  }
+
+  constexpr lion_sim_state_t const &state() const { return state_; }
+  constexpr CellParams const       &cell() const { return cell_; }
+  constexpr Rint const             &rint() const { return rint_; }
+  constexpr Soh const              &soh() const { return soh_; }
+
+private:
+  EngineConfig     conf_;
+  CellParams       cell_;
+  Rint             rint_;
+  Soh              soh_;
+  lion_sim_state_t state_;
+
+  void update(lion_sim_state_t &s) const {
+    s.kappa                    = model::kappa(s.internal_temperature, cell_.vft);
+    s.capacity_nominal         = model::capacity_nominal(cell_.init.capacity, s.soh);
+    s.soc_use                  = model::soc_usable(s.soc_nominal, s.kappa);
+    s.capacity_use             = model::capacity_usable(s.capacity_nominal, s.kappa);
+    s.ehc                      = model::ehc(s.soc_use, cell_.ehc);
+    s.ref_open_circuit_voltage = model::voc(s.soc_use, cell_.ocv);
+    s.open_circuit_voltage     = s.ref_open_circuit_voltage + s.ehc * (s.internal_temperature - cell_.vft.tref);
+    s.current                  = solve_current(s.power, s.soc_use, s.open_circuit_voltage, s.current);
+    s.internal_resistance      = rint_(s.soc_use, s.current, s.soh);
+    s.voltage                  = (s.current != 0.0) ? s.power / s.current : s.open_circuit_voltage;
+    s.generated_heat           = model::generated_heat(s.current, s.internal_temperature, s.internal_resistance, s.ehc);
+    s.surface_temperature      = model::surface_temperature(s.internal_temperature, s.ambient_temperature, cell_.temp);
+  }
+
+  double solve_current(double power, double soc, double open_circuit_voltage, double guess) const {
+    // The current fixed point is evaluated with unit state of health, same as
+    // `lion_current_optimize_targetfn`
+    if constexpr (!Rint::current_dependent) {
+      // Past the maximum power point the power cannot be delivered, and the
+      // current is held at the point instead
+      double r    = rint_(soc, guess, 1.0);
+      double half = open_circuit_voltage / (2.0 * r);
+      return (half * half - power / r >= 0.0) ? model::current(power, open_circuit_voltage, r) : half;
+    } else {
+      // Secant iterations on g(I) = I - f(I)
+      auto   g  = [&](double i) { return i - model::current(power, open_circuit_voltage, rint_(soc, i, 1.0)); };
+      double x0 = guess;
+      double g0 = g(x0);
+      double x1 = x0 - g0;
+      for (uint64_t iter = 0; iter < conf_.maxiter; iter++) {
+        double g1 = g(x1);
+        if (g1 == g0) {
+          break;
+        }
+        double x2 = x1 - g1 * (x1 - x0) / (g1 - g0);
+        x2        = (x2 < model::current_optmin) ? model::current_optmin : ((x2 > model::current_optmax) ? model::current_optmax : x2);
+        x0        = x1;
+        g0        = g1;
+        x1        = x2;
+        if (std::fabs(x1 - x0) < conf_.epsabs + conf_.epsrel * std::fabs(x1)) {
+          break;
+        }
+      }
+      return x1;
+    }
+  }
+
+  void rhs(lion_sim_state_t const &s, double const *y, double *dydt) const {
+    dydt[0] = -s.current / s.capacity_use;
+    dydt[1] = model::internal_temperature_d(y[1], s.generated_heat, s.ambient_temperature, cell_.temp);
+  }
+
+  void jacobian(lion_sim_state_t const &s, double const *y, double *dfdy) const {
+    // Same expressions as `lion_slv_jac_analytical`
+    double di_dvoc   = model::current_grad_voc(s.power, s.open_circuit_voltage, s.internal_resistance);
+    double dvoc_dsoc = model::voc_grad(s.soc_use, cell_.ocv);
+    double dkappa    = model::kappa_grad(s.internal_temperature, cell_.vft);
+    double rt        = cell_.temp.rin + cell_.temp.rout;
+
+    double numl = s.capacity_use * di_dvoc * dvoc_dsoc * s.soc_nominal * dkappa;
+    double numr = s.current * s.capacity_nominal * dkappa;
+
+    dfdy[0] = -di_dvoc * dvoc_dsoc * s.kappa / s.capacity_use;
+    dfdy[1] = (numl - numr) / (s.capacity_use * s.capacity_use);
+    dfdy[2] = (2.0 * s.internal_resistance * s.current - s.internal_temperature * s.ehc) * di_dvoc * dvoc_dsoc * s.kappa / cell_.temp.cp;
+    dfdy[3] = -1.0 / (cell_.temp.cp * rt) - s.ehc / cell_.temp.cp;
+  }
+};
+
+/// Engine with the default models of `lion_params_default`.
+using DefaultEngine = Engine<rint::Fixed, soh::Vendor, stepper::RK4>;
+
+} // namespace lion
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "engine.hpp"
 #include "sim.hpp"
 #include "status.hpp"
 #include "vector.hpp"
@@ -12,20 +12,29 @@ enum SimRegime {
   BOTH    = LION_BOTH,
 };
 
+enum SimInputMode {
+  INPUT_POWER   = LION_INPUT_POWER,
+  INPUT_CURRENT = LION_INPUT_CURRENT,
+  INPUT_VOLTAGE = LION_INPUT_VOLTAGE,
+};
+
 class SimStepper {
 public:
   enum Value {
-    RK2     = LION_STEPPER_RK2,
-    RK4     = LION_STEPPER_RK4,
-    RKF45   = LION_STEPPER_RKF45,
-    RKCK    = LION_STEPPER_RKCK,
-    RK8PD   = LION_STEPPER_RK8PD,
-    RK1IMP  = LION_STEPPER_RK1IMP,
-    RK2IMP  = LION_STEPPER_RK2IMP,
-    RK4IMP  = LION_STEPPER_RK4IMP,
-    BSIMP   = LION_STEPPER_BSIMP,
-    MSADAMS = LION_STEPPER_MSADAMS,
-    MSBDF   = LION_STEPPER_MSBDF,
+    RK2         = LION_STEPPER_RK2,
+    RK4         = LION_STEPPER_RK4,
+    RKF45       = LION_STEPPER_RKF45,
+    RKCK        = LION_STEPPER_RKCK,
+    RK8PD       = LION_STEPPER_RK8PD,
+    RK1IMP      = LION_STEPPER_RK1IMP,
+    RK2IMP      = LION_STEPPER_RK2IMP,
+    RK4IMP      = LION_STEPPER_RK4IMP,
+    BSIMP       = LION_STEPPER_BSIMP,
+    MSADAMS     = LION_STEPPER_MSADAMS,
+    MSBDF       = LION_STEPPER_MSBDF,
+    NATIVE_RK4  = LION_STEPPER_NATIVE_RK4,
+    NATIVE_RK45 = LION_STEPPER_NATIVE_RK45,
+    NATIVE_ROS2 = LION_STEPPER_NATIVE_ROS2,
   };
 
   SimStepper() = default;
@@ -91,8 +100,11 @@ public:
   operator lion_sim_t *();
 
   Status   step(double power, double amb_temp);
+  Status   step(SimInputMode mode, double value, double amb_temp);
+  Status   jump(double power, double amb_temp, uint64_t steps);
   Status   run(std::vector<double> const &power, std::vector<double> const &amb_temp);
   bool     should_close() const;
+  void     cancel();
   uint64_t max_iters() const;
 
 private:
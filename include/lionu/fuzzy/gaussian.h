@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -10,6 +12,8 @@ typedef struct lion_mf_gaussian_params {
 } lion_mf_gaussian_params_t;
 
 double lion_mf_gaussian(double x, lion_mf_gaussian_params_t *params);
+void   lion_mf_gaussian_batch(const double *x, size_t count, lion_mf_gaussian_params_t *params, double *out);
+void   lion_mf_gaussian_batch_f(const float *x, size_t count, lion_mf_gaussian_params_t *params, float *out);
 
 #ifdef __cplusplus
 }
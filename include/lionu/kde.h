@@ -24,3 +24,4 @@ lion_status_t lion_gaussian_kde_init(double *data, size_t len, lion_gaussian_kde
 lion_status_t lion_gaussian_kde_cleanup(lion_gaussian_kde_t *kde);
 
 double lion_gaussian_kde_sample(const lion_gaussian_kde_t *kde);
+double lion_gaussian_kde_sample_rng(const lion_gaussian_kde_t *kde, gsl_rng *rng);
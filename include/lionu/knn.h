@@ -20,7 +20,6 @@ typedef struct lion_knn_regressor {
   size_t               n_neighbors;
   int                  is_trained;
   lion_knn_sample_t   *_dataset;
-  lion_knn_neighbor_t *_neighbors;
   size_t               _n_samples;
 } lion_knn_regressor_t;
 
@@ -28,4 +27,4 @@ lion_status_t lion_knn_regressor_init(lion_sim_t *sim, size_t n_neighbors, lion_
 lion_status_t lion_knn_regressor_cleanup(lion_sim_t *sim, lion_knn_regressor_t *out);
 
 lion_status_t lion_knn_regressor_fit(lion_sim_t *sim, lion_knn_regressor_t *knn, lion_knn_sample_t *dataset, size_t n_samples);
-double        lion_knn_regressor_predict(lion_sim_t *sim, lion_knn_regressor_t *knn, lion_vector_t *X);
+double        lion_knn_regressor_predict(lion_sim_t *sim, const lion_knn_regressor_t *knn, lion_vector_t *X);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Packed math over arrays of doubles and floats. Every function reads
+// `count` values from `vals` and writes the results to `out`, which may
+// alias `vals`. The kernels are picked at runtime from the instruction sets
+// the CPU supports, falling back to libm one value at a time. The vector
+// kernels keep these error bounds against the correctly rounded result:
+//   lion_vexp      1 ULP
+//   lion_vexpm1    2 ULP
+//   lion_vsqrt     correctly rounded
+//   lion_vsigmoid  3 ULP, computing 1 / (1 + exp(-x))
+// The single precision versions, with an `f` suffix, keep these bounds in
+// units of the last place of a float:
+//   lion_vexpf      1.5 ULP
+//   lion_vsqrtf     correctly rounded
+//   lion_vsigmoidf  3 ULP
+// Overflow, underflow and NaN behave as in libm.
+
+typedef enum lion_vmath_backend {
+  LION_VMATH_AUTO = 0, // Best backend supported by the CPU
+  LION_VMATH_SCALAR,
+  LION_VMATH_AVX2,
+  LION_VMATH_AVX512,
+} lion_vmath_backend_t;
+
+void lion_vexp(const double *vals, size_t count, double *out);
+void lion_vexpm1(const double *vals, size_t count, double *out);
+void lion_vsqrt(const double *vals, size_t count, double *out);
+void lion_vsigmoid(const double *vals, size_t count, double *out);
+void lion_vexpf(const float *vals, size_t count, float *out);
+void lion_vsqrtf(const float *vals, size_t count, float *out);
+void lion_vsigmoidf(const float *vals, size_t count, float *out);
+
+// Backend in use, never LION_VMATH_AUTO
+lion_vmath_backend_t lion_vmath_backend(void);
+const char          *lion_vmath_backend_name(lion_vmath_backend_t backend);
+// Forces a backend, returns 0 without changing it when the CPU does not
+// support it. Meant for testing and benchmarking
+int lion_vmath_set_backend(lion_vmath_backend_t backend);
+
+#ifdef __cplusplus
+}
+#endif
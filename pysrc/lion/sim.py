@@ -407,6 +407,15 @@ class Sim:
             self.init()
         ffi_call(_lionl.lion_sim_step(self._cdata, power, amb_temp), "Failed stepping")
 
+    def jump(self, power: float, amb_temp: float, steps: int):
+        if not self._initialized:
+            LOGGER.warn("Auto-initializing before jump")
+            self.init()
+        ffi_call(
+            _lionl.lion_sim_jump(self._cdata, power, amb_temp, steps),
+            "Failed jumping",
+        )
+
     def run(self, power: Vectorizable, amb_temp: Vectorizable):
         try:
             power = Vector.new(power, dtypes.FLOAT64)
@@ -27,6 +27,9 @@ class Stepper(Enum):
     BSIMP = _lionl.LION_STEPPER_BSIMP
     MSADAMS = _lionl.LION_STEPPER_MSADAMS
     MSBDF = _lionl.LION_STEPPER_MSBDF
+    NATIVE_RK4 = _lionl.LION_STEPPER_NATIVE_RK4
+    NATIVE_RK45 = _lionl.LION_STEPPER_NATIVE_RK45
+    NATIVE_ROS2 = _lionl.LION_STEPPER_NATIVE_ROS2
 
 
 class Minimizer(Enum):
@@ -327,6 +327,20 @@ class Vector:
             "Failed resizing",
         )
 
+    def reserve(self, additional: int) -> None:
+        """Make room for at least `additional` more elements"""
+        ffi_call(
+            _lionl.lion_vector_reserve(self._sim, self._cdata, additional),
+            "Failed reserving",
+        )
+
+    def shrink_to_fit(self) -> None:
+        """Release the capacity beyond the length of this vector"""
+        ffi_call(
+            _lionl.lion_vector_shrink_to_fit(self._sim, self._cdata),
+            "Failed shrinking",
+        )
+
     def push(self, element) -> None:
         """Push an element into the vector"""
         val = ffi.new(f"{self._dtype.long_name} *")
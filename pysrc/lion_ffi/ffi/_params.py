@@ -1,7 +1,9 @@
 CTYPEDEF = """
-#define LION_FUZZY_SETS_COUNT 8
-#define LION_FUZZY_SETS_DEGREE 4
-#define LION_SOH_TABLE_COUNT   11
+#define LION_FUZZY_SETS_COUNT   8
+#define LION_FUZZY_SETS_DEGREE  4
+#define LION_SOH_TABLE_COUNT    11
+#define LION_SOH_TEMP_POLYCOUNT 7
+#define LION_RC_MAX_BRANCHES    3
 
 typedef struct lion_params_init {
   double soc;
@@ -76,21 +78,57 @@ typedef enum lion_soh_model {
   LION_SOH_MODEL_MASSERANO,
 } lion_soh_model_t;
 
-typedef struct lion_params_degradation_element {
-  double max;
-  double min;
-  double coeff;
-} lion_params_degradation_element_t;
-
 typedef struct lion_params_soh_vendor {
   uint64_t total_cycles;
   double   final_soh;
 } lion_params_soh_vendor_t;
 
+typedef enum lion_gaussian_kde_bwmethod {
+  LION_GAUSSIAN_KDE_SCOTT,
+  LION_GAUSSIAN_KDE_SILVERMAN,
+} lion_gaussian_kde_bwmethod_t;
+
+typedef struct lion_gaussian_kde {
+  double  *data;
+  size_t   len;
+  double   variance;
+  double   std;
+  gsl_rng *rng;
+  int      is_trained;
+} lion_gaussian_kde_t;
+
+typedef struct lion_knn_sample {
+  lion_vector_t X;
+  double        y;
+} lion_knn_sample_t;
+
+typedef struct lion_knn_regressor {
+  size_t             n_neighbors;
+  int                is_trained;
+  lion_knn_sample_t *_dataset;
+  size_t             _n_samples;
+} lion_knn_regressor_t;
+
 typedef struct lion_params_soh_masserano {
-  uint64_t                          total_cycles;
-  double                            final_soh;
-  lion_params_degradation_element_t table[LION_SOH_TABLE_COUNT];
+  uint64_t nominal_cycles;
+  double   nominal_sr;
+  double   nominal_final_soh;
+  double   eq_cycles;
+  double   eq_final_soh;
+  double   eq_sr;
+  double   temp_poly[LION_SOH_TEMP_POLYCOUNT];
+  double   x_table[LION_SOH_TABLE_COUNT][3];
+  double   y_table[LION_SOH_TABLE_COUNT];
+  struct {
+    lion_vector_t                eta_values;
+    lion_gaussian_kde_bwmethod_t bw_method;
+  } kde_params;
+  struct {
+    lion_vector_t X;
+    lion_vector_t y;
+  } knn_params;
+  lion_gaussian_kde_t  kde;
+  lion_knn_regressor_t knn;
 } lion_params_soh_masserano_t;
 
 typedef struct lion_params_soh {
@@ -101,6 +139,20 @@ typedef struct lion_params_soh {
   } params;
 } lion_params_soh_t;
 
+typedef struct lion_params_rc {
+  uint32_t n_branches;
+  double   resistance[LION_RC_MAX_BRANCHES];
+  double   capacitance[LION_RC_MAX_BRANCHES];
+} lion_params_rc_t;
+
+typedef struct lion_params_calendar {
+  double rate;
+  double activation_energy;
+  double reference_temperature;
+  double soc_sensitivity;
+  double reference_soc;
+} lion_params_calendar_t;
+
 typedef struct lion_params {
   lion_params_init_t init;
   lion_params_ehc_t ehc;
@@ -108,6 +160,9 @@ typedef struct lion_params {
   lion_params_vft_t vft;
   lion_params_temp_t temp;
   lion_params_rint_t rint;
+  lion_params_soh_t soh;
+  lion_params_rc_t rc;
+  lion_params_calendar_t calendar;
 } lion_params_t;
 """
 
@@ -121,6 +176,10 @@ lion_params_temp_t              lion_params_default_temp(void);
 lion_params_rint_fixed_t        lion_params_default_rint_fixed(void);
 lion_params_rint_polarization_t lion_params_default_rint_polarization(void);
 lion_params_rint_t              lion_params_default_rint(void);
+lion_params_soh_vendor_t        lion_params_default_soh_vendor(void);
+lion_params_soh_masserano_t     lion_params_default_soh_masserano(void);
 lion_params_soh_t               lion_params_default_soh(void);
+lion_params_rc_t                lion_params_default_rc(void);
+lion_params_calendar_t          lion_params_default_calendar(void);
 lion_params_t                   lion_params_default(void);
 """
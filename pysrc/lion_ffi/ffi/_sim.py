@@ -19,6 +19,9 @@ typedef enum lion_stepper {
   LION_STEPPER_BSIMP,
   LION_STEPPER_MSADAMS,
   LION_STEPPER_MSBDF,
+  LION_STEPPER_NATIVE_RK4,
+  LION_STEPPER_NATIVE_RK45,
+  LION_STEPPER_NATIVE_ROS2,
 } lion_stepper_t;
 
 typedef enum lion_minimizer {
@@ -32,6 +35,23 @@ typedef enum lion_jacobian_method {
   LION_JACOBIAN_2POINT,
 } lion_jacobian_method_t;
 
+typedef enum lion_input_mode {
+  LION_INPUT_POWER,
+  LION_INPUT_CURRENT,
+  LION_INPUT_VOLTAGE,
+} lion_input_mode_t;
+
+typedef enum lion_input_hold {
+  LION_HOLD_ZERO,
+  LION_HOLD_FIRST,
+} lion_input_hold_t;
+
+typedef enum lion_jump {
+  LION_JUMP_NONE,
+  LION_JUMP_REST,
+  LION_JUMP_CONSTANT,
+} lion_jump_t;
+
 extern "Python" lion_status_t init_pythoncb(lion_sim_t *);
 extern "Python" lion_status_t update_pythoncb(lion_sim_t *);
 extern "Python" lion_status_t finished_pythoncb(lion_sim_t *);
@@ -48,6 +68,17 @@ typedef struct lion_sim_config {
   double                 sim_epsabs;
   double                 sim_epsrel;
   uint64_t               sim_min_maxiter;
+  lion_input_hold_t      sim_input_hold;
+
+  lion_jump_t sim_jump;
+  uint64_t    sim_jump_min_steps;
+  double      sim_jump_max_seconds;
+
+  uint64_t sim_thermal_steps;
+  uint64_t sim_aging_steps;
+
+  uint64_t sim_current_budget;
+  uint64_t sim_ode_budget;
 
   const char *log_dir;
   int         log_stdlvl;
@@ -87,6 +118,11 @@ typedef struct lion_sim_state {
 typedef struct lion_slv_inputs {
   lion_sim_state_t *sys_inputs;
   lion_params_t    *sys_params;
+  uint64_t          evaluations;
+  uint64_t          max_evaluations;
+  double            hold_span;
+  int               thermal_frozen;
+  double            thermal_decay;
 } lion_slv_inputs_t;
 
 typedef struct lion_sim {
@@ -112,10 +148,18 @@ lion_status_t lion_sim_init(lion_sim_t *sim);
 lion_status_t lion_sim_reset(lion_sim_t *sim);
 lion_status_t lion_sim_step(lion_sim_t *sim, double power,
                             double ambient_temperature);
+lion_status_t lion_sim_step_input(lion_sim_t *sim, lion_input_mode_t mode,
+                                  double value, double ambient_temperature);
+lion_status_t lion_sim_jump(lion_sim_t *sim, double power,
+                            double ambient_temperature, uint64_t steps);
 lion_status_t lion_sim_run(lion_sim_t *sim, lion_vector_t *power,
                            lion_vector_t *ambient_temperature);
+lion_status_t lion_sim_checkpoint(lion_sim_t *sim, lion_vector_t *out);
+lion_status_t lion_sim_restore(lion_sim_t *sim, const lion_vector_t *buf);
+lion_status_t lion_sim_fork(lion_sim_t *src, lion_sim_t *dst);
 
 int lion_sim_should_close(lion_sim_t *sim);
+void lion_sim_cancel(lion_sim_t *sim);
 uint64_t lion_sim_max_iters(lion_sim_t *sim);
 
 lion_status_t lion_sim_cleanup(lion_sim_t *sim);
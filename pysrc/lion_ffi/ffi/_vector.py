@@ -4,6 +4,7 @@ typedef struct lion_vector {
   size_t data_size;
   size_t len;
   size_t capacity;
+  int mapped;
 } lion_vector_t;
 """
 
@@ -54,6 +55,9 @@ lion_status_t lion_vector_set(lion_sim_t *sim, lion_vector_t *vec,
                               const size_t i, const void *src);
 lion_status_t lion_vector_resize(lion_sim_t *sim, lion_vector_t *vec,
                                  const size_t new_capacity);
+lion_status_t lion_vector_reserve(lion_sim_t *sim, lion_vector_t *vec,
+                                  const size_t additional);
+lion_status_t lion_vector_shrink_to_fit(lion_sim_t *sim, lion_vector_t *vec);
 lion_status_t lion_vector_push(lion_sim_t *sim, lion_vector_t *vec,
                                const void *src);
 lion_status_t lion_vector_extend_array(lion_sim_t *sim, lion_vector_t *vec,
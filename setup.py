@@ -31,6 +31,7 @@ typedef struct lion_mf_gaussian_params {
   double sigma;
 } lion_mf_gaussian_params_t;
 
+typedef struct gsl_rng gsl_rng;
 typedef struct gsl_odeiv2_system gsl_odeiv2_system;
 typedef struct gsl_odeiv2_driver gsl_odeiv2_driver;
 typedef struct gsl_odeiv2_step_type gsl_odeiv2_step_type;
@@ -45,10 +46,10 @@ FFI_CDEF = f"""
 
 // Typedefs
 {_status.CTYPEDEF}
+{_vector.CTYPEDEF}
 {_params.CTYPEDEF}
 {_sim.CTYPEDEF}
 {_names.CTYPEDEF}
-{_vector.CTYPEDEF}
 
 // Function definitions
 {_status.CDEF}
@@ -1,3 +1,4 @@
+#include <lion/events.h>
 #include <lion/sim.h>
 #include <lion/vector.h>
 #include <lionpp/sim.hpp>
@@ -22,6 +23,12 @@ Sim::operator lion_sim_t *() { return handle; }
 
 Status Sim::step(double power, double amb_temp) { return static_cast<Status>(lion_sim_step(handle, power, amb_temp)); }
 
+Status Sim::step(SimInputMode mode, double value, double amb_temp) {
+  return static_cast<Status>(lion_sim_step_input(handle, static_cast<lion_input_mode_t>(mode), value, amb_temp));
+}
+
+Status Sim::jump(double power, double amb_temp, uint64_t steps) { return static_cast<Status>(lion_sim_jump(handle, power, amb_temp, steps)); }
+
 Status Sim::run(std::vector<double> const &power, std::vector<double> const &amb_temp) {
   lion_vector_t power_vec;
   lion_vector_t amb_vec;
@@ -42,6 +49,8 @@ Status Sim::run(std::vector<double> const &power, std::vector<double> const &amb
 
 bool Sim::should_close() const { return lion_sim_should_close(handle); }
 
+void Sim::cancel() { lion_sim_cancel(handle); }
+
 uint64_t Sim::max_iters() const { return lion_sim_max_iters(handle); }
 
 } // namespace lion
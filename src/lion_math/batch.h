@@ -0,0 +1,12 @@
+#pragma once
+
+#include <lionu/vmath.h>
+#include <stddef.h>
+
+// Elements the batched functions handle at a time, which bounds the scratch
+// arrays they keep on the stack
+#define LION_MATH_BATCH_BLOCK 128
+
+static inline size_t lion_math_batch_count(size_t first, size_t n) {
+  return (n - first < LION_MATH_BATCH_BLOCK) ? n - first : LION_MATH_BATCH_BLOCK;
+}
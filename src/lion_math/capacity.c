@@ -1,5 +1,8 @@
 #include "capacity.h"
 
+#include "batch.h"
+
+#include <gsl/gsl_math.h>
 #include <lion/lion.h>
 #include <math.h>
 
@@ -19,3 +22,52 @@ double lion_soc_usable(double soc, double kappa, lion_params_t *params) { return
 double lion_capacity_usable(double capacity, double kappa, lion_params_t *params) { return kappa * capacity; }
 
 double lion_capacity_nominal(double capacity, double soh, lion_params_t *params) { return soh * capacity; }
+
+void lion_kappa_batch(const double internal_temperature[], size_t n, lion_params_t *params, double out[]) {
+  double right = params->vft.k1 / (params->vft.tref - params->vft.k2);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = params->vft.k1 / (internal_temperature[i] - params->vft.k2) - right;
+  }
+  lion_vexp(out, n, out);
+}
+
+void lion_kappa_grad_batch(const double internal_temperature[], size_t n, lion_params_t *params, double out[]) {
+  lion_kappa_batch(internal_temperature, n, params, out);
+  for (size_t i = 0; i < n; i++) {
+    out[i] *= -params->vft.k1 / gsl_pow_2(internal_temperature[i] - params->vft.k2);
+  }
+}
+
+void lion_soc_usable_batch(const double soc[], const double kappa[], size_t n, lion_params_t *params, double out[]) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = 1.0 + (soc[i] - 1.0) / kappa[i];
+  }
+}
+
+void lion_capacity_usable_batch(const double capacity[], const double kappa[], size_t n, lion_params_t *params, double out[]) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = kappa[i] * capacity[i];
+  }
+}
+
+void lion_capacity_nominal_batch(const double capacity[], const double soh[], size_t n, lion_params_t *params, double out[]) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = soh[i] * capacity[i];
+  }
+}
+
+void lion_kappa_batch_f(const float internal_temperature[], size_t n, lion_params_t *params, float out[]) {
+  float k1    = (float)params->vft.k1;
+  float k2    = (float)params->vft.k2;
+  float right = (float)(params->vft.k1 / (params->vft.tref - params->vft.k2));
+  for (size_t i = 0; i < n; i++) {
+    out[i] = k1 / (internal_temperature[i] - k2) - right;
+  }
+  lion_vexpf(out, n, out);
+}
+
+void lion_soc_usable_batch_f(const float soc[], const float kappa[], size_t n, lion_params_t *params, float out[]) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = 1.0f + (soc[i] - 1.0f) / kappa[i];
+  }
+}
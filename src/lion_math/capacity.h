@@ -1,6 +1,7 @@
 #pragma once
 
 #include <lion/params.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +14,13 @@ double lion_kappa_grad(double internal_temperature, lion_params_t *params);
 double lion_soc_usable(double soc, double kappa, lion_params_t *params);
 double lion_capacity_usable(double capacity, double kappa, lion_params_t *params);
 double lion_capacity_nominal(double capacity, double soh, lion_params_t *params);
+void   lion_kappa_batch(const double internal_temperature[], size_t n, lion_params_t *params, double out[]);
+void   lion_kappa_grad_batch(const double internal_temperature[], size_t n, lion_params_t *params, double out[]);
+void   lion_soc_usable_batch(const double soc[], const double kappa[], size_t n, lion_params_t *params, double out[]);
+void   lion_capacity_usable_batch(const double capacity[], const double kappa[], size_t n, lion_params_t *params, double out[]);
+void   lion_capacity_nominal_batch(const double capacity[], const double soh[], size_t n, lion_params_t *params, double out[]);
+void   lion_kappa_batch_f(const float internal_temperature[], size_t n, lion_params_t *params, float out[]);
+void   lion_soc_usable_batch_f(const float soc[], const float kappa[], size_t n, lion_params_t *params, float out[]);
 
 #ifdef __cplusplus
 }
@@ -1,5 +1,7 @@
 #include "current.h"
 
+#include "batch.h"
+
 #include "internal_resistance.h"
 
 #include <gsl/gsl_errno.h>
@@ -8,6 +10,9 @@
 #include <lion_utils/vendor/log.h>
 #include <math.h>
 
+// Relative step of the finite differences of the resistance
+#define LION_CURRENT_FD_STEP 1e-6
+
 double lion_current(double power, double open_circuit_voltage, double internal_resistance, lion_params_t *params) {
   // Aliases for equations
   double p   = power;
@@ -35,11 +40,51 @@ double lion_current_grad_voc(double power, double open_circuit_voltage, double i
   return term1 - term2;
 }
 
+void lion_current_batch(const double power[], const double open_circuit_voltage[], const double internal_resistance[], size_t n, lion_params_t *params, double out[]) {
+  // Negative discriminants give NaN currents, which the callers check, so the
+  // kernel stays free of logging
+  for (size_t i = 0; i < n; i++) {
+    double r = internal_resistance[i];
+    out[i]   = gsl_pow_2(open_circuit_voltage[i] / (2.0 * r)) - power[i] / r;
+  }
+  lion_vsqrt(out, n, out);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = open_circuit_voltage[i] / (2.0 * internal_resistance[i]) - out[i];
+  }
+}
+
+void lion_current_batch_f(const float power[], const float open_circuit_voltage[], const float internal_resistance[], size_t n, lion_params_t *params, float out[]) {
+  for (size_t i = 0; i < n; i++) {
+    float half = open_circuit_voltage[i] / (2.0f * internal_resistance[i]);
+    out[i]     = half * half - power[i] / internal_resistance[i];
+  }
+  lion_vsqrtf(out, n, out);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = open_circuit_voltage[i] / (2.0f * internal_resistance[i]) - out[i];
+  }
+}
+
+void lion_current_grad_voc_batch(
+    const double power[], const double open_circuit_voltage[], const double internal_resistance[], size_t n, lion_params_t *params, double out[]
+) {
+  for (size_t i = 0; i < n; i++) {
+    double r = internal_resistance[i];
+    out[i]   = gsl_pow_2(open_circuit_voltage[i] / (2.0 * r)) - power[i] / r;
+  }
+  lion_vsqrt(out, n, out);
+  for (size_t i = 0; i < n; i++) {
+    double r     = internal_resistance[i];
+    double term2 = open_circuit_voltage[i] / (4 * gsl_pow_2(r)) / out[i];
+    out[i]       = 1.0 / (2.0 * r) - term2;
+  }
+}
+
 double lion_current_optimize_targetfn(double current, void *params) {
   struct lion_optimization_iter_params *p            = params;
   double                                rint         = lion_resistance(p->soc, current, 1.0, p->params);
   double                                pred_current = lion_current(p->power, p->voc, rint, p->params);
   double                                val          = gsl_pow_2(fabs(current - pred_current));
+  p->evaluations++;
   return val;
 }
 
@@ -53,6 +98,31 @@ double lion_current_optimize(
     double              epsrel,
     int                 max_iter,
     lion_params_t      *params
+) {
+  double   current;
+  uint64_t evaluations;
+  int      status = lion_current_optimize_bounded(
+      s, power, soc, open_circuit_voltage, initial_guess, epsabs, epsrel, max_iter, UINT64_MAX, params, &current, &evaluations
+  );
+  if (status != GSL_SUCCESS) {
+    logi_error("Current did not converge");
+  }
+  return current;
+}
+
+int lion_current_optimize_bounded(
+    gsl_min_fminimizer *s,
+    double              power,
+    double              soc,
+    double              open_circuit_voltage,
+    double              initial_guess,
+    double              epsabs,
+    double              epsrel,
+    int                 max_iter,
+    uint64_t            max_evaluations,
+    lion_params_t      *params,
+    double             *current,
+    uint64_t           *evaluations
 ) {
   // The goal is to find the current I that solves the equation I = f(I)
   // where f is some known equation. The issue is that f might no be invertible
@@ -60,24 +130,37 @@ double lion_current_optimize(
   // optimization problem
   //   min ||I - f(I)||^2
   struct lion_optimization_iter_params opt_params = {
-    .power  = power,
-    .voc    = open_circuit_voltage,
-    .soc    = soc,
-    .params = params,
+    .power       = power,
+    .voc         = open_circuit_voltage,
+    .soc         = soc,
+    .params      = params,
+    .evaluations = 0,
   };
 
   double opt_min = LION_CURRENT_OPTMIN;
   double opt_max = LION_CURRENT_OPTMAX;
 
+  // Setting the minimizer evaluates the bracket and the initial guess, which
+  // counts against the budget like the iterations
+  if (max_evaluations < LION_CURRENT_SET_EVALUATIONS) {
+    *current     = initial_guess;
+    *evaluations = 0;
+    return GSL_EMAXITER;
+  }
+
   gsl_function F;
 
   F.function = &lion_current_optimize_targetfn;
   F.params   = &opt_params;
   gsl_min_fminimizer_set(s, &F, initial_guess, opt_min, opt_max);
 
-  int status;
-  int iter = 0;
+  // Each iteration evaluates the target function once
+  int status = GSL_CONTINUE;
+  int iter   = 0;
   do {
+    if (opt_params.evaluations >= max_evaluations) {
+      break;
+    }
     iter++;
     status = gsl_min_fminimizer_iterate(s);
 
@@ -87,8 +170,168 @@ double lion_current_optimize(
 
     status = gsl_min_test_interval(opt_min, opt_max, epsabs, epsrel);
   } while (status == GSL_CONTINUE && iter < max_iter);
-  if (status != GSL_SUCCESS) {
-    logi_error("Current did not converge");
+  *current     = initial_guess;
+  *evaluations = opt_params.evaluations;
+  return (status == GSL_CONTINUE) ? GSL_EMAXITER : status;
+}
+
+int lion_current_from_voltage(
+    double         voltage,
+    double         soc,
+    double         open_circuit_voltage,
+    double         initial_guess,
+    double         epsabs,
+    double         epsrel,
+    int            max_iter,
+    lion_params_t *params,
+    double        *current,
+    uint64_t      *evaluations
+) {
+  // Newton iterations on g(I) = voc - R(I) I - V, with the resistance of the
+  // power solve. A fixed resistance makes the first iteration exact
+  double   x      = initial_guess;
+  uint64_t evals  = 0;
+  int      status = GSL_CONTINUE;
+  for (int iter = 0; iter < max_iter && status == GSL_CONTINUE; iter++) {
+    double r  = lion_resistance(soc, x, 1.0, params);
+    double dr = 0.0;
+    evals++;
+    if (params->rint.model != LION_RINT_MODEL_FIXED) {
+      double h  = LION_CURRENT_FD_STEP * fmax(fabs(x), 1.0);
+      dr        = (lion_resistance(soc, x + h, 1.0, params) - lion_resistance(soc, x - h, 1.0, params)) / (2.0 * h);
+      evals    += 2;
+    }
+    double slope = r + dr * x;
+    if (!(slope > 0.0)) {
+      status = GSL_EFAILED;
+      break;
+    }
+    double delta  = (open_circuit_voltage - r * x - voltage) / slope;
+    x            += delta;
+    if (fabs(delta) < epsabs + epsrel * fabs(x)) {
+      status = GSL_SUCCESS;
+    }
+  }
+  *current     = x;
+  *evaluations = evals;
+  return (status == GSL_CONTINUE) ? GSL_EMAXITER : status;
+}
+
+void lion_current_resistance_lanes(size_t lanes, const double soc[], const double current[], lion_params_t *params, double r[], double dr[]) {
+  if (params->rint.model == LION_RINT_MODEL_FIXED) {
+    for (size_t i = 0; i < lanes; i++) {
+      r[i]  = params->rint.params.fixed.internal_resistance;
+      dr[i] = 0.0;
+    }
+    return;
+  }
+  double h[LION_CURRENT_LANES];
+  double plus[LION_CURRENT_LANES];
+  double minus[LION_CURRENT_LANES];
+  double r_plus[LION_CURRENT_LANES];
+  double r_minus[LION_CURRENT_LANES];
+  double soh[LION_CURRENT_LANES];
+  for (size_t i = 0; i < lanes; i++) {
+    h[i]     = LION_CURRENT_FD_STEP * fmax(fabs(current[i]), 1.0);
+    plus[i]  = current[i] + h[i];
+    minus[i] = current[i] - h[i];
+    soh[i]   = 1.0;
+  }
+  // The batched kernels do not allow the currents and the output to alias
+  lion_resistance_batch(soc, current, soh, lanes, params, r);
+  lion_resistance_batch(soc, plus, soh, lanes, params, r_plus);
+  lion_resistance_batch(soc, minus, soh, lanes, params, r_minus);
+  for (size_t i = 0; i < lanes; i++) {
+    dr[i] = (r_plus[i] - r_minus[i]) / (2.0 * h[i]);
+  }
+}
+
+static void lanes_newton(
+    size_t         lanes,
+    const double   power[],
+    const double   soc[],
+    const double   voc[],
+    double         epsabs,
+    double         epsrel,
+    int            max_iter,
+    lion_params_t *params,
+    double         current[],
+    int            converged[]
+) {
+  // The residual g(I) = (voc - R(I) I) I - P grows with the current on the
+  // discharge branch, where the physical root lies, so a lane whose slope
+  // is not positive has left it and is stopped
+  double r[LION_CURRENT_LANES];
+  double dr[LION_CURRENT_LANES];
+  int    active[LION_CURRENT_LANES];
+  int    n_active = (int)lanes;
+  for (size_t i = 0; i < lanes; i++) {
+    active[i]    = 1;
+    converged[i] = 0;
+  }
+
+  for (int iter = 0; iter < max_iter && n_active > 0; iter++) {
+    lion_current_resistance_lanes(lanes, soc, current, params, r, dr);
+    n_active = 0;
+    for (size_t i = 0; i < lanes; i++) {
+      double I     = current[i];
+      double g     = (voc[i] - r[i] * I) * I - power[i];
+      double slope = voc[i] - 2.0 * r[i] * I - I * I * dr[i];
+      double next  = I - g / slope;
+      int    ok    = active[i] && slope > 0.0 && isfinite(next);
+      int    done  = ok && fabs(next - I) <= epsabs + epsrel * fabs(next);
+
+      current[i]    = ok ? next : I;
+      converged[i] |= done;
+      active[i]     = ok && !done;
+      n_active     += active[i];
+    }
+  }
+}
+
+int lion_current_solve_lanes(
+    gsl_min_fminimizer *s,
+    size_t              n,
+    const double        power[],
+    const double        soc[],
+    const double        open_circuit_voltage[],
+    double              epsabs,
+    double              epsrel,
+    int                 max_iter,
+    lion_params_t      *params,
+    double              current[],
+    size_t             *fallbacks
+) {
+  int status = GSL_SUCCESS;
+  *fallbacks = 0;
+  for (size_t first = 0; first < n; first += LION_CURRENT_LANES) {
+    size_t lanes = GSL_MIN(n - first, (size_t)LION_CURRENT_LANES);
+    double guess[LION_CURRENT_LANES];
+    int    converged[LION_CURRENT_LANES];
+    for (size_t i = 0; i < lanes; i++) {
+      guess[i] = current[first + i];
+    }
+    lanes_newton(lanes, &power[first], &soc[first], &open_circuit_voltage[first], epsabs, epsrel, max_iter, params, &current[first], converged);
+
+    for (size_t i = 0; i < lanes; i++) {
+      if (converged[i]) {
+        continue;
+      }
+      size_t c = first + i;
+      if (s == NULL) {
+        current[c] = guess[i];
+        status     = GSL_EMAXITER;
+        continue;
+      }
+      uint64_t evaluations;
+      int      lane_status = lion_current_optimize_bounded(
+          s, power[c], soc[c], open_circuit_voltage[c], guess[i], epsabs, epsrel, max_iter, UINT64_MAX, params, &current[c], &evaluations
+      );
+      if (lane_status != GSL_SUCCESS) {
+        status = lane_status;
+      }
+      (*fallbacks)++;
+    }
   }
-  return initial_guess;
+  return status;
 }
@@ -2,10 +2,19 @@
 
 #include <gsl/gsl_min.h>
 #include <lion/params.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define LION_CURRENT_OPTMIN -1e3
 #define LION_CURRENT_OPTMAX 1e3
 
+// Evaluations of the target function spent bracketing the minimum before the
+// first iteration of the optimizer
+#define LION_CURRENT_SET_EVALUATIONS 3
+
+// Number of cells solved together by `lion_current_solve_lanes`
+#define LION_CURRENT_LANES 8
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,10 +24,16 @@ struct lion_optimization_iter_params {
   double         voc;
   double         soc;
   lion_params_t *params;
+  uint64_t       evaluations; // Number of evaluations of the target function
 };
 
 double lion_current(double power, double open_circuit_voltage, double internal_resistance, lion_params_t *params);
 double lion_current_grad_voc(double power, double open_circuit_voltage, double internal_resistance, lion_params_t *params);
+void   lion_current_batch(const double power[], const double open_circuit_voltage[], const double internal_resistance[], size_t n, lion_params_t *params, double out[]);
+void   lion_current_batch_f(const float power[], const float open_circuit_voltage[], const float internal_resistance[], size_t n, lion_params_t *params, float out[]);
+void   lion_current_grad_voc_batch(
+      const double power[], const double open_circuit_voltage[], const double internal_resistance[], size_t n, lion_params_t *params, double out[]
+  );
 double lion_current_optimize_targetfn(double current, void *params);
 double lion_current_optimize(
     gsl_min_fminimizer *s,
@@ -31,6 +46,62 @@ double lion_current_optimize(
     int                 max_iter,
     lion_params_t      *params
 );
+// Same as `lion_current_optimize`, but it also stops once the target function
+// has been evaluated `max_evaluations` times, and reports the outcome instead
+// of logging it. Budgets below LION_CURRENT_SET_EVALUATIONS cannot even set up
+// the optimizer, so they return the initial guess without evaluating anything.
+// Returns GSL_SUCCESS when the current converged
+int lion_current_optimize_bounded(
+    gsl_min_fminimizer *s,
+    double              power,
+    double              soc,
+    double              open_circuit_voltage,
+    double              initial_guess,
+    double              epsabs,
+    double              epsrel,
+    int                 max_iter,
+    uint64_t            max_evaluations,
+    lion_params_t      *params,
+    double             *current,
+    uint64_t           *evaluations
+);
+// Solves the current drawn at the terminal voltage `voltage`, that is
+// voc - R(I) I = V, with Newton iterations from `initial_guess`. Returns
+// GSL_SUCCESS when the current converged
+int lion_current_from_voltage(
+    double         voltage,
+    double         soc,
+    double         open_circuit_voltage,
+    double         initial_guess,
+    double         epsabs,
+    double         epsrel,
+    int            max_iter,
+    lion_params_t *params,
+    double        *current,
+    uint64_t      *evaluations
+);
+// Resistance at unit state of health of up to LION_CURRENT_LANES cells, and its
+// derivative with respect to the current by central differences
+void lion_current_resistance_lanes(size_t lanes, const double soc[], const double current[], lion_params_t *params, double r[], double dr[]);
+// Solves the current of `n` cells at once, in groups of LION_CURRENT_LANES.
+// Each lane runs Newton iterations on I V(I) = P from its value in `current`
+// and stops on its own once converged. Lanes that diverge or run out of
+// iterations fall back to the bracketing minimizer `s`, counted in
+// `fallbacks`. Without a minimizer those lanes keep their initial guess.
+// Returns GSL_SUCCESS when every current converged
+int lion_current_solve_lanes(
+    gsl_min_fminimizer *s,
+    size_t              n,
+    const double        power[],
+    const double        soc[],
+    const double        open_circuit_voltage[],
+    double              epsabs,
+    double              epsrel,
+    int                 max_iter,
+    lion_params_t      *params,
+    double              current[],
+    size_t             *fallbacks
+);
 #ifdef __cplusplus
 }
 #endif
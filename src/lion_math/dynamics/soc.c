@@ -7,3 +7,9 @@ double lion_soc_d(double current, double usable_capacity, lion_params_t *params)
   double diff = -current / usable_capacity;
   return diff;
 }
+
+void lion_soc_d_batch(const double current[], const double usable_capacity[], size_t n, lion_params_t *params, double out[]) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = -current[i] / usable_capacity[i];
+  }
+}
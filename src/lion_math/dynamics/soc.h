@@ -1,12 +1,14 @@
 #pragma once
 
 #include <lion/params.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 double lion_soc_d(double current, double usable_capacity, lion_params_t *params);
+void   lion_soc_d_batch(const double current[], const double usable_capacity[], size_t n, lion_params_t *params, double out[]);
 
 #ifdef __cplusplus
 }
@@ -2,6 +2,8 @@
 
 #include "lion/vector.h"
 
+#include <lion/sim.h>
+
 #include <lion_utils/vendor/log.h>
 #include <lionu/math.h>
 #include <math.h>
@@ -15,10 +17,16 @@ double lion_soh_next_vendor(
   return rate * soh;
 }
 
-double degradation_factor(lion_sim_t *sim, double soc_mean, double soc_max, double soc_min, double eq_final_soh, lion_knn_regressor_t *knn) {
-  lion_vector_t input;
+double degradation_factor(lion_sim_t *sim, double soc_mean, double soc_max, double soc_min, double eq_final_soh, const lion_knn_regressor_t *knn) {
+  // The query only lives for this call, so it borrows the stack array
+  // instead of copying it into the heap
   double        data[3] = {soc_mean, soc_max - soc_min, eq_final_soh};
-  lion_vector_from_array(sim, data, 3, sizeof(double), &input);
+  lion_vector_t input   = {
+    .data      = data,
+    .data_size = sizeof(double),
+    .len       = 3,
+    .capacity  = 3,
+  };
   return lion_knn_regressor_predict(sim, knn, &input);
 }
 
@@ -43,8 +51,11 @@ double lion_soh_next_masserano(
 
   double noise = 0.0;
   double BIAS  = 0.999161393145505;
-  if (p->kde.is_trained)
-    noise = lion_gaussian_kde_sample(&p->kde) - BIAS;
+  if (p->kde.is_trained) {
+    // Prefer the generator of the simulation, so forks sample independent streams
+    gsl_rng *rng = (sim != NULL && sim->rng != NULL) ? sim->rng : p->kde.rng;
+    noise        = lion_gaussian_kde_sample_rng(&p->kde, rng) - BIAS;
+  }
   double base_rate = exp(log(p->eq_final_soh) / total_cycles);
   double rate      = lion_clip_d(base_rate + noise, 0.0, 1.0);
 
@@ -57,6 +68,14 @@ double lion_soh_next_masserano(
   return rate * soh;
 }
 
+double lion_soh_calendar_rate(double internal_temperature, double soc, lion_params_t *params) {
+  // Arrhenius dependence on the temperature and exponential on the state of charge
+  const double            gas_constant = 8.314462618;
+  lion_params_calendar_t *p            = &params->calendar;
+  double                  arrhenius    = exp(p->activation_energy / gas_constant * (1.0 / p->reference_temperature - 1.0 / internal_temperature));
+  return p->rate * arrhenius * exp(p->soc_sensitivity * (soc - p->reference_soc));
+}
+
 double lion_soh_next(
     lion_sim_t *sim, double soh, double soc_mean, double soc_max, double soc_min, double internal_temperature, lion_params_t *params
 ) {
@@ -12,6 +12,9 @@ double lion_soh_next(
     lion_sim_t *sim, double soh, double soc_mean, double soc_max, double soc_min, double internal_temperature, lion_params_t *params
 );
 
+// Rate of the calendar aging, as the fraction of the state of health lost per second
+double lion_soh_calendar_rate(double internal_temperature, double soc, lion_params_t *params);
+
 #ifdef __cplusplus
 }
 #endif
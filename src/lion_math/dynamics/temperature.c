@@ -21,3 +21,19 @@ double lion_surface_temperature(double internal_temperature, double ambient_temp
   double term2 = ambient_temperature * params->temp.rin / rt;
   return term1 + term2;
 }
+
+void lion_internal_temperature_d_batch(
+    const double internal_temperature[], const double heat[], const double ambient_temperature[], size_t n, lion_params_t *params, double out[]
+) {
+  double rt = params->temp.rin + params->temp.rout;
+  for (size_t i = 0; i < n; i++) {
+    out[i] = ((ambient_temperature[i] - internal_temperature[i]) / rt + heat[i]) / params->temp.cp;
+  }
+}
+
+void lion_surface_temperature_batch(const double internal_temperature[], const double ambient_temperature[], size_t n, lion_params_t *params, double out[]) {
+  double rt = params->temp.rin + params->temp.rout;
+  for (size_t i = 0; i < n; i++) {
+    out[i] = internal_temperature[i] * params->temp.rout / rt + ambient_temperature[i] * params->temp.rin / rt;
+  }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <lion/params.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -8,6 +9,10 @@ extern "C" {
 
 double lion_internal_temperature_d(double internal_temperature, double heat, double ambient_temperature, lion_params_t *params);
 double lion_surface_temperature(double internal_temperature, double ambient_temperature, lion_params_t *params);
+void   lion_internal_temperature_d_batch(
+      const double internal_temperature[], const double heat[], const double ambient_temperature[], size_t n, lion_params_t *params, double out[]
+  );
+void   lion_surface_temperature_batch(const double internal_temperature[], const double ambient_temperature[], size_t n, lion_params_t *params, double out[]);
 
 #ifdef __cplusplus
 }
@@ -1,5 +1,7 @@
 #include "ehc.h"
 
+#include "batch.h"
+
 #include <gsl/gsl_math.h>
 #include <lion/lion.h>
 #include <math.h>
@@ -13,3 +15,50 @@ double lion_ehc(double soc, lion_params_t *params) {
   double second_term = params->ehc.l * exp(-params->ehc.kappa * soc);
   return params->ehc.a * (first_term - second_term) + params->ehc.b;
 }
+
+void lion_ehc_batch(const double soc[], size_t n, lion_params_t *params, double out[]) {
+  double first_exp[LION_MATH_BATCH_BLOCK];
+  double second_exp[LION_MATH_BATCH_BLOCK];
+  double exp_den     = 2.0 * gsl_pow_2(params->ehc.sigma);
+  double first_coeff = M_SQRT1_2 / (M_SQRTPI * params->ehc.sigma);
+  for (size_t first = 0; first < n; first += LION_MATH_BATCH_BLOCK) {
+    size_t        m = lion_math_batch_count(first, n);
+    const double *x = &soc[first];
+    for (size_t i = 0; i < m; i++) {
+      first_exp[i]  = -gsl_pow_2(x[i] - params->ehc.mu) / exp_den;
+      second_exp[i] = -params->ehc.kappa * x[i];
+    }
+    lion_vexp(first_exp, m, first_exp);
+    lion_vexp(second_exp, m, second_exp);
+    for (size_t i = 0; i < m; i++) {
+      double first_term  = first_exp[i] * first_coeff;
+      double second_term = params->ehc.l * second_exp[i];
+      out[first + i]     = params->ehc.a * (first_term - second_term) + params->ehc.b;
+    }
+  }
+}
+
+void lion_ehc_batch_f(const float soc[], size_t n, lion_params_t *params, float out[]) {
+  float first_exp[LION_MATH_BATCH_BLOCK];
+  float second_exp[LION_MATH_BATCH_BLOCK];
+  float mu          = (float)params->ehc.mu;
+  float kappa       = (float)params->ehc.kappa;
+  float first_scale = (float)(-1.0 / (2.0 * gsl_pow_2(params->ehc.sigma)));
+  float first_coeff = (float)(params->ehc.a * M_SQRT1_2 / (M_SQRTPI * params->ehc.sigma));
+  float second_coef = (float)(params->ehc.a * params->ehc.l);
+  float offset      = (float)params->ehc.b;
+  for (size_t first = 0; first < n; first += LION_MATH_BATCH_BLOCK) {
+    size_t       m = lion_math_batch_count(first, n);
+    const float *x = &soc[first];
+    for (size_t i = 0; i < m; i++) {
+      float diff    = x[i] - mu;
+      first_exp[i]  = first_scale * diff * diff;
+      second_exp[i] = -kappa * x[i];
+    }
+    lion_vexpf(first_exp, m, first_exp);
+    lion_vexpf(second_exp, m, second_exp);
+    for (size_t i = 0; i < m; i++) {
+      out[first + i] = first_coeff * first_exp[i] - second_coef * second_exp[i] + offset;
+    }
+  }
+}
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <lion/params.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 double lion_ehc(double soc, lion_params_t *params);
+void   lion_ehc_batch(const double soc[], size_t n, lion_params_t *params, double out[]);
+void   lion_ehc_batch_f(const float soc[], size_t n, lion_params_t *params, float out[]);
 
 #ifdef __cplusplus
 }
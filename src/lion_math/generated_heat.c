@@ -11,3 +11,21 @@ double lion_generated_heat(double current, double internal_temperature, double i
   return (qgen > 0.0) ? qgen : 0.0;
   // return ohmic - entropic;
 }
+
+void lion_generated_heat_batch(
+    const double current[], const double internal_temperature[], const double internal_resistance[], const double ehc[], size_t n, lion_params_t *params, double out[]
+) {
+  for (size_t i = 0; i < n; i++) {
+    double qgen = internal_resistance[i] * gsl_pow_2(current[i]) - current[i] * internal_temperature[i] * ehc[i];
+    out[i]      = (qgen > 0.0) ? qgen : 0.0;
+  }
+}
+
+void lion_generated_heat_batch_f(
+    const float current[], const float internal_temperature[], const float internal_resistance[], const float ehc[], size_t n, lion_params_t *params, float out[]
+) {
+  for (size_t i = 0; i < n; i++) {
+    float qgen = internal_resistance[i] * current[i] * current[i] - current[i] * internal_temperature[i] * ehc[i];
+    out[i]     = (qgen > 0.0f) ? qgen : 0.0f;
+  }
+}
@@ -1,12 +1,19 @@
 #pragma once
 
 #include <lion/params.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 double lion_generated_heat(double current, double internal_temperature, double internal_resistance, double ehc, lion_params_t *params);
+void   lion_generated_heat_batch(
+      const double current[], const double internal_temperature[], const double internal_resistance[], const double ehc[], size_t n, lion_params_t *params, double out[]
+  );
+void   lion_generated_heat_batch_f(
+      const float current[], const float internal_temperature[], const float internal_resistance[], const float ehc[], size_t n, lion_params_t *params, float out[]
+  );
 
 #ifdef __cplusplus
 }
@@ -1,5 +1,7 @@
 #include "internal_resistance.h"
 
+#include "batch.h"
+
 #include <lion/lion.h>
 #include <lion_utils/vendor/log.h>
 #include <lionu/fuzzy.h>
@@ -45,3 +47,121 @@ double lion_resistance(double soc, double current, double soh, lion_params_t *pa
     return -1.0;
   }
 }
+
+static void lion_resistance_polarization_batch(const double soc[], const double current[], const double soh[], size_t n, lion_params_t *params, double out[]) {
+  // Memberships are accumulated set by set, in the same order as the
+  // scalar version, with the sigmoids at both ends
+  lion_params_rint_polarization_t *p           = &params->rint.params.polarization;
+  lion_mf_gaussian_params_t       *gaussians[] = {&p->c20, &p->c10, &p->c4, &p->d5, &p->d10, &p->d15};
+  double                           membership[LION_MATH_BATCH_BLOCK];
+  double                           memberships_sum[LION_MATH_BATCH_BLOCK];
+  for (size_t first = 0; first < n; first += LION_MATH_BATCH_BLOCK) {
+    size_t        m   = lion_math_batch_count(first, n);
+    const double *x   = &current[first];
+    double       *num = &out[first];
+    for (size_t i = 0; i < m; i++) {
+      num[i]             = 0.0;
+      memberships_sum[i] = 0.0;
+    }
+    for (int j = 0; j < LION_FUZZY_SETS_COUNT; j++) {
+      if (j == 0) {
+        lion_mf_sigmoid_batch(x, m, &p->c40, membership);
+      } else if (j == LION_FUZZY_SETS_COUNT - 1) {
+        lion_mf_sigmoid_batch(x, m, &p->d30, membership);
+      } else {
+        lion_mf_gaussian_batch(x, m, gaussians[j - 1], membership);
+      }
+      for (size_t i = 0; i < m; i++) {
+        num[i]             += membership[i] * lion_polyval_d(soc[first + i], p->poly[j], LION_FUZZY_SETS_DEGREE);
+        memberships_sum[i] += membership[i];
+      }
+    }
+    for (size_t i = 0; i < m; i++) {
+      num[i] = num[i] / memberships_sum[i] / soh[first + i];
+    }
+  }
+}
+
+void lion_resistance_batch(const double soc[], const double current[], const double soh[], size_t n, lion_params_t *params, double out[]) {
+  switch (params->rint.model) {
+  case LION_RINT_MODEL_FIXED:
+    for (size_t i = 0; i < n; i++) {
+      out[i] = params->rint.params.fixed.internal_resistance / soh[i];
+    }
+    break;
+  case LION_RINT_MODEL_POLARIZATION:
+    lion_resistance_polarization_batch(soc, current, soh, n, params, out);
+    break;
+  default:
+    logi_error("Internal resistance model not valid");
+    for (size_t i = 0; i < n; i++) {
+      out[i] = -1.0;
+    }
+    break;
+  }
+}
+
+static void lion_resistance_polarization_batch_f(const float soc[], const float current[], const float soh[], size_t n, lion_params_t *params, float out[]) {
+  lion_params_rint_polarization_t *p           = &params->rint.params.polarization;
+  lion_mf_gaussian_params_t       *gaussians[] = {&p->c20, &p->c10, &p->c4, &p->d5, &p->d10, &p->d15};
+  float                            poly[LION_FUZZY_SETS_COUNT][LION_FUZZY_SETS_DEGREE];
+  float                            membership[LION_MATH_BATCH_BLOCK];
+  float                            memberships_sum[LION_MATH_BATCH_BLOCK];
+  for (int j = 0; j < LION_FUZZY_SETS_COUNT; j++) {
+    for (int d = 0; d < LION_FUZZY_SETS_DEGREE; d++) {
+      poly[j][d] = (float)p->poly[j][d];
+    }
+  }
+  for (size_t first = 0; first < n; first += LION_MATH_BATCH_BLOCK) {
+    size_t       m   = lion_math_batch_count(first, n);
+    const float *x   = &current[first];
+    float       *num = &out[first];
+    for (size_t i = 0; i < m; i++) {
+      num[i]             = 0.0f;
+      memberships_sum[i] = 0.0f;
+    }
+    for (int j = 0; j < LION_FUZZY_SETS_COUNT; j++) {
+      if (j == 0) {
+        lion_mf_sigmoid_batch_f(x, m, &p->c40, membership);
+      } else if (j == LION_FUZZY_SETS_COUNT - 1) {
+        lion_mf_sigmoid_batch_f(x, m, &p->d30, membership);
+      } else {
+        lion_mf_gaussian_batch_f(x, m, gaussians[j - 1], membership);
+      }
+      for (size_t i = 0; i < m; i++) {
+        // Horner form of lion_polyval_d, coefficients in increasing degree
+        float s     = soc[first + i];
+        float value = poly[j][LION_FUZZY_SETS_DEGREE - 1];
+        for (int d = LION_FUZZY_SETS_DEGREE - 2; d >= 0; d--) {
+          value = value * s + poly[j][d];
+        }
+        num[i]             += membership[i] * value;
+        memberships_sum[i] += membership[i];
+      }
+    }
+    for (size_t i = 0; i < m; i++) {
+      num[i] = num[i] / memberships_sum[i] / soh[first + i];
+    }
+  }
+}
+
+void lion_resistance_batch_f(const float soc[], const float current[], const float soh[], size_t n, lion_params_t *params, float out[]) {
+  switch (params->rint.model) {
+  case LION_RINT_MODEL_FIXED: {
+    float internal_resistance = (float)params->rint.params.fixed.internal_resistance;
+    for (size_t i = 0; i < n; i++) {
+      out[i] = internal_resistance / soh[i];
+    }
+    break;
+  }
+  case LION_RINT_MODEL_POLARIZATION:
+    lion_resistance_polarization_batch_f(soc, current, soh, n, params, out);
+    break;
+  default:
+    logi_error("Internal resistance model not valid");
+    for (size_t i = 0; i < n; i++) {
+      out[i] = -1.0f;
+    }
+    break;
+  }
+}
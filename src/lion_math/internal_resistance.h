@@ -1,12 +1,15 @@
 #pragma once
 
 #include <lion/params.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 double lion_resistance(double soc, double current, double soh, lion_params_t *params);
+void   lion_resistance_batch(const double soc[], const double current[], const double soh[], size_t n, lion_params_t *params, double out[]);
+void   lion_resistance_batch_f(const float soc[], const float current[], const float soh[], size_t n, lion_params_t *params, float out[]);
 
 #ifdef __cplusplus
 }
@@ -1,5 +1,7 @@
 #include "open_circuit.h"
 
+#include "batch.h"
+
 #include <lion/lion.h>
 #include <lion_utils/vendor/log.h>
 #include <math.h>
@@ -39,3 +41,82 @@ double lion_voc_grad(double soc, lion_params_t *params) {
 
   return term1 + term2 + term3;
 }
+
+void lion_voc_batch(const double soc[], size_t n, lion_params_t *params, double out[]) {
+  double term1_exp[LION_MATH_BATCH_BLOCK];
+  double term3_exp[LION_MATH_BATCH_BLOCK];
+  double term1_ct         = params->ocv.v0 - params->ocv.vl;
+  double term3_ct         = (1.0 - params->ocv.alpha) * params->ocv.vl;
+  double term3_inner_left = exp(-params->ocv.beta);
+  for (size_t first = 0; first < n; first += LION_MATH_BATCH_BLOCK) {
+    size_t        m = lion_math_batch_count(first, n);
+    const double *x = &soc[first];
+    lion_vsqrt(x, m, term3_exp);
+    for (size_t i = 0; i < m; i++) {
+      term1_exp[i]  = params->ocv.gamma * (x[i] - 1.0);
+      term3_exp[i] *= -params->ocv.beta;
+    }
+    lion_vexp(term1_exp, m, term1_exp);
+    lion_vexp(term3_exp, m, term3_exp);
+    for (size_t i = 0; i < m; i++) {
+      double term1   = term1_ct * term1_exp[i];
+      double term2   = params->ocv.alpha * params->ocv.vl * (x[i] - 1.0);
+      double term3   = term3_ct * (term3_inner_left - term3_exp[i]);
+      out[first + i] = params->ocv.vl + term1 + term2 + term3;
+    }
+  }
+}
+
+void lion_voc_grad_batch(const double soc[], size_t n, lion_params_t *params, double out[]) {
+  double term1_exp[LION_MATH_BATCH_BLOCK];
+  double sqrt_soc[LION_MATH_BATCH_BLOCK];
+  double term3_exp[LION_MATH_BATCH_BLOCK];
+  double term1_coeff     = params->ocv.gamma * (params->ocv.v0 - params->ocv.vl);
+  double term2           = params->ocv.alpha * params->ocv.vl;
+  double term3_num_coeff = (1.0 - params->ocv.alpha) * params->ocv.vl * params->ocv.beta;
+  for (size_t first = 0; first < n; first += LION_MATH_BATCH_BLOCK) {
+    size_t        m = lion_math_batch_count(first, n);
+    const double *x = &soc[first];
+    lion_vsqrt(x, m, sqrt_soc);
+    for (size_t i = 0; i < m; i++) {
+      term1_exp[i] = params->ocv.gamma * (x[i] - 1.0);
+      term3_exp[i] = -params->ocv.beta * sqrt_soc[i];
+    }
+    lion_vexp(term1_exp, m, term1_exp);
+    lion_vexp(term3_exp, m, term3_exp);
+    for (size_t i = 0; i < m; i++) {
+      double term1   = term1_coeff * term1_exp[i];
+      double term3   = term3_num_coeff * term3_exp[i] / (2 * sqrt_soc[i]);
+      out[first + i] = term1 + term2 + term3;
+    }
+  }
+}
+
+void lion_voc_batch_f(const float soc[], size_t n, lion_params_t *params, float out[]) {
+  float term1_exp[LION_MATH_BATCH_BLOCK];
+  float term3_exp[LION_MATH_BATCH_BLOCK];
+  float vl               = (float)params->ocv.vl;
+  float gamma            = (float)params->ocv.gamma;
+  float beta             = (float)params->ocv.beta;
+  float term1_ct         = (float)(params->ocv.v0 - params->ocv.vl);
+  float term2_ct         = (float)(params->ocv.alpha * params->ocv.vl);
+  float term3_ct         = (float)((1.0 - params->ocv.alpha) * params->ocv.vl);
+  float term3_inner_left = (float)exp(-params->ocv.beta);
+  for (size_t first = 0; first < n; first += LION_MATH_BATCH_BLOCK) {
+    size_t       m = lion_math_batch_count(first, n);
+    const float *x = &soc[first];
+    lion_vsqrtf(x, m, term3_exp);
+    for (size_t i = 0; i < m; i++) {
+      term1_exp[i]  = gamma * (x[i] - 1.0f);
+      term3_exp[i] *= -beta;
+    }
+    lion_vexpf(term1_exp, m, term1_exp);
+    lion_vexpf(term3_exp, m, term3_exp);
+    for (size_t i = 0; i < m; i++) {
+      float term1    = term1_ct * term1_exp[i];
+      float term2    = term2_ct * (x[i] - 1.0f);
+      float term3    = term3_ct * (term3_inner_left - term3_exp[i]);
+      out[first + i] = vl + term1 + term2 + term3;
+    }
+  }
+}
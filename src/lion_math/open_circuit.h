@@ -1,6 +1,7 @@
 #pragma once
 
 #include <lion/params.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -8,6 +9,9 @@ extern "C" {
 
 double lion_voc(double soc, lion_params_t *params);
 double lion_voc_grad(double soc, lion_params_t *params);
+void   lion_voc_batch(const double soc[], size_t n, lion_params_t *params, double out[]);
+void   lion_voc_grad_batch(const double soc[], size_t n, lion_params_t *params, double out[]);
+void   lion_voc_batch_f(const float soc[], size_t n, lion_params_t *params, float out[]);
 
 #ifdef __cplusplus
 }
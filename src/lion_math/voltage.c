@@ -10,3 +10,14 @@ double lion_voltage(double power, double open_circuit_voltage, double internal_r
 }
 
 double lion_voltage_from_current(double power, double current, lion_params_t *params) { return power / current; }
+
+void lion_voltage_batch(const double power[], const double open_circuit_voltage[], const double internal_resistance[], size_t n, lion_params_t *params, double out[]) {
+  lion_current_batch(power, open_circuit_voltage, internal_resistance, n, params, out);
+  lion_voltage_from_current_batch(power, out, n, params, out);
+}
+
+void lion_voltage_from_current_batch(const double power[], const double current[], size_t n, lion_params_t *params, double out[]) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = power[i] / current[i];
+  }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <lion/params.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -8,6 +9,8 @@ extern "C" {
 
 double lion_voltage(double power, double open_circuit_voltage, double internal_resistance, lion_params_t *params);
 double lion_voltage_from_current(double power, double current, lion_params_t *params);
+void   lion_voltage_batch(const double power[], const double open_circuit_voltage[], const double internal_resistance[], size_t n, lion_params_t *params, double out[]);
+void   lion_voltage_from_current_batch(const double power[], const double current[], size_t n, lion_params_t *params, double out[]);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,121 @@
+#include "mem.h"
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_odeiv2.h>
+#include <gsl/gsl_rng.h>
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LION_CHECKPOINT_MAGIC        "LION"
+#define LION_CHECKPOINT_RNG_NAME_MAX 32
+
+/*
+   Layout of a checkpoint blob, all values in native byte order
+
+     lion_checkpoint_header_t header
+     lion_sim_state_t         state
+     uint8_t                  rng_state[header.rng_size]
+*/
+typedef struct lion_checkpoint_header {
+  char     magic[4];
+  uint32_t version;
+  uint32_t state_size;
+  uint32_t rng_size;
+  uint32_t rint_model;
+  uint32_t soh_model;
+  double   step_seconds;
+  char     rng_name[LION_CHECKPOINT_RNG_NAME_MAX];
+} lion_checkpoint_header_t;
+
+lion_status_t lion_sim_checkpoint(lion_sim_t *sim, lion_vector_t *out) {
+  gsl_rng *rng      = sim->rng;
+  size_t   rng_size = (rng != NULL) ? gsl_rng_size(rng) : 0;
+
+  lion_checkpoint_header_t header = {
+    .version      = LION_CHECKPOINT_VERSION,
+    .state_size   = (uint32_t)sizeof(lion_sim_state_t),
+    .rng_size     = (uint32_t)rng_size,
+    .rint_model   = (uint32_t)sim->params->rint.model,
+    .soh_model    = (uint32_t)sim->params->soh.model,
+    .step_seconds = sim->conf->sim_step_seconds,
+  };
+  memcpy(header.magic, LION_CHECKPOINT_MAGIC, sizeof(header.magic));
+  if (rng != NULL) {
+    strncpy(header.rng_name, gsl_rng_name(rng), LION_CHECKPOINT_RNG_NAME_MAX - 1);
+  }
+
+  size_t total = sizeof(header) + sizeof(lion_sim_state_t) + rng_size;
+  LION_CALL_I(lion_vector_with_capacity(sim, total, sizeof(uint8_t), out), "Failed allocating checkpoint buffer");
+  LION_CALL_I(lion_vector_extend_array(sim, out, &header, sizeof(header)), "Failed writing checkpoint header");
+  LION_CALL_I(lion_vector_extend_array(sim, out, &sim->state, sizeof(lion_sim_state_t)), "Failed writing checkpoint state");
+  if (rng != NULL) {
+    LION_CALL_I(lion_vector_extend_array(sim, out, gsl_rng_state(rng), rng_size), "Failed writing checkpoint RNG state");
+  }
+  logi_debug("Created checkpoint at step %" PRIu64 " (%zu B)", sim->state.step, total);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_sim_restore(lion_sim_t *sim, const lion_vector_t *buf) {
+  size_t len = lion_vector_total_size(sim, buf);
+  if (len < sizeof(lion_checkpoint_header_t)) {
+    logi_error("Checkpoint buffer is too small (%zu B)", len);
+    return LION_STATUS_FAILURE;
+  }
+
+  const uint8_t           *data = buf->data;
+  lion_checkpoint_header_t header;
+  memcpy(&header, data, sizeof(header));
+  data += sizeof(header);
+
+  if (memcmp(header.magic, LION_CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+    logi_error("Buffer is not a checkpoint");
+    return LION_STATUS_FAILURE;
+  }
+  if (header.version != LION_CHECKPOINT_VERSION) {
+    logi_error("Unsupported checkpoint version %" PRIu32 " (expected %d)", header.version, LION_CHECKPOINT_VERSION);
+    return LION_STATUS_FAILURE;
+  }
+  if (header.state_size != sizeof(lion_sim_state_t) || len != sizeof(header) + header.state_size + header.rng_size) {
+    logi_error("Checkpoint size does not match this build of the simulator");
+    return LION_STATUS_FAILURE;
+  }
+  if (header.rint_model != (uint32_t)sim->params->rint.model || header.soh_model != (uint32_t)sim->params->soh.model) {
+    logi_error("Checkpoint was created with different models");
+    return LION_STATUS_FAILURE;
+  }
+  if (header.step_seconds != sim->conf->sim_step_seconds) {
+    logi_warn("Checkpoint step (%f s) differs from the configured step (%f s)", header.step_seconds, sim->conf->sim_step_seconds);
+  }
+
+  gsl_rng *rng = sim->rng;
+  if (header.rng_size > 0) {
+    if (rng == NULL || gsl_rng_size(rng) != header.rng_size || strncmp(header.rng_name, gsl_rng_name(rng), LION_CHECKPOINT_RNG_NAME_MAX) != 0) {
+      logi_error("Checkpoint RNG state does not match the simulation RNG");
+      return LION_STATUS_FAILURE;
+    }
+  } else if (rng != NULL) {
+    logi_warn("Checkpoint has no RNG state, keeping the current one");
+  }
+
+  memcpy(&sim->state, data, sizeof(lion_sim_state_t));
+  data += sizeof(lion_sim_state_t);
+  if (header.rng_size > 0) {
+    memcpy(gsl_rng_state(rng), data, header.rng_size);
+  }
+
+  // Restart the driver so no stepper history carries over from the
+  // previous trajectory, and reopen a simulation closed by an event or a
+  // cancellation on that trajectory
+  if (sim->driver != NULL) {
+    int status = gsl_odeiv2_driver_reset(sim->driver);
+    LION_GSL_CALL_I(status, "Failed resetting ode driver");
+  }
+  lion_sim_events_reset(sim);
+  lion_sim_stats_reset(sim);
+  logi_debug("Restored checkpoint at step %" PRIu64, sim->state.step);
+  return LION_STATUS_SUCCESS;
+}
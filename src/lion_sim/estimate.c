@@ -0,0 +1,441 @@
+#include "mem.h"
+#include "sim_run.h"
+#include "solver/sys.h"
+
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_multifit_nlinear.h>
+#include <gsl/gsl_odeiv2.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_vector.h>
+#include <lion/estimate.h>
+#include <lion/lion.h>
+#include <lion_math/lion_math.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+#include <string.h>
+
+#define LION_ESTIMATE_OUTPUTS           2
+#define LION_ESTIMATE_FD_STEP           6e-6
+#define LION_ESTIMATE_FD_FLOOR          1e-8
+#define LION_ESTIMATE_CURRENT_MAXITER   50
+#define LION_ESTIMATE_CURRENT_TOLERANCE 1e-12
+
+typedef struct lion_estimate_ctx {
+  lion_sim_t            *sim;
+  lion_params_t         *params;
+  const lion_estimate_t *est;
+  double               **fields;
+  size_t                 n_steps;
+  size_t                 n_outputs;
+  const double          *power;
+  const double          *amb;
+  const double          *measured[LION_ESTIMATE_OUTPUTS];
+  double                 weights[LION_ESTIMATE_OUTPUTS];
+
+  // Forward sensitivities of the state, integrated next to the simulation
+  gsl_odeiv2_system             sens_sys;
+  gsl_odeiv2_driver            *sens_driver;
+  lion_slv_sensitivity_inputs_t sens_inputs;
+  double                       *sens;
+  double                       *dfdp;
+  double                       *dydp;
+
+  size_t simulations;
+} lion_estimate_ctx_t;
+
+lion_estimate_t lion_estimate_default(void) {
+  lion_estimate_t est = {
+    .names              = NULL,
+    .n_params           = 0,
+    .voltage_weight     = 1.0,
+    .temperature_weight = 1.0,
+    .max_iter           = 100,
+    .xtol               = 1e-8,
+    .gtol               = 1e-8,
+    .ftol               = 0.0,
+  };
+  return est;
+}
+
+static double estimate_current(double power, double soc_use, double voc, double guess, lion_params_t *params) {
+  // Secant iterations on I - f(I), the same fixed point the simulation
+  // solves with its minimizer, which is exact for the fixed resistance model
+  double i0 = guess;
+  double g0 = i0 - lion_current(power, voc, lion_resistance(soc_use, i0, 1.0, params), params);
+  double i1 = i0 - g0;
+  for (int it = 0; it < LION_ESTIMATE_CURRENT_MAXITER; it++) {
+    double g1 = i1 - lion_current(power, voc, lion_resistance(soc_use, i1, 1.0, params), params);
+    if (fabs(g1) <= LION_ESTIMATE_CURRENT_TOLERANCE * fmax(fabs(i1), 1.0) || g1 == g0) {
+      break;
+    }
+    double i2 = i1 - g1 * (i1 - i0) / (g1 - g0);
+    i0        = i1;
+    g0        = g1;
+    i1        = i2;
+  }
+  return i1;
+}
+
+static void estimate_eval(const lion_sim_state_t *at, double soc, double temp, lion_params_t *params, double f[2], double y[2]) {
+  // Mirrors lion_slv_update followed by the state dynamics, keeping the
+  // inputs and the state of health of the current step
+  double kappa            = lion_kappa(temp, params);
+  double capacity_nominal = lion_capacity_nominal(params->init.capacity, at->soh, params);
+  double soc_use          = lion_soc_usable(soc, kappa, params);
+  double capacity_use     = lion_capacity_usable(capacity_nominal, kappa, params);
+  double ehc              = lion_ehc(soc_use, params);
+  double voc              = lion_voc(soc_use, params) + ehc * (temp - params->vft.tref);
+  double current          = estimate_current(at->power, soc_use, voc, at->current, params);
+  double resistance       = lion_resistance(soc_use, current, at->soh, params);
+  double heat             = lion_generated_heat(current, temp, resistance, ehc, params);
+
+  f[0] = lion_soc_d(current, capacity_use, params);
+  f[1] = lion_internal_temperature_d(temp, heat, at->ambient_temperature, params);
+  y[0] = lion_voltage_from_current(at->power, current, params);
+  y[1] = lion_surface_temperature(temp, at->ambient_temperature, params);
+}
+
+static double estimate_fd_step(double value) { return LION_ESTIMATE_FD_STEP * fmax(fabs(value), LION_ESTIMATE_FD_FLOOR / LION_ESTIMATE_FD_STEP); }
+
+static void estimate_partials(lion_estimate_ctx_t *ctx, double dydx[LION_ESTIMATE_OUTPUTS][2]) {
+  // The algebraic part of the model is cheap compared to a simulation, so
+  // its partial derivatives are taken with central differences
+  const lion_sim_state_t *at   = &ctx->sim->state;
+  size_t                  n    = ctx->est->n_params;
+  double                  x[2] = {at->soc_nominal, at->internal_temperature};
+  double                  fp[2], fm[2], yp[2], ym[2];
+
+  for (size_t s = 0; s < 2; s++) {
+    double h     = estimate_fd_step(x[s]);
+    double xp[2] = {x[0], x[1]};
+    double xm[2] = {x[0], x[1]};
+    xp[s]       += h;
+    xm[s]       -= h;
+    estimate_eval(at, xp[0], xp[1], ctx->params, fp, yp);
+    estimate_eval(at, xm[0], xm[1], ctx->params, fm, ym);
+    for (size_t o = 0; o < LION_ESTIMATE_OUTPUTS; o++) {
+      dydx[o][s] = (yp[o] - ym[o]) / (2.0 * h);
+    }
+  }
+
+  for (size_t j = 0; j < n; j++) {
+    double *field = ctx->fields[j];
+    double  value = *field;
+    double  h     = estimate_fd_step(value);
+
+    *field = value + h;
+    estimate_eval(at, x[0], x[1], ctx->params, fp, yp);
+    *field = value - h;
+    estimate_eval(at, x[0], x[1], ctx->params, fm, ym);
+    *field = value;
+
+    for (size_t o = 0; o < 2; o++) {
+      ctx->dfdp[o * n + j] = (fp[o] - fm[o]) / (2.0 * h);
+    }
+    for (size_t o = 0; o < LION_ESTIMATE_OUTPUTS; o++) {
+      ctx->dydp[o * n + j] = (yp[o] - ym[o]) / (2.0 * h);
+    }
+  }
+}
+
+static lion_status_t estimate_simulate(lion_estimate_ctx_t *ctx, const gsl_vector *x, gsl_vector *f, gsl_matrix *jac) {
+  lion_sim_t *sim = ctx->sim;
+  size_t      n   = ctx->est->n_params;
+  for (size_t j = 0; j < n; j++) {
+    *ctx->fields[j] = gsl_vector_get(x, j);
+  }
+  // The inputs cached from the parameters follow them, and every evaluation
+  // draws the same noise, so the residuals only depend on the parameters
+  lion_sim_refresh_inputs(sim);
+  gsl_rng_set(sim->rng, sim->_seed);
+
+  LION_CALL_I(lion_sim_reset(sim), "Failed resetting simulation");
+  int status = gsl_odeiv2_driver_reset(sim->driver);
+  LION_GSL_CALL_I(status, "Failed resetting ode driver");
+  if (jac != NULL) {
+    // Only the initial conditions depend directly on the parameters at t = 0
+    memset(ctx->sens, 0, 2 * n * sizeof(double));
+    for (size_t j = 0; j < n; j++) {
+      if (strcmp(ctx->est->names[j], "init.soc") == 0) {
+        ctx->sens[j] = 1.0;
+      } else if (strcmp(ctx->est->names[j], "init.temp_in") == 0) {
+        ctx->sens[n + j] = 1.0;
+      }
+    }
+    status = gsl_odeiv2_driver_reset(ctx->sens_driver);
+    LION_GSL_CALL_I(status, "Failed resetting sensitivity driver");
+  }
+  ctx->simulations++;
+
+  double dydx[LION_ESTIMATE_OUTPUTS][2];
+  for (size_t k = 0; k < ctx->n_steps; k++) {
+    size_t i = k + 1;
+    LION_VCALL_I(lion_sim_step(sim, ctx->power[i], ctx->amb[i]), "Failed simulating step %zu", i);
+    if (jac != NULL) {
+      estimate_partials(ctx, dydx);
+    }
+
+    double simulated[LION_ESTIMATE_OUTPUTS] = {sim->state.voltage, sim->state.surface_temperature};
+    for (size_t o = 0; o < ctx->n_outputs; o++) {
+      size_t row      = k * ctx->n_outputs + o;
+      double measured = ctx->measured[o][i];
+      double w        = ctx->weights[o];
+      if (isnan(measured)) {
+        gsl_vector_set(f, row, 0.0);
+        for (size_t j = 0; jac != NULL && j < n; j++) {
+          gsl_matrix_set(jac, row, j, 0.0);
+        }
+        continue;
+      }
+
+      gsl_vector_set(f, row, w * (simulated[o] - measured));
+      if (jac != NULL) {
+        // Chain rule through the state, dy/dp = dy/dx S + dy/dp|x
+        for (size_t j = 0; j < n; j++) {
+          double grad = dydx[o][0] * ctx->sens[j] + dydx[o][1] * ctx->sens[n + j] + ctx->dydp[o * n + j];
+          gsl_matrix_set(jac, row, j, w * grad);
+        }
+      }
+    }
+
+    if (jac != NULL) {
+      double state[2] = {sim->state.soc_nominal, sim->state.internal_temperature};
+      double dfdt[2];
+      double t = sim->state.time;
+      lion_slv_jac_analytical(t, state, ctx->sens_inputs.jac, dfdt, &sim->inputs);
+      ctx->sens_inputs.dfdp = ctx->dfdp;
+      status                = gsl_odeiv2_driver_apply_fixed_step(ctx->sens_driver, &t, sim->conf->sim_step_seconds, 1, ctx->sens);
+      LION_GSL_VCALL_I(status, "Failed integrating sensitivities at step %zu", i);
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static int estimate_f(const gsl_vector *x, void *params, gsl_vector *f) {
+  return (estimate_simulate(params, x, f, NULL) == LION_STATUS_SUCCESS) ? GSL_SUCCESS : GSL_EFAILED;
+}
+
+static int estimate_df(const gsl_vector *x, void *params, gsl_matrix *jac) {
+  lion_estimate_ctx_t *ctx = params;
+  gsl_vector          *f   = gsl_vector_alloc(jac->size1);
+  if (f == NULL) {
+    return GSL_ENOMEM;
+  }
+  lion_status_t status = estimate_simulate(ctx, x, f, jac);
+  gsl_vector_free(f);
+  return (status == LION_STATUS_SUCCESS) ? GSL_SUCCESS : GSL_EFAILED;
+}
+
+static void estimate_callback(const size_t iter, void *params, const gsl_multifit_nlinear_workspace *w) {
+  (void)params;
+  gsl_vector *f = gsl_multifit_nlinear_residual(w);
+  logi_debug("Iteration %zu, cost = %e", iter, 0.5 * gsl_pow_2(gsl_blas_dnrm2(f)));
+}
+
+static lion_status_t estimate_solve(lion_estimate_ctx_t *ctx, size_t n_residuals, gsl_vector *x, lion_estimate_result_t *result) {
+  gsl_multifit_nlinear_fdf fdf = {
+    .f      = &estimate_f,
+    .df     = &estimate_df,
+    .fvv    = NULL,
+    .n      = n_residuals,
+    .p      = ctx->est->n_params,
+    .params = ctx,
+  };
+  gsl_multifit_nlinear_parameters fdf_params = gsl_multifit_nlinear_default_parameters();
+  fdf_params.trs                             = gsl_multifit_nlinear_trs_lm;
+
+  gsl_multifit_nlinear_workspace *w = gsl_multifit_nlinear_alloc(gsl_multifit_nlinear_trust, &fdf_params, n_residuals, ctx->est->n_params);
+  if (w == NULL) {
+    logi_error("Could not allocate Levenberg-Marquardt workspace");
+    return LION_STATUS_FAILURE;
+  }
+
+  int status = gsl_multifit_nlinear_init(x, &fdf, w);
+  if (status != GSL_SUCCESS) {
+    gsl_multifit_nlinear_free(w);
+    LION_GSL_CALL_I(status, "Failed initializing Levenberg-Marquardt solver");
+  }
+  result->initial_cost = 0.5 * gsl_pow_2(gsl_blas_dnrm2(gsl_multifit_nlinear_residual(w)));
+  logi_info("Initial cost = %e", result->initial_cost);
+
+  int info = 0;
+  status   = gsl_multifit_nlinear_driver(ctx->est->max_iter, ctx->est->xtol, ctx->est->gtol, ctx->est->ftol, estimate_callback, NULL, &info, w);
+  if (status == GSL_EMAXITER || status == GSL_ENOPROG) {
+    logi_warn("Estimation stopped without converging (%s)", lion_gsl_errno_name(status));
+    info = 0;
+  } else if (status != GSL_SUCCESS) {
+    gsl_multifit_nlinear_free(w);
+    LION_GSL_CALL_I(status, "Failed running Levenberg-Marquardt solver");
+  }
+
+  gsl_vector_memcpy(x, gsl_multifit_nlinear_position(w));
+  result->final_cost = 0.5 * gsl_pow_2(gsl_blas_dnrm2(gsl_multifit_nlinear_residual(w)));
+  result->iterations = gsl_multifit_nlinear_niter(w);
+  result->info       = info;
+  gsl_multifit_nlinear_free(w);
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t estimate_validate(
+    lion_sim_t *sim, const lion_estimate_t *est, lion_vector_t *power, lion_vector_t *ambient_temperature, lion_vector_t *voltage
+) {
+  if (sim->driver == NULL) {
+    logi_error("Estimation requires an initialized simulation");
+    return LION_STATUS_FAILURE;
+  }
+  if (sim->params->rc.n_branches > 0) {
+    logi_error("Estimation does not support RC branches yet");
+    return LION_STATUS_FAILURE;
+  }
+  if (est->n_params == 0) {
+    logi_error("No parameters to estimate");
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t j = 0; j < est->n_params; j++) {
+    if (lion_params_field(sim->params, est->names[j]) == NULL) {
+      logi_error("Unknown parameter '%s'", est->names[j]);
+      return LION_STATUS_FAILURE;
+    }
+  }
+  if (power == NULL || ambient_temperature == NULL || voltage == NULL) {
+    logi_error("Null arguments were passed to the estimation");
+    return LION_STATUS_FAILURE;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t estimate_fork(
+    lion_sim_t             *sim,
+    lion_sim_t             *fork,
+    const lion_estimate_t  *est,
+    size_t                  n_steps,
+    size_t                  n_outputs,
+    lion_vector_t          *power,
+    lion_vector_t          *ambient_temperature,
+    lion_vector_t          *voltage,
+    lion_vector_t          *temperature,
+    lion_estimate_result_t *result
+) {
+  size_t   n      = est->n_params;
+  double **fields = lion_malloc(sim, n * sizeof(double *));
+  if (fields == NULL) {
+    logi_error("Could not allocate parameter fields");
+    return LION_STATUS_FAILURE;
+  }
+  // Sensitivities, and derivatives of the dynamics and outputs with respect
+  // to the parameters, each with (2 x n_params) elements
+  double *buffer = lion_malloc(sim, 6 * n * sizeof(double));
+  if (buffer == NULL) {
+    logi_error("Could not allocate sensitivity buffers");
+    lion_free(sim, fields);
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_estimate_ctx_t ctx = {
+    .sim         = fork,
+    .params      = fork->params,
+    .est         = est,
+    .fields      = fields,
+    .n_steps     = n_steps,
+    .n_outputs   = n_outputs,
+    .power       = power->data,
+    .amb         = ambient_temperature->data,
+    .measured    = {voltage->data, (temperature != NULL) ? temperature->data : NULL},
+    .weights     = {est->voltage_weight, est->temperature_weight},
+    .sens_driver = NULL,
+    .sens_inputs = {.n_params = n, .dfdp = buffer + 2 * n},
+    .sens        = buffer,
+    .dfdp        = buffer + 2 * n,
+    .dydp        = buffer + 4 * n,
+    .simulations = 0,
+  };
+  gsl_odeiv2_system sens_sys = {
+    .function  = &lion_slv_system_sensitivity,
+    .jacobian  = &lion_slv_jac_sensitivity,
+    .dimension = 2 * n,
+    .params    = &ctx.sens_inputs,
+  };
+  ctx.sens_sys    = sens_sys;
+  ctx.sens_driver = gsl_odeiv2_driver_alloc_y_new(&ctx.sens_sys, fork->step_type, sim->conf->sim_step_seconds, sim->conf->sim_epsabs, sim->conf->sim_epsrel);
+  gsl_vector *x   = gsl_vector_alloc(n);
+
+  lion_status_t status = LION_STATUS_FAILURE;
+  if (ctx.sens_driver == NULL || x == NULL) {
+    logi_error("Could not allocate solver handles");
+  } else {
+    for (size_t j = 0; j < n; j++) {
+      fields[j] = lion_params_field(fork->params, est->names[j]);
+      gsl_vector_set(x, j, *fields[j]);
+    }
+    logi_info("Estimating %zu parameters from %zu measurements", n, n_steps * n_outputs);
+    status              = estimate_solve(&ctx, n_steps * n_outputs, x, result);
+    result->simulations = ctx.simulations;
+  }
+
+  if (status == LION_STATUS_SUCCESS) {
+    logi_info("Finished estimation after %zu iterations, cost = %e", result->iterations, result->final_cost);
+    for (size_t j = 0; j < n; j++) {
+      *lion_params_field(sim->params, est->names[j]) = gsl_vector_get(x, j);
+      logi_info(" * %s = %f", est->names[j], gsl_vector_get(x, j));
+    }
+  }
+
+  if (x != NULL) {
+    gsl_vector_free(x);
+  }
+  if (ctx.sens_driver != NULL) {
+    gsl_odeiv2_driver_free(ctx.sens_driver);
+  }
+  lion_free(sim, buffer);
+  lion_free(sim, fields);
+  return status;
+}
+
+lion_status_t lion_estimate_run(
+    lion_sim_t             *sim,
+    const lion_estimate_t  *est,
+    lion_vector_t          *power,
+    lion_vector_t          *ambient_temperature,
+    lion_vector_t          *voltage,
+    lion_vector_t          *temperature,
+    lion_estimate_result_t *out
+) {
+  LION_CALL_I(estimate_validate(sim, est, power, ambient_temperature, voltage), "Invalid estimation problem");
+
+  size_t len = power->len;
+  len        = (ambient_temperature->len < len) ? ambient_temperature->len : len;
+  len        = (voltage->len < len) ? voltage->len : len;
+  if (temperature != NULL) {
+    len = (temperature->len < len) ? temperature->len : len;
+  }
+  size_t n_outputs = (temperature != NULL) ? 2 : 1;
+  size_t n_steps   = (len > 0) ? len - 1 : 0;
+  if (n_steps * n_outputs < est->n_params) {
+    logi_error("Not enough measurements (%zu) to estimate %zu parameters", n_steps * n_outputs, est->n_params);
+    return LION_STATUS_FAILURE;
+  }
+
+  // The estimation runs on a fork with its own parameters, so the simulation
+  // given by the user only sees the final estimate
+  lion_params_t params = *sim->params;
+  lion_sim_t    fork;
+  LION_CALL_I(lion_sim_fork(sim, &fork), "Failed forking simulation");
+  fork.params        = &params;
+  fork.init_hook     = NULL;
+  fork.update_hook   = NULL;
+  fork.finished_hook = NULL;
+  lion_sim_refresh_inputs(&fork);
+
+  lion_estimate_result_t result = {0};
+  lion_status_t          status = estimate_fork(sim, &fork, est, n_steps, n_outputs, power, ambient_temperature, voltage, temperature, &result);
+  LION_CALL_I(lion_sim_cleanup(&fork), "Failed cleaning up estimation simulation");
+  LION_CALL_I(status, "Failed estimating parameters");
+  if (out != NULL) {
+    *out = result;
+  }
+  return LION_STATUS_SUCCESS;
+}
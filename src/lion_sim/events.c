@@ -0,0 +1,276 @@
+#include "mem.h"
+#include "sim_run.h"
+#include "solver/blocks.h"
+#include "solver/native.h"
+#include "solver/update.h"
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_odeiv2.h>
+#include <lion/events.h>
+#include <lion/lion.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+#include <string.h>
+
+// Requests to close come from other threads through lion_sim_cancel
+#if defined(__GNUC__) || defined(__clang__)
+  #define EV_LOAD(p)     __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+  #define EV_STORE(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+  #define EV_CLEAR(p, v)                                                                                                                             \
+    do {                                                                                                                                             \
+      int expected = (v);                                                                                                                            \
+      __atomic_compare_exchange_n(&(p), &expected, LION_CLOSE_NONE, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);                                          \
+    } while (0)
+#else
+  #define EV_LOAD(p)     (p)
+  #define EV_STORE(p, v) ((p) = (v))
+  #define EV_CLEAR(p, v)                                                                                                                             \
+    do {                                                                                                                                             \
+      if ((p) == (v)) {                                                                                                                              \
+        (p) = LION_CLOSE_NONE;                                                                                                                       \
+      }                                                                                                                                              \
+    } while (0)
+#endif
+
+// Relative tolerance on the fraction of the step where a crossing happens
+#define LION_EVENT_TOLERANCE 1e-9
+
+static double event_value(const lion_event_t *event, const lion_sim_state_t *state) { return *(const double *)((const char *)state + event->offset); }
+
+static int event_holds(const lion_event_t *event, double value) {
+  switch (event->kind) {
+  case LION_EVENT_ABOVE:
+    return value > event->threshold;
+  case LION_EVENT_BELOW:
+    return value < event->threshold;
+  default:
+    return value >= event->threshold;
+  }
+}
+
+lion_status_t lion_sim_events_add(lion_sim_t *sim, const lion_event_config_t *conf, size_t *out) {
+  double *field = lion_sim_state_field(&sim->state, conf->field);
+  if (field == NULL) {
+    logi_error("Unknown state field '%s'", conf->field);
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_event_t *events = lion_realloc(sim, sim->events, (sim->n_events + 1) * sizeof(lion_event_t));
+  if (events == NULL) {
+    logi_error("Could not allocate event");
+    return LION_STATUS_FAILURE;
+  }
+  logi_debug("Watching '%s' at index %zu", conf->field, sim->n_events);
+  events[sim->n_events] = (lion_event_t){
+    .kind       = conf->kind,
+    .offset     = (size_t)((char *)field - (char *)&sim->state),
+    .threshold  = conf->threshold,
+    .action     = conf->action,
+    .hook       = conf->hook,
+    .count      = 0,
+    .first_time = NAN,
+    .last_time  = NAN,
+    .fired      = 0,
+  };
+  sim->events = events;
+  if (out != NULL) {
+    *out = sim->n_events;
+  }
+  sim->n_events++;
+  return LION_STATUS_SUCCESS;
+}
+
+const lion_event_t *lion_sim_event(const lion_sim_t *sim, size_t index) {
+  if (index >= sim->n_events) {
+    return NULL;
+  }
+  return &sim->events[index];
+}
+
+void lion_sim_events_reset(lion_sim_t *sim) {
+  for (size_t i = 0; i < sim->n_events; i++) {
+    sim->events[i].count      = 0;
+    sim->events[i].first_time = NAN;
+    sim->events[i].last_time  = NAN;
+    sim->events[i].fired      = 0;
+  }
+  sim->_events_span = 0.0;
+  EV_STORE(sim->_close, LION_CLOSE_NONE);
+}
+
+lion_status_t lion_sim_events_remove(lion_sim_t *sim, size_t index) {
+  if (index >= sim->n_events) {
+    logi_error("No event at index %zu", index);
+    return LION_STATUS_FAILURE;
+  }
+  memmove(&sim->events[index], &sim->events[index + 1], (sim->n_events - index - 1) * sizeof(lion_event_t));
+  sim->n_events--;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_sim_events_cleanup(lion_sim_t *sim) {
+  if (sim->events != NULL) {
+    lion_free(sim, sim->events);
+  }
+  sim->events   = NULL;
+  sim->n_events = 0;
+  return LION_STATUS_SUCCESS;
+}
+
+void lion_sim_cancel(lion_sim_t *sim) { EV_STORE(sim->_close, LION_CLOSE_CANCELLED); }
+
+int lion_sim_should_close(lion_sim_t *sim) { return EV_LOAD(sim->_close); }
+
+void lion_sim_events_resume(lion_sim_t *sim) { EV_CLEAR(sim->_close, LION_CLOSE_EVENT); }
+
+// Integrate the previous step over `dt` seconds from its start, with its
+// inputs, and update the outputs at the end of the partial step
+static lion_status_t event_trial(lion_sim_t *sim, const lion_sim_state_t *previous, double start, double dt, lion_sim_state_t *out) {
+  lion_sim_state_t current = sim->state;
+  uint64_t         budget  = sim->inputs.max_evaluations;
+  double           y[LION_SLV_MAX_DIMENSION];
+  double           t = start;
+
+  sim->state = *previous;
+  lion_slv_blocks_load(&sim->state, sim->params, y);
+  sim->inputs.max_evaluations = 0;
+  int status                  = gsl_odeiv2_driver_reset(sim->driver);
+  if (status == GSL_SUCCESS && dt > 0.0) {
+    status = lion_slv_apply(sim, &t, dt, y);
+  }
+  lion_status_t result = LION_STATUS_FAILURE;
+  if (status == GSL_SUCCESS) {
+    lion_slv_blocks_store(&sim->state, sim->params, y);
+    lion_slv_blocks_advance(&sim->state, sim->params);
+    sim->state.time = start + dt;
+    result          = lion_slv_update(sim);
+    *out            = sim->state;
+  }
+  sim->state                  = current;
+  sim->inputs.max_evaluations = budget;
+  return result;
+}
+
+// Locate the crossing of an event inside the previous step with the Illinois
+// variant of regula falsi. Returns 0 when the field does not cross inside the
+// step with its inputs frozen, so the crossing comes from a jump of the inputs
+static int event_locate(
+    lion_sim_t *sim, const lion_event_t *event, const lion_sim_state_t *previous, double start, double span, lion_sim_state_t *out
+) {
+  lion_sim_state_t trial;
+  double           a  = 0.0;
+  double           b  = 1.0;
+  double           fa = event_value(event, previous) - event->threshold;
+  if (event_trial(sim, previous, start, span, &trial) != LION_STATUS_SUCCESS) {
+    return 0;
+  }
+  double fb = event_value(event, &trial) - event->threshold;
+  if ((fa < 0.0) == (fb < 0.0)) {
+    return 0;
+  }
+  *out     = trial;
+  int side = 0;
+  for (int iter = 0; iter < LION_EVENT_MAXITER && b - a > LION_EVENT_TOLERANCE; iter++) {
+    double c = (a * fb - b * fa) / (fb - fa);
+    if (event_trial(sim, previous, start, c * span, &trial) != LION_STATUS_SUCCESS) {
+      break;
+    }
+    double fc = event_value(event, &trial) - event->threshold;
+    if ((fc < 0.0) == (fb < 0.0)) {
+      b    = c;
+      fb   = fc;
+      *out = trial;
+      if (side == -1) {
+        fa /= 2.0;
+      }
+      side = -1;
+    } else {
+      a  = c;
+      fa = fc;
+      if (side == 1) {
+        fb /= 2.0;
+      }
+      side = 1;
+    }
+    if (fc == 0.0) {
+      *out = trial;
+      break;
+    }
+  }
+  return 1;
+}
+
+lion_status_t lion_sim_events_check(lion_sim_t *sim, const lion_sim_state_t *previous, int *stop) {
+  // Outputs at the previous step are only comparable after a step was integrated
+  double span  = sim->_events_span;
+  int    valid = span > 0.0;
+  double start = sim->state.time - span;
+  double now   = sim->state.time;
+
+  lion_sim_state_t located;
+  double           stop_time  = INFINITY;
+  int              stop_moved = 0;
+  int              integrated = 0;
+  *stop                       = 0;
+  for (size_t i = 0; i < sim->n_events; i++) {
+    lion_event_t *event = &sim->events[i];
+    double        value = event_value(event, &sim->state);
+    int           fired;
+    if (event->kind == LION_EVENT_CROSSING) {
+      fired = valid && event_holds(event, value) != event_holds(event, event_value(event, previous));
+    } else {
+      fired = event_holds(event, value) && !(valid && event_holds(event, event_value(event, previous)));
+    }
+    event->fired = fired;
+    if (!fired) {
+      continue;
+    }
+
+    double           time = now;
+    lion_sim_state_t crossing;
+    int              moved = valid && event_locate(sim, event, previous, start, span, &crossing);
+    integrated            |= valid;
+    if (moved) {
+      time = crossing.time;
+    }
+    event->count++;
+    if (event->count == 1) {
+      event->first_time = time;
+    }
+    event->last_time = time;
+    logi_debug("Event %zu fired at t = %f", i, time);
+
+    if (event->action == LION_EVENT_STOP && time < stop_time) {
+      stop_time  = time;
+      stop_moved = moved;
+      *stop      = 1;
+      if (moved) {
+        located = crossing;
+      }
+    }
+  }
+  // Locating a crossing integrates the step again, which leaves the history
+  // of multistep drivers out of step with the trajectory. Steps where no
+  // event fired keep it, so passive events do not change the run
+  if (integrated) {
+    int status = gsl_odeiv2_driver_reset(sim->driver);
+    LION_GSL_CALL_I(status, "Failed resetting ode driver");
+  }
+
+  if (*stop) {
+    if (stop_moved) {
+      // The step ends at the crossing, which becomes the start of the next one
+      sim->state = located;
+    }
+    logi_info("Stop event fired at t = %f", stop_time);
+    EV_STORE(sim->_close, LION_CLOSE_EVENT);
+  }
+  for (size_t i = 0; i < sim->n_events; i++) {
+    lion_event_t *event = &sim->events[i];
+    if (event->hook != NULL && event->fired) {
+      LION_CALLDF_I(event->hook(sim, i), "Failed calling event hook");
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
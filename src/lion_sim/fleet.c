@@ -0,0 +1,335 @@
+#include "mem.h"
+
+#include <gsl/gsl_math.h>
+#include <lion/fleet.h>
+#include <lion/lion.h>
+#include <lion_math/lion_math.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+#include <string.h>
+
+// Fixed-point iterations of the current, same as lion_rollout
+#define LION_FLEET_CURRENT_ITERS 3
+
+// Intermediate arrays of a step, each of them n_cells long
+enum {
+  FLEET_SCRATCH_SOH,
+  FLEET_SCRATCH_FULL_HEALTH,
+  FLEET_SCRATCH_KAPPA,
+  FLEET_SCRATCH_SOC_USE,
+  FLEET_SCRATCH_EHC,
+  FLEET_SCRATCH_VOC,
+  FLEET_SCRATCH_RESISTANCE,
+  FLEET_SCRATCH_HEAT,
+  FLEET_SCRATCH_COUNT,
+};
+
+// Inputs and decay factors shared by every cell in a step
+typedef struct lion_fleet_consts {
+  double h;
+  double tref;
+  double capacity_nominal;
+  double ambient_temperature;
+  double thermal_resistance;
+  double thermal_decay;
+} lion_fleet_consts_t;
+
+static size_t fleet_data_size(lion_fleet_precision_t precision) { return (precision == LION_FLEET_F32) ? sizeof(float) : sizeof(double); }
+
+static void fleet_step_f64(lion_fleet_t *fleet, const double *power, const lion_fleet_consts_t *c) {
+  lion_params_t *params      = fleet->sim->params;
+  size_t         n           = fleet->n_cells;
+  double        *scratch     = fleet->_scratch;
+  double        *soh         = &scratch[FLEET_SCRATCH_SOH * n];
+  double        *full_health = &scratch[FLEET_SCRATCH_FULL_HEALTH * n];
+  double        *kappa       = &scratch[FLEET_SCRATCH_KAPPA * n];
+  double        *soc_use     = &scratch[FLEET_SCRATCH_SOC_USE * n];
+  double        *ehc         = &scratch[FLEET_SCRATCH_EHC * n];
+  double        *voc         = &scratch[FLEET_SCRATCH_VOC * n];
+  double        *resistance  = &scratch[FLEET_SCRATCH_RESISTANCE * n];
+  double        *heat        = &scratch[FLEET_SCRATCH_HEAT * n];
+  double        *soc         = fleet->soc.data;
+  double        *temperature = fleet->temperature.data;
+  double        *current     = fleet->current.data;
+
+  lion_kappa_batch(temperature, n, params, kappa);
+  lion_soc_usable_batch(soc, kappa, n, params, soc_use);
+  lion_ehc_batch(soc_use, n, params, ehc);
+  lion_voc_batch(soc_use, n, params, voc);
+  for (size_t i = 0; i < n; i++) {
+    voc[i] += ehc[i] * (temperature[i] - c->tref);
+  }
+  for (int iter = 0; iter < LION_FLEET_CURRENT_ITERS; iter++) {
+    // The current solve of the simulation evaluates the resistance at full health
+    lion_resistance_batch(soc_use, current, full_health, n, params, resistance);
+    for (size_t i = 0; i < n; i++) {
+      double half         = voc[i] / (2.0 * resistance[i]);
+      double discriminant = half * half - power[i] / resistance[i];
+      current[i]          = half - sqrt(GSL_MAX_DBL(discriminant, 0.0));
+    }
+  }
+  lion_resistance_batch(soc_use, current, soh, n, params, resistance);
+  lion_generated_heat_batch(current, temperature, resistance, ehc, n, params, heat);
+  for (size_t i = 0; i < n; i++) {
+    double steady   = c->ambient_temperature + heat[i] * c->thermal_resistance;
+    temperature[i]  = steady + (temperature[i] - steady) * c->thermal_decay;
+    soc[i]         -= c->h * current[i] / (kappa[i] * c->capacity_nominal);
+  }
+}
+
+static void fleet_step_f32(lion_fleet_t *fleet, const float *power, const lion_fleet_consts_t *c) {
+  lion_params_t *params      = fleet->sim->params;
+  size_t         n           = fleet->n_cells;
+  float         *scratch     = fleet->_scratch;
+  float         *soh         = &scratch[FLEET_SCRATCH_SOH * n];
+  float         *full_health = &scratch[FLEET_SCRATCH_FULL_HEALTH * n];
+  float         *kappa       = &scratch[FLEET_SCRATCH_KAPPA * n];
+  float         *soc_use     = &scratch[FLEET_SCRATCH_SOC_USE * n];
+  float         *ehc         = &scratch[FLEET_SCRATCH_EHC * n];
+  float         *voc         = &scratch[FLEET_SCRATCH_VOC * n];
+  float         *resistance  = &scratch[FLEET_SCRATCH_RESISTANCE * n];
+  float         *heat        = &scratch[FLEET_SCRATCH_HEAT * n];
+  float         *soc         = fleet->soc.data;
+  float         *temperature = fleet->temperature.data;
+  float         *current     = fleet->current.data;
+  float          h           = (float)c->h;
+  float          tref        = (float)c->tref;
+  float          capacity    = (float)c->capacity_nominal;
+  float          ambient     = (float)c->ambient_temperature;
+  float          rt          = (float)c->thermal_resistance;
+  float          decay       = (float)c->thermal_decay;
+
+  lion_kappa_batch_f(temperature, n, params, kappa);
+  lion_soc_usable_batch_f(soc, kappa, n, params, soc_use);
+  lion_ehc_batch_f(soc_use, n, params, ehc);
+  lion_voc_batch_f(soc_use, n, params, voc);
+  for (size_t i = 0; i < n; i++) {
+    voc[i] += ehc[i] * (temperature[i] - tref);
+  }
+  for (int iter = 0; iter < LION_FLEET_CURRENT_ITERS; iter++) {
+    lion_resistance_batch_f(soc_use, current, full_health, n, params, resistance);
+    for (size_t i = 0; i < n; i++) {
+      float half         = voc[i] / (2.0f * resistance[i]);
+      float discriminant = half * half - power[i] / resistance[i];
+      current[i]         = half - sqrtf((discriminant > 0.0f) ? discriminant : 0.0f);
+    }
+  }
+  lion_resistance_batch_f(soc_use, current, soh, n, params, resistance);
+  lion_generated_heat_batch_f(current, temperature, resistance, ehc, n, params, heat);
+  for (size_t i = 0; i < n; i++) {
+    float steady    = ambient + heat[i] * rt;
+    temperature[i]  = steady + (temperature[i] - steady) * decay;
+    soc[i]         -= h * current[i] / (kappa[i] * capacity);
+  }
+}
+
+lion_status_t lion_fleet_reset(lion_fleet_t *fleet) {
+  logi_debug("Resetting fleet");
+  lion_sim_state_t *state = &fleet->sim->state;
+  size_t            n     = fleet->n_cells;
+  if (fleet->precision == LION_FLEET_F32) {
+    float *scratch = fleet->_scratch;
+    for (size_t i = 0; i < n; i++) {
+      ((float *)fleet->soc.data)[i]              = (float)state->_next_soc_nominal;
+      ((float *)fleet->temperature.data)[i]      = (float)state->_next_internal_temperature;
+      ((float *)fleet->current.data)[i]          = (float)state->current;
+      scratch[FLEET_SCRATCH_SOH * n + i]         = (float)state->soh;
+      scratch[FLEET_SCRATCH_FULL_HEALTH * n + i] = 1.0f;
+    }
+  } else {
+    double *scratch = fleet->_scratch;
+    for (size_t i = 0; i < n; i++) {
+      ((double *)fleet->soc.data)[i]             = state->_next_soc_nominal;
+      ((double *)fleet->temperature.data)[i]     = state->_next_internal_temperature;
+      ((double *)fleet->current.data)[i]         = state->current;
+      scratch[FLEET_SCRATCH_SOH * n + i]         = state->soh;
+      scratch[FLEET_SCRATCH_FULL_HEALTH * n + i] = 1.0;
+    }
+  }
+  fleet->time = 0.0;
+  fleet->step = 0;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_fleet_new(lion_sim_t *sim, size_t n_cells, lion_fleet_precision_t precision, lion_fleet_t *out) {
+  if (sim->driver == NULL) {
+    logi_error("Fleets require an initialized simulation");
+    return LION_STATUS_FAILURE;
+  }
+  if (n_cells == 0) {
+    logi_error("Fleet must have at least one cell");
+    return LION_STATUS_FAILURE;
+  }
+  if (precision != LION_FLEET_F64 && precision != LION_FLEET_F32) {
+    logi_error("Fleet precision not valid");
+    return LION_STATUS_FAILURE;
+  }
+  if (sim->params->rc.n_branches > 0) {
+    logi_error("Fleets do not support RC branches yet");
+    return LION_STATUS_FAILURE;
+  }
+
+  logi_info("Creating fleet of %zu cells in %s precision", n_cells, (precision == LION_FLEET_F32) ? "single" : "double");
+  size_t       data_size = fleet_data_size(precision);
+  lion_fleet_t fleet     = {
+    .sim       = sim,
+    .n_cells   = n_cells,
+    .precision = precision,
+    ._scratch  = lion_malloc(sim, FLEET_SCRATCH_COUNT * n_cells * data_size),
+  };
+  if (fleet._scratch == NULL) {
+    logi_error("Could not allocate fleet scratch space");
+    return LION_STATUS_FAILURE;
+  }
+  if (lion_vector_zero(sim, n_cells, data_size, &fleet.soc) != LION_STATUS_SUCCESS
+      || lion_vector_zero(sim, n_cells, data_size, &fleet.temperature) != LION_STATUS_SUCCESS
+      || lion_vector_zero(sim, n_cells, data_size, &fleet.current) != LION_STATUS_SUCCESS) {
+    logi_error("Could not allocate fleet state");
+    LION_CALL_I(lion_fleet_cleanup(&fleet), "Failed cleaning up fleet");
+    return LION_STATUS_FAILURE;
+  }
+  LION_CALL_I(lion_fleet_reset(&fleet), "Failed resetting fleet");
+  *out = fleet;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_fleet_step(lion_fleet_t *fleet, const lion_vector_t *power, double ambient_temperature) {
+  if (power->len != fleet->n_cells || power->data_size != fleet->soc.data_size) {
+    logi_error("Fleet power must hold one element of the precision of the fleet per cell");
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_sim_t    *sim    = fleet->sim;
+  lion_params_t *params = sim->params;
+  lion_fleet_consts_t c = {
+    .h                   = sim->conf->sim_step_seconds,
+    .tref                = params->vft.tref,
+    .capacity_nominal    = lion_capacity_nominal(params->init.capacity, sim->state.soh, params),
+    .ambient_temperature = ambient_temperature,
+    .thermal_resistance  = params->temp.rin + params->temp.rout,
+  };
+  c.thermal_decay = exp(-c.h / (params->temp.cp * c.thermal_resistance));
+
+  if (fleet->precision == LION_FLEET_F32) {
+    fleet_step_f32(fleet, power->data, &c);
+  } else {
+    fleet_step_f64(fleet, power->data, &c);
+  }
+  fleet->time += c.h;
+  fleet->step++;
+  return LION_STATUS_SUCCESS;
+}
+
+double lion_fleet_soc(const lion_fleet_t *fleet, size_t cell) {
+  if (fleet->precision == LION_FLEET_F32) {
+    return ((const float *)fleet->soc.data)[cell];
+  }
+  return ((const double *)fleet->soc.data)[cell];
+}
+
+double lion_fleet_temperature(const lion_fleet_t *fleet, size_t cell) {
+  if (fleet->precision == LION_FLEET_F32) {
+    return ((const float *)fleet->temperature.data)[cell];
+  }
+  return ((const double *)fleet->temperature.data)[cell];
+}
+
+lion_status_t lion_fleet_validate(lion_fleet_t *fleet, const double *power, size_t n_steps, double ambient_temperature, lion_fleet_drift_t *out) {
+  lion_sim_t *sim = fleet->sim;
+  size_t      n   = fleet->n_cells;
+  if (n_steps == 0) {
+    logi_error("Validation requires at least one step");
+    return LION_STATUS_FAILURE;
+  }
+
+  // Reference trajectories of every cell, step by step
+  double *reference = lion_malloc(sim, 2 * n_steps * n * sizeof(double));
+  if (reference == NULL) {
+    logi_error("Could not allocate reference trajectories");
+    return LION_STATUS_FAILURE;
+  }
+  double *ref_soc         = reference;
+  double *ref_temperature = &reference[n_steps * n];
+  for (size_t i = 0; i < n; i++) {
+    lion_sim_t fork;
+    if (lion_sim_fork(sim, &fork) != LION_STATUS_SUCCESS) {
+      logi_error("Failed forking simulation");
+      lion_free(sim, reference);
+      return LION_STATUS_FAILURE;
+    }
+    for (size_t t = 0; t < n_steps; t++) {
+      if (lion_sim_step(&fork, power[t * n + i], ambient_temperature) != LION_STATUS_SUCCESS) {
+        logi_error("Failed stepping reference of cell %zu", i);
+        lion_sim_cleanup(&fork);
+        lion_free(sim, reference);
+        return LION_STATUS_FAILURE;
+      }
+      ref_soc[t * n + i]         = fork.state._next_soc_nominal;
+      ref_temperature[t * n + i] = fork.state._next_internal_temperature;
+    }
+    lion_sim_cleanup(&fork);
+  }
+
+  lion_vector_t step_power;
+  if (lion_vector_zero(sim, n, fleet->soc.data_size, &step_power) != LION_STATUS_SUCCESS) {
+    logi_error("Failed allocating power of a step");
+    lion_free(sim, reference);
+    return LION_STATUS_FAILURE;
+  }
+  LION_CALL_I(lion_fleet_reset(fleet), "Failed resetting fleet");
+  lion_fleet_drift_t drift          = {0};
+  double             soc_sq         = 0.0;
+  double             temperature_sq = 0.0;
+  lion_status_t      status         = LION_STATUS_SUCCESS;
+  for (size_t t = 0; t < n_steps && status == LION_STATUS_SUCCESS; t++) {
+    for (size_t i = 0; i < n; i++) {
+      if (fleet->precision == LION_FLEET_F32) {
+        ((float *)step_power.data)[i] = (float)power[t * n + i];
+      } else {
+        ((double *)step_power.data)[i] = power[t * n + i];
+      }
+    }
+    status = lion_fleet_step(fleet, &step_power, ambient_temperature);
+    for (size_t i = 0; i < n; i++) {
+      double soc_err          = fabs(lion_fleet_soc(fleet, i) - ref_soc[t * n + i]);
+      double temperature_err  = fabs(lion_fleet_temperature(fleet, i) - ref_temperature[t * n + i]);
+      soc_sq                 += soc_err * soc_err;
+      temperature_sq         += temperature_err * temperature_err;
+      if (soc_err > drift.soc_max) {
+        drift.soc_max    = soc_err;
+        drift.worst_cell = i;
+      }
+      drift.temperature_max = GSL_MAX_DBL(drift.temperature_max, temperature_err);
+    }
+  }
+  drift.soc_rms         = sqrt(soc_sq / (double)(n_steps * n));
+  drift.temperature_rms = sqrt(temperature_sq / (double)(n_steps * n));
+  logi_info(
+      "Fleet drift: soc max %g rms %g, temperature max %g rms %g (worst cell %zu)",
+      drift.soc_max,
+      drift.soc_rms,
+      drift.temperature_max,
+      drift.temperature_rms,
+      drift.worst_cell
+  );
+
+  lion_vector_cleanup(sim, &step_power);
+  lion_free(sim, reference);
+  if (status != LION_STATUS_SUCCESS) {
+    logi_error("Failed stepping fleet");
+    return status;
+  }
+  *out = drift;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_fleet_cleanup(lion_fleet_t *fleet) {
+  logi_debug("Cleaning up fleet");
+  LION_CALL_I(lion_vector_cleanup(fleet->sim, &fleet->soc), "Failed cleaning up state of charge");
+  LION_CALL_I(lion_vector_cleanup(fleet->sim, &fleet->temperature), "Failed cleaning up temperature");
+  LION_CALL_I(lion_vector_cleanup(fleet->sim, &fleet->current), "Failed cleaning up current");
+  lion_free(fleet->sim, fleet->_scratch);
+  fleet->_scratch = NULL;
+  return LION_STATUS_SUCCESS;
+}
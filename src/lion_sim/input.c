@@ -0,0 +1,163 @@
+#include "sim_run.h"
+
+#include <lion/input.h>
+#include <lion/lion.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+
+// Samples scanned forward from the cursor before falling back to a binary search
+#define LION_INPUT_SCAN 8
+// Times that land on a sample of a fixed rate channel up to rounding use that
+// sample, as a fraction of the period
+#define LION_INPUT_TIME_TOLERANCE 1e-9
+
+static lion_status_t channel_check(lion_interp_t interp, size_t n) {
+  if (interp != LION_INTERP_ZOH && interp != LION_INTERP_LINEAR && interp != LION_INTERP_CUBIC) {
+    logi_error("Interpolation not valid");
+    return LION_STATUS_FAILURE;
+  }
+  if (n == 0) {
+    logi_error("Channels need at least one sample");
+    return LION_STATUS_FAILURE;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_input_channel_new(lion_sim_t *sim, const lion_vector_t *values, double start, double period, lion_interp_t interp, lion_input_channel_t *out) {
+  lion_vector_view_d_t view;
+  LION_CALL_I(lion_vector_view_d(sim, values, &view), "Samples must be a vector of doubles");
+  LION_CALL_I(channel_check(interp, view.len), "Invalid channel");
+  if (!(period > 0.0)) {
+    logi_error("The period of a channel must be positive");
+    return LION_STATUS_FAILURE;
+  }
+  *out = (lion_input_channel_t){
+    .values = view.data,
+    .times  = NULL,
+    .n      = view.len,
+    .start  = start,
+    .period = period,
+    .interp = interp,
+    .cursor = 0,
+  };
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_input_channel_new_timed(
+    lion_sim_t *sim, const lion_vector_t *values, const lion_vector_t *times, lion_interp_t interp, lion_input_channel_t *out
+) {
+  lion_vector_view_d_t values_view, times_view;
+  LION_CALL_I(lion_vector_view_d(sim, values, &values_view), "Samples must be a vector of doubles");
+  LION_CALL_I(lion_vector_view_d(sim, times, &times_view), "Times must be a vector of doubles");
+  LION_CALL_I(channel_check(interp, values_view.len), "Invalid channel");
+  if (times_view.len != values_view.len) {
+    logi_error("Got %zu times for %zu samples", times_view.len, values_view.len);
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t i = 1; i < times_view.len; i++) {
+    if (!(times_view.data[i] > times_view.data[i - 1])) {
+      logi_error("Times must be strictly increasing, sample %zu is not", i);
+      return LION_STATUS_FAILURE;
+    }
+  }
+  *out = (lion_input_channel_t){
+    .values = values_view.data,
+    .times  = times_view.data,
+    .n      = values_view.len,
+    .start  = times_view.data[0],
+    .period = 0.0,
+    .interp = interp,
+    .cursor = 0,
+  };
+  return LION_STATUS_SUCCESS;
+}
+
+static double channel_time(const lion_input_channel_t *channel, size_t k) {
+  return (channel->times != NULL) ? channel->times[k] : channel->start + (double)k * channel->period;
+}
+
+// Index of the last sample at or before `time`, the first one if there is none
+static size_t channel_seek(lion_input_channel_t *channel, double time) {
+  size_t last = channel->n - 1;
+  if (channel->times == NULL) {
+    double x          = floor((time - channel->start) / channel->period + LION_INPUT_TIME_TOLERANCE);
+    channel->cursor   = (x <= 0.0) ? 0 : (x >= (double)last) ? last : (size_t)x;
+    return channel->cursor;
+  }
+
+  // Sweeps forward in time only scan a few samples past the cursor, and
+  // anything else is a binary search over the samples left on that side
+  const double *times = channel->times;
+  size_t        k     = channel->cursor;
+  size_t        lo    = 0;
+  size_t        hi    = k;
+  if (time >= times[k]) {
+    size_t limit = (last - k < LION_INPUT_SCAN) ? last : k + LION_INPUT_SCAN;
+    while (k < limit && times[k + 1] <= time) {
+      k++;
+    }
+    lo = k;
+    hi = (k < limit) ? k : last;
+  }
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo + 1) / 2;
+    if (times[mid] <= time) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  channel->cursor = lo;
+  return lo;
+}
+
+double lion_input_channel_at(lion_input_channel_t *channel, double time) {
+  size_t        k  = channel_seek(channel, time);
+  const double *y  = channel->values;
+  double        t0 = channel_time(channel, k);
+  if (channel->interp == LION_INTERP_ZOH || k == channel->n - 1 || time <= t0) {
+    return y[k];
+  }
+  double t1 = channel_time(channel, k + 1);
+  double h  = t1 - t0;
+  double s  = (time - t0) / h;
+  if (channel->interp == LION_INTERP_LINEAR) {
+    return y[k] + s * (y[k + 1] - y[k]);
+  }
+
+  // Catmull-Rom tangents from the neighbouring samples, one-sided at the ends
+  double m0  = (k > 0) ? (y[k + 1] - y[k - 1]) / (t1 - channel_time(channel, k - 1)) : (y[k + 1] - y[k]) / h;
+  double m1  = (k + 2 < channel->n) ? (y[k + 2] - y[k]) / (channel_time(channel, k + 2) - t0) : (y[k + 1] - y[k]) / h;
+  double s2  = s * s;
+  double s3  = s2 * s;
+  double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+  double h10 = s3 - 2.0 * s2 + s;
+  double h01 = -2.0 * s3 + 3.0 * s2;
+  double h11 = s3 - s2;
+  return h00 * y[k] + h10 * h * m0 + h01 * y[k + 1] + h11 * h * m1;
+}
+
+double lion_input_channel_end(const lion_input_channel_t *channel) { return channel_time(channel, channel->n - 1); }
+
+void lion_input_channel_rewind(lion_input_channel_t *channel) { channel->cursor = 0; }
+
+lion_status_t lion_sim_run_inputs(lion_sim_t *sim, lion_input_channel_t *power, lion_input_channel_t *ambient_temperature) {
+  logi_info("Simulation start");
+#ifndef NDEBUG
+  if (sim->_idebug_heap_head == NULL)
+    LION_CALL_I(lion_sim_init_debug(sim), "Failed initializing debug information");
+#endif
+
+  if (power != NULL && ambient_temperature != NULL) {
+    logi_info("Initializing simulation");
+    LION_CALL_I(lion_sim_init(sim), "Failed initializing sim");
+
+    logi_debug("Running simulation");
+    LION_CALL_I(lion_sim_simulate_inputs(sim, power, ambient_temperature), "Failed simulating system");
+  } else {
+    logi_error("Null arguments were passed, skipping simulation running");
+  }
+
+  return LION_STATUS_SUCCESS;
+}
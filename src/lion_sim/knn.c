@@ -4,12 +4,18 @@
 #include <lion_utils/vendor/log.h>
 #include <lionu/knn.h>
 #include <math.h>
+#include <stdlib.h>
 
 double euclidean_distance(lion_sim_t *sim, const lion_vector_t *x, const lion_vector_t *y) {
-  // Assume both have same lengths and contain doubles
+  // Assume both have same lengths
+  lion_vector_view_d_t xv, yv;
+  if (lion_vector_view_d(sim, x, &xv) != LION_STATUS_SUCCESS || lion_vector_view_d(sim, y, &yv) != LION_STATUS_SUCCESS) {
+    logi_error("Distances require vectors of doubles");
+    return NAN;
+  }
   double sum = 0.0;
-  for (size_t i = 0; i < x->len; i++) {
-    double diff  = lion_vector_get_d(sim, x, i) - lion_vector_get_d(sim, y, i);
+  for (size_t i = 0; i < xv.len; i++) {
+    double diff  = xv.data[i] - yv.data[i];
     sum         += diff * diff;
   }
   return sqrt(sum);
@@ -25,15 +31,13 @@ lion_status_t lion_knn_regressor_init(lion_sim_t *sim, size_t n_neighbors, lion_
   lion_knn_regressor_t ret;
   ret.n_neighbors = n_neighbors;
   ret.is_trained  = 0;
-  ret._neighbors  = NULL;
 
   *out = ret;
   return LION_STATUS_SUCCESS;
 }
 
 lion_status_t lion_knn_regressor_cleanup(lion_sim_t *sim, lion_knn_regressor_t *knn) {
-  if (knn->is_trained)
-    lion_free(sim, knn->_neighbors);
+  knn->is_trained = 0;
   return LION_STATUS_SUCCESS;
 }
 
@@ -41,26 +45,31 @@ lion_status_t lion_knn_regressor_fit(lion_sim_t *sim, lion_knn_regressor_t *knn,
   if (knn->is_trained)
     logi_warn("Retraining already trained KNN regressor");
 
-  // Setting up neighbors
-  lion_knn_neighbor_t *neighbors = lion_malloc(sim, n_samples * sizeof(lion_knn_neighbor_t));
-  knn->_dataset                  = dataset;
-  knn->_neighbors                = neighbors;
-  knn->_n_samples                = n_samples;
+  knn->_dataset   = dataset;
+  knn->_n_samples = n_samples;
 
   knn->is_trained = 1;
   return LION_STATUS_SUCCESS;
 }
 
-double lion_knn_regressor_predict(lion_sim_t *sim, lion_knn_regressor_t *knn, lion_vector_t *X) {
+double lion_knn_regressor_predict(lion_sim_t *sim, const lion_knn_regressor_t *knn, lion_vector_t *X) {
+  // Neighbors are sorted in a local buffer so a trained regressor can be
+  // shared between simulations
+  lion_knn_neighbor_t *neighbors = lion_malloc(sim, knn->_n_samples * sizeof(lion_knn_neighbor_t));
+  if (neighbors == NULL) {
+    logi_error("Could not allocate neighbors");
+    return NAN;
+  }
   for (size_t i = 0; i < knn->_n_samples; i++) {
-    knn->_neighbors[i].distance = euclidean_distance(sim, X, &knn->_dataset[i].X);
-    knn->_neighbors[i].target   = knn->_dataset[i].y;
+    neighbors[i].distance = euclidean_distance(sim, X, &knn->_dataset[i].X);
+    neighbors[i].target   = knn->_dataset[i].y;
   }
-  qsort(knn->_neighbors, knn->_n_samples, sizeof(lion_knn_neighbor_t), compare_neighbors);
+  qsort(neighbors, knn->_n_samples, sizeof(lion_knn_neighbor_t), compare_neighbors);
 
   double sum = 0.0;
   for (size_t i = 0; i < knn->n_neighbors; i++) {
-    sum += knn->_neighbors[i].target;
+    sum += neighbors[i].target;
   }
-  return sum / knn->n_neighbors;
+  lion_free(sim, neighbors);
+  return sum / (double)knn->n_neighbors;
 }
@@ -39,6 +39,12 @@ const char *lion_stepper_name(lion_stepper_t stepper) {
     return "LION_STEPPER_MSADAMS";
   case LION_STEPPER_MSBDF:
     return "LION_STEPPER_MSBDF";
+  case LION_STEPPER_NATIVE_RK4:
+    return "LION_STEPPER_NATIVE_RK4";
+  case LION_STEPPER_NATIVE_RK45:
+    return "LION_STEPPER_NATIVE_RK45";
+  case LION_STEPPER_NATIVE_ROS2:
+    return "LION_STEPPER_NATIVE_ROS2";
   default:
     return "N/A";
   }
@@ -72,3 +78,54 @@ const char *lion_jacobian_name(lion_jacobian_method_t jacobian) {
   }
   return "Unexpected return";
 }
+
+const char *lion_input_hold_name(lion_input_hold_t hold) {
+  switch (hold) {
+  case LION_HOLD_ZERO:
+    return "LION_HOLD_ZERO";
+  case LION_HOLD_FIRST:
+    return "LION_HOLD_FIRST";
+  default:
+    return "N/A";
+  }
+  return "Unexpected return";
+}
+
+const char *lion_jump_name(lion_jump_t jump) {
+  switch (jump) {
+  case LION_JUMP_NONE:
+    return "LION_JUMP_NONE";
+  case LION_JUMP_REST:
+    return "LION_JUMP_REST";
+  case LION_JUMP_CONSTANT:
+    return "LION_JUMP_CONSTANT";
+  default:
+    return "N/A";
+  }
+  return "Unexpected return";
+}
+
+const char *lion_sweep_metric_name(lion_sweep_metric_t metric) {
+  switch (metric) {
+  case LION_SWEEP_FINAL_SOC:
+    return "LION_SWEEP_FINAL_SOC";
+  case LION_SWEEP_FINAL_SOH:
+    return "LION_SWEEP_FINAL_SOH";
+  case LION_SWEEP_FINAL_TEMPERATURE:
+    return "LION_SWEEP_FINAL_TEMPERATURE";
+  case LION_SWEEP_MAX_TEMPERATURE:
+    return "LION_SWEEP_MAX_TEMPERATURE";
+  case LION_SWEEP_MIN_VOLTAGE:
+    return "LION_SWEEP_MIN_VOLTAGE";
+  case LION_SWEEP_MAX_VOLTAGE:
+    return "LION_SWEEP_MAX_VOLTAGE";
+  case LION_SWEEP_MEAN_VOLTAGE:
+    return "LION_SWEEP_MEAN_VOLTAGE";
+  case LION_SWEEP_CHARGE_THROUGHPUT:
+    return "LION_SWEEP_CHARGE_THROUGHPUT";
+  case LION_SWEEP_CYCLES:
+    return "LION_SWEEP_CYCLES";
+  default:
+    return "N/A";
+  }
+}
@@ -0,0 +1,329 @@
+#include "mem.h"
+#include "solver/sys.h"
+#include "solver/thermal.h"
+#include "solver/update.h"
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_odeiv2.h>
+#include <gsl/gsl_randist.h>
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion/pack.h>
+#include <lion_math/lion_math.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+#include <string.h>
+
+#define LION_PACK_NEWTON_MAXITER   50
+#define LION_PACK_NEWTON_TOLERANCE 1e-10
+#define LION_PACK_FD_STEP          1e-6
+
+static void pack_cell_reset(lion_sim_state_t *cell, lion_params_t *params) {
+  memset(cell, 0, sizeof(lion_sim_state_t));
+  cell->_next_soc_nominal          = params->init.soc;
+  cell->_next_internal_temperature = params->init.temp_in;
+  cell->_soc_min                   = 1.0;
+  cell->soh                        = params->init.soh;
+  cell->current                    = params->init.current_guess;
+}
+
+lion_status_t lion_pack_reset(lion_pack_t *pack) {
+  logi_debug("Resetting pack");
+  for (size_t c = 0; c < pack->n_cells; c++) {
+    pack_cell_reset(&pack->cells[c], &pack->params[c]);
+  }
+  for (size_t s = 0; s < pack->n_parallel; s++) {
+    pack->string_current[s] = 0.0;
+  }
+  pack->time    = 0.0;
+  pack->step    = 0;
+  pack->power   = 0.0;
+  pack->voltage = 0.0;
+  pack->current = 0.0;
+  if (pack->thermal.solver != NULL) {
+    LION_CALL_I(lion_slv_thermal_reset(&pack->thermal), "Failed resetting thermal network");
+  }
+
+  for (size_t c = 0; c < pack->n_cells && pack->drivers != NULL; c++) {
+    int status = gsl_odeiv2_driver_reset(pack->drivers[c]);
+    LION_GSL_CALL_I(status, "Failed resetting ode driver");
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_pack_new(lion_sim_t *sim, const lion_pack_config_t *conf, lion_pack_t *out) {
+  if (sim->driver == NULL || sim->rng == NULL) {
+    logi_error("Packs require an initialized simulation");
+    return LION_STATUS_FAILURE;
+  }
+  if (conf->n_series == 0 || conf->n_parallel == 0) {
+    logi_error("Pack must have at least one cell (%zus%zup)", conf->n_series, conf->n_parallel);
+    return LION_STATUS_FAILURE;
+  }
+  if (sim->params->rc.n_branches > 0) {
+    logi_error("Packs do not support RC branches yet");
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t v = 0; v < conf->n_variation; v++) {
+    if (lion_params_field(sim->params, conf->variation[v].name) == NULL) {
+      logi_error("Unknown parameter '%s'", conf->variation[v].name);
+      return LION_STATUS_FAILURE;
+    }
+  }
+
+  size_t n_cells = conf->n_series * conf->n_parallel;
+  logi_info("Creating %zus%zup pack (%zu cells)", conf->n_series, conf->n_parallel, n_cells);
+  lion_pack_t pack = {
+    .sim            = sim,
+    .n_series       = conf->n_series,
+    .n_parallel     = conf->n_parallel,
+    .n_cells        = n_cells,
+    .params         = lion_malloc(sim, n_cells * sizeof(lion_params_t)),
+    .cells          = lion_malloc(sim, n_cells * sizeof(lion_sim_state_t)),
+    .string_current = lion_malloc(sim, 3 * conf->n_parallel * sizeof(double)),
+    .y              = lion_malloc(sim, 2 * n_cells * sizeof(double)),
+    .inputs         = lion_malloc(sim, n_cells * sizeof(lion_slv_pack_inputs_t)),
+    .sys            = lion_malloc(sim, n_cells * sizeof(gsl_odeiv2_system)),
+    .drivers        = NULL,
+  };
+  if (pack.params == NULL || pack.cells == NULL || pack.string_current == NULL || pack.y == NULL || pack.inputs == NULL || pack.sys == NULL) {
+    logi_error("Could not allocate pack");
+    lion_free(sim, pack.params);
+    lion_free(sim, pack.cells);
+    lion_free(sim, pack.string_current);
+    lion_free(sim, pack.y);
+    lion_free(sim, pack.inputs);
+    lion_free(sim, pack.sys);
+    return LION_STATUS_FAILURE;
+  }
+  pack._newton = pack.string_current + conf->n_parallel;
+
+  for (size_t c = 0; c < n_cells; c++) {
+    pack.params[c] = *sim->params;
+    for (size_t v = 0; v < conf->n_variation; v++) {
+      double *field = lion_params_field(&pack.params[c], conf->variation[v].name);
+      *field       *= 1.0 + gsl_ran_gaussian(sim->rng, conf->variation[v].spread);
+    }
+  }
+  *out = pack;
+
+  if (sim->conf->sim_regime != LION_ONLYSF) {
+    if (lion_slv_thermal_new(sim, conf->thermal, n_cells, out->params, &out->thermal) != LION_STATUS_SUCCESS) {
+      logi_error("Failed creating thermal network");
+      LION_CALL_I(lion_pack_cleanup(out), "Failed cleaning up pack");
+      return LION_STATUS_FAILURE;
+    }
+  } else if (conf->thermal != NULL) {
+    logi_warn("Thermal network is ignored in the %s regime", lion_regime_name(LION_ONLYSF));
+  }
+
+  // The solver handles point into the pack, so they are created in place.
+  // Every cell gets its own two state system, so the implicit steppers only
+  // ever see its 2x2 block of the Jacobian
+  out->drivers = lion_malloc(sim, n_cells * sizeof(gsl_odeiv2_driver *));
+  if (out->drivers == NULL) {
+    logi_error("Could not allocate pack drivers");
+    LION_CALL_I(lion_pack_cleanup(out), "Failed cleaning up pack");
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t c = 0; c < n_cells; c++) {
+    out->drivers[c] = NULL;
+  }
+  for (size_t c = 0; c < n_cells; c++) {
+    out->inputs[c]        = (lion_slv_pack_inputs_t){.n_cells = 1, .cells = &out->cells[c], .params = &out->params[c]};
+    gsl_odeiv2_system sys = {
+      .function  = &lion_slv_system_pack,
+      .jacobian  = (sim->conf->sim_jacobian == LION_JACOBIAN_ANALYTICAL) ? &lion_slv_jac_pack : NULL,
+      .dimension = 2,
+      .params    = &out->inputs[c],
+    };
+    out->sys[c]     = sys;
+    out->drivers[c] = gsl_odeiv2_driver_alloc_y_new(&out->sys[c], sim->step_type, sim->conf->sim_step_seconds, sim->conf->sim_epsabs, sim->conf->sim_epsrel);
+    if (out->drivers[c] == NULL) {
+      logi_error("Could not allocate pack driver");
+      LION_CALL_I(lion_pack_cleanup(out), "Failed cleaning up pack");
+      return LION_STATUS_FAILURE;
+    }
+  }
+  LION_CALL_I(lion_pack_reset(out), "Failed resetting pack");
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t pack_share_current(lion_pack_t *pack, double power) {
+  /*
+     Every string s carries a current I_s and every string sees the terminal
+     voltage V of the pack, so the unknowns solve
+
+       g_s = sum_i (voc_i - R_i(I_s) I_s) - V = 0
+       h   = V sum_s I_s - P                  = 0
+
+     The Jacobian of this system is an arrow matrix, with dg_s/dI_s = -a_s in
+     the diagonal, so each Newton step is solved by eliminating the currents
+     in O(n_parallel) instead of factorizing it
+  */
+  size_t  m = pack->n_parallel;
+  double *I = pack->string_current;
+  double *g = pack->_newton;
+  double *a = pack->_newton + m;
+  double  V = pack->voltage;
+
+  if (pack->step == 0) {
+    // No previous solution, so start from an even split at open circuit
+    V = 0.0;
+    for (size_t i = 0; i < pack->n_series; i++) {
+      V += pack->cells[i].open_circuit_voltage;
+    }
+    for (size_t s = 0; s < m; s++) {
+      I[s] = power / (V * (double)m);
+    }
+  }
+
+  for (int iter = 0; iter < LION_PACK_NEWTON_MAXITER; iter++) {
+    double sum_current = 0.0;
+    double sum_inv_a   = 0.0;
+    double sum_g_a     = 0.0;
+    double max_g       = 0.0;
+    for (size_t s = 0; s < m; s++) {
+      double v_s = 0.0;
+      a[s]       = 0.0;
+      for (size_t i = 0; i < pack->n_series; i++) {
+        lion_sim_state_t *cell   = &pack->cells[s * pack->n_series + i];
+        lion_params_t    *params = &pack->params[s * pack->n_series + i];
+        double            h      = LION_PACK_FD_STEP * fmax(fabs(I[s]), 1.0);
+        // Same resistance as the current solve of a single cell, which
+        // evaluates it at unit state of health
+        double r    = lion_resistance(cell->soc_use, I[s], 1.0, params);
+        double r_p  = lion_resistance(cell->soc_use, I[s] + h, 1.0, params);
+        double r_m  = lion_resistance(cell->soc_use, I[s] - h, 1.0, params);
+        v_s        += cell->open_circuit_voltage - r * I[s];
+        a[s]       += r + I[s] * (r_p - r_m) / (2.0 * h);
+      }
+      g[s]         = v_s - V;
+      sum_current += I[s];
+      sum_inv_a   += 1.0 / a[s];
+      sum_g_a     += g[s] / a[s];
+      max_g        = fmax(max_g, fabs(g[s]));
+    }
+    double h = V * sum_current - power;
+
+    if (max_g <= LION_PACK_NEWTON_TOLERANCE * fmax(fabs(V), 1.0) && fabs(h) <= LION_PACK_NEWTON_TOLERANCE * fmax(fabs(power), 1.0)) {
+      pack->voltage = V;
+      pack->current = sum_current;
+      logi_trace("Current sharing converged after %d iterations", iter);
+      return LION_STATUS_SUCCESS;
+    }
+
+    double dV = (-h - V * sum_g_a) / (sum_current - V * sum_inv_a);
+    for (size_t s = 0; s < m; s++) {
+      I[s] += (g[s] - dV) / a[s];
+    }
+    V += dV;
+  }
+  logi_error("Current sharing did not converge (P = %f W, V = %f V)", power, V);
+  return LION_STATUS_FAILURE;
+}
+
+static lion_status_t pack_integrate_network(lion_pack_t *pack, double ambient_temperature) {
+  // With the inputs frozen over the step the state of charge changes at a
+  // constant rate, so only the temperatures need the implicit solve of the
+  // sparse thermal network
+  double h = pack->sim->conf->sim_step_seconds;
+  LION_CALL_I(lion_slv_thermal_step(&pack->thermal, pack->cells, ambient_temperature), "Failed solving thermal network");
+  for (size_t c = 0; c < pack->n_cells; c++) {
+    lion_sim_state_t *cell = &pack->cells[c];
+    pack->y[2 * c]        += h * lion_soc_d(cell->current, cell->capacity_use, &pack->params[c]);
+    pack->y[2 * c + 1]     = pack->thermal.temperature[c];
+  }
+  pack->time += h;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_pack_step(lion_pack_t *pack, double power, double ambient_temperature) {
+  // Same update logic as lion_sim_step, for every cell at once
+  for (size_t c = 0; c < pack->n_cells; c++) {
+    lion_sim_state_t *cell     = &pack->cells[c];
+    cell->soc_nominal          = cell->_next_soc_nominal;
+    cell->internal_temperature = cell->_next_internal_temperature;
+    cell->ambient_temperature  = (pack->thermal.solver != NULL) ? lion_slv_thermal_surroundings(&pack->thermal, c) : ambient_temperature;
+    lion_slv_update_open_circuit(cell, &pack->params[c]);
+  }
+  LION_VCALL_I(pack_share_current(pack, power), "Failed sharing current at step %" PRIu64, pack->step);
+  pack->power = power;
+
+  for (size_t c = 0; c < pack->n_cells; c++) {
+    lion_sim_state_t *cell      = &pack->cells[c];
+    lion_params_t    *params    = &pack->params[c];
+    cell->current               = pack->string_current[c / pack->n_series];
+    cell->voltage               = cell->open_circuit_voltage - lion_resistance(cell->soc_use, cell->current, 1.0, params) * cell->current;
+    cell->power                 = cell->voltage * cell->current;
+    cell->internal_resistance   = lion_resistance(cell->soc_use, cell->current, cell->soh, params);
+    lion_slv_update_thermal(cell, params);
+    pack->y[2 * c]     = cell->soc_nominal;
+    pack->y[2 * c + 1] = cell->internal_temperature;
+  }
+
+  if (pack->thermal.solver != NULL) {
+    LION_VCALL_I(pack_integrate_network(pack, ambient_temperature), "Failed at step %" PRIu64 " (t = %f)", pack->step, pack->time);
+  } else {
+    double h = pack->sim->conf->sim_step_seconds;
+    for (size_t c = 0; c < pack->n_cells; c++) {
+      double t = pack->time;
+      LION_GSL_VCALL_I(
+          gsl_odeiv2_driver_apply_fixed_step(pack->drivers[c], &t, h, 1, &pack->y[2 * c]),
+          "Failed at step %" PRIu64 " of cell %zu (t = %f)",
+          pack->step,
+          c,
+          pack->time
+      );
+    }
+    pack->time += h;
+  }
+
+  for (size_t c = 0; c < pack->n_cells; c++) {
+    lion_sim_state_t *cell           = &pack->cells[c];
+    cell->_next_soc_nominal          = pack->y[2 * c];
+    cell->_next_internal_temperature = pack->y[2 * c + 1];
+    cell->time                       = pack->time;
+    cell->step                       = pack->step;
+    LION_CALL_I(lion_slv_update_degradation(pack->sim, cell, &pack->params[c]), "Failed updating degradation state");
+  }
+  pack->step++;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_pack_run(lion_pack_t *pack, lion_vector_t *power, lion_vector_t *ambient_temperature) {
+  if (power == NULL || ambient_temperature == NULL) {
+    logi_error("Null arguments were passed, skipping pack simulation");
+    return LION_STATUS_FAILURE;
+  }
+  uint64_t      max_iters = (power->len < ambient_temperature->len) ? power->len : ambient_temperature->len;
+  const double *p         = power->data;
+  const double *amb       = ambient_temperature->data;
+  logi_info("Pack simulation start");
+  for (uint64_t i = 1; i < max_iters; i++) {
+    LION_VCALL_I(lion_pack_step(pack, p[i], amb[i]), "Failed at iteration %" PRIu64, i);
+  }
+  logi_info("Pack simulation finished");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_pack_cleanup(lion_pack_t *pack) {
+  LION_CALL_I(lion_slv_thermal_cleanup(pack->sim, &pack->thermal), "Failed cleaning up thermal network");
+  if (pack->drivers != NULL) {
+    for (size_t c = 0; c < pack->n_cells; c++) {
+      if (pack->drivers[c] != NULL) {
+        gsl_odeiv2_driver_free(pack->drivers[c]);
+      }
+    }
+    lion_free(pack->sim, pack->drivers);
+    pack->drivers = NULL;
+  }
+  lion_free(pack->sim, pack->params);
+  lion_free(pack->sim, pack->cells);
+  lion_free(pack->sim, pack->string_current);
+  lion_free(pack->sim, pack->y);
+  lion_free(pack->sim, pack->inputs);
+  lion_free(pack->sim, pack->sys);
+  return LION_STATUS_SUCCESS;
+}
@@ -0,0 +1,31 @@
+#include "parallel.h"
+
+#ifdef _OPENMP
+  #include <lion_utils/vendor/log.h>
+
+static void log_lock_fn(bool lock, void *udata) {
+  lion_log_lock_t *l = udata;
+  if (lock) {
+    omp_set_lock(&l->lock);
+    if (l->caller != NULL) {
+      l->caller(true, l->caller_udata);
+    }
+  } else {
+    if (l->caller != NULL) {
+      l->caller(false, l->caller_udata);
+    }
+    omp_unset_lock(&l->lock);
+  }
+}
+
+void lion_log_lock_begin(lion_log_lock_t *lock) {
+  omp_init_lock(&lock->lock);
+  log_get_lock(&lock->caller, &lock->caller_udata);
+  log_set_lock(log_lock_fn, lock);
+}
+
+void lion_log_lock_end(lion_log_lock_t *lock) {
+  log_set_lock(lock->caller, lock->caller_udata);
+  omp_destroy_lock(&lock->lock);
+}
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#ifdef _OPENMP
+  #include <lionu/log.h>
+  #include <omp.h>
+
+// Lock that serializes the log across the threads of a parallel region. It is
+// taken before the lock set by the caller, which is put back at the end
+typedef struct lion_log_lock {
+  omp_lock_t lock;
+  log_LockFn caller;
+  void      *caller_udata;
+} lion_log_lock_t;
+
+void lion_log_lock_begin(lion_log_lock_t *lock);
+void lion_log_lock_end(lion_log_lock_t *lock);
+#endif
@@ -2,6 +2,8 @@
 
 #include <lion/lion.h>
 #include <lion_utils/vendor/log.h>
+#include <stddef.h>
+#include <string.h>
 
 #define LION_PARAMS_DEFAULT_INIT                                                                                                                     \
   {                                                                                                                                                  \
@@ -156,15 +158,33 @@
     .params.vendor = LION_PARAMS_DEFAULT_SOH_VENDOR,                                                                                                 \
   }
 
+#define LION_PARAMS_DEFAULT_RC                                                                                                                       \
+  {                                                                                                                                                  \
+    .n_branches  = 0,                                                                                                                                \
+    .resistance  = {0.015, 0.025, 0.03},                                                                                                             \
+    .capacitance = {2000.0, 40000.0, 300000.0},                                                                                                      \
+  }
+
+#define LION_PARAMS_DEFAULT_CALENDAR                                                                                                                 \
+  {                                                                                                                                                  \
+    .rate                  = 0.0,                                                                                                                    \
+    .activation_energy     = 50000.0,                                                                                                                \
+    .reference_temperature = 298.15,                                                                                                                 \
+    .soc_sensitivity       = 1.0,                                                                                                                    \
+    .reference_soc         = 0.5,                                                                                                                    \
+  }
+
 #define LION_PARAMS_DEFAULT                                                                                                                          \
   {                                                                                                                                                  \
-    .init = LION_PARAMS_DEFAULT_INIT,                                                                                                                \
-    .ehc  = LION_PARAMS_DEFAULT_EHC,                                                                                                                 \
-    .ocv  = LION_PARAMS_DEFAULT_OCV,                                                                                                                 \
-    .vft  = LION_PARAMS_DEFAULT_VFT,                                                                                                                 \
-    .temp = LION_PARAMS_DEFAULT_TEMP,                                                                                                                \
-    .rint = LION_PARAMS_DEFAULT_RINT,                                                                                                                \
-    .soh  = LION_PARAMS_DEFAULT_SOH,                                                                                                                 \
+    .init     = LION_PARAMS_DEFAULT_INIT,                                                                                                            \
+    .ehc      = LION_PARAMS_DEFAULT_EHC,                                                                                                             \
+    .ocv      = LION_PARAMS_DEFAULT_OCV,                                                                                                             \
+    .vft      = LION_PARAMS_DEFAULT_VFT,                                                                                                             \
+    .temp     = LION_PARAMS_DEFAULT_TEMP,                                                                                                            \
+    .rint     = LION_PARAMS_DEFAULT_RINT,                                                                                                            \
+    .soh      = LION_PARAMS_DEFAULT_SOH,                                                                                                             \
+    .rc       = LION_PARAMS_DEFAULT_RC,                                                                                                              \
+    .calendar = LION_PARAMS_DEFAULT_CALENDAR,                                                                                                        \
   }
 
 lion_params_init_t lion_params_default_init(void) {
@@ -228,6 +248,16 @@ lion_params_soh_t lion_params_default_soh(void) {
   return out;
 }
 
+lion_params_rc_t lion_params_default_rc(void) {
+  lion_params_rc_t out = LION_PARAMS_DEFAULT_RC;
+  return out;
+}
+
+lion_params_calendar_t lion_params_default_calendar(void) {
+  lion_params_calendar_t out = LION_PARAMS_DEFAULT_CALENDAR;
+  return out;
+}
+
 lion_params_t lion_params_default(void) {
   lion_params_t out = LION_PARAMS_DEFAULT;
   return out;
@@ -254,3 +284,57 @@ const char *lion_params_soh_get_name(lion_soh_model_t model) {
     return "N/A";
   }
 }
+
+#define _LION_PARAMS_FIELD(path) {.name = #path, .offset = offsetof(lion_params_t, path)}
+
+typedef struct lion_params_field_entry {
+  const char *name;
+  size_t      offset;
+} lion_params_field_entry_t;
+
+static const lion_params_field_entry_t LION_PARAMS_FIELDS[] = {
+  _LION_PARAMS_FIELD(init.soc),
+  _LION_PARAMS_FIELD(init.temp_in),
+  _LION_PARAMS_FIELD(init.soh),
+  _LION_PARAMS_FIELD(init.capacity),
+  _LION_PARAMS_FIELD(init.current_guess),
+  _LION_PARAMS_FIELD(ehc.a),
+  _LION_PARAMS_FIELD(ehc.b),
+  _LION_PARAMS_FIELD(ehc.mu),
+  _LION_PARAMS_FIELD(ehc.kappa),
+  _LION_PARAMS_FIELD(ehc.sigma),
+  _LION_PARAMS_FIELD(ehc.l),
+  _LION_PARAMS_FIELD(ocv.alpha),
+  _LION_PARAMS_FIELD(ocv.beta),
+  _LION_PARAMS_FIELD(ocv.gamma),
+  _LION_PARAMS_FIELD(ocv.v0),
+  _LION_PARAMS_FIELD(ocv.vl),
+  _LION_PARAMS_FIELD(vft.k1),
+  _LION_PARAMS_FIELD(vft.k2),
+  _LION_PARAMS_FIELD(vft.tref),
+  _LION_PARAMS_FIELD(temp.cp),
+  _LION_PARAMS_FIELD(temp.rin),
+  _LION_PARAMS_FIELD(temp.rout),
+  _LION_PARAMS_FIELD(rint.params.fixed.internal_resistance),
+  _LION_PARAMS_FIELD(soh.params.vendor.final_soh),
+  _LION_PARAMS_FIELD(rc.resistance[0]),
+  _LION_PARAMS_FIELD(rc.resistance[1]),
+  _LION_PARAMS_FIELD(rc.resistance[2]),
+  _LION_PARAMS_FIELD(rc.capacitance[0]),
+  _LION_PARAMS_FIELD(rc.capacitance[1]),
+  _LION_PARAMS_FIELD(rc.capacitance[2]),
+  _LION_PARAMS_FIELD(calendar.rate),
+  _LION_PARAMS_FIELD(calendar.activation_energy),
+  _LION_PARAMS_FIELD(calendar.reference_temperature),
+  _LION_PARAMS_FIELD(calendar.soc_sensitivity),
+  _LION_PARAMS_FIELD(calendar.reference_soc),
+};
+
+double *lion_params_field(lion_params_t *params, const char *name) {
+  for (size_t i = 0; i < sizeof(LION_PARAMS_FIELDS) / sizeof(LION_PARAMS_FIELDS[0]); i++) {
+    if (strcmp(LION_PARAMS_FIELDS[i].name, name) == 0) {
+      return (double *)((char *)params + LION_PARAMS_FIELDS[i].offset);
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,313 @@
+#include "mem.h"
+#include "parallel.h"
+#include "sim_run.h"
+#include "solver/blocks.h"
+#include "solver/jump.h"
+#include "solver/update.h"
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_odeiv2.h>
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion/parareal.h>
+#include <lion_math/lion_math.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+typedef struct lion_parareal_ctx {
+  lion_sim_t          *sim;
+  lion_vector_view_d_t power;
+  lion_vector_view_d_t amb;
+  size_t               n_slices;
+  uint64_t            *bounds;       // First sample of each slice, and the end of the run
+  uint64_t             coarse_steps; // Samples in each coarse step
+  size_t               dimension;    // States corrected at each boundary
+} lion_parareal_ctx_t;
+
+/* Boundary states, the states of the ODE at the start of the next step and the state of health */
+
+static size_t parareal_dimension(lion_params_t *params) { return lion_slv_blocks_dimension(params) + 1; }
+
+static void parareal_pack(const lion_sim_state_t *state, lion_params_t *params, double y[]) {
+  // A thermal step that is not over yet holds its temperature apart
+  lion_sim_state_t next = *state;
+  lion_slv_blocks_advance(&next, params);
+  if (next._thermal_step > 0) {
+    next.internal_temperature = next._thermal_temperature;
+  }
+  lion_slv_blocks_load(&next, params, y);
+  y[lion_slv_blocks_dimension(params)] = state->soh;
+}
+
+static void parareal_unpack(lion_sim_state_t *state, lion_params_t *params, const double y[]) {
+  double temperature = state->_next_internal_temperature;
+  lion_slv_blocks_store(state, params, y);
+  if (state->_thermal_step > 0) {
+    state->_thermal_temperature       = state->_next_internal_temperature;
+    state->_next_internal_temperature = temperature;
+  }
+  state->soh = y[lion_slv_blocks_dimension(params)];
+}
+
+/* Coarse propagator */
+
+static void parareal_coarse_step(lion_sim_state_t *s, lion_params_t *params, double power, double ambient_temperature, double span) {
+  // Same outputs as lion_slv_update, with the current solved in closed form
+  // at the resistance of the previous current, or at the maximum power point
+  // when the power cannot be delivered
+  lion_slv_blocks_advance(s, params);
+  s->power               = power;
+  s->ambient_temperature = ambient_temperature;
+  s->input_mode          = LION_INPUT_POWER;
+  lion_slv_update_open_circuit(s, params);
+  double voc             = s->open_circuit_voltage - s->polarization_voltage;
+  double r               = lion_resistance(s->soc_use, s->current, 1.0, params);
+  double discriminant    = gsl_pow_2(voc / (2.0 * r)) - power / r;
+  s->current             = (discriminant >= 0.0) ? lion_current(power, voc, r, params) : voc / (2.0 * r);
+  s->voltage             = voc - r * s->current;
+  s->internal_resistance = lion_resistance(s->soc_use, s->current, s->soh, params);
+  lion_slv_update_thermal(s, params);
+
+  double y[LION_SLV_MAX_DIMENSION];
+  lion_slv_blocks_load(s, params, y);
+  lion_slv_jump(s, params, s->current, y, span);
+  lion_slv_blocks_store(s, params, y);
+  s->time += span;
+}
+
+// Propagate the start of slice `p` to its end with steps of `coarse_steps`
+// samples, over which the inputs are averaged
+static void parareal_coarse(const lion_parareal_ctx_t *ctx, size_t p, const lion_sim_state_t *start, lion_sim_state_t *out, double y[]) {
+  lion_params_t *params = ctx->sim->params;
+  double         h      = ctx->sim->conf->sim_step_seconds;
+  uint64_t       end    = ctx->bounds[p + 1];
+
+  *out = *start;
+  if (out->_thermal_step > 0) {
+    out->_next_internal_temperature = out->_thermal_temperature;
+    out->_thermal_step              = 0;
+  }
+  for (uint64_t i = ctx->bounds[p]; i < end;) {
+    uint64_t m       = GSL_MIN(ctx->coarse_steps, end - i);
+    double   power   = 0.0;
+    double   ambient = 0.0;
+    for (uint64_t j = i; j < i + m; j++) {
+      power   += ctx->power.data[j];
+      ambient += ctx->amb.data[j];
+    }
+    parareal_coarse_step(out, params, power / (double)m, ambient / (double)m, (double)m * h);
+    out->step += m;
+    i         += m;
+  }
+  parareal_pack(out, params, y);
+}
+
+/* Fine propagator */
+
+static lion_status_t parareal_fine(const lion_parareal_ctx_t *ctx, lion_sim_t *fork, size_t p, const lion_sim_state_t *start, lion_sim_state_t *out) {
+  fork->state = *start;
+  int status  = gsl_odeiv2_driver_reset(fork->driver);
+  LION_GSL_CALL_I(status, "Failed resetting ode driver");
+  LION_CALL_I(lion_sim_simulate_span(fork, &ctx->power, &ctx->amb, ctx->bounds[p], ctx->bounds[p + 1]), "Failed running slice");
+  *out = fork->state;
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t parareal_iterate(
+    const lion_parareal_ctx_t *ctx,
+    const lion_parareal_t     *parareal,
+    int                        threads,
+    lion_sim_t                *forks,
+    lion_sim_state_t          *start,
+    lion_sim_state_t          *fine,
+    double                    *coarse,
+    lion_parareal_result_t    *out
+) {
+  lion_params_t *params   = ctx->sim->params;
+  size_t         n        = ctx->n_slices;
+  size_t         dim      = ctx->dimension;
+  size_t         max_iter = (parareal->max_iterations > 0) ? GSL_MIN(parareal->max_iterations, n) : n;
+#ifndef _OPENMP
+  (void)threads;
+#endif
+
+  // The coarse propagator seeds the start of every slice
+  for (size_t p = 0; p < n; p++) {
+    parareal_coarse(ctx, p, &start[p], &start[p + 1], &coarse[p * dim]);
+  }
+
+  *out = (lion_parareal_result_t){.iterations = 0, .defect = INFINITY, .converged = 0};
+  for (size_t k = 0; k < max_iter && !out->converged; k++) {
+    // Slices before k start from the exact state and are settled
+    int first    = (int)k;
+    int last     = (int)n;
+    int failures = 0;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(threads) reduction(+ : failures)
+#endif
+    for (int p = first; p < last; p++) {
+      if (parareal_fine(ctx, &forks[p], (size_t)p, &start[p], &fine[p]) != LION_STATUS_SUCCESS) {
+        failures++;
+      }
+    }
+    if (failures > 0) {
+      logi_error("%d slices failed at correction %zu", failures, k);
+      return LION_STATUS_FAILURE;
+    }
+
+    // U(p + 1) <- F(U(p)) + G(U(p)) - G(previous U(p)), where the coarse
+    // terms cancel out exactly for the slice starting from the exact state
+    double defect = 0.0;
+    for (size_t p = k; p < n; p++) {
+      double           g[LION_SLV_MAX_DIMENSION + 1];
+      double           f[LION_SLV_MAX_DIMENSION + 1];
+      double           u[LION_SLV_MAX_DIMENSION + 1];
+      lion_sim_state_t propagated;
+      parareal_coarse(ctx, p, &start[p], &propagated, g);
+      parareal_pack(&fine[p], params, f);
+      parareal_pack(&start[p + 1], params, u);
+      for (size_t j = 0; j < dim; j++) {
+        f[j]                += g[j] - coarse[p * dim + j];
+        coarse[p * dim + j]  = g[j];
+        defect               = GSL_MAX_DBL(defect, fabs(f[j] - u[j]));
+      }
+      start[p + 1] = fine[p];
+      parareal_unpack(&start[p + 1], params, f);
+    }
+
+    out->iterations = k + 1;
+    out->defect     = defect;
+    out->converged  = defect <= parareal->tolerance || k + 1 == n;
+    logi_info("Correction %zu of the slices, defect %e", k + 1, defect);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static void parareal_cleanup(lion_sim_t *sim, lion_sim_t *forks, size_t n_forks, void *start, void *fine, void *coarse, void *bounds) {
+  for (size_t p = 0; p < n_forks; p++) {
+    lion_sim_cleanup(&forks[p]);
+  }
+  lion_free(sim, forks);
+  lion_free(sim, start);
+  lion_free(sim, fine);
+  lion_free(sim, coarse);
+  lion_free(sim, bounds);
+}
+
+lion_status_t lion_sim_run_parareal(
+    lion_sim_t *sim, const lion_parareal_t *parareal, lion_vector_t *power, lion_vector_t *ambient_temperature, lion_parareal_result_t *out
+) {
+  logi_info("Simulation start");
+#ifndef NDEBUG
+  if (sim->_idebug_heap_head == NULL)
+    LION_CALL_I(lion_sim_init_debug(sim), "Failed initializing debug information");
+#endif
+  if (power == NULL || ambient_temperature == NULL || parareal == NULL) {
+    logi_error("Null arguments were passed, skipping simulation running");
+    return LION_STATUS_FAILURE;
+  }
+  if (sim->n_events > 0 || sim->n_stats > 0) {
+    logi_error("Simulations with events or statistics cannot run in parallel in time");
+    return LION_STATUS_FAILURE;
+  }
+  if (sim->conf->sim_jump != LION_JUMP_NONE) {
+    // Jumps would be split at the slice boundaries, which breaks the match with the serial run
+    logi_error("Simulations that jump over intervals (%s) cannot run in parallel in time", lion_jump_name(sim->conf->sim_jump));
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_parareal_ctx_t ctx = {.sim = sim, .coarse_steps = parareal->coarse_steps};
+  LION_CALL_I(lion_vector_view_d(sim, power, &ctx.power), "Power must be a vector of doubles");
+  LION_CALL_I(lion_vector_view_d(sim, ambient_temperature, &ctx.amb), "Ambient temperature must be a vector of doubles");
+  logi_info("Initializing simulation");
+  LION_CALL_I(lion_sim_init(sim), "Failed initializing sim");
+
+  // Like lion_sim_simulate, the first sample only sets the initial state
+  uint64_t samples = GSL_MIN(ctx.power.len, ctx.amb.len);
+  uint64_t steps   = (samples > 1) ? samples - 1 : 0;
+#ifdef _OPENMP
+  int threads = (parareal->n_threads > 0) ? parareal->n_threads : omp_get_max_threads();
+#else
+  int threads = 1;
+#endif
+  ctx.n_slices  = (parareal->n_slices > 0) ? parareal->n_slices : (size_t)threads;
+  ctx.n_slices  = GSL_MIN(ctx.n_slices, steps);
+  ctx.dimension = parareal_dimension(sim->params);
+  if (ctx.n_slices == 0) {
+    lion_parareal_result_t none = {.iterations = 0, .defect = 0.0, .converged = 1};
+    if (out != NULL) {
+      *out = none;
+    }
+    return LION_STATUS_SUCCESS;
+  }
+
+  size_t            n      = ctx.n_slices;
+  lion_sim_t       *forks  = lion_calloc(sim, n, sizeof(lion_sim_t));
+  lion_sim_state_t *start  = lion_malloc(sim, (n + 1) * sizeof(lion_sim_state_t));
+  lion_sim_state_t *fine   = lion_malloc(sim, n * sizeof(lion_sim_state_t));
+  double           *coarse = lion_malloc(sim, n * ctx.dimension * sizeof(double));
+  ctx.bounds               = lion_malloc(sim, (n + 1) * sizeof(uint64_t));
+  if (forks == NULL || start == NULL || fine == NULL || coarse == NULL || ctx.bounds == NULL) {
+    logi_error("Could not allocate slices");
+    parareal_cleanup(sim, forks, 0, start, fine, coarse, ctx.bounds);
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t p = 0; p <= n; p++) {
+    ctx.bounds[p] = 1 + steps * p / n;
+  }
+  if (ctx.coarse_steps == 0) {
+    ctx.coarse_steps = UINT64_MAX;
+  }
+
+  // Each slice keeps its fork across corrections, without the hooks of the
+  // simulation and with its own stream of random numbers
+  size_t n_forks = 0;
+  for (; n_forks < n; n_forks++) {
+    if (lion_sim_fork(sim, &forks[n_forks]) != LION_STATUS_SUCCESS) {
+      logi_error("Failed forking slice %zu", n_forks);
+      parareal_cleanup(sim, forks, n_forks, start, fine, coarse, ctx.bounds);
+      return LION_STATUS_FAILURE;
+    }
+    forks[n_forks].init_hook     = NULL;
+    forks[n_forks].update_hook   = NULL;
+    forks[n_forks].finished_hook = NULL;
+  }
+  start[0] = sim->state;
+  logi_info("Running %" PRIu64 " steps in %zu slices on %d threads", steps, n, threads);
+
+#ifdef _OPENMP
+  lion_log_lock_t log_lock;
+  lion_log_lock_begin(&log_lock);
+#endif
+  lion_parareal_result_t result;
+  lion_status_t          status = parareal_iterate(&ctx, parareal, threads, forks, start, fine, coarse, &result);
+#ifdef _OPENMP
+  lion_log_lock_end(&log_lock);
+#endif
+
+  if (status == LION_STATUS_SUCCESS) {
+    sim->state = start[n];
+    if (!result.converged) {
+      logi_warn("Slices did not converge after %zu corrections (defect %e)", result.iterations, result.defect);
+    }
+    if (out != NULL) {
+      *out = result;
+    }
+  }
+  parareal_cleanup(sim, forks, n_forks, start, fine, coarse, ctx.bounds);
+  LION_CALL_I(status, "Failed running slices");
+
+  int reset = gsl_odeiv2_driver_reset(sim->driver);
+  LION_GSL_CALL_I(reset, "Failed resetting ode driver");
+  if (sim->finished_hook != NULL) {
+    logi_debug("Found finished hook");
+    LION_CALLDF_I(sim->finished_hook(sim), "Failed calling finished hook");
+  }
+  return LION_STATUS_SUCCESS;
+}
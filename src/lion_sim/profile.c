@@ -0,0 +1,456 @@
+#include "mem.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#define LION_PROFILE_MAGIC    "LIONPROF"
+#define LION_PROFILE_LINE_MAX 4096
+
+/*
+   Layout of a profile file, all values in native byte order
+
+     lion_profile_header_t header
+     lion_profile_entry_t  entries[header.n_columns]
+     for every column, starting at entries[i].offset:
+       samples[header.count] of the type given by header.dtype
+
+   Every column starts at an offset aligned to LION_PROFILE_ALIGNMENT and the
+   gaps are filled with zeros.
+*/
+typedef struct lion_profile_header {
+  char     magic[8];
+  uint32_t version;
+  uint32_t dtype;
+  uint64_t count;
+  uint32_t n_columns;
+  uint32_t sample_size;
+  double   sample_period;
+} lion_profile_header_t;
+
+typedef struct lion_profile_entry {
+  char     name[LION_PROFILE_NAME_MAX];
+  char     unit[LION_PROFILE_UNIT_MAX];
+  uint64_t offset;
+} lion_profile_entry_t;
+
+static size_t sample_size(lion_profile_dtype_t dtype) { return (dtype == LION_PROFILE_F32) ? sizeof(float) : sizeof(double); }
+
+static uint64_t align_offset(uint64_t offset) { return (offset + LION_PROFILE_ALIGNMENT - 1) / LION_PROFILE_ALIGNMENT * LION_PROFILE_ALIGNMENT; }
+
+/* Writing */
+
+static lion_status_t write_padding(lion_sim_t *sim, FILE *f, uint64_t *position, uint64_t target) {
+  static const char zeros[LION_PROFILE_ALIGNMENT] = {0};
+  size_t            gap                           = (size_t)(target - *position);
+  if (gap > 0 && fwrite(zeros, 1, gap, f) != gap) {
+    logi_error("Failed writing padding");
+    return LION_STATUS_FAILURE;
+  }
+  *position = target;
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t write_column(lion_sim_t *sim, FILE *f, const double *values, uint64_t count, lion_profile_dtype_t dtype) {
+  if (dtype == LION_PROFILE_F64) {
+    if (fwrite(values, sizeof(double), (size_t)count, f) != count) {
+      logi_error("Failed writing samples");
+      return LION_STATUS_FAILURE;
+    }
+    return LION_STATUS_SUCCESS;
+  }
+
+  // Narrowed in chunks to avoid a second copy of the whole column
+  float chunk[512];
+  for (uint64_t i = 0; i < count; i += 512) {
+    size_t n = (count - i < 512) ? (size_t)(count - i) : 512;
+    for (size_t j = 0; j < n; j++) {
+      chunk[j] = (float)values[i + j];
+    }
+    if (fwrite(chunk, sizeof(float), n, f) != n) {
+      logi_error("Failed writing samples");
+      return LION_STATUS_FAILURE;
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t write_profile(lion_sim_t *sim, FILE *f, const lion_profile_info_t *info, const double *const columns[]) {
+  lion_profile_header_t header = {
+    .version       = LION_PROFILE_VERSION,
+    .dtype         = (uint32_t)info->dtype,
+    .count         = info->count,
+    .n_columns     = info->n_columns,
+    .sample_size   = (uint32_t)sample_size(info->dtype),
+    .sample_period = info->sample_period,
+  };
+  memcpy(header.magic, LION_PROFILE_MAGIC, sizeof(header.magic));
+
+  lion_profile_entry_t entries[LION_PROFILE_MAX_COLUMNS];
+  memset(entries, 0, sizeof(entries));
+  uint64_t offset = sizeof(header) + info->n_columns * sizeof(lion_profile_entry_t);
+  for (uint32_t c = 0; c < info->n_columns; c++) {
+    strncpy(entries[c].name, info->columns[c].name, LION_PROFILE_NAME_MAX - 1);
+    strncpy(entries[c].unit, info->columns[c].unit, LION_PROFILE_UNIT_MAX - 1);
+    entries[c].offset = align_offset(offset);
+    offset            = entries[c].offset + info->count * header.sample_size;
+  }
+
+  uint64_t position = sizeof(header) + info->n_columns * sizeof(lion_profile_entry_t);
+  if (fwrite(&header, sizeof(header), 1, f) != 1 || fwrite(entries, sizeof(lion_profile_entry_t), info->n_columns, f) != info->n_columns) {
+    logi_error("Failed writing profile header");
+    return LION_STATUS_FAILURE;
+  }
+  for (uint32_t c = 0; c < info->n_columns; c++) {
+    LION_VCALL_I(write_padding(sim, f, &position, entries[c].offset), "Failed aligning column '%s'", entries[c].name);
+    LION_VCALL_I(write_column(sim, f, columns[c], info->count, info->dtype), "Failed writing column '%s'", entries[c].name);
+    position += info->count * header.sample_size;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_profile_write(lion_sim_t *sim, const char *filename, const lion_profile_info_t *info, const double *const columns[]) {
+  if (info->n_columns == 0 || info->n_columns > LION_PROFILE_MAX_COLUMNS) {
+    logi_error("Profiles hold between 1 and %d columns, got %" PRIu32, LION_PROFILE_MAX_COLUMNS, info->n_columns);
+    return LION_STATUS_FAILURE;
+  }
+  if (info->dtype != LION_PROFILE_F64 && info->dtype != LION_PROFILE_F32) {
+    logi_error("Unknown sample type %d", info->dtype);
+    return LION_STATUS_FAILURE;
+  }
+
+  logi_debug("Writing profile '%s'", filename);
+  FILE *f = fopen(filename, "wb");
+  if (f == NULL) {
+    logi_error("Could not open file '%s'", filename);
+    return LION_STATUS_FAILURE;
+  }
+  lion_status_t status = write_profile(sim, f, info, columns);
+  if (fclose(f) != 0) {
+    logi_error("Failed closing file '%s'", filename);
+    return LION_STATUS_FAILURE;
+  }
+  return status;
+}
+
+/* Conversion from CSV */
+
+static char *trim(char *s) {
+  while (*s == ' ' || *s == '\t') {
+    s++;
+  }
+  char *end = s + strlen(s);
+  while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) {
+    end--;
+  }
+  *end = '\0';
+  return s;
+}
+
+static lion_status_t parse_csv_header(lion_sim_t *sim, char *line, lion_profile_info_t *info) {
+  info->n_columns = 0;
+  for (char *field = strtok(line, ","); field != NULL; field = strtok(NULL, ",")) {
+    if (info->n_columns == LION_PROFILE_MAX_COLUMNS) {
+      logi_error("CSV file has more than %d columns", LION_PROFILE_MAX_COLUMNS);
+      return LION_STATUS_FAILURE;
+    }
+    lion_profile_column_t *column = &info->columns[info->n_columns];
+    memset(column, 0, sizeof(*column));
+
+    // A unit may follow the name in brackets, as in "power [W]"
+    char *bracket = strchr(field, '[');
+    if (bracket != NULL) {
+      *bracket    = '\0';
+      char *close = strchr(bracket + 1, ']');
+      if (close != NULL) {
+        *close = '\0';
+      }
+      strncpy(column->unit, trim(bracket + 1), LION_PROFILE_UNIT_MAX - 1);
+    }
+    char *name = trim(field);
+    if (*name == '\0') {
+      logi_error("Column %" PRIu32 " of the CSV file has no name", info->n_columns);
+      return LION_STATUS_FAILURE;
+    }
+    strncpy(column->name, name, LION_PROFILE_NAME_MAX - 1);
+    info->n_columns++;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t parse_csv(lion_sim_t *sim, FILE *f, lion_profile_info_t *info, lion_vector_t columns[]) {
+  char line[LION_PROFILE_LINE_MAX];
+  if (fgets(line, sizeof(line), f) == NULL) {
+    logi_error("CSV file is empty");
+    return LION_STATUS_FAILURE;
+  }
+  LION_CALL_I(parse_csv_header(sim, line, info), "Failed parsing CSV header");
+  for (uint32_t c = 0; c < info->n_columns; c++) {
+    LION_CALL_I(lion_vector_new(sim, sizeof(double), &columns[c]), "Failed creating column");
+  }
+
+  for (uint64_t row = 1; fgets(line, sizeof(line), f) != NULL; row++) {
+    if (strchr(line, '\n') == NULL && !feof(f)) {
+      logi_error("Line %" PRIu64 " is longer than %d characters", row, LION_PROFILE_LINE_MAX - 1);
+      return LION_STATUS_FAILURE;
+    }
+    if (*trim(line) == '\0') {
+      continue;
+    }
+    char *cursor = line;
+    for (uint32_t c = 0; c < info->n_columns; c++) {
+      char  *end;
+      double value = strtod(cursor, &end);
+      while (*end == ' ' || *end == '\t') {
+        end++;
+      }
+      int last = (c + 1 == info->n_columns);
+      if (end == cursor || (last ? *end != '\0' : *end != ',')) {
+        logi_error("Line %" PRIu64 " does not hold %" PRIu32 " numeric values", row, info->n_columns);
+        return LION_STATUS_FAILURE;
+      }
+      LION_CALL_I(lion_vector_push_d(sim, &columns[c], value), "Failed storing sample");
+      cursor = end + 1;
+    }
+  }
+  info->count = columns[0].len;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_profile_from_csv(lion_sim_t *sim, const char *csv_filename, const char *filename, double sample_period, lion_profile_dtype_t dtype) {
+  logi_debug("Converting '%s' into profile '%s'", csv_filename, filename);
+  FILE *f = fopen(csv_filename, "r");
+  if (f == NULL) {
+    logi_error("Could not open file '%s'", csv_filename);
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_profile_info_t info = {
+    .sample_period = sample_period,
+    .dtype         = dtype,
+  };
+  lion_vector_t columns[LION_PROFILE_MAX_COLUMNS] = {0};
+  lion_status_t status                            = parse_csv(sim, f, &info, columns);
+  fclose(f);
+
+  if (status == LION_STATUS_SUCCESS) {
+    const double *data[LION_PROFILE_MAX_COLUMNS];
+    for (uint32_t c = 0; c < info.n_columns; c++) {
+      data[c] = columns[c].data;
+    }
+    logi_info("Writing %" PRIu64 " samples of %" PRIu32 " columns", info.count, info.n_columns);
+    status = lion_profile_write(sim, filename, &info, data);
+  }
+  for (uint32_t c = 0; c < LION_PROFILE_MAX_COLUMNS; c++) {
+    lion_vector_cleanup(sim, &columns[c]);
+  }
+  return status;
+}
+
+/* Reading */
+
+static lion_status_t read_header(lion_sim_t *sim, const char *filename, lion_profile_header_t *header, lion_profile_entry_t entries[]) {
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL) {
+    logi_error("Could not open file '%s'", filename);
+    return LION_STATUS_FAILURE;
+  }
+  size_t read = fread(header, sizeof(*header), 1, f);
+  if (read != 1 || memcmp(header->magic, LION_PROFILE_MAGIC, sizeof(header->magic)) != 0) {
+    logi_error("File '%s' is not a profile", filename);
+    fclose(f);
+    return LION_STATUS_FAILURE;
+  }
+  if (header->version != LION_PROFILE_VERSION) {
+    logi_error("Unsupported profile version %" PRIu32 " (expected %d)", header->version, LION_PROFILE_VERSION);
+    fclose(f);
+    return LION_STATUS_FAILURE;
+  }
+  if (header->n_columns == 0 || header->n_columns > LION_PROFILE_MAX_COLUMNS || (header->dtype != LION_PROFILE_F64 && header->dtype != LION_PROFILE_F32)
+      || header->sample_size != sample_size((lion_profile_dtype_t)header->dtype)) {
+    logi_error("Profile '%s' has a corrupted header", filename);
+    fclose(f);
+    return LION_STATUS_FAILURE;
+  }
+  read = fread(entries, sizeof(lion_profile_entry_t), header->n_columns, f);
+  fclose(f);
+  if (read != header->n_columns) {
+    logi_error("Profile '%s' is truncated", filename);
+    return LION_STATUS_FAILURE;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_profile_read_info(lion_sim_t *sim, const char *filename, lion_profile_info_t *out) {
+  lion_profile_header_t header;
+  lion_profile_entry_t  entries[LION_PROFILE_MAX_COLUMNS];
+  LION_VCALL_I(read_header(sim, filename, &header, entries), "Failed reading profile '%s'", filename);
+
+  lion_profile_info_t info = {
+    .sample_period = header.sample_period,
+    .count         = header.count,
+    .n_columns     = header.n_columns,
+    .dtype         = (lion_profile_dtype_t)header.dtype,
+  };
+  for (uint32_t c = 0; c < header.n_columns; c++) {
+    memcpy(info.columns[c].name, entries[c].name, LION_PROFILE_NAME_MAX);
+    memcpy(info.columns[c].unit, entries[c].unit, LION_PROFILE_UNIT_MAX);
+    info.columns[c].name[LION_PROFILE_NAME_MAX - 1] = '\0';
+    info.columns[c].unit[LION_PROFILE_UNIT_MAX - 1] = '\0';
+  }
+  *out = info;
+  return LION_STATUS_SUCCESS;
+}
+
+/* Mapping */
+
+// Mappings must start at a multiple of the granularity of the system, so
+// a column is mapped from the closest boundary before it. The start of the
+// mapping is then recovered from the data pointer by rounding it down.
+static size_t map_granularity(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (size_t)info.dwAllocationGranularity;
+#else
+  return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+static lion_status_t map_range(lion_sim_t *sim, const char *filename, uint64_t offset, size_t length, void **out) {
+  size_t   granularity = map_granularity();
+  uint64_t start       = offset / granularity * granularity;
+  size_t   span        = (size_t)(offset - start) + length;
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    logi_error("Could not open file '%s'", filename);
+    return LION_STATUS_FAILURE;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || (uint64_t)size.QuadPart < offset + length) {
+    logi_error("Profile '%s' is truncated", filename);
+    CloseHandle(file);
+    return LION_STATUS_FAILURE;
+  }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (mapping == NULL) {
+    logi_error("Could not map file '%s'", filename);
+    return LION_STATUS_FAILURE;
+  }
+  // The view keeps the mapping alive after its handle is closed
+  void *base = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)(start & 0xFFFFFFFF), span);
+  CloseHandle(mapping);
+  if (base == NULL) {
+    logi_error("Could not map file '%s'", filename);
+    return LION_STATUS_FAILURE;
+  }
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    logi_error("Could not open file '%s', found errno %i", filename, errno);
+    return LION_STATUS_FAILURE;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < offset + length) {
+    logi_error("Profile '%s' is truncated", filename);
+    close(fd);
+    return LION_STATUS_FAILURE;
+  }
+  // Shared read-only pages come straight from the page cache, so every
+  // process mapping the file uses the same physical copy
+  void *base = mmap(NULL, span, PROT_READ, MAP_SHARED, fd, (off_t)start);
+  close(fd);
+  if (base == MAP_FAILED) {
+    logi_error("Could not map file '%s', found errno %i", filename, errno);
+    return LION_STATUS_FAILURE;
+  }
+#endif
+  *out = (char *)base + (offset - start);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_vector_map_file(lion_sim_t *sim, const char *filename, const char *column, lion_vector_t *out) {
+  lion_profile_header_t header;
+  lion_profile_entry_t  entries[LION_PROFILE_MAX_COLUMNS];
+  LION_VCALL_I(read_header(sim, filename, &header, entries), "Failed reading profile '%s'", filename);
+
+  const lion_profile_entry_t *entry = NULL;
+  for (uint32_t c = 0; c < header.n_columns; c++) {
+    if (strncmp(entries[c].name, column, LION_PROFILE_NAME_MAX) == 0) {
+      entry = &entries[c];
+      break;
+    }
+  }
+  if (entry == NULL) {
+    logi_error("Profile '%s' has no column '%s'", filename, column);
+    return LION_STATUS_FAILURE;
+  }
+  if (entry->offset % LION_PROFILE_ALIGNMENT != 0) {
+    logi_error("Column '%s' of profile '%s' is misaligned", column, filename);
+    return LION_STATUS_FAILURE;
+  }
+  // A corrupted count could wrap the size of the column around and pass the
+  // size check of the file
+  if (header.count > SIZE_MAX / header.sample_size || header.count > (UINT64_MAX - entry->offset) / header.sample_size) {
+    logi_error("Profile '%s' has a corrupted sample count (%" PRIu64 ")", filename, header.count);
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_vector_t result = {
+    .data      = NULL,
+    .data_size = header.sample_size,
+    .len       = (size_t)header.count,
+    .capacity  = (size_t)header.count,
+    .mapped    = 1,
+  };
+  if (header.count > 0) {
+    LION_VCALL_I(
+        map_range(sim, filename, entry->offset, (size_t)header.count * header.sample_size, &result.data), "Failed mapping column '%s'", column
+    );
+  }
+  logi_debug("Mapped %" PRIu64 " samples of '%s' from '%s'", header.count, column, filename);
+  *out = result;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_vector_unmap(lion_sim_t *sim, lion_vector_t *vec) {
+  if (vec->data == NULL) {
+    return LION_STATUS_SUCCESS;
+  }
+  size_t granularity = map_granularity();
+  char  *base        = (char *)((uintptr_t)vec->data / granularity * granularity);
+#ifdef _WIN32
+  if (!UnmapViewOfFile(base)) {
+    logi_error("Failed unmapping vector");
+    return LION_STATUS_FAILURE;
+  }
+#else
+  size_t span = (size_t)((char *)vec->data - base) + vec->len * vec->data_size;
+  if (munmap(base, span) != 0) {
+    logi_error("Failed unmapping vector, found errno %i", errno);
+    return LION_STATUS_FAILURE;
+  }
+#endif
+  vec->data     = NULL;
+  vec->len      = 0;
+  vec->capacity = 0;
+  vec->mapped   = 0;
+  return LION_STATUS_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "sim_run.h"
+
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion/protocol.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+
+lion_status_t lion_protocol_new(const lion_protocol_step_t *steps, size_t n_steps, double ambient_temperature, lion_protocol_t *out) {
+  for (size_t i = 0; i < n_steps; i++) {
+    if (steps[i].mode != LION_INPUT_POWER && steps[i].mode != LION_INPUT_CURRENT && steps[i].mode != LION_INPUT_VOLTAGE) {
+      logi_error("Step %zu has an invalid input mode", i);
+      return LION_STATUS_FAILURE;
+    }
+    if (steps[i].field == NULL && !(steps[i].duration > 0.0)) {
+      logi_error("Step %zu never ends, it needs a condition or a duration", i);
+      return LION_STATUS_FAILURE;
+    }
+  }
+  *out = (lion_protocol_t){
+    .steps               = steps,
+    .n_steps             = n_steps,
+    .ambient_temperature = ambient_temperature,
+    .active              = 0,
+    .start_time          = 0.0,
+  };
+  return LION_STATUS_SUCCESS;
+}
+
+void lion_protocol_cccv(double charge_current, double max_voltage, double cutoff_current, lion_protocol_step_t out[LION_PROTOCOL_CCCV_STEPS]) {
+  // Charge currents are negative, as the current is the one drawn from the cell
+  out[0] = (lion_protocol_step_t){
+    .mode      = LION_INPUT_CURRENT,
+    .value     = -charge_current,
+    .field     = "voltage",
+    .kind      = LION_EVENT_ABOVE,
+    .threshold = max_voltage,
+    .duration  = 0.0,
+  };
+  out[1] = (lion_protocol_step_t){
+    .mode      = LION_INPUT_VOLTAGE,
+    .value     = max_voltage,
+    .field     = "current",
+    .kind      = LION_EVENT_ABOVE,
+    .threshold = -cutoff_current,
+    .duration  = 0.0,
+  };
+}
+
+// Index of the event of the step, or PROTOCOL_UNWATCHED without a condition
+#define PROTOCOL_UNWATCHED SIZE_MAX
+
+// Watch the condition of the active step, if it has one
+static lion_status_t protocol_watch(lion_sim_t *sim, const lion_protocol_step_t *step, size_t *watch) {
+  *watch = PROTOCOL_UNWATCHED;
+  if (step->field == NULL) {
+    return LION_STATUS_SUCCESS;
+  }
+  lion_event_config_t conf = {
+    .field     = step->field,
+    .kind      = step->kind,
+    .threshold = step->threshold,
+    .action    = LION_EVENT_STOP,
+    .hook      = NULL,
+  };
+  LION_CALL_I(lion_sim_events_add(sim, &conf, watch), "Failed watching the condition of the step");
+  return LION_STATUS_SUCCESS;
+}
+
+// Hooks can add events while the step runs, so the event of the step is
+// removed by its index instead of assuming it is the last one
+static lion_status_t protocol_unwatch(lion_sim_t *sim, size_t *watch) {
+  size_t index = *watch;
+  *watch       = PROTOCOL_UNWATCHED;
+  if (index == PROTOCOL_UNWATCHED) {
+    return LION_STATUS_SUCCESS;
+  }
+  return lion_sim_events_remove(sim, index);
+}
+
+lion_status_t lion_sim_run_protocol(lion_sim_t *sim, lion_protocol_t *protocol, uint64_t max_steps) {
+  protocol->active     = 0;
+  protocol->start_time = sim->state.time;
+  if (protocol->n_steps == 0) {
+    return LION_STATUS_SUCCESS;
+  }
+
+  size_t watch;
+  LION_CALL_I(protocol_watch(sim, &protocol->steps[0], &watch), "Failed starting protocol");
+  lion_status_t status = LION_STATUS_SUCCESS;
+  for (uint64_t k = 0; max_steps == 0 || k < max_steps; k++) {
+    const lion_protocol_step_t *step = &protocol->steps[protocol->active];
+    if (lion_sim_step_input(sim, step->mode, step->value, protocol->ambient_temperature) != LION_STATUS_SUCCESS) {
+      logi_error("Failed at step %zu of the protocol", protocol->active);
+      status = LION_STATUS_FAILURE;
+      break;
+    }
+
+    // Stop events of the simulation end the protocol, even if they fire
+    // along with the condition of the step
+    int reason = lion_sim_should_close(sim);
+    int ended  = step->duration > 0.0 && sim->state.time - protocol->start_time >= step->duration * (1.0 - 1e-12);
+    if (reason == LION_CLOSE_EVENT) {
+      int other = 0;
+      for (size_t i = 0; i < sim->n_events; i++) {
+        other |= i != watch && sim->events[i].action == LION_EVENT_STOP && sim->events[i].fired;
+      }
+      if (other || watch == PROTOCOL_UNWATCHED) {
+        break;
+      }
+      lion_sim_events_resume(sim);
+      ended = 1;
+    } else if (reason != LION_CLOSE_NONE) {
+      break;
+    }
+    if (!ended) {
+      continue;
+    }
+
+    logi_debug("Protocol step %zu ended at t = %f", protocol->active, sim->state.time);
+    if (protocol_unwatch(sim, &watch) != LION_STATUS_SUCCESS) {
+      status = LION_STATUS_FAILURE;
+      break;
+    }
+    protocol->active++;
+    protocol->start_time = sim->state.time;
+    if (protocol->active == protocol->n_steps) {
+      break;
+    }
+    if (protocol_watch(sim, &protocol->steps[protocol->active], &watch) != LION_STATUS_SUCCESS) {
+      status = LION_STATUS_FAILURE;
+      break;
+    }
+  }
+  if (protocol_unwatch(sim, &watch) != LION_STATUS_SUCCESS) {
+    status = LION_STATUS_FAILURE;
+  }
+  if (protocol->active < protocol->n_steps) {
+    logi_info("Protocol stopped at step %zu (t = %f, step %" PRIu64 ")", protocol->active, sim->state.time, sim->state.step);
+  }
+  return status;
+}
@@ -0,0 +1,323 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  // Required for pthread_attr_setaffinity_np
+  #define _GNU_SOURCE
+#endif
+
+#include "mem.h"
+
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <string.h>
+
+#ifdef __linux__
+  #include <errno.h>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <time.h>
+#endif
+
+#define LION_RT_DEFAULT_PERIOD_NS 1000000
+#define LION_RT_DEFAULT_CAPACITY  1024
+#define LION_RT_NS_PER_SECOND     1000000000LL
+
+lion_status_t lion_rt_queue_new(lion_sim_t *sim, size_t capacity, size_t elem_size, lion_rt_queue_t *out) {
+  if (capacity == 0 || elem_size == 0) {
+    logi_error("Queue must have a positive capacity and element size");
+    return LION_STATUS_FAILURE;
+  }
+  // A power of two capacity lets the free-running indices wrap with a mask
+  size_t slots = 1;
+  while (slots < capacity) {
+    slots <<= 1;
+  }
+  unsigned char *buffer = lion_malloc(sim, slots * elem_size);
+  if (buffer == NULL) {
+    logi_error("Could not allocate queue of %zu elements", slots);
+    return LION_STATUS_FAILURE;
+  }
+  out->capacity  = slots;
+  out->elem_size = elem_size;
+  out->buffer    = buffer;
+  out->head      = 0;
+  out->tail      = 0;
+  return LION_STATUS_SUCCESS;
+}
+
+int lion_rt_queue_push(lion_rt_queue_t *queue, const void *elem) {
+  // The producer owns the tail, so it only needs to synchronize with the
+  // head written by the consumer
+  size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+  size_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  if (tail - head == queue->capacity) {
+    return 0;
+  }
+  memcpy(queue->buffer + (tail & (queue->capacity - 1)) * queue->elem_size, elem, queue->elem_size);
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+int lion_rt_queue_pop(lion_rt_queue_t *queue, void *elem) {
+  size_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+  size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    return 0;
+  }
+  memcpy(elem, queue->buffer + (head & (queue->capacity - 1)) * queue->elem_size, queue->elem_size);
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+size_t lion_rt_queue_size(const lion_rt_queue_t *queue) {
+  size_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+  return tail - head;
+}
+
+lion_status_t lion_rt_queue_cleanup(lion_sim_t *sim, lion_rt_queue_t *queue) {
+  lion_free(sim, queue->buffer);
+  queue->buffer   = NULL;
+  queue->capacity = 0;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_rt_config_t lion_rt_config_default(void) {
+  lion_rt_config_t out = {
+    .period_ns      = LION_RT_DEFAULT_PERIOD_NS,
+    .cpu            = -1,
+    .priority       = 0,
+    .max_iter       = 0,
+    .queue_capacity = LION_RT_DEFAULT_CAPACITY,
+    .mute_logs      = 1,
+  };
+  return out;
+}
+
+lion_status_t lion_rt_new(lion_sim_t *sim, const lion_rt_config_t *conf, lion_rt_t *out) {
+  if (sim->driver == NULL) {
+    logi_error("Real-time runner requires an initialized simulation");
+    return LION_STATUS_FAILURE;
+  }
+  if (conf->period_ns <= 0) {
+    logi_error("Real-time period must be positive (got %" PRId64 " ns)", conf->period_ns);
+    return LION_STATUS_FAILURE;
+  }
+  out->sim  = sim;
+  out->conf = *conf;
+  out->hold = (lion_rt_input_t){
+    .power               = 0.0,
+    .ambient_temperature = sim->params->init.temp_in,
+  };
+  memset(&out->stats, 0, sizeof(out->stats));
+  out->_running     = 0;
+  out->_status      = LION_STATUS_SUCCESS;
+  out->_caller_conf = NULL;
+  out->_thread      = NULL;
+
+  LION_CALL_I(lion_rt_queue_new(sim, conf->queue_capacity, sizeof(lion_rt_input_t), &out->inputs), "Failed creating input queue");
+  if (lion_rt_queue_new(sim, conf->queue_capacity, sizeof(lion_rt_output_t), &out->outputs) != LION_STATUS_SUCCESS) {
+    logi_error("Failed creating output queue");
+    LION_CALL_I(lion_rt_queue_cleanup(sim, &out->inputs), "Failed cleaning up input queue");
+    return LION_STATUS_FAILURE;
+  }
+  logi_debug("Created real-time runner with a period of %" PRId64 " ns", conf->period_ns);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_rt_stats_t lion_rt_get_stats(const lion_rt_t *rt) {
+  lion_rt_stats_t out = {
+    .steps           = __atomic_load_n(&rt->stats.steps, __ATOMIC_RELAXED),
+    .deadline_misses = __atomic_load_n(&rt->stats.deadline_misses, __ATOMIC_RELAXED),
+    .stale_inputs    = __atomic_load_n(&rt->stats.stale_inputs, __ATOMIC_RELAXED),
+    .dropped_outputs = __atomic_load_n(&rt->stats.dropped_outputs, __ATOMIC_RELAXED),
+    .max_elapsed_ns  = __atomic_load_n(&rt->stats.max_elapsed_ns, __ATOMIC_RELAXED),
+    .max_late_ns     = __atomic_load_n(&rt->stats.max_late_ns, __ATOMIC_RELAXED),
+  };
+  return out;
+}
+
+#ifdef __linux__
+
+static int64_t rt_ns(const struct timespec *t) { return (int64_t)t->tv_sec * LION_RT_NS_PER_SECOND + t->tv_nsec; }
+
+static struct timespec rt_timespec(int64_t ns) {
+  struct timespec out = {
+    .tv_sec  = ns / LION_RT_NS_PER_SECOND,
+    .tv_nsec = ns % LION_RT_NS_PER_SECOND,
+  };
+  return out;
+}
+
+static int64_t rt_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return rt_ns(&t);
+}
+
+static void rt_add(uint64_t *counter, uint64_t value) {
+  // Only the stepping thread writes the statistics, so a plain read is
+  // enough and the store only has to be atomic for the readers
+  __atomic_store_n(counter, *counter + value, __ATOMIC_RELAXED);
+}
+
+static void rt_max(int64_t *counter, int64_t value) {
+  if (value > *counter) {
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+  }
+}
+
+static void *rt_loop(void *udata) {
+  lion_rt_t *rt = udata;
+  if (rt->conf.mute_logs) {
+    log_set_thread_muted(true);
+  }
+
+  int64_t deadline = rt_now();
+  while (__atomic_load_n(&rt->_running, __ATOMIC_ACQUIRE)) {
+    deadline += rt->conf.period_ns;
+
+    // Only the newest input matters, older ones are already late
+    int fresh = 0;
+    while (lion_rt_queue_pop(&rt->inputs, &rt->hold)) {
+      fresh = 1;
+    }
+    if (!fresh) {
+      rt_add(&rt->stats.stale_inputs, 1);
+    }
+
+    int64_t       start  = rt_now();
+    lion_status_t status = lion_sim_step(rt->sim, rt->hold.power, rt->hold.ambient_temperature);
+    int64_t       end    = rt_now();
+    if (status != LION_STATUS_SUCCESS) {
+      __atomic_store_n(&rt->_status, LION_STATUS_FAILURE, __ATOMIC_RELAXED);
+      __atomic_store_n(&rt->_running, 0, __ATOMIC_RELEASE);
+      break;
+    }
+
+    lion_rt_output_t out = {
+      .step                 = rt->sim->state.step,
+      .power                = rt->sim->state.power,
+      .voltage              = rt->sim->state.voltage,
+      .current              = rt->sim->state.current,
+      .soc                  = rt->sim->state.soc_nominal,
+      .internal_temperature = rt->sim->state.internal_temperature,
+      .surface_temperature  = rt->sim->state.surface_temperature,
+      .elapsed_ns           = end - start,
+      .missed               = end > deadline,
+    };
+    if (!lion_rt_queue_push(&rt->outputs, &out)) {
+      rt_add(&rt->stats.dropped_outputs, 1);
+    }
+    rt_add(&rt->stats.steps, 1);
+    rt_max(&rt->stats.max_elapsed_ns, out.elapsed_ns);
+
+    if (out.missed) {
+      // Restart the schedule instead of bursting through the missed periods
+      rt_add(&rt->stats.deadline_misses, 1);
+      rt_max(&rt->stats.max_late_ns, end - deadline);
+      deadline = end;
+      continue;
+    }
+    struct timespec wake = rt_timespec(deadline);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) {
+    }
+  }
+
+  if (rt->conf.mute_logs) {
+    log_set_thread_muted(false);
+  }
+  return NULL;
+}
+
+lion_status_t lion_rt_start(lion_rt_t *rt) {
+  if (rt->_thread != NULL) {
+    logi_error("Real-time runner is already running");
+    return LION_STATUS_FAILURE;
+  }
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  if (rt->conf.cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(rt->conf.cpu, &cpus);
+    pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+  }
+  if (rt->conf.priority > 0) {
+    struct sched_param sched = {.sched_priority = rt->conf.priority};
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    pthread_attr_setschedparam(&attr, &sched);
+  }
+
+  pthread_t *thread = lion_malloc(rt->sim, sizeof(pthread_t));
+  if (thread == NULL) {
+    pthread_attr_destroy(&attr);
+    logi_error("Could not allocate stepping thread");
+    return LION_STATUS_FAILURE;
+  }
+  // The cap goes on a copy, so the caller keeps its configuration
+  rt->_sim_conf    = *rt->sim->conf;
+  rt->_caller_conf = rt->sim->conf;
+  if (rt->conf.max_iter > 0) {
+    rt->_sim_conf.sim_min_maxiter = rt->conf.max_iter;
+  }
+  rt->sim->conf = &rt->_sim_conf;
+  rt->_status   = LION_STATUS_SUCCESS;
+  __atomic_store_n(&rt->_running, 1, __ATOMIC_RELEASE);
+
+  int status = pthread_create(thread, &attr, &rt_loop, rt);
+  pthread_attr_destroy(&attr);
+  if (status != 0) {
+    rt->_running  = 0;
+    rt->sim->conf = rt->_caller_conf;
+    lion_free(rt->sim, thread);
+    logi_error("Could not start stepping thread (%s)", strerror(status));
+    return LION_STATUS_FAILURE;
+  }
+  rt->_thread = thread;
+  logi_info("Started real-time runner at %f Hz", (double)LION_RT_NS_PER_SECOND / (double)rt->conf.period_ns);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_rt_stop(lion_rt_t *rt) {
+  if (rt->_thread == NULL) {
+    return LION_STATUS_SUCCESS;
+  }
+  __atomic_store_n(&rt->_running, 0, __ATOMIC_RELEASE);
+  pthread_join(*(pthread_t *)rt->_thread, NULL);
+  lion_free(rt->sim, rt->_thread);
+  rt->_thread   = NULL;
+  rt->sim->conf = rt->_caller_conf;
+
+  lion_rt_stats_t stats = lion_rt_get_stats(rt);
+  logi_info("Stopped real-time runner after %" PRIu64 " steps (%" PRIu64 " deadline misses)", stats.steps, stats.deadline_misses);
+  if (rt->_status != LION_STATUS_SUCCESS) {
+    logi_error("Simulation failed at step %" PRIu64 " while running in real time", rt->sim->state.step);
+    return LION_STATUS_FAILURE;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+#else
+
+lion_status_t lion_rt_start(lion_rt_t *rt) {
+  (void)rt;
+  logi_error("Real-time runner is only supported on Linux");
+  return LION_STATUS_FAILURE;
+}
+
+lion_status_t lion_rt_stop(lion_rt_t *rt) {
+  (void)rt;
+  return LION_STATUS_SUCCESS;
+}
+
+#endif
+
+lion_status_t lion_rt_cleanup(lion_rt_t *rt) {
+  lion_status_t status = lion_rt_stop(rt);
+  LION_CALL_I(lion_rt_queue_cleanup(rt->sim, &rt->inputs), "Failed cleaning up input queue");
+  LION_CALL_I(lion_rt_queue_cleanup(rt->sim, &rt->outputs), "Failed cleaning up output queue");
+  return status;
+}
@@ -0,0 +1,173 @@
+#include <float.h>
+#include <gsl/gsl_math.h>
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion_math/lion_math.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+
+// Fixed-point iterations of the current, enough for the polarization
+// resistance to settle and exact after the first one for a fixed resistance
+#define LION_ROLLOUT_CURRENT_ITERS 3
+
+// State of a group of candidates, laid out as arrays so the arithmetic of
+// each step runs over every lane at once
+typedef struct lion_rollout_lanes {
+  double soc[LION_ROLLOUT_LANES];
+  double temperature[LION_ROLLOUT_LANES];
+  double current[LION_ROLLOUT_LANES];
+  double rc_voltage[LION_RC_MAX_BRANCHES][LION_ROLLOUT_LANES];
+
+  double power[LION_ROLLOUT_LANES];
+  double soh[LION_ROLLOUT_LANES];
+  double full_health[LION_ROLLOUT_LANES];
+  double kappa[LION_ROLLOUT_LANES];
+  double soc_use[LION_ROLLOUT_LANES];
+  double capacity_use[LION_ROLLOUT_LANES];
+  double ehc[LION_ROLLOUT_LANES];
+  double voc[LION_ROLLOUT_LANES];
+  double resistance[LION_ROLLOUT_LANES];
+  double heat[LION_ROLLOUT_LANES];
+} lion_rollout_lanes_t;
+
+// Inputs and decay factors shared by every step
+typedef struct lion_rollout_consts {
+  double h;
+  double capacity_nominal;
+  double ambient_temperature;
+  double thermal_resistance;
+  double thermal_decay;
+  double rc_decay[LION_RC_MAX_BRANCHES];
+} lion_rollout_consts_t;
+
+static void rollout_step(lion_rollout_lanes_t *l, const lion_rollout_consts_t *c, lion_params_t *params, size_t lanes, lion_rollout_result_t *res) {
+  // Algebraic part, same equations as lion_slv_update
+  lion_kappa_batch(l->temperature, lanes, params, l->kappa);
+  lion_soc_usable_batch(l->soc, l->kappa, lanes, params, l->soc_use);
+  lion_ehc_batch(l->soc_use, lanes, params, l->ehc);
+  lion_voc_batch(l->soc_use, lanes, params, l->voc);
+  for (size_t i = 0; i < lanes; i++) {
+    l->capacity_use[i]  = lion_capacity_usable(c->capacity_nominal, l->kappa[i], params);
+    l->voc[i]          += l->ehc[i] * (l->temperature[i] - params->vft.tref);
+  }
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    for (size_t i = 0; i < lanes; i++) {
+      l->voc[i] -= l->rc_voltage[k][i];
+    }
+  }
+  for (int iter = 0; iter < LION_ROLLOUT_CURRENT_ITERS; iter++) {
+    // The current solve of the simulation evaluates the resistance at full health
+    lion_resistance_batch(l->soc_use, l->current, l->full_health, lanes, params, l->resistance);
+    for (size_t i = 0; i < lanes; i++) {
+      double half         = l->voc[i] / (2.0 * l->resistance[i]);
+      double discriminant = half * half - l->power[i] / l->resistance[i];
+      res[i].feasible &= discriminant >= 0.0;
+      l->current[i] = half - sqrt(GSL_MAX_DBL(discriminant, 0.0));
+    }
+  }
+  lion_resistance_batch(l->soc_use, l->current, l->soh, lanes, params, l->resistance);
+  lion_generated_heat_batch(l->current, l->temperature, l->resistance, l->ehc, lanes, params, l->heat);
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    for (size_t i = 0; i < lanes; i++) {
+      l->heat[i] += l->rc_voltage[k][i] * l->rc_voltage[k][i] / params->rc.resistance[k];
+    }
+  }
+
+  // Outputs of the step
+  for (size_t i = 0; i < lanes; i++) {
+    double voltage          = l->voc[i] - l->resistance[i] * l->current[i];
+    res[i].min_voltage      = GSL_MIN_DBL(res[i].min_voltage, voltage);
+    res[i].max_current      = GSL_MAX_DBL(res[i].max_current, fabs(l->current[i]));
+    res[i].max_temperature  = GSL_MAX_DBL(res[i].max_temperature, l->temperature[i]);
+    res[i].energy          += l->current[i] * voltage * c->h;
+  }
+
+  // With the inputs frozen over the step the dynamics are linear, so the
+  // states follow their exact solution
+  for (size_t i = 0; i < lanes; i++) {
+    double steady     = c->ambient_temperature + l->heat[i] * c->thermal_resistance;
+    l->temperature[i] = steady + (l->temperature[i] - steady) * c->thermal_decay;
+    l->soc[i]        -= c->h * l->current[i] / l->capacity_use[i];
+  }
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    for (size_t i = 0; i < lanes; i++) {
+      double steady       = l->current[i] * params->rc.resistance[k];
+      l->rc_voltage[k][i] = steady + (l->rc_voltage[k][i] - steady) * c->rc_decay[k];
+    }
+  }
+}
+
+lion_status_t lion_rollout(lion_sim_t *sim, const double *power_candidates, size_t n_candidates, size_t horizon, lion_rollout_result_t *out) {
+  if (sim->driver == NULL) {
+    logi_error("Rollouts require an initialized simulation");
+    return LION_STATUS_FAILURE;
+  }
+  if (n_candidates > 0 && (power_candidates == NULL || out == NULL)) {
+    logi_error("Null arguments were passed to the rollout");
+    return LION_STATUS_FAILURE;
+  }
+  // The closed-form temperature is the surface model of a lone cell updated
+  // every step, anything else would silently diverge from `lion_sim_step`
+  if (sim->conf->sim_regime != LION_ONLYSF) {
+    logi_error("Rollouts do not support thermal networks (regime %s)", lion_regime_name(sim->conf->sim_regime));
+    return LION_STATUS_FAILURE;
+  }
+  if (sim->conf->sim_thermal_steps > 1) {
+    logi_error("Rollouts do not support multirate thermal steps (%" PRIu64 " steps per update)", sim->conf->sim_thermal_steps);
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_params_t   *params = sim->params;
+  lion_sim_state_t *state  = &sim->state;
+
+  lion_rollout_consts_t c = {
+    .h                   = sim->conf->sim_step_seconds,
+    .capacity_nominal    = lion_capacity_nominal(params->init.capacity, state->soh, params),
+    .ambient_temperature = state->ambient_temperature,
+    .thermal_resistance  = params->temp.rin + params->temp.rout,
+  };
+  c.thermal_decay = exp(-c.h / (params->temp.cp * c.thermal_resistance));
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    c.rc_decay[k] = exp(-c.h / (params->rc.resistance[k] * params->rc.capacitance[k]));
+  }
+
+  for (size_t first = 0; first < n_candidates; first += LION_ROLLOUT_LANES) {
+    size_t                 lanes = GSL_MIN(n_candidates - first, (size_t)LION_ROLLOUT_LANES);
+    lion_rollout_result_t *res   = out + first;
+    lion_rollout_lanes_t   l;
+
+    // Every candidate starts from x(k + 1), like the next call to lion_sim_step
+    for (size_t i = 0; i < lanes; i++) {
+      l.soc[i]         = state->_next_soc_nominal;
+      l.temperature[i] = state->_next_internal_temperature;
+      l.current[i]     = state->current;
+      l.soh[i]         = state->soh;
+      l.full_health[i] = 1.0;
+      for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+        l.rc_voltage[k][i] = state->_next_rc_voltage[k];
+      }
+      res[i] = (lion_rollout_result_t){
+        .max_temperature = -DBL_MAX,
+        .min_voltage     = DBL_MAX,
+        .max_current     = 0.0,
+        .energy          = 0.0,
+        .feasible        = 1,
+      };
+    }
+
+    for (size_t t = 0; t < horizon; t++) {
+      for (size_t i = 0; i < lanes; i++) {
+        l.power[i] = power_candidates[(first + i) * horizon + t];
+      }
+      rollout_step(&l, &c, params, lanes, res);
+    }
+
+    for (size_t i = 0; i < lanes; i++) {
+      res[i].final_soc         = l.soc[i];
+      res[i].final_temperature = l.temperature[i];
+      res[i].max_temperature   = GSL_MAX_DBL(res[i].max_temperature, l.temperature[i]);
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
@@ -1,16 +1,23 @@
 #include "mem.h"
 #include "sim_run.h"
+#include "solver/blocks.h"
+#include "solver/jump.h"
+#include "solver/multirate.h"
+#include "solver/native.h"
 #include "solver/sys.h"
 #include "solver/update.h"
 
 #include <gsl/gsl_errno.h>
+#include <gsl/gsl_math.h>
 #include <gsl/gsl_odeiv2.h>
+#include <gsl/gsl_rng.h>
 #include <inttypes.h>
 #include <lion/lion.h>
 #include <lion_math/dynamics/soh.h>
 #include <lion_utils/macros.h>
 #include <lion_utils/vendor/log.h>
 #include <math.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -56,6 +63,20 @@ const lion_sim_config_t LION_SIM_CONFIG_DEFAULT = {
   .sim_step_seconds = 1e-3,
   .sim_epsabs       = 1e-8,
   .sim_epsrel       = 1e-8,
+  .sim_input_hold   = LION_HOLD_ZERO,
+
+  // Closed form propagation
+  .sim_jump             = LION_JUMP_NONE,
+  .sim_jump_min_steps   = 16,
+  .sim_jump_max_seconds = 600.0,
+
+  // Multirate integration
+  .sim_thermal_steps = 1,
+  .sim_aging_steps   = 1,
+
+  // Step budget
+  .sim_current_budget = 0,
+  .sim_ode_budget     = 0,
 
   // Logging
   .log_dir     = NULL,
@@ -71,6 +92,18 @@ lion_status_t lion_sim_config_new(lion_sim_config_t *out) {
 
 lion_sim_config_t lion_sim_config_default(void) { return LION_SIM_CONFIG_DEFAULT; }
 
+double *lion_sim_config_field(lion_sim_config_t *conf, const char *name) {
+  if (strcmp(name, "sim_time_seconds") == 0)
+    return &conf->sim_time_seconds;
+  if (strcmp(name, "sim_step_seconds") == 0)
+    return &conf->sim_step_seconds;
+  if (strcmp(name, "sim_epsabs") == 0)
+    return &conf->sim_epsabs;
+  if (strcmp(name, "sim_epsrel") == 0)
+    return &conf->sim_epsrel;
+  return NULL;
+}
+
 static lion_status_t create_directory(const char *dirname) {
 #ifdef _WIN32
   if (CREATE_DIRECTORY(dirname) == 0) {
@@ -110,6 +143,8 @@ lion_status_t lion_sim_new(lion_sim_config_t *conf, lion_params_t *params, lion_
     .sys_min   = NULL,
     .step_type = NULL,
     .minimizer = NULL,
+    .rng       = NULL,
+    .parent    = NULL,
 
 #ifndef NDEBUG // Internal debug information
     ._idebug_malloced_total = 0,
@@ -173,11 +208,17 @@ static void lion_sim_log_startup_info(lion_sim_t *sim) {
   logi_info(" * Stepper                        : %s", lion_stepper_name(sim->conf->sim_stepper));
   logi_info(" * Minimizer                      : %s", lion_minimizer_name(sim->conf->sim_minimizer));
   logi_info(" * Jacobian                       : %s", lion_jacobian_name(sim->conf->sim_jacobian));
+  logi_info(" * Input hold                     : %s", lion_input_hold_name(sim->conf->sim_input_hold));
+  logi_info(" * Jumped intervals               : %s", lion_jump_name(sim->conf->sim_jump));
+  logi_info(" * Steps per thermal step         : %" PRIu64 " steps", GSL_MAX(sim->conf->sim_thermal_steps, 1));
+  logi_info(" * Steps per aging step           : %" PRIu64 " steps", GSL_MAX(sim->conf->sim_aging_steps, 1));
   logi_info(" * Total simulation time          : %f s", sim->conf->sim_time_seconds);
   logi_info(" * Simulation step time           : %f s", sim->conf->sim_step_seconds);
   logi_info(" * Absolute epsilon               : %f", sim->conf->sim_epsabs);
   logi_info(" * Relative epsilon               : %f", sim->conf->sim_epsrel);
   logi_info(" * Minimization max iterations    : %d iterations", sim->conf->sim_min_maxiter);
+  logi_info(" * Current evaluation budget      : %" PRIu64 " evaluations", sim->conf->sim_current_budget);
+  logi_info(" * ODE evaluation budget          : %" PRIu64 " evaluations", sim->conf->sim_ode_budget);
   if (sim->init_hook != NULL) {
     logi_info(" * Init hook                      : YES");
   } else {
@@ -222,6 +263,11 @@ static void lion_sim_log_startup_info(lion_sim_t *sim) {
   logi_info(" |-> Outer thermal resistivity    : %f K W-1", sim->params->temp.rout);
   logi_info(" * Internal resistance model");
   logi_info(" |-> Model                        : %s", lion_params_rint_get_name(sim->params->rint.model));
+  logi_info(" * Polarization model");
+  logi_info(" |-> RC branches                  : %u", sim->params->rc.n_branches);
+  for (uint32_t k = 0; k < sim->params->rc.n_branches; k++) {
+    logi_info(" |-> Branch %u                     : %f Ohm, %f F", k, sim->params->rc.resistance[k], sim->params->rc.capacitance[k]);
+  }
   logi_info(" * Degradation model");
   logi_info(" |-> Model                        : %s", lion_params_soh_get_name(sim->params->soh.model));
   logi_info("+-------------------------------------------------------+");
@@ -265,6 +311,12 @@ lion_status_t _init_simulation_stepper(lion_sim_t *sim) {
   case LION_STEPPER_MSBDF:
     sim->step_type = gsl_odeiv2_step_msbdf;
     break;
+  case LION_STEPPER_NATIVE_RK4:
+  case LION_STEPPER_NATIVE_RK45:
+  case LION_STEPPER_NATIVE_ROS2:
+    // The cell steps natively, the driver is kept for everything else
+    sim->step_type = lion_slv_native_fallback(sim->conf->sim_stepper);
+    break;
   default:
     logi_error("Desired step type not implemented");
     return LION_STATUS_FAILURE;
@@ -296,31 +348,52 @@ lion_status_t _init_initial_state(lion_sim_t *sim) {
   logi_debug("Setting up initial conditions");
   // The current is set at first because it is used as an initial guess
   // for the optimization problem
-  sim->state._next_soc_nominal          = sim->params->init.soc;
-  sim->state._next_internal_temperature = sim->params->init.temp_in;
+  lion_slv_blocks_reset(&sim->state, sim->params);
   sim->state._acc_discharge             = 0.0;
   sim->state._soc_mean                  = 0.0;
   sim->state._soc_max                   = 0.0;
   sim->state._soc_min                   = 1.0;
   sim->state.soh                        = sim->params->init.soh;
   sim->state.current                    = sim->params->init.current_guess;
+  sim->state.input_mode                 = LION_INPUT_POWER;
   sim->state.time                       = 0.0;
   sim->state.step                       = 0;
   sim->state.cycle                      = 0;
+  sim->state.step_flags                 = 0;
+  sim->state.step_evaluations           = 0;
+  sim->state._thermal_step              = 0;
+  sim->state._aging_step                = 0;
+  lion_sim_stats_reset(sim);
+  lion_sim_events_reset(sim);
   return LION_STATUS_SUCCESS;
 }
 
+void lion_sim_refresh_inputs(lion_sim_t *sim) {
+  sim->inputs.sys_params     = sim->params;
+  sim->inputs.hold_span      = (sim->conf->sim_input_hold == LION_HOLD_FIRST) ? sim->conf->sim_step_seconds : 0.0;
+  sim->inputs.thermal_frozen = sim->conf->sim_thermal_steps > 1;
+  sim->inputs.thermal_decay  = exp(-sim->conf->sim_step_seconds / ((sim->params->temp.rin + sim->params->temp.rout) * sim->params->temp.cp));
+}
+
 lion_status_t _init_ode_system(lion_sim_t *sim) {
+  LION_CALL_I(lion_slv_blocks_validate(sim->params), "Invalid model parameters");
   logi_debug("Setting up GSL inputs");
-  sim->inputs.sys_inputs = &sim->state;
-  sim->inputs.sys_params = sim->params;
+  sim->inputs.sys_inputs      = &sim->state;
+  sim->inputs.evaluations     = 0;
+  sim->inputs.max_evaluations = 0;
+  lion_sim_refresh_inputs(sim);
   logi_debug("Creating GSL system");
-  void *jac;
+  size_t dimension = lion_slv_blocks_dimension(sim->params);
+  void  *jac;
   switch (sim->conf->sim_jacobian) {
   case LION_JACOBIAN_ANALYTICAL:
-    jac = &lion_slv_jac_analytical;
+    jac = &lion_slv_jac_blocks;
     break;
   case LION_JACOBIAN_2POINT:
+    if (dimension != LION_SLV_DIMENSION) {
+      logi_error("Two point Jacobian only supports the state of charge and internal temperature");
+      return LION_STATUS_FAILURE;
+    }
     jac = &lion_slv_jac_2point;
     break;
   default:
@@ -328,9 +401,9 @@ lion_status_t _init_ode_system(lion_sim_t *sim) {
     break;
   }
   gsl_odeiv2_system sys = {
-    .function  = &lion_slv_system_continuous,
+    .function  = &lion_slv_system_blocks,
     .jacobian  = jac,
-    .dimension = LION_SLV_DIMENSION,
+    .dimension = dimension,
     .params    = &sim->inputs,
   };
   sim->sys = sys;
@@ -342,6 +415,19 @@ lion_status_t _init_ode_driver(lion_sim_t *sim) {
   return LION_STATUS_SUCCESS;
 }
 
+lion_status_t _init_rng(lion_sim_t *sim) {
+  gsl_rng_env_setup();
+  sim->rng = gsl_rng_alloc(gsl_rng_default);
+  if (sim->rng == NULL) {
+    logi_error("Failed allocating random number generator");
+    return LION_STATUS_FAILURE;
+  }
+  sim->_seed = (unsigned long)time(NULL);
+  gsl_rng_set(sim->rng, sim->_seed);
+  logi_debug("Using random number generator %s", gsl_rng_name(sim->rng));
+  return LION_STATUS_SUCCESS;
+}
+
 lion_status_t _init_parameters(lion_sim_t *sim) {
   // Initialize SoH model
   if (sim->params->soh.model == LION_SOH_MODEL_MASSERANO) {
@@ -395,6 +481,9 @@ lion_status_t lion_sim_init(lion_sim_t *sim) {
   logi_info("Configuring simulation driver");
   LION_CALL_I(_init_ode_driver(sim), "Failed initializing ode driver");
 
+  logi_debug("Configuring random number generator");
+  LION_CALL_I(_init_rng(sim), "Failed initializing random number generator");
+
   logi_info("Configuring simulation parameters");
   LION_CALL_I(_init_parameters(sim), "Failed initializing simulation parameters");
 
@@ -418,7 +507,171 @@ lion_status_t lion_sim_reset(lion_sim_t *sim) {
   return LION_STATUS_SUCCESS;
 }
 
+#define _LION_STATE_FIELD(path) {.name = #path, .offset = offsetof(lion_sim_state_t, path)}
+
+typedef struct lion_state_field_entry {
+  const char *name;
+  size_t      offset;
+} lion_state_field_entry_t;
+
+static const lion_state_field_entry_t LION_STATE_FIELDS[] = {
+  _LION_STATE_FIELD(time),
+  _LION_STATE_FIELD(power),
+  _LION_STATE_FIELD(ambient_temperature),
+  _LION_STATE_FIELD(voltage),
+  _LION_STATE_FIELD(current),
+  _LION_STATE_FIELD(ref_open_circuit_voltage),
+  _LION_STATE_FIELD(open_circuit_voltage),
+  _LION_STATE_FIELD(internal_resistance),
+  _LION_STATE_FIELD(rc_voltage[0]),
+  _LION_STATE_FIELD(rc_voltage[1]),
+  _LION_STATE_FIELD(rc_voltage[2]),
+  _LION_STATE_FIELD(polarization_voltage),
+  _LION_STATE_FIELD(soh),
+  _LION_STATE_FIELD(ehc),
+  _LION_STATE_FIELD(generated_heat),
+  _LION_STATE_FIELD(internal_temperature),
+  _LION_STATE_FIELD(surface_temperature),
+  _LION_STATE_FIELD(kappa),
+  _LION_STATE_FIELD(soc_nominal),
+  _LION_STATE_FIELD(capacity_nominal),
+  _LION_STATE_FIELD(soc_use),
+  _LION_STATE_FIELD(capacity_use),
+};
+
+double *lion_sim_state_field(lion_sim_state_t *state, const char *name) {
+  for (size_t i = 0; i < sizeof(LION_STATE_FIELDS) / sizeof(LION_STATE_FIELDS[0]); i++) {
+    if (strcmp(LION_STATE_FIELDS[i].name, name) == 0) {
+      return (double *)((char *)state + LION_STATE_FIELDS[i].offset);
+    }
+  }
+  return NULL;
+}
+
+// Seed of the n-th fork of a simulation seeded with `seed`, mixed so that
+// consecutive forks start unrelated streams
+static unsigned long _fork_seed(unsigned long seed, uint64_t n) {
+  uint64_t z = (uint64_t)seed + n * 0x9E3779B97F4A7C15ull;
+  z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z          = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return (unsigned long)(z ^ (z >> 31));
+}
+
+static lion_status_t _fork_handles(lion_sim_t *src, lion_sim_t *dst) {
+  // The solver handles point into the sim, so they are created in place
+  LION_CALL_I(_init_ode_system(dst), "Failed initializing ode system");
+  LION_CALL_I(_init_ode_driver(dst), "Failed initializing ode driver");
+  dst->sys_min = gsl_min_fminimizer_alloc(dst->minimizer);
+  dst->rng     = gsl_rng_alloc(src->rng->type);
+  if (dst->sys_min == NULL || dst->rng == NULL) {
+    logi_error("Failed allocating solver handles for fork");
+    return LION_STATUS_FAILURE;
+  }
+
+  // The fork is seeded from the count of forks of its parent, which leaves
+  // the stream of the parent untouched
+  dst->_seed = _fork_seed(src->_seed, ++src->_forks);
+  gsl_rng_set(dst->rng, dst->_seed);
+
+  // Events and accumulators carry on from where the parent left them
+  if (src->n_events > 0) {
+    dst->events = lion_malloc(dst, src->n_events * sizeof(lion_event_t));
+    if (dst->events == NULL) {
+      logi_error("Failed allocating events for fork");
+      return LION_STATUS_FAILURE;
+    }
+    memcpy(dst->events, src->events, src->n_events * sizeof(lion_event_t));
+    dst->n_events = src->n_events;
+  }
+  if (src->n_stats > 0) {
+    dst->stats = lion_malloc(dst, src->n_stats * sizeof(lion_stat_t));
+    if (dst->stats == NULL) {
+      logi_error("Failed allocating accumulators for fork");
+      return LION_STATUS_FAILURE;
+    }
+    for (size_t i = 0; i < src->n_stats; i++) {
+      dst->stats[i]      = src->stats[i];
+      dst->stats[i].bins = NULL;
+      dst->n_stats       = i + 1;
+      if (src->stats[i].bins != NULL) {
+        dst->stats[i].bins = lion_malloc(dst, src->stats[i].n_bins * sizeof(uint64_t));
+        if (dst->stats[i].bins == NULL) {
+          logi_error("Failed allocating histogram for fork");
+          return LION_STATUS_FAILURE;
+        }
+        memcpy(dst->stats[i].bins, src->stats[i].bins, src->stats[i].n_bins * sizeof(uint64_t));
+      }
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_sim_fork(lion_sim_t *src, lion_sim_t *dst) {
+  if (src->driver == NULL || src->rng == NULL) {
+    logi_error("Only initialized simulations can be forked");
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_sim_t sim = {
+    .conf          = src->conf,
+    .params        = src->params,
+    .state         = src->state,
+    .init_hook     = src->init_hook,
+    .update_hook   = src->update_hook,
+    .finished_hook = src->finished_hook,
+
+    .driver    = NULL,
+    .sys_min   = NULL,
+    .step_type = src->step_type,
+    .minimizer = src->minimizer,
+    .rng       = NULL,
+    .parent    = src,
+    ._close    = lion_sim_should_close(src),
+
+    .log_file = src->log_file,
+
+#ifndef NDEBUG // Internal debug information
+    ._idebug_malloced_total = 0,
+#endif
+  };
+  memcpy(sim.log_filename, src->log_filename, sizeof(sim.log_filename));
+#ifndef NDEBUG
+  LION_CALL_I(lion_sim_init_debug(&sim), "Failed initializing debug information");
+#endif
+  *dst = sim;
+
+  if (_fork_handles(src, dst) != LION_STATUS_SUCCESS) {
+    lion_sim_cleanup(dst);
+    return LION_STATUS_FAILURE;
+  }
+  logi_debug("Forked simulation at step %" PRIu64, src->state.step);
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t _step_fallback(lion_sim_t *sim, double y[]) {
+  // The stepper ran out of budget halfway, so the step restarts from x(k)
+  // with a single evaluation of the derivatives
+  double dydt[LION_SLV_MAX_DIMENSION];
+  lion_slv_blocks_load(&sim->state, sim->params, y);
+  sim->inputs.max_evaluations = 0;
+  int status                  = lion_slv_system_blocks(sim->state.time, y, dydt, &sim->inputs);
+  LION_GSL_CALL_I(status, "Failed evaluating fallback derivatives");
+  for (size_t i = 0; i < sim->sys.dimension; i++) {
+    y[i] += sim->conf->sim_step_seconds * dydt[i];
+  }
+  sim->state.time += sim->conf->sim_step_seconds;
+  sim->state.step_evaluations++;
+  sim->state.step_flags |= LION_STEP_ODE_FALLBACK;
+  status = gsl_odeiv2_driver_reset(sim->driver);
+  LION_GSL_CALL_I(status, "Failed resetting ode driver");
+  return LION_STATUS_SUCCESS;
+}
+
 lion_status_t lion_sim_step(lion_sim_t *sim, double power, double ambient_temperature) {
+  return lion_sim_step_input(sim, LION_INPUT_POWER, power, ambient_temperature);
+}
+
+lion_status_t lion_sim_step_input(lion_sim_t *sim, lion_input_mode_t mode, double value, double ambient_temperature) {
   /*
      By using this update logic, at the end of every call sim->state contains the inputs,
      outputs and states at timestep k, and the states at k+1 are stored in placeholder
@@ -426,54 +679,70 @@ lion_status_t lion_sim_step(lion_sim_t *sim, double power, double ambient_temper
   */
 
   // sim->state = {x(k - 1), y(k - 1), u(k - 1)}
-  sim->state.soc_nominal          = sim->state._next_soc_nominal;
-  sim->state.internal_temperature = sim->state._next_internal_temperature;
+  lion_sim_state_t previous;
+  if (sim->n_events > 0) {
+    previous = sim->state;
+  }
+  lion_slv_blocks_advance(&sim->state, sim->params);
   // sim->state = {x(k), y(k - 1), u(k - 1)}
-  sim->state.power                = power;
-  sim->state.ambient_temperature  = ambient_temperature;
+  // The first-order hold ramps from the inputs of the previous step, as long
+  // as they control the same quantity
+  int ramp                             = sim->state.step > 0 && mode == sim->state.input_mode;
+  sim->state._hold_ambient_temperature = ramp ? sim->state.ambient_temperature : ambient_temperature;
+  switch (mode) {
+  case LION_INPUT_POWER:
+    sim->state._hold_input = ramp ? sim->state.power : value;
+    sim->state.power       = value;
+    break;
+  case LION_INPUT_CURRENT:
+    sim->state._hold_input = ramp ? sim->state.current : value;
+    sim->state.current     = value;
+    break;
+  case LION_INPUT_VOLTAGE:
+    sim->state._hold_input = ramp ? sim->state.voltage : value;
+    sim->state.voltage     = value;
+    break;
+  default:
+    logi_error("Input mode not valid");
+    return LION_STATUS_FAILURE;
+  }
+  sim->state.input_mode          = mode;
+  sim->state.ambient_temperature = ambient_temperature;
+  sim->state.step_flags          = 0;
+  sim->state.step_evaluations    = 0;
   // sim->state = {x(k), y(k - 1), u(k)}
   LION_CALL_I(lion_slv_update(sim), "Failed updating state");
   // sim->state = {x(k), y(k), u(k)}
-  double partial_result[2] = {sim->state.soc_nominal, sim->state.internal_temperature};
-  LION_GSL_VCALL_I(
-      gsl_odeiv2_driver_apply_fixed_step(sim->driver, &sim->state.time, sim->conf->sim_step_seconds, 1, partial_result),
-      "Failed at step %" PRIu64 " (t = %f)",
-      sim->state.step,
-      sim->state.time
-  );
-  sim->state._next_soc_nominal          = partial_result[0];
-  sim->state._next_internal_temperature = partial_result[1];
-
-  // Update SoC statistics
-  sim->state._soc_mean = ((double)sim->state._cycle_step * sim->state._soc_mean + sim->state.soc_nominal) / (double)(sim->state._cycle_step + 1);
-  if (sim->state.soc_nominal > sim->state._soc_max)
-    sim->state._soc_max = sim->state.soc_nominal;
-  if (sim->state.soc_nominal < sim->state._soc_min)
-    sim->state._soc_min = sim->state.soc_nominal;
-
-  // Update the degradation state of the cell
-  sim->state._acc_discharge += GSL_MAX_DBL(sim->state.current * sim->conf->sim_step_seconds, 0.0);
-  if (sim->state._acc_discharge >= sim->state.capacity_nominal) {
-    // A cycle has been completed so we update the SoH
-    logi_debug("Old SoH: %lf", sim->state.soh);
-    logi_debug("ASSR: %lf", sim->state._soc_mean);
-    logi_debug("SR: %lf", sim->state._soc_max - sim->state._soc_min);
-    sim->state._acc_discharge = fmod(sim->state._acc_discharge, sim->state.capacity_nominal);
-    sim->state.soh            = lion_soh_next(
-        sim, sim->state.soh, sim->state._soc_mean, sim->state._soc_max, sim->state._soc_min, sim->state.internal_temperature, sim->params
-    );
-    logi_debug("New SoH: %lf", sim->state.soh);
-
-    // Restart placeholder values
-    sim->state._soc_mean   = 0.0;
-    sim->state._soc_max    = 0.0;
-    sim->state._soc_min    = 1.0;
-    sim->state._cycle_step = 0;
-
-    sim->state.cycle++;
+  if (sim->n_events > 0) {
+    int stop;
+    LION_CALL_I(lion_sim_events_check(sim, &previous, &stop), "Failed checking events");
+    if (stop) {
+      // The step ends at the event without being integrated
+      sim->_events_span = 0.0;
+      if (sim->update_hook != NULL) {
+        LION_CALLDF_I(sim->update_hook(sim), "Failed calling update hook");
+      }
+      sim->state.step++;
+      return LION_STATUS_SUCCESS;
+    }
+  }
+  double partial_result[LION_SLV_MAX_DIMENSION];
+  lion_slv_blocks_load(&sim->state, sim->params, partial_result);
+  sim->inputs.evaluations     = 0;
+  sim->inputs.max_evaluations = sim->conf->sim_ode_budget;
+  int status = lion_slv_apply(sim, &sim->state.time, sim->conf->sim_step_seconds, partial_result);
+  sim->state.step_evaluations += sim->inputs.evaluations;
+  if (status == GSL_EMAXITER && sim->conf->sim_ode_budget > 0) {
+    LION_CALL_I(_step_fallback(sim, partial_result), "Failed falling back to an Euler step");
   } else {
-    sim->state._cycle_step++;
+    LION_GSL_VCALL_I(status, "Failed at step %" PRIu64 " (t = %f)", sim->state.step, sim->state.time);
   }
+  lion_slv_blocks_store(&sim->state, sim->params, partial_result);
+  lion_slv_multirate_thermal(sim);
+  sim->_events_span = sim->conf->sim_step_seconds;
+
+  LION_CALL_I(lion_slv_update_degradation(sim, &sim->state, sim->params), "Failed updating degradation state");
+  lion_sim_stats_update(sim);
 
   if (sim->update_hook != NULL) {
     // TODO: Evaluate implementation of concurrency
@@ -485,6 +754,80 @@ lion_status_t lion_sim_step(lion_sim_t *sim, double power, double ambient_temper
   return LION_STATUS_SUCCESS;
 }
 
+lion_status_t lion_sim_jump(lion_sim_t *sim, double power, double ambient_temperature, uint64_t steps) {
+  if (steps == 0) {
+    return LION_STATUS_SUCCESS;
+  }
+  // The first step goes through the stepper, so the events, the input hold
+  // and the hooks see the change of inputs
+  LION_CALL_I(lion_sim_step(sim, power, ambient_temperature), "Failed stepping into the interval");
+  if (sim->n_events > 0) {
+    for (uint64_t i = 1; i < steps && !lion_sim_should_close(sim); i++) {
+      LION_CALL_I(lion_sim_step(sim, power, ambient_temperature), "Failed stepping over the interval");
+    }
+    return LION_STATUS_SUCCESS;
+  }
+
+  // The closed form carries the temperature along with the other states
+  lion_slv_multirate_flush(sim);
+
+  // At rest nothing is held, so the whole interval is a single stretch. The
+  // current is taken as exactly zero, instead of the one solved up to the
+  // tolerance of the minimizer, which would drift over long rests. The
+  // statistics only see the outputs at the ends of the stretches, so they
+  // keep the stretches short even at rest
+  int      rest    = power == 0.0;
+  double   h       = sim->conf->sim_step_seconds;
+  uint64_t chunk   = (rest && sim->n_stats == 0) ? UINT64_MAX : (uint64_t)GSL_MAX_DBL(floor(sim->conf->sim_jump_max_seconds / h), 1.0);
+  uint64_t left    = steps - 1;
+  uint64_t pending = 0;
+  while (left > 0 && !lion_sim_should_close(sim)) {
+    // sim->state = {x(k), y(k), u}
+    lion_slv_blocks_advance(&sim->state, sim->params);
+    sim->state.step_flags       = 0;
+    sim->state.step_evaluations = 0;
+    LION_CALL_I(lion_slv_update(sim), "Failed updating state");
+    // sim->state = {x(k + 1), y(k + 1), u}, which hold over the next c steps.
+    // The last step is taken alone, so the interval ends like lion_sim_step
+    uint64_t c = (left > 1) ? GSL_MIN(left - 1, chunk) : 1;
+    if (!rest && sim->state.current > 0.0) {
+      // Cycles complete at the end of a stretch, with the outputs of its start
+      double to_cycle = ceil((sim->state.capacity_nominal - sim->state._acc_discharge) / (sim->state.current * h));
+      c               = (uint64_t)GSL_MAX_DBL(GSL_MIN_DBL((double)c, to_cycle), 1.0);
+    }
+
+    double y[LION_SLV_MAX_DIMENSION];
+    double span    = (double)c * h;
+    double current = rest ? 0.0 : sim->state.current;
+    lion_slv_blocks_load(&sim->state, sim->params, y);
+    double calendar = lion_slv_jump_calendar(&sim->state, sim->params, current, y, span);
+    double soc      = y[0];
+    lion_slv_jump(&sim->state, sim->params, current, y, span);
+    lion_slv_blocks_store(&sim->state, sim->params, y);
+    sim->state.time += span;
+    // sim->state = {x(k + 1), y(k + 1), u} with the placeholders holding x(k + 1 + c)
+
+    double soc_last = soc + (y[0] - soc) * (double)(c - 1) / (double)c;
+    LION_CALL_I(lion_slv_update_degradation_steps(sim, &sim->state, sim->params, c, soc_last, calendar), "Failed updating degradation state");
+    // The c steps of the stretch are summed with the trapezoidal rule, which
+    // gives (c + 1) / 2 of them to its start and (c - 1) / 2 to its end. The
+    // end is only known once the next stretch is updated, so its share waits
+    lion_sim_stats_update_steps(sim, pending + (c + 2) / 2);
+    pending = c - (c + 2) / 2;
+    if (sim->update_hook != NULL) {
+      LION_CALLDF_I(sim->update_hook(sim), "Failed calling update hook");
+    }
+    sim->state.step += c;
+    left -= c;
+  }
+  // The interval ends with a stretch of a single step, which leaves nothing
+  // pending unless the simulation closed earlier
+  if (pending > 0) {
+    lion_sim_stats_update_steps(sim, pending);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
 lion_status_t lion_sim_run(lion_sim_t *sim, lion_vector_t *power, lion_vector_t *ambient_temperature) {
   logi_info("Simulation start");
 #ifndef NDEBUG
@@ -507,20 +850,29 @@ lion_status_t lion_sim_run(lion_sim_t *sim, lion_vector_t *power, lion_vector_t
 
 lion_status_t lion_sim_cleanup(lion_sim_t *sim) {
   if (sim->driver != NULL) {
-    logi_info("GSL driver detected, freeing it");
+    logi_debug("GSL driver detected, freeing it");
     gsl_odeiv2_driver_free(sim->driver);
   } else {
     logi_warn("No GSL driver detected");
   }
 
   if (sim->sys_min != NULL) {
-    logi_info("GSL minimizer detected, freeing it");
+    logi_debug("GSL minimizer detected, freeing it");
     gsl_min_fminimizer_free(sim->sys_min);
   } else {
     logi_warn("No GSL minimizer detected");
   }
 
-  if (sim->params->soh.model == LION_SOH_MODEL_MASSERANO) {
+  if (sim->rng != NULL) {
+    gsl_rng_free(sim->rng);
+  }
+
+  LION_CALL_I(lion_sim_stats_cleanup(sim), "Failed cleaning up accumulators");
+  LION_CALL_I(lion_sim_events_cleanup(sim), "Failed cleaning up events");
+
+  if (sim->parent != NULL) {
+    logi_debug("Forked simulation, parameter tables are owned by the parent");
+  } else if (sim->params->soh.model == LION_SOH_MODEL_MASSERANO) {
     logi_info("Detected Masserano's SoH model, freeing it");
     lion_free(sim, sim->params->soh.params.masserano.knn._dataset);
     lion_gaussian_kde_cleanup(&sim->params->soh.params.masserano.kde);
@@ -566,6 +918,4 @@ lion_version_t lion_sim_get_version(lion_sim_t *sim) {
   return out;
 }
 
-int lion_sim_should_close(lion_sim_t *sim) { return 0; }
-
 uint64_t lion_sim_max_iters(lion_sim_t *sim) { return (uint64_t)(sim->conf->sim_time_seconds / sim->conf->sim_step_seconds); }
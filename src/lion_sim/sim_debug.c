@@ -41,6 +41,15 @@ void heapinfo_push(lion_sim_t *sim, void *addr, size_t size, const char *file, i
   logi_trace("Pushing %#p @ %s:%d", addr, file, line);
   _idebug_heap_info_t *head  = sim->_idebug_heap_head;
   size_t               count = 0;
+  if (head == NULL) {
+    // Every tracked allocation was popped, so the list starts over
+    head = heapinfo_new(sim);
+    if (head == NULL) {
+      logi_error("Could not push element");
+      return;
+    }
+    sim->_idebug_heap_head = head;
+  }
   if (head->addr == NULL) {
     logi_trace("Pushing to start of list");
     head->addr = addr;
@@ -74,6 +83,10 @@ size_t heapinfo_popaddr(lion_sim_t *sim, void *addr) {
   logi_trace("Searching element with address %#p", addr);
   size_t               count = 0;
   _idebug_heap_info_t *curr  = sim->_idebug_heap_head;
+  if (curr == NULL) {
+    logi_error("Could not find element %#p, no elements are tracked", addr);
+    return 0;
+  }
   if (curr->addr == addr) {
     // First element is the one to pop (border case)
     logi_trace("HEAP INFO (%d) %#p", count, curr->addr);
@@ -1,6 +1,7 @@
 #include "sim_run.h"
 
 #include <gsl/gsl_odeiv2.h>
+#include <inttypes.h>
 #include <lion/lion.h>
 #include <lion_utils/macros.h>
 #include <lion_utils/vendor/log.h>
@@ -66,8 +67,41 @@ void _update_progressbar(FILE *buf, int i, int max, int width, int *c, int *last
 
 void _finish_progressbar(FILE *buf) { fprintf(stderr, "\033[EDone\n"); }
 
+// Length of the interval of constant inputs starting at sample i if it can be
+// jumped, 0 otherwise
+static uint64_t sim_run_length(lion_sim_t *sim, const lion_vector_view_d_t *power, const lion_vector_view_d_t *amb_temp, uint64_t i, uint64_t end) {
+  lion_jump_t jump = sim->conf->sim_jump;
+  if (jump == LION_JUMP_NONE || (jump == LION_JUMP_REST && power->data[i] != 0.0)) {
+    return 0;
+  }
+  uint64_t n = 1;
+  while (i + n < end && power->data[i + n] == power->data[i] && amb_temp->data[i + n] == amb_temp->data[i]) {
+    n++;
+  }
+  return (n >= sim->conf->sim_jump_min_steps && n > 1) ? n : 0;
+}
+
+lion_status_t lion_sim_simulate_span(
+    lion_sim_t *sim, const lion_vector_view_d_t *power, const lion_vector_view_d_t *amb_temp, uint64_t begin, uint64_t end
+) {
+  for (uint64_t i = begin; i < end && !lion_sim_should_close(sim); i++) {
+    uint64_t run = sim_run_length(sim, power, amb_temp, i, end);
+    if (run > 0) {
+      LION_CALL_I(lion_sim_jump(sim, power->data[i], amb_temp->data[i], run), "Failed jumping over constant inputs");
+      i += run - 1;
+    } else {
+      LION_CALL_I(lion_sim_step(sim, power->data[i], amb_temp->data[i]), "Failed stepping");
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
 lion_status_t lion_sim_simulate(lion_sim_t *sim, lion_vector_t *power, lion_vector_t *amb_temp) {
 
+  lion_vector_view_d_t power_view, amb_temp_view;
+  LION_CALL_I(lion_vector_view_d(sim, power, &power_view), "Power must be a vector of doubles");
+  LION_CALL_I(lion_vector_view_d(sim, amb_temp, &amb_temp_view), "Ambient temperature must be a vector of doubles");
+
   uint64_t max_iters = fminl(power->len, amb_temp->len);
   logi_debug("Considering %d max iterations", max_iters);
 
@@ -82,7 +116,52 @@ lion_status_t lion_sim_simulate(lion_sim_t *sim, lion_vector_t *power, lion_vect
       logi_error("Ran out of inputs before reaching end of simulation");
       break;
     }
-    LION_VCALL_I(lion_sim_step(sim, lion_vector_get_d(sim, power, i), lion_vector_get_d(sim, amb_temp, i)), "Failed at iteration %i", i);
+    uint64_t run = sim_run_length(sim, &power_view, &amb_temp_view, i, max_iters);
+    if (run > 0) {
+      LION_CALL_I(lion_sim_jump(sim, power_view.data[i], amb_temp_view.data[i], run), "Failed jumping over constant inputs");
+      i += run - 1;
+    } else {
+      LION_VCALL_I(lion_sim_step(sim, power_view.data[i], amb_temp_view.data[i]), "Failed at iteration %i", i);
+    }
+    if (lion_sim_should_close(sim)) {
+      logi_info("Closing simulation early at step %" PRIu64, sim->state.step);
+      break;
+    }
+  }
+  _finish_progressbar(stderr);
+
+  logi_debug("Finished iterations");
+  if (sim->finished_hook != NULL) {
+    logi_debug("Found finished hook");
+    LION_CALLDF_I(sim->finished_hook(sim), "Failed calling finished hook");
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_sim_simulate_inputs(lion_sim_t *sim, lion_input_channel_t *power, lion_input_channel_t *amb_temp) {
+  // Steps take the inputs at the time they end, and the times are measured
+  // from the start of the run so they do not drift with the step count
+  double   h         = sim->conf->sim_step_seconds;
+  double   start     = sim->state.time;
+  double   end       = fmin(lion_input_channel_end(power), lion_input_channel_end(amb_temp));
+  uint64_t max_iters = (end > start) ? (uint64_t)floor((end - start) / h + 1e-9) + 1 : 1;
+  logi_debug("Considering %" PRIu64 " max iterations", max_iters);
+  lion_input_channel_rewind(power);
+  lion_input_channel_rewind(amb_temp);
+
+  logi_debug("Starting iterations");
+  _template_progressbar(stderr, LION_PROGRESSBAR_WIDTH);
+  int c      = 0;
+  int last_c = 0;
+  for (uint64_t i = 1; i < max_iters; i++) {
+    _update_progressbar(stderr, i, max_iters, LION_PROGRESSBAR_WIDTH, &c, &last_c);
+
+    double t = start + (double)i * h;
+    LION_CALL_I(lion_sim_step(sim, lion_input_channel_at(power, t), lion_input_channel_at(amb_temp, t)), "Failed stepping over the input channels");
+    if (lion_sim_should_close(sim)) {
+      logi_info("Closing simulation early at step %" PRIu64, sim->state.step);
+      break;
+    }
   }
   _finish_progressbar(stderr);
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <lion/input.h>
 #include <lion/sim.h>
 #include <lion/status.h>
 #include <stddef.h>
@@ -12,6 +13,20 @@ lion_status_t lion_sim_show_state_info(lion_sim_t *sim);
 lion_status_t lion_sim_show_state_debug(lion_sim_t *sim);
 lion_status_t lion_sim_show_state_trace(lion_sim_t *sim);
 lion_status_t lion_sim_simulate(lion_sim_t *sim, lion_vector_t *power, lion_vector_t *amb_temp);
+lion_status_t lion_sim_simulate_inputs(lion_sim_t *sim, lion_input_channel_t *power, lion_input_channel_t *amb_temp);
+// Run the samples in [begin, end) like lion_sim_simulate, without logging progress
+lion_status_t lion_sim_simulate_span(
+    lion_sim_t *sim, const lion_vector_view_d_t *power, const lion_vector_view_d_t *amb_temp, uint64_t begin, uint64_t end
+);
+// Recompute the inputs of the ode system cached from the configuration and
+// parameters, after either of them is swapped
+void          lion_sim_refresh_inputs(lion_sim_t *sim);
+void          lion_sim_stats_update(lion_sim_t *sim);
+// Accumulate the outputs of the state as if they held over `steps` steps
+void          lion_sim_stats_update_steps(lion_sim_t *sim, uint64_t steps);
+lion_status_t lion_sim_events_check(lion_sim_t *sim, const lion_sim_state_t *previous, int *stop);
+// Clear a close request from a stop event, keeping cancellations
+void          lion_sim_events_resume(lion_sim_t *sim);
 
 #ifndef NDEBUG
 lion_status_t lion_sim_init_debug(lion_sim_t *sim);
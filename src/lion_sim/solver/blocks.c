@@ -0,0 +1,318 @@
+#include "blocks.h"
+
+#include "jacobian.h"
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_math.h>
+#include <lion/params.h>
+#include <lion/sim.h>
+#include <lion_math/capacity.h>
+#include <lion_math/current.h>
+#include <lion_math/dynamics/soc.h>
+#include <lion_math/dynamics/temperature.h>
+#include <lion_math/generated_heat.h>
+#include <lion_math/open_circuit.h>
+#include <lion_utils/vendor/log.h>
+
+/* Core block: state of charge and internal temperature */
+
+static size_t core_dimension(lion_params_t *params) {
+  (void)params;
+  return LION_SLV_DIMENSION;
+}
+
+static void core_reset(lion_sim_state_t *state, lion_params_t *params) {
+  state->_next_soc_nominal          = params->init.soc;
+  state->_next_internal_temperature = params->init.temp_in;
+}
+
+static void core_advance(lion_sim_state_t *state, lion_params_t *params) {
+  (void)params;
+  state->soc_nominal          = state->_next_soc_nominal;
+  state->internal_temperature = state->_next_internal_temperature;
+}
+
+static void core_load(const lion_sim_state_t *state, lion_params_t *params, double y[]) {
+  (void)params;
+  y[0] = state->soc_nominal;
+  y[1] = state->internal_temperature;
+}
+
+static void core_store(lion_sim_state_t *state, lion_params_t *params, const double y[]) {
+  (void)params;
+  state->_next_soc_nominal          = y[0];
+  state->_next_internal_temperature = y[1];
+}
+
+static void core_rhs(const lion_slv_block_ctx_t *ctx, const double y[], double out[]) {
+  lion_sim_state_t *state = ctx->state;
+  out[0]                  = lion_soc_d(ctx->current, state->capacity_use, ctx->params);
+  if (ctx->frozen_temperature) {
+    out[1] = 0.0;
+  } else {
+    out[1] = lion_internal_temperature_d(y[1], ctx->generated_heat, ctx->ambient_temperature, ctx->params);
+  }
+}
+
+static void core_jac(const lion_slv_block_ctx_t *ctx, const double y[], double *dfdy, double dfdt[]) {
+  lion_sim_state_t *state  = ctx->state;
+  lion_params_t    *params = ctx->params;
+  size_t            n      = ctx->dimension;
+  size_t            core   = ctx->offset[LION_SLV_BLOCK_CORE];
+  size_t            rc     = ctx->offset[LION_SLV_BLOCK_RC];
+
+  (void)y;
+  dfdy[core]         = jac_0_0_analytical(state, params);
+  dfdy[core + 1]     = jac_0_1_analytical(state, params);
+  dfdy[n + core]     = jac_1_0_analytical(state, params);
+  dfdy[n + core + 1] = jac_1_1_analytical(state, params);
+  dfdt[0]            = jac_0_t_analytical(state, params);
+  dfdt[1]            = jac_1_t_analytical(state, params);
+
+  // Every branch voltage drives the current through dI/dv = -dI/dvoc, and
+  // also dissipates v^2 / R on its own resistance
+  double heat_grad_current = 2.0 * state->internal_resistance * state->current - state->internal_temperature * state->ehc;
+  for (uint32_t j = 0; j < params->rc.n_branches; j++) {
+    dfdy[rc + j]     = ctx->current_grad_voc / state->capacity_use;
+    dfdy[n + rc + j] = (-heat_grad_current * ctx->current_grad_voc + 2.0 * state->rc_voltage[j] / params->rc.resistance[j]) / params->temp.cp;
+  }
+  if (ctx->frozen_temperature) {
+    for (size_t j = 0; j < n; j++) {
+      dfdy[n + j] = 0.0;
+    }
+    dfdt[1] = 0.0;
+  }
+}
+
+/* RC block: voltage across each branch of the polarization model */
+
+static size_t rc_dimension(lion_params_t *params) { return params->rc.n_branches; }
+
+static void rc_reset(lion_sim_state_t *state, lion_params_t *params) {
+  (void)params;
+  for (size_t k = 0; k < LION_RC_MAX_BRANCHES; k++) {
+    state->rc_voltage[k]       = 0.0;
+    state->_next_rc_voltage[k] = 0.0;
+  }
+}
+
+static void rc_advance(lion_sim_state_t *state, lion_params_t *params) {
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    state->rc_voltage[k] = state->_next_rc_voltage[k];
+  }
+}
+
+static void rc_load(const lion_sim_state_t *state, lion_params_t *params, double y[]) {
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    y[k] = state->rc_voltage[k];
+  }
+}
+
+static void rc_store(lion_sim_state_t *state, lion_params_t *params, const double y[]) {
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    state->_next_rc_voltage[k] = y[k];
+  }
+}
+
+static void rc_rhs(const lion_slv_block_ctx_t *ctx, const double y[], double out[]) {
+  lion_params_t *params = ctx->params;
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    out[k] = (ctx->current - y[k] / params->rc.resistance[k]) / params->rc.capacitance[k];
+  }
+}
+
+static void rc_jac(const lion_slv_block_ctx_t *ctx, const double y[], double *dfdy, double dfdt[]) {
+  lion_params_t *params = ctx->params;
+  size_t         n      = ctx->dimension;
+  size_t         core   = ctx->offset[LION_SLV_BLOCK_CORE];
+  size_t         rc     = ctx->offset[LION_SLV_BLOCK_RC];
+
+  (void)y;
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    double *row = dfdy + k * n;
+    double  c   = params->rc.capacitance[k];
+    row[core]     = ctx->current_grad_soc / c;
+    row[core + 1] = ctx->current_grad_temp / c;
+    for (uint32_t j = 0; j < params->rc.n_branches; j++) {
+      row[rc + j] = -ctx->current_grad_voc / c;
+    }
+    row[rc + k] -= 1.0 / (params->rc.resistance[k] * c);
+    dfdt[k] = 0.0;
+  }
+}
+
+const lion_slv_block_t LION_SLV_BLOCKS[LION_SLV_BLOCK_COUNT] = {
+  [LION_SLV_BLOCK_CORE] =
+      {
+        .name      = "core",
+        .dimension = &core_dimension,
+        .reset     = &core_reset,
+        .advance   = &core_advance,
+        .load      = &core_load,
+        .store     = &core_store,
+        .rhs       = &core_rhs,
+        .jac       = &core_jac,
+      },
+  [LION_SLV_BLOCK_RC] =
+      {
+        .name      = "rc",
+        .dimension = &rc_dimension,
+        .reset     = &rc_reset,
+        .advance   = &rc_advance,
+        .load      = &rc_load,
+        .store     = &rc_store,
+        .rhs       = &rc_rhs,
+        .jac       = &rc_jac,
+      },
+};
+
+lion_status_t lion_slv_blocks_validate(lion_params_t *params) {
+  if (params->rc.n_branches > LION_RC_MAX_BRANCHES) {
+    logi_error("Too many RC branches (%u, at most %d)", params->rc.n_branches, LION_RC_MAX_BRANCHES);
+    return LION_STATUS_FAILURE;
+  }
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    if (params->rc.resistance[k] <= 0.0 || params->rc.capacitance[k] <= 0.0) {
+      logi_error("RC branch %u must have a positive resistance and capacitance", k);
+      return LION_STATUS_FAILURE;
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+size_t lion_slv_blocks_dimension(lion_params_t *params) {
+  size_t n = 0;
+  for (size_t b = 0; b < LION_SLV_BLOCK_COUNT; b++) {
+    n += LION_SLV_BLOCKS[b].dimension(params);
+  }
+  return n;
+}
+
+void lion_slv_blocks_reset(lion_sim_state_t *state, lion_params_t *params) {
+  for (size_t b = 0; b < LION_SLV_BLOCK_COUNT; b++) {
+    LION_SLV_BLOCKS[b].reset(state, params);
+  }
+}
+
+void lion_slv_blocks_advance(lion_sim_state_t *state, lion_params_t *params) {
+  for (size_t b = 0; b < LION_SLV_BLOCK_COUNT; b++) {
+    LION_SLV_BLOCKS[b].advance(state, params);
+  }
+}
+
+void lion_slv_blocks_load(const lion_sim_state_t *state, lion_params_t *params, double y[]) {
+  for (size_t b = 0; b < LION_SLV_BLOCK_COUNT; b++) {
+    LION_SLV_BLOCKS[b].load(state, params, y);
+    y += LION_SLV_BLOCKS[b].dimension(params);
+  }
+}
+
+void lion_slv_blocks_store(lion_sim_state_t *state, lion_params_t *params, const double y[]) {
+  for (size_t b = 0; b < LION_SLV_BLOCK_COUNT; b++) {
+    LION_SLV_BLOCKS[b].store(state, params, y);
+    y += LION_SLV_BLOCKS[b].dimension(params);
+  }
+}
+
+static void blocks_ctx(lion_slv_inputs_t *p, lion_slv_block_ctx_t *ctx) {
+  ctx->state               = p->sys_inputs;
+  ctx->params              = p->sys_params;
+  ctx->current             = p->sys_inputs->current;
+  ctx->generated_heat      = p->sys_inputs->generated_heat;
+  ctx->ambient_temperature = p->sys_inputs->ambient_temperature;
+  ctx->frozen_temperature  = p->thermal_frozen;
+  ctx->dimension           = 0;
+  for (size_t b = 0; b < LION_SLV_BLOCK_COUNT; b++) {
+    ctx->offset[b] = ctx->dimension;
+    ctx->dimension += LION_SLV_BLOCKS[b].dimension(ctx->params);
+  }
+}
+
+static void blocks_hold(lion_slv_inputs_t *p, double t, lion_slv_block_ctx_t *ctx) {
+  // The step starts at s->time, where the inputs still have the values of
+  // the previous step, and they reach the values of this step at its end
+  lion_sim_state_t *s = ctx->state;
+  if (!(p->hold_span > 0.0)) {
+    return;
+  }
+  double left = 1.0 - (t - s->time) / p->hold_span;
+  if (!(left > 0.0)) {
+    return;
+  }
+  left                     = GSL_MIN_DBL(left, 1.0);
+  ctx->ambient_temperature = s->ambient_temperature + left * (s->_hold_ambient_temperature - s->ambient_temperature);
+
+  // Currents at other inputs are linearized around the one solved for the step
+  double r = s->internal_resistance;
+  switch (s->input_mode) {
+  case LION_INPUT_CURRENT:
+    ctx->current = s->current + left * (s->_hold_input - s->current);
+    break;
+  case LION_INPUT_VOLTAGE:
+    ctx->current = s->current - left * (s->_hold_input - s->voltage) / r;
+    break;
+  default: {
+    // dI/dP = 1 / (voc - 2 R I), from the quadratic of the power balance
+    double slope = s->open_circuit_voltage - s->polarization_voltage - 2.0 * r * s->current;
+    if (slope > 0.0) {
+      ctx->current = s->current + left * (s->_hold_input - s->power) / slope;
+    }
+    break;
+  }
+  }
+  ctx->generated_heat = s->generated_heat - lion_generated_heat(s->current, s->internal_temperature, r, s->ehc, ctx->params) +
+                        lion_generated_heat(ctx->current, s->internal_temperature, r, s->ehc, ctx->params);
+}
+
+static int blocks_count(lion_slv_inputs_t *p) {
+  // Both the derivatives and the Jacobian count towards the budget, and
+  // running out of it aborts the step
+  if (p->max_evaluations > 0 && p->evaluations >= p->max_evaluations) {
+    return GSL_EMAXITER;
+  }
+  p->evaluations++;
+  return GSL_SUCCESS;
+}
+
+int lion_slv_system_blocks(double t, const double state[], double out[], void *inputs) {
+  int status = blocks_count(inputs);
+  if (status != GSL_SUCCESS) {
+    return status;
+  }
+  lion_slv_block_ctx_t ctx;
+  blocks_ctx(inputs, &ctx);
+  blocks_hold(inputs, t, &ctx);
+
+  for (size_t b = 0; b < LION_SLV_BLOCK_COUNT; b++) {
+    LION_SLV_BLOCKS[b].rhs(&ctx, state + ctx.offset[b], out + ctx.offset[b]);
+  }
+  return GSL_SUCCESS;
+}
+
+int lion_slv_jac_blocks(double t, const double state[], double *dfdy, double dfdt[], void *inputs) {
+  int status = blocks_count(inputs);
+  if (status != GSL_SUCCESS) {
+    return status;
+  }
+  lion_slv_block_ctx_t ctx;
+  blocks_ctx(inputs, &ctx);
+
+  // Sensitivities of the current at the frozen inputs, shared by the blocks
+  // coupled through it. The temperature dependence of the open circuit
+  // voltage through the entropic heat is neglected, like in the core block
+  lion_sim_state_t *s    = ctx.state;
+  double            dvoc = lion_voc_grad(s->soc_use, ctx.params);
+  ctx.current_grad_voc   = jac_current_grad_voc(s, s->open_circuit_voltage - s->polarization_voltage, ctx.params);
+  ctx.current_grad_soc   = ctx.current_grad_voc * dvoc / s->kappa;
+  ctx.current_grad_temp  = ctx.current_grad_voc * dvoc * (1.0 - s->soc_nominal) * lion_kappa_grad(s->internal_temperature, ctx.params) / gsl_pow_2(s->kappa);
+
+  (void)t;
+  for (size_t i = 0; i < ctx.dimension * ctx.dimension; i++) {
+    dfdy[i] = 0.0;
+  }
+  for (size_t b = 0; b < LION_SLV_BLOCK_COUNT; b++) {
+    size_t offset = ctx.offset[b];
+    LION_SLV_BLOCKS[b].jac(&ctx, state + offset, dfdy + offset * ctx.dimension, dfdt + offset);
+  }
+  return GSL_SUCCESS;
+}
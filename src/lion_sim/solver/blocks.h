@@ -0,0 +1,66 @@
+#pragma once
+
+#include "sys.h"
+
+#include <lion/params.h>
+#include <lion/sim.h>
+#include <lion/status.h>
+#include <stddef.h>
+
+/*
+   The state vector of a cell is assembled from blocks, each of them owning a
+   contiguous range of states with its own dynamics and rows of the Jacobian.
+   The core block holds the state of charge and internal temperature, and any
+   other model with states of its own (RC branches for now) adds a block after
+   it, so a cell without extra models keeps the original two states.
+ */
+
+typedef enum lion_slv_block_id {
+  LION_SLV_BLOCK_CORE, // State of charge and internal temperature
+  LION_SLV_BLOCK_RC,   // Voltage across each RC branch
+  LION_SLV_BLOCK_COUNT,
+} lion_slv_block_id_t;
+
+typedef struct lion_slv_block_ctx {
+  lion_sim_state_t *state;                        // Frozen inputs and outputs of the step
+  lion_params_t    *params;                       // Parameters of the cell
+  size_t            dimension;                    // Dimension of the whole system
+  size_t            offset[LION_SLV_BLOCK_COUNT]; // First state of each block
+  double            current_grad_voc;             // dI/d(voc - polarization)
+  double            current_grad_soc;             // dI/d(soc)
+  double            current_grad_temp;            // dI/d(internal temperature)
+  double            current;                      // Current at the time of the evaluation
+  double            generated_heat;               // Generated heat at the time of the evaluation
+  double            ambient_temperature;          // Ambient temperature at the time of the evaluation
+  int               frozen_temperature;           // Whether the internal temperature is held over the step
+} lion_slv_block_ctx_t;
+
+typedef struct lion_slv_block {
+  const char *name;
+  size_t (*dimension)(lion_params_t *params);
+  void (*reset)(lion_sim_state_t *state, lion_params_t *params);
+  void (*advance)(lion_sim_state_t *state, lion_params_t *params);
+  void (*load)(const lion_sim_state_t *state, lion_params_t *params, double y[]);
+  void (*store)(lion_sim_state_t *state, lion_params_t *params, const double y[]);
+  // `y` and `out` point to the states of the block, `dfdy` to the first
+  // row of the block in the row-major Jacobian of the whole system
+  void (*rhs)(const lion_slv_block_ctx_t *ctx, const double y[], double out[]);
+  void (*jac)(const lion_slv_block_ctx_t *ctx, const double y[], double *dfdy, double dfdt[]);
+} lion_slv_block_t;
+
+extern const lion_slv_block_t LION_SLV_BLOCKS[LION_SLV_BLOCK_COUNT];
+
+lion_status_t lion_slv_blocks_validate(lion_params_t *params);
+size_t        lion_slv_blocks_dimension(lion_params_t *params);
+
+// x(0) <- initial conditions
+void lion_slv_blocks_reset(lion_sim_state_t *state, lion_params_t *params);
+// x(k) <- placeholders for x(k + 1)
+void lion_slv_blocks_advance(lion_sim_state_t *state, lion_params_t *params);
+// y <- x(k)
+void lion_slv_blocks_load(const lion_sim_state_t *state, lion_params_t *params, double y[]);
+// Placeholders for x(k + 1) <- y
+void lion_slv_blocks_store(lion_sim_state_t *state, lion_params_t *params, const double y[]);
+
+int lion_slv_system_blocks(double t, const double state[], double out[], void *inputs);
+int lion_slv_jac_blocks(double t, const double state[], double *dfdy, double dfdt[], void *inputs);
@@ -2,6 +2,9 @@
 
 #include <lion/sim.h>
 
+// Sensitivity of the current to the open circuit voltage, under the input mode of the state
+double jac_current_grad_voc(lion_sim_state_t *state, double open_circuit_voltage, lion_params_t *params);
+
 double jac_0_0_analytical(lion_sim_state_t *state, lion_params_t *params);
 double jac_0_1_analytical(lion_sim_state_t *state, lion_params_t *params);
 double jac_1_0_analytical(lion_sim_state_t *state, lion_params_t *params);
@@ -3,16 +3,32 @@
 #include <lion/sim.h>
 #include <lion_math/capacity.h>
 #include <lion_math/current.h>
+#include <lion_math/internal_resistance.h>
 #include <lion_math/open_circuit.h>
 
+double jac_current_grad_voc(lion_sim_state_t *state, double open_circuit_voltage, lion_params_t *params) {
+  // A controlled current does not move with the open circuit voltage, and a
+  // controlled voltage moves it through the internal resistance alone. The
+  // current is solved with the resistance at unit state of health, so its
+  // derivative uses the same one and not the reported resistance
+  if (state->input_mode == LION_INPUT_CURRENT) {
+    return 0.0;
+  }
+  double r = lion_resistance(state->soc_use, state->current, 1.0, params);
+  if (state->input_mode == LION_INPUT_VOLTAGE) {
+    return 1.0 / r;
+  }
+  return lion_current_grad_voc(state->power, open_circuit_voltage, r, params);
+}
+
 double jac_0_0_analytical(lion_sim_state_t *state, lion_params_t *params) {
-  double term1 = lion_current_grad_voc(state->power, state->open_circuit_voltage, state->internal_resistance, params);
+  double term1 = jac_current_grad_voc(state, state->open_circuit_voltage, params);
   double term2 = lion_voc_grad(state->soc_use, params);
   return -term1 * term2 * state->kappa / state->capacity_use;
 }
 
 double jac_0_1_analytical(lion_sim_state_t *state, lion_params_t *params) {
-  double numl_term1 = lion_current_grad_voc(state->power, state->open_circuit_voltage, state->internal_resistance, params);
+  double numl_term1 = jac_current_grad_voc(state, state->open_circuit_voltage, params);
   double numl_term2 = lion_voc_grad(state->soc_use, params);
   double numl_term3 = state->soc_nominal;
   double numl_term4 = lion_kappa_grad(state->internal_temperature, params);
@@ -30,7 +46,7 @@ double jac_1_0_analytical(lion_sim_state_t *state, lion_params_t *params) {
   double term1_1 = 2.0 * state->internal_resistance * state->current;
   double term1_2 = state->internal_temperature * state->ehc;
   double term1   = term1_1 - term1_2;
-  double term2   = lion_current_grad_voc(state->power, state->open_circuit_voltage, state->internal_resistance, params);
+  double term2   = jac_current_grad_voc(state, state->open_circuit_voltage, params);
   double term3   = lion_voc_grad(state->soc_use, params);
   return term1 * term2 * term3 * state->kappa / params->temp.cp;
 }
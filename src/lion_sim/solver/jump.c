@@ -0,0 +1,92 @@
+#include "jump.h"
+
+#include "sys.h"
+
+#include <gsl/gsl_math.h>
+#include <lion_math/dynamics/soh.h>
+#include <math.h>
+
+// Panels of the Simpson rule over the transient and over the tail of a jump
+#define LION_JUMP_PANELS 32
+// Time constants after which the transient is considered settled
+#define LION_JUMP_SETTLE 20.0
+
+// Integral over [0, t] of exp(-a (t - s)) exp(-b s), written so that it never
+// overflows for long jumps
+static double jump_convolve(double a, double b, double t) {
+  double lo   = GSL_MIN_DBL(a, b);
+  double diff = fabs(a - b);
+  if (diff * t < 1e-12) {
+    return t * exp(-lo * t);
+  }
+  return exp(-lo * t) * -expm1(-diff * t) / diff;
+}
+
+// States at `t` after the start of the jump, with the RC block right after the
+// core one like in the block table
+static void jump_at(const lion_sim_state_t *s, lion_params_t *p, double current, const double y0[], double t, double y[]) {
+  double rt = p->temp.rin + p->temp.rout;
+  double a  = 1.0 / (rt * p->temp.cp);
+
+  // Heat outside of the branches is held, and each branch settles towards
+  // the drop of the held current on its resistance
+  double heat = s->generated_heat;
+  for (uint32_t k = 0; k < p->rc.n_branches; k++) {
+    heat -= gsl_pow_2(s->rc_voltage[k]) / p->rc.resistance[k];
+  }
+  double settled   = heat;
+  double transient = 0.0;
+  for (uint32_t k = 0; k < p->rc.n_branches; k++) {
+    double r  = p->rc.resistance[k];
+    double mu = 1.0 / (r * p->rc.capacitance[k]);
+    double d  = y0[LION_SLV_DIMENSION + k] - current * r;
+    settled += current * current * r;
+    transient += (2.0 * current * d * jump_convolve(a, mu, t) + d * d / r * jump_convolve(a, 2.0 * mu, t)) / p->temp.cp;
+    y[LION_SLV_DIMENSION + k] = current * r + d * exp(-mu * t);
+  }
+
+  double final = s->ambient_temperature + settled * rt;
+  y[0]         = y0[0] - current * t / s->capacity_use;
+  y[1]         = final + (y0[1] - final) * exp(-a * t) + transient;
+}
+
+void lion_slv_jump(const lion_sim_state_t *state, lion_params_t *params, double current, double y[], double span) {
+  double y0[LION_SLV_MAX_DIMENSION];
+  for (size_t i = 0; i < LION_SLV_DIMENSION + params->rc.n_branches; i++) {
+    y0[i] = y[i];
+  }
+  jump_at(state, params, current, y0, span, y);
+}
+
+static double jump_rate(const lion_sim_state_t *state, lion_params_t *params, double current, const double y0[], double t) {
+  double y[LION_SLV_MAX_DIMENSION];
+  jump_at(state, params, current, y0, t, y);
+  return lion_soh_calendar_rate(y[1], y[0], params);
+}
+
+// Composite Simpson rule of the calendar aging rate over [from, to]
+static double jump_simpson(const lion_sim_state_t *state, lion_params_t *params, double current, const double y0[], double from, double to) {
+  if (!(to > from)) {
+    return 0.0;
+  }
+  double h   = (to - from) / LION_JUMP_PANELS;
+  double sum = jump_rate(state, params, current, y0, from) + jump_rate(state, params, current, y0, to);
+  for (int i = 1; i < LION_JUMP_PANELS; i++) {
+    sum += ((i % 2) ? 4.0 : 2.0) * jump_rate(state, params, current, y0, from + i * h);
+  }
+  return sum * h / 3.0;
+}
+
+double lion_slv_jump_calendar(const lion_sim_state_t *state, lion_params_t *params, double current, const double y[], double span) {
+  if (!(params->calendar.rate > 0.0)) {
+    return 0.0;
+  }
+  // The temperature changes fast until the slowest exponential settles, and
+  // the rate is smooth afterwards, so each part gets its own panels
+  double slowest = (params->temp.rin + params->temp.rout) * params->temp.cp;
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    slowest = GSL_MAX_DBL(slowest, params->rc.resistance[k] * params->rc.capacitance[k]);
+  }
+  double split = GSL_MIN_DBL(span, LION_JUMP_SETTLE * slowest);
+  return jump_simpson(state, params, current, y, 0.0, split) + jump_simpson(state, params, current, y, split, span);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <lion/params.h>
+#include <lion/sim.h>
+
+/*
+   Closed form propagation of the cell over many steps at once. The current,
+   the heat generated outside of the RC branches and the ambient temperature
+   are held, the latter two at the values of the outputs in `state`, like they
+   are held inside a single step. Under those the state of charge moves
+   linearly, every branch relaxes exponentially and the internal temperature
+   follows a sum of exponentials. At rest the current is zero and nothing else
+   is held, so the propagation is exact.
+ */
+
+// y <- x(t + span), from y = x(t) loaded from the blocks of `state`
+void lion_slv_jump(const lion_sim_state_t *state, lion_params_t *params, double current, double y[], double span);
+
+// Integral of the calendar aging rate over the same trajectory, starting from y = x(t)
+double lion_slv_jump_calendar(const lion_sim_state_t *state, lion_params_t *params, double current, const double y[], double span);
@@ -0,0 +1,30 @@
+#include "multirate.h"
+
+int lion_slv_multirate_refresh(const lion_sim_t *sim) { return sim->conf->sim_thermal_steps <= 1 || sim->state._thermal_step == 0; }
+
+void lion_slv_multirate_thermal(lion_sim_t *sim) {
+  lion_sim_state_t *s = &sim->state;
+  if (sim->conf->sim_thermal_steps <= 1) {
+    return;
+  }
+  if (s->_thermal_step == 0) {
+    s->_thermal_temperature = s->internal_temperature;
+  }
+
+  // Exact response of the thermal model to the heat held over the step
+  double rt               = sim->params->temp.rin + sim->params->temp.rout;
+  double equilibrium      = s->ambient_temperature + rt * s->generated_heat;
+  s->_thermal_temperature = equilibrium + (s->_thermal_temperature - equilibrium) * sim->inputs.thermal_decay;
+  s->_thermal_step++;
+  if (s->_thermal_step >= sim->conf->sim_thermal_steps) {
+    lion_slv_multirate_flush(sim);
+  }
+}
+
+void lion_slv_multirate_flush(lion_sim_t *sim) {
+  lion_sim_state_t *s = &sim->state;
+  if (s->_thermal_step > 0) {
+    s->_next_internal_temperature = s->_thermal_temperature;
+    s->_thermal_step              = 0;
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <lion/sim.h>
+
+/*
+   Multirate integration of the cell. The electrical states are integrated on
+   every step, while the internal temperature is held by the ODE and advanced
+   on its own from the heat and ambient temperature of each step, which are
+   held over it like in the ODE. The temperature reached is only seen by the
+   rest of the model once every `sim_thermal_steps` steps, and so are the
+   capacity and the usable state of charge that depend on it, which are not
+   recomputed in between.
+ */
+
+// Whether the temperature dependent coefficients are updated on this step
+int lion_slv_multirate_refresh(const lion_sim_t *sim);
+
+// Advance the internal temperature over the step just integrated, publishing
+// it to the placeholders once the thermal step is over
+void lion_slv_multirate_thermal(lion_sim_t *sim);
+
+// Publish the internal temperature of an unfinished thermal step
+void lion_slv_multirate_flush(lion_sim_t *sim);
@@ -0,0 +1,217 @@
+#include "native.h"
+
+#include "blocks.h"
+#include "sys.h"
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_odeiv2.h>
+#include <math.h>
+#include <string.h>
+
+#define NATIVE_N LION_SLV_MAX_DIMENSION
+
+int lion_slv_native(lion_stepper_t stepper) {
+  return stepper == LION_STEPPER_NATIVE_RK4 || stepper == LION_STEPPER_NATIVE_RK45 || stepper == LION_STEPPER_NATIVE_ROS2;
+}
+
+const gsl_odeiv2_step_type *lion_slv_native_fallback(lion_stepper_t stepper) {
+  switch (stepper) {
+  case LION_STEPPER_NATIVE_RK4:
+    return gsl_odeiv2_step_rk4;
+  case LION_STEPPER_NATIVE_RK45:
+    return gsl_odeiv2_step_rkf45;
+  case LION_STEPPER_NATIVE_ROS2:
+    return gsl_odeiv2_step_rk2imp;
+  default:
+    return NULL;
+  }
+}
+
+// y + h sum(a[j] k[j]) over the first m stages
+static void native_stage(size_t n, const double y[], double h, size_t m, const double a[], double k[][NATIVE_N], double out[]) {
+  for (size_t i = 0; i < n; i++) {
+    double acc = 0.0;
+    for (size_t j = 0; j < m; j++) {
+      acc += a[j] * k[j][i];
+    }
+    out[i] = y[i] + h * acc;
+  }
+}
+
+static int native_rk4(lion_slv_inputs_t *p, size_t n, double t, double h, double y[]) {
+  double k[4][NATIVE_N];
+  double yt[NATIVE_N];
+  int    status;
+  if ((status = lion_slv_system_blocks(t, y, k[0], p)) != GSL_SUCCESS) {
+    return status;
+  }
+  native_stage(n, y, h, 1, (const double[]){0.5}, k, yt);
+  if ((status = lion_slv_system_blocks(t + 0.5 * h, yt, k[1], p)) != GSL_SUCCESS) {
+    return status;
+  }
+  native_stage(n, y, h, 2, (const double[]){0.0, 0.5}, k, yt);
+  if ((status = lion_slv_system_blocks(t + 0.5 * h, yt, k[2], p)) != GSL_SUCCESS) {
+    return status;
+  }
+  native_stage(n, y, h, 3, (const double[]){0.0, 0.0, 1.0}, k, yt);
+  if ((status = lion_slv_system_blocks(t + h, yt, k[3], p)) != GSL_SUCCESS) {
+    return status;
+  }
+  for (size_t i = 0; i < n; i++) {
+    y[i] += h / 6.0 * (k[0][i] + 2.0 * k[1][i] + 2.0 * k[2][i] + k[3][i]);
+  }
+  return GSL_SUCCESS;
+}
+
+// Dormand-Prince 5(4), advancing with the fifth order solution. Fixed steps
+// never use the error estimate, so the seventh stage is not evaluated
+static const double DP_C[6]    = {0.0, 1.0 / 5.0, 3.0 / 10.0, 4.0 / 5.0, 8.0 / 9.0, 1.0};
+static const double DP_A[6][5] = {
+  {0.0},
+  {1.0 / 5.0},
+  {3.0 / 40.0, 9.0 / 40.0},
+  {44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0},
+  {19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0},
+  {9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0},
+};
+static const double DP_B[6] = {35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0};
+
+static int native_rk45(lion_slv_inputs_t *p, size_t n, double t, double h, double y[]) {
+  double k[6][NATIVE_N];
+  double yt[NATIVE_N];
+  for (size_t s = 0; s < 6; s++) {
+    native_stage(n, y, h, s, DP_A[s], k, yt);
+    int status = lion_slv_system_blocks(t + DP_C[s] * h, yt, k[s], p);
+    if (status != GSL_SUCCESS) {
+      return status;
+    }
+  }
+  native_stage(n, y, h, 6, DP_B, k, yt);
+  memcpy(y, yt, n * sizeof(double));
+  return GSL_SUCCESS;
+}
+
+// Solves m x = b in place with Gaussian elimination and partial pivoting,
+// `m` is row-major with rows of NATIVE_N
+static int native_solve(size_t n, double m[][NATIVE_N], double b[]) {
+  for (size_t c = 0; c < n; c++) {
+    size_t pivot = c;
+    for (size_t r = c + 1; r < n; r++) {
+      if (fabs(m[r][c]) > fabs(m[pivot][c])) {
+        pivot = r;
+      }
+    }
+    if (m[pivot][c] == 0.0) {
+      return GSL_ESING;
+    }
+    if (pivot != c) {
+      for (size_t j = 0; j < n; j++) {
+        double tmp  = m[c][j];
+        m[c][j]     = m[pivot][j];
+        m[pivot][j] = tmp;
+      }
+      double tmp = b[c];
+      b[c]       = b[pivot];
+      b[pivot]   = tmp;
+    }
+    for (size_t r = c + 1; r < n; r++) {
+      double f = m[r][c] / m[c][c];
+      for (size_t j = c; j < n; j++) {
+        m[r][j] -= f * m[c][j];
+      }
+      b[r] -= f * b[c];
+    }
+  }
+  for (size_t c = n; c-- > 0;) {
+    for (size_t j = c + 1; j < n; j++) {
+      b[c] -= m[c][j] * b[j];
+    }
+    b[c] /= m[c][c];
+  }
+  return GSL_SUCCESS;
+}
+
+// Two stage Rosenbrock method ROS2 of Verwer et al., of second order and
+// L-stable with gamma = 1 + 1/sqrt(2). Both stages share the same matrix
+// I - gamma h J, so each step takes a single Jacobian and factorization.
+// The time derivatives of the Jacobian are neglected
+static int native_ros2(lion_slv_inputs_t *p, lion_sim_t *sim, size_t n, double t, double h, double y[]) {
+  const double gamma = 1.0 + M_SQRT1_2;
+  double       dfdy[NATIVE_N * NATIVE_N];
+  double       dfdt[NATIVE_N];
+  double       w[NATIVE_N][NATIVE_N];
+  double       lu[NATIVE_N][NATIVE_N];
+  double       k1[NATIVE_N], k2[NATIVE_N], yt[NATIVE_N];
+
+  int status = (sim->conf->sim_jacobian == LION_JACOBIAN_ANALYTICAL) ? lion_slv_jac_blocks(t, y, dfdy, dfdt, p)
+                                                                      : sim->sys.jacobian(t, y, dfdy, dfdt, p);
+  if (status != GSL_SUCCESS) {
+    return status;
+  }
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      w[i][j] = ((i == j) ? 1.0 : 0.0) - gamma * h * dfdy[i * n + j];
+    }
+  }
+
+  if ((status = lion_slv_system_blocks(t, y, k1, p)) != GSL_SUCCESS) {
+    return status;
+  }
+  memcpy(lu, w, sizeof(w));
+  if ((status = native_solve(n, lu, k1)) != GSL_SUCCESS) {
+    return status;
+  }
+  for (size_t i = 0; i < n; i++) {
+    yt[i] = y[i] + h * k1[i];
+  }
+  if ((status = lion_slv_system_blocks(t + h, yt, k2, p)) != GSL_SUCCESS) {
+    return status;
+  }
+  for (size_t i = 0; i < n; i++) {
+    k2[i] -= 2.0 * k1[i];
+  }
+  memcpy(lu, w, sizeof(w));
+  if ((status = native_solve(n, lu, k2)) != GSL_SUCCESS) {
+    return status;
+  }
+  for (size_t i = 0; i < n; i++) {
+    y[i] += h * (1.5 * k1[i] + 0.5 * k2[i]);
+  }
+  return GSL_SUCCESS;
+}
+
+int lion_slv_native_apply(lion_sim_t *sim, double *t, double h, double y[]) {
+  // Stages are only committed once every evaluation succeeded, so a step
+  // that runs out of budget leaves y untouched
+  lion_slv_inputs_t *p = &sim->inputs;
+  size_t             n = sim->sys.dimension;
+  double             next[NATIVE_N];
+  memcpy(next, y, n * sizeof(double));
+
+  int status;
+  switch (sim->conf->sim_stepper) {
+  case LION_STEPPER_NATIVE_RK4:
+    status = native_rk4(p, n, *t, h, next);
+    break;
+  case LION_STEPPER_NATIVE_RK45:
+    status = native_rk45(p, n, *t, h, next);
+    break;
+  case LION_STEPPER_NATIVE_ROS2:
+    status = native_ros2(p, sim, n, *t, h, next);
+    break;
+  default:
+    return GSL_EINVAL;
+  }
+  if (status == GSL_SUCCESS) {
+    memcpy(y, next, n * sizeof(double));
+    *t += h;
+  }
+  return status;
+}
+
+int lion_slv_apply(lion_sim_t *sim, double *t, double h, double y[]) {
+  if (lion_slv_native(sim->conf->sim_stepper)) {
+    return lion_slv_native_apply(sim, t, h, y);
+  }
+  return gsl_odeiv2_driver_apply_fixed_step(sim->driver, t, h, 1, y);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <gsl/gsl_odeiv2.h>
+#include <lion/sim.h>
+
+/*
+   Fixed step integrators written for the block system of a single cell. They
+   call the derivatives and the Jacobian of the blocks directly, keep every
+   stage on the stack, and skip the error estimates and the bookkeeping of the
+   GSL driver, which dominate the cost of a step for systems this small.
+ */
+
+// Whether the stepper is integrated natively instead of through the GSL driver
+int lion_slv_native(lion_stepper_t stepper);
+
+// GSL stepper of the same order, used by the systems that are not integrated natively
+const gsl_odeiv2_step_type *lion_slv_native_fallback(lion_stepper_t stepper);
+
+// Advances y over one step of length h from *t, and moves *t to its end.
+// Returns a GSL status, GSL_EMAXITER when the evaluation budget runs out
+int lion_slv_native_apply(lion_sim_t *sim, double *t, double h, double y[]);
+
+// Advances the cell over one step with the stepper of the simulation
+int lion_slv_apply(lion_sim_t *sim, double *t, double h, double y[]);
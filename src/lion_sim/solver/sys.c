@@ -68,10 +68,10 @@ int lion_slv_jac_2point(double t, const double state[], double *dfdy, double dfd
 
   double jac00 = jac_0_0_2point(sys_state, sys_params);
   double jac01 = jac_0_1_2point(sys_state, sys_params);
-  double jac10 = jac_1_0_2point(sys_state, sys_params);
-  double jac11 = jac_1_1_2point(sys_state, sys_params);
+  double jac10 = p->thermal_frozen ? 0.0 : jac_1_0_2point(sys_state, sys_params);
+  double jac11 = p->thermal_frozen ? 0.0 : jac_1_1_2point(sys_state, sys_params);
   double jac0t = jac_0_t_2point(sys_state, sys_params);
-  double jac1t = jac_1_t_2point(sys_state, sys_params);
+  double jac1t = p->thermal_frozen ? 0.0 : jac_1_t_2point(sys_state, sys_params);
 
   gsl_matrix_set(m, 0, 0, jac00);
   gsl_matrix_set(m, 0, 1, jac01);
@@ -82,3 +82,85 @@ int lion_slv_jac_2point(double t, const double state[], double *dfdy, double dfd
   logi_trace("jac_2point={{%f, %f}, {%f, %f}}", jac00, jac01, jac10, jac11);
   return GSL_SUCCESS;
 }
+
+int lion_slv_system_sensitivity(double t, const double sens[], double out[], void *inputs) {
+  /*
+     sens[j]            -> d(state of charge)/d(param j)
+     sens[n_params + j] -> d(internal temperature)/d(param j)
+
+     The forward sensitivities follow dS/dt = (df/dx) S + df/dp, with both
+     Jacobians frozen over the step like the inputs of the state system
+   */
+  lion_slv_sensitivity_inputs_t *p = inputs;
+  size_t                         n = p->n_params;
+
+  (void)t;
+  for (size_t j = 0; j < n; j++) {
+    out[j]     = p->jac[0] * sens[j] + p->jac[1] * sens[n + j] + p->dfdp[j];
+    out[n + j] = p->jac[2] * sens[j] + p->jac[3] * sens[n + j] + p->dfdp[n + j];
+  }
+  return GSL_SUCCESS;
+}
+
+int lion_slv_jac_sensitivity(double t, const double sens[], double *dfdy, double dfdt[], void *inputs) {
+  lion_slv_sensitivity_inputs_t *p = inputs;
+  size_t                         n = p->n_params;
+
+  (void)t;
+  (void)sens;
+  gsl_matrix_view dfdy_mat = gsl_matrix_view_array(dfdy, 2 * n, 2 * n);
+  gsl_matrix     *m        = &dfdy_mat.matrix;
+
+  gsl_matrix_set_zero(m);
+  for (size_t j = 0; j < n; j++) {
+    gsl_matrix_set(m, j, j, p->jac[0]);
+    gsl_matrix_set(m, j, n + j, p->jac[1]);
+    gsl_matrix_set(m, n + j, j, p->jac[2]);
+    gsl_matrix_set(m, n + j, n + j, p->jac[3]);
+    dfdt[j]     = 0.0;
+    dfdt[n + j] = 0.0;
+  }
+  return GSL_SUCCESS;
+}
+
+int lion_slv_system_pack(double t, const double state[], double out[], void *inputs) {
+  /*
+     state[2 * c]     -> state of charge of cell c
+     state[2 * c + 1] -> internal temperature of cell c
+   */
+  lion_slv_pack_inputs_t *p = inputs;
+
+  (void)t;
+  for (size_t c = 0; c < p->n_cells; c++) {
+    lion_sim_state_t *cell = &p->cells[c];
+    out[2 * c]             = lion_soc_d(cell->current, cell->capacity_use, &p->params[c]);
+    out[2 * c + 1]         = lion_internal_temperature_d(state[2 * c + 1], cell->generated_heat, cell->ambient_temperature, &p->params[c]);
+  }
+  return GSL_SUCCESS;
+}
+
+int lion_slv_jac_pack(double t, const double state[], double *dfdy, double dfdt[], void *inputs) {
+  // Cells only interact through the current sharing, which is frozen during
+  // the step, so the Jacobian is block diagonal. The pack integrates every
+  // cell on its own, which only leaves the 2x2 block of a single cell
+  lion_slv_pack_inputs_t *p = inputs;
+  size_t                  n = 2 * p->n_cells;
+
+  (void)t;
+  (void)state;
+  gsl_matrix_view dfdy_mat = gsl_matrix_view_array(dfdy, n, n);
+  gsl_matrix     *m        = &dfdy_mat.matrix;
+
+  gsl_matrix_set_zero(m);
+  for (size_t c = 0; c < p->n_cells; c++) {
+    lion_sim_state_t *cell   = &p->cells[c];
+    lion_params_t    *params = &p->params[c];
+    gsl_matrix_set(m, 2 * c, 2 * c, jac_0_0_analytical(cell, params));
+    gsl_matrix_set(m, 2 * c, 2 * c + 1, jac_0_1_analytical(cell, params));
+    gsl_matrix_set(m, 2 * c + 1, 2 * c, jac_1_0_analytical(cell, params));
+    gsl_matrix_set(m, 2 * c + 1, 2 * c + 1, jac_1_1_analytical(cell, params));
+    dfdt[2 * c]     = jac_0_t_analytical(cell, params);
+    dfdt[2 * c + 1] = jac_1_t_analytical(cell, params);
+  }
+  return GSL_SUCCESS;
+}
@@ -1,10 +1,24 @@
 #pragma once
 
+#include <lion/pack.h>
 #include <lion/params.h>
+#include <stddef.h>
 
-#define LION_SLV_DIMENSION 2
+#define LION_SLV_DIMENSION     2
+#define LION_SLV_MAX_DIMENSION (LION_SLV_DIMENSION + LION_RC_MAX_BRANCHES)
 
+typedef struct lion_slv_sensitivity_inputs {
+  size_t        n_params; // Number of parameters being tracked
+  double        jac[4];   // Row-major Jacobian of the dynamics with respect to the state
+  const double *dfdp;     // Row-major (2 x n_params) Jacobian of the dynamics with respect to the parameters
+} lion_slv_sensitivity_inputs_t;
 int lion_slv_system_continuous(double t, const double state[], double out[], void *inputs);
 
 int lion_slv_jac_analytical(double t, const double state[], double *dfdy, double dfdt[], void *inputs);
 int lion_slv_jac_2point(double t, const double state[], double *dfdy, double dfdt[], void *inputs);
+
+int lion_slv_system_sensitivity(double t, const double sens[], double out[], void *inputs);
+int lion_slv_jac_sensitivity(double t, const double sens[], double *dfdy, double dfdt[], void *inputs);
+
+int lion_slv_system_pack(double t, const double state[], double out[], void *inputs);
+int lion_slv_jac_pack(double t, const double state[], double *dfdy, double dfdt[], void *inputs);
@@ -0,0 +1,242 @@
+#include "thermal.h"
+
+#include <lion_sim/mem.h>
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_spmatrix.h>
+#include <gsl/gsl_splinalg.h>
+#include <gsl/gsl_vector.h>
+#include <lion/lion.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <string.h>
+
+#define LION_THERMAL_TOLERANCE 1e-10
+#define LION_THERMAL_KRYLOV    30
+#define LION_THERMAL_RESTARTS  100
+
+struct lion_thermal_solver {
+  lion_thermal_link_t *links;        // Conductances of the network, with the cells linked to their nodes
+  size_t               n_links;      // Number of conductances
+  double               step_seconds; // Time step the system matrix was built for
+
+  // GSL objects
+  gsl_spmatrix           *system;    // Sparse matrix of the implicit step
+  gsl_vector             *rhs;       // Right hand side of the implicit step
+  gsl_splinalg_itersolve *itersolve; // Iterative sparse solver
+};
+
+static void thermal_add(gsl_spmatrix *m, size_t i, size_t j, double x) { gsl_spmatrix_set(m, i, j, gsl_spmatrix_get(m, i, j) + x); }
+
+static void thermal_link(gsl_spmatrix *m, size_t a, size_t b, double conductance) {
+  thermal_add(m, a, a, conductance);
+  thermal_add(m, b, b, conductance);
+  thermal_add(m, a, b, -conductance);
+  thermal_add(m, b, a, -conductance);
+}
+
+static lion_status_t thermal_validate(lion_sim_t *sim, const lion_thermal_config_t *conf, size_t n_cells) {
+  if (conf == NULL || conf->n_nodes == 0) {
+    logi_error("Regime %s requires a thermal network with at least one node", lion_regime_name(sim->conf->sim_regime));
+    return LION_STATUS_FAILURE;
+  }
+  size_t n_total = n_cells + conf->n_nodes;
+  for (size_t l = 0; l < conf->n_links; l++) {
+    const lion_thermal_link_t *link = &conf->links[l];
+    if (link->a >= n_total || link->b >= n_total || link->a == link->b) {
+      logi_error("Invalid thermal link %zu (%zu - %zu)", l, link->a, link->b);
+      return LION_STATUS_FAILURE;
+    }
+  }
+  for (size_t c = 0; conf->cell_node != NULL && c < n_cells; c++) {
+    if (conf->cell_node[c] >= conf->n_nodes) {
+      logi_error("Cell %zu faces unknown node %zu", c, conf->cell_node[c]);
+      return LION_STATUS_FAILURE;
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t thermal_links(lion_thermal_t *thermal, const lion_thermal_config_t *conf, lion_params_t *params) {
+  lion_thermal_solver_t *solver = thermal->solver;
+  solver->links                 = lion_malloc(thermal->sim, (thermal->n_cells + conf->n_links) * sizeof(lion_thermal_link_t));
+  if (solver->links == NULL) {
+    logi_error("Could not allocate thermal network links");
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t c = 0; c < thermal->n_cells; c++) {
+    double rt                         = params[c].temp.rin + params[c].temp.rout;
+    solver->links[solver->n_links++] = (lion_thermal_link_t){.a = c, .b = thermal->n_cells + thermal->cell_node[c], .conductance = 1.0 / rt};
+  }
+  for (size_t l = 0; l < conf->n_links; l++) {
+    const lion_thermal_link_t *link = &conf->links[l];
+    if (thermal->regime == LION_ONLYAIR && link->a < thermal->n_cells && link->b < thermal->n_cells) {
+      // Conduction between cells is only considered in LION_BOTH
+      continue;
+    }
+    solver->links[solver->n_links++] = *link;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t thermal_assemble(lion_thermal_t *thermal) {
+  /*
+     Backward Euler on C dT/dt = -G T + g_amb T_amb + q gives the sparse
+     system
+
+       (C / h + G) T(k + 1) = C / h T(k) + g_amb T_amb + q(k)
+
+     where G is the weighted Laplacian of the network plus the conductances
+     to the ambient, so it is only assembled again when the time step of the
+     simulation changes
+  */
+  lion_thermal_solver_t *solver  = thermal->solver;
+  double                 h       = thermal->sim->conf->sim_step_seconds;
+  size_t                 n       = thermal->n_total;
+  gsl_spmatrix          *triplet = gsl_spmatrix_alloc(n, n);
+  if (triplet == NULL) {
+    logi_error("Could not allocate thermal network matrix");
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t i = 0; i < n; i++) {
+    thermal_add(triplet, i, i, thermal->capacity[i] / h + thermal->ambient_conductance[i]);
+  }
+  for (size_t l = 0; l < solver->n_links; l++) {
+    thermal_link(triplet, solver->links[l].a, solver->links[l].b, solver->links[l].conductance);
+  }
+
+  if (solver->system != NULL) {
+    gsl_spmatrix_free(solver->system);
+  }
+  solver->system = gsl_spmatrix_ccs(triplet);
+  gsl_spmatrix_free(triplet);
+  if (solver->system == NULL) {
+    logi_error("Could not compress thermal network matrix");
+    return LION_STATUS_FAILURE;
+  }
+  solver->step_seconds = h;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_slv_thermal_new(
+    lion_sim_t *sim, const lion_thermal_config_t *conf, size_t n_cells, lion_params_t *params, lion_thermal_t *out
+) {
+  LION_CALL_I(thermal_validate(sim, conf, n_cells), "Invalid thermal network");
+
+  size_t         n       = n_cells + conf->n_nodes;
+  lion_thermal_t thermal = {
+    .sim                 = sim,
+    .regime              = sim->conf->sim_regime,
+    .n_cells             = n_cells,
+    .n_total             = n,
+    .temperature         = lion_malloc(sim, n * sizeof(double)),
+    .initial_temperature = lion_malloc(sim, n * sizeof(double)),
+    .capacity            = lion_malloc(sim, n * sizeof(double)),
+    .ambient_conductance = lion_malloc(sim, n * sizeof(double)),
+    .cell_node           = lion_malloc(sim, n_cells * sizeof(size_t)),
+    .tolerance           = (conf->tolerance > 0.0) ? conf->tolerance : LION_THERMAL_TOLERANCE,
+    .solver              = lion_malloc(sim, sizeof(lion_thermal_solver_t)),
+  };
+  if (thermal.solver != NULL) {
+    *thermal.solver = (lion_thermal_solver_t){
+      .links        = NULL,
+      .n_links      = 0,
+      .step_seconds = 0.0,
+      .system       = NULL,
+      .rhs          = gsl_vector_alloc(n),
+      .itersolve    = gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_gmres, n, (n < LION_THERMAL_KRYLOV) ? n : LION_THERMAL_KRYLOV),
+    };
+  }
+  *out = thermal;
+  if (thermal.temperature == NULL || thermal.initial_temperature == NULL || thermal.capacity == NULL || thermal.ambient_conductance == NULL || thermal.cell_node == NULL ||
+      thermal.solver == NULL || thermal.solver->rhs == NULL || thermal.solver->itersolve == NULL) {
+    logi_error("Could not allocate thermal network");
+    lion_slv_thermal_cleanup(sim, out);
+    return LION_STATUS_FAILURE;
+  }
+
+  // Cells only reach the ambient through the network
+  for (size_t c = 0; c < n_cells; c++) {
+    out->capacity[c]            = params[c].temp.cp;
+    out->ambient_conductance[c] = 0.0;
+    out->cell_node[c]           = (conf->cell_node != NULL) ? conf->cell_node[c] : 0;
+    out->initial_temperature[c] = params[c].init.temp_in;
+  }
+  for (size_t k = 0; k < conf->n_nodes; k++) {
+    out->capacity[n_cells + k]            = conf->nodes[k].heat_capacity;
+    out->ambient_conductance[n_cells + k] = conf->nodes[k].ambient_conductance;
+    out->initial_temperature[n_cells + k] = conf->nodes[k].initial_temperature;
+  }
+  if (thermal_links(out, conf, params) != LION_STATUS_SUCCESS || thermal_assemble(out) != LION_STATUS_SUCCESS) {
+    lion_slv_thermal_cleanup(sim, out);
+    return LION_STATUS_FAILURE;
+  }
+  logi_info("Created thermal network with %zu nodes (%zu non-zeros)", n, gsl_spmatrix_nnz(out->solver->system));
+  return lion_slv_thermal_reset(out);
+}
+
+lion_status_t lion_slv_thermal_reset(lion_thermal_t *thermal) {
+  memcpy(thermal->temperature, thermal->initial_temperature, thermal->n_total * sizeof(double));
+  return LION_STATUS_SUCCESS;
+}
+
+double lion_slv_thermal_surroundings(const lion_thermal_t *thermal, size_t cell) {
+  return thermal->temperature[thermal->n_cells + thermal->cell_node[cell]];
+}
+
+lion_status_t lion_slv_thermal_step(lion_thermal_t *thermal, const lion_sim_state_t *cells, double ambient_temperature) {
+  lion_thermal_solver_t *solver = thermal->solver;
+  double                 h      = thermal->sim->conf->sim_step_seconds;
+  if (h != solver->step_seconds) {
+    LION_VCALL_I(thermal_assemble(thermal), "Failed assembling thermal network for a step of %f s", h);
+  }
+  for (size_t i = 0; i < thermal->n_total; i++) {
+    double b  = thermal->capacity[i] / h * thermal->temperature[i];
+    b        += thermal->ambient_conductance[i] * ambient_temperature;
+    if (i < thermal->n_cells) {
+      b += cells[i].generated_heat;
+    }
+    gsl_vector_set(solver->rhs, i, b);
+  }
+
+  // The previous temperatures are a good initial guess for the solver
+  gsl_vector_view x      = gsl_vector_view_array(thermal->temperature, thermal->n_total);
+  int             status = GSL_CONTINUE;
+  for (int restart = 0; restart < LION_THERMAL_RESTARTS && status == GSL_CONTINUE; restart++) {
+    status = gsl_splinalg_itersolve_iterate(solver->system, solver->rhs, thermal->tolerance, &x.vector, solver->itersolve);
+  }
+  if (status != GSL_SUCCESS) {
+    logi_error("Thermal network solver did not converge (residual = %e)", gsl_splinalg_itersolve_normr(solver->itersolve));
+    return LION_STATUS_FAILURE;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_slv_thermal_cleanup(lion_sim_t *sim, lion_thermal_t *thermal) {
+  lion_thermal_solver_t *solver = thermal->solver;
+  if (solver != NULL) {
+    if (solver->system != NULL) {
+      gsl_spmatrix_free(solver->system);
+    }
+    if (solver->rhs != NULL) {
+      gsl_vector_free(solver->rhs);
+    }
+    if (solver->itersolve != NULL) {
+      gsl_splinalg_itersolve_free(solver->itersolve);
+    }
+    lion_free(sim, solver->links);
+    lion_free(sim, solver);
+    thermal->solver = NULL;
+  }
+  lion_free(sim, thermal->temperature);
+  lion_free(sim, thermal->initial_temperature);
+  lion_free(sim, thermal->capacity);
+  lion_free(sim, thermal->ambient_conductance);
+  lion_free(sim, thermal->cell_node);
+  thermal->temperature         = NULL;
+  thermal->initial_temperature = NULL;
+  thermal->capacity            = NULL;
+  thermal->ambient_conductance = NULL;
+  thermal->cell_node           = NULL;
+  return LION_STATUS_SUCCESS;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <lion/sim.h>
+#include <lion/status.h>
+#include <lion/thermal.h>
+
+lion_status_t lion_slv_thermal_new(
+    lion_sim_t *sim, const lion_thermal_config_t *conf, size_t n_cells, lion_params_t *params, lion_thermal_t *out
+);
+lion_status_t lion_slv_thermal_reset(lion_thermal_t *thermal);
+double        lion_slv_thermal_surroundings(const lion_thermal_t *thermal, size_t cell);
+lion_status_t lion_slv_thermal_step(lion_thermal_t *thermal, const lion_sim_state_t *cells, double ambient_temperature);
+lion_status_t lion_slv_thermal_cleanup(lion_sim_t *sim, lion_thermal_t *thermal);
@@ -1,39 +1,205 @@
 #include "update.h"
 
+#include "multirate.h"
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_math.h>
 #include <lion/lion.h>
+#include <lion_math/dynamics/soh.h>
 #include <lion_math/lion_math.h>
 #include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
 
-lion_status_t lion_slv_update(lion_sim_t *sim) {
-  // This function assumes sim->state.{internal_temperature, soc_nominal, soh}
-  // have been properly set, and spreads those initial values, and it also
-  // assumes that sim->state.{power, ambient_temperature} have been filled with
-  // the corresponding input
-  sim->state.kappa            = lion_kappa(sim->state.internal_temperature, sim->params);
-  sim->state.capacity_nominal = lion_capacity_nominal(sim->params->init.capacity, sim->state.soh, sim->params);
-  sim->state.soc_use          = lion_soc_usable(sim->state.soc_nominal, sim->state.kappa, sim->params);
-  sim->state.capacity_use     = lion_capacity_usable(sim->state.capacity_nominal, sim->state.kappa, sim->params);
-  sim->state.ehc              = lion_ehc(sim->state.soc_use, sim->params);
-
-  sim->state.ref_open_circuit_voltage = lion_voc(sim->state.soc_use, sim->params);
-  double voc_delta                    = sim->state.ehc * (sim->state.internal_temperature - sim->params->vft.tref);
-  sim->state.open_circuit_voltage     = sim->state.ref_open_circuit_voltage + voc_delta;
-  sim->state.current                  = lion_current_optimize(
+void lion_slv_update_capacity(lion_sim_state_t *state, lion_params_t *params) {
+  state->kappa            = lion_kappa(state->internal_temperature, params);
+  state->capacity_nominal = lion_capacity_nominal(params->init.capacity, state->soh, params);
+  state->capacity_use     = lion_capacity_usable(state->capacity_nominal, state->kappa, params);
+}
+
+void lion_slv_update_open_circuit(lion_sim_state_t *state, lion_params_t *params) {
+  lion_slv_update_capacity(state, params);
+  lion_slv_update_charge(state, params);
+}
+
+void lion_slv_update_charge(lion_sim_state_t *state, lion_params_t *params) {
+  state->soc_use = lion_soc_usable(state->soc_nominal, state->kappa, params);
+  state->ehc     = lion_ehc(state->soc_use, params);
+
+  state->ref_open_circuit_voltage = lion_voc(state->soc_use, params);
+  double voc_delta                = state->ehc * (state->internal_temperature - params->vft.tref);
+  state->open_circuit_voltage     = state->ref_open_circuit_voltage + voc_delta;
+
+  state->polarization_voltage = 0.0;
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    state->polarization_voltage += state->rc_voltage[k];
+  }
+}
+
+void lion_slv_update_thermal(lion_sim_state_t *state, lion_params_t *params) {
+  state->generated_heat      = lion_generated_heat(state->current, state->internal_temperature, state->internal_resistance, state->ehc, params);
+  for (uint32_t k = 0; k < params->rc.n_branches; k++) {
+    state->generated_heat += gsl_pow_2(state->rc_voltage[k]) / params->rc.resistance[k];
+  }
+  state->surface_temperature = lion_surface_temperature(state->internal_temperature, state->ambient_temperature, params);
+}
+
+static double update_current_fallback(lion_sim_t *sim, double open_circuit_voltage) {
+  // One-shot estimate with the resistance at the previous current, which
+  // needs a single evaluation, or the previous current if the power cannot
+  // be delivered at that resistance. The resistance is taken at unit state of
+  // health, like in the optimizer, so both agree when the budget suffices
+  lion_sim_state_t *state        = &sim->state;
+  double            r            = lion_resistance(state->soc_use, state->current, 1.0, sim->params);
+  double            discriminant = gsl_pow_2(open_circuit_voltage / (2.0 * r)) - state->power / r;
+  state->step_evaluations++;
+  if (discriminant >= 0.0) {
+    state->step_flags |= LION_STEP_CURRENT_ANALYTIC;
+    return lion_current(state->power, open_circuit_voltage, r, sim->params);
+  }
+  state->step_flags |= LION_STEP_CURRENT_HOLD;
+  return state->current;
+}
+
+static double update_current_power(lion_sim_t *sim, double open_circuit_voltage) {
+  uint64_t budget = (sim->conf->sim_current_budget > 0) ? sim->conf->sim_current_budget : UINT64_MAX;
+  double   current;
+  uint64_t evaluations;
+  int      status = lion_current_optimize_bounded(
       sim->sys_min,
       sim->state.power,
       sim->state.soc_use,
-      sim->state.open_circuit_voltage,
+      open_circuit_voltage,
       sim->state.current,
       sim->conf->sim_epsabs,
       sim->conf->sim_epsrel,
       sim->conf->sim_min_maxiter,
-      sim->params
+      budget,
+      sim->params,
+      &current,
+      &evaluations
   );
+  sim->state.step_evaluations += evaluations;
+  if (status != GSL_SUCCESS) {
+    sim->state.step_flags |= LION_STEP_CURRENT_UNCONVERGED;
+    if (sim->conf->sim_current_budget > 0) {
+      current = update_current_fallback(sim, open_circuit_voltage);
+    } else {
+      logi_error("Current did not converge");
+    }
+  }
+  return current;
+}
+
+static double update_current_voltage(lion_sim_t *sim, double open_circuit_voltage) {
+  // The previous current is a good starting point, as the voltage setpoint
+  // rarely changes between steps
+  double   current;
+  uint64_t evaluations;
+  int      status = lion_current_from_voltage(
+      sim->state.voltage,
+      sim->state.soc_use,
+      open_circuit_voltage,
+      sim->state.current,
+      sim->conf->sim_epsabs,
+      sim->conf->sim_epsrel,
+      sim->conf->sim_min_maxiter,
+      sim->params,
+      &current,
+      &evaluations
+  );
+  sim->state.step_evaluations += evaluations;
+  if (status != GSL_SUCCESS) {
+    sim->state.step_flags |= LION_STEP_CURRENT_UNCONVERGED;
+    logi_error("Current did not converge at %f V", sim->state.voltage);
+  }
+  return current;
+}
+
+lion_status_t lion_slv_update(lion_sim_t *sim) {
+  // This function assumes sim->state.{internal_temperature, soc_nominal, soh}
+  // have been properly set, and spreads those initial values, and it also
+  // assumes that sim->state.ambient_temperature and the field controlled by
+  // sim->state.input_mode have been filled with the corresponding input. The
+  // RC branches sit in series with the internal resistance, so the current is
+  // solved against the polarized voltage. The coefficients driven by the
+  // temperature only change along with it
+  if (lion_slv_multirate_refresh(sim)) {
+    lion_slv_update_capacity(&sim->state, sim->params);
+  }
+  lion_slv_update_charge(&sim->state, sim->params);
+  double voc = sim->state.open_circuit_voltage - sim->state.polarization_voltage;
+  switch (sim->state.input_mode) {
+  case LION_INPUT_CURRENT:
+    // The terminal voltage uses the same resistance as the power solve
+    sim->state.voltage = voc - lion_resistance(sim->state.soc_use, sim->state.current, 1.0, sim->params) * sim->state.current;
+    sim->state.power   = sim->state.voltage * sim->state.current;
+    sim->state.step_evaluations++;
+    break;
+  case LION_INPUT_VOLTAGE:
+    sim->state.current = update_current_voltage(sim, voc);
+    sim->state.power   = sim->state.voltage * sim->state.current;
+    break;
+  default:
+    sim->state.current = update_current_power(sim, voc);
+    sim->state.voltage = lion_voltage_from_current(sim->state.power, sim->state.current, sim->params);
+    break;
+  }
   sim->state.internal_resistance = lion_resistance(sim->state.soc_use, sim->state.current, sim->state.soh, sim->params);
-  sim->state.voltage             = lion_voltage_from_current(sim->state.power, sim->state.current, sim->params);
+  lion_slv_update_thermal(&sim->state, sim->params);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_slv_update_degradation(lion_sim_t *sim, lion_sim_state_t *state, lion_params_t *params) {
+  // Calendar aging is slow enough to be applied once every few steps, at the
+  // conditions of the last one
+  double calendar = 0.0;
+  if (params->calendar.rate > 0.0) {
+    uint64_t every = GSL_MAX(sim->conf->sim_aging_steps, 1);
+    if (++state->_aging_step >= every) {
+      double span        = sim->conf->sim_step_seconds * (double)every;
+      calendar           = lion_soh_calendar_rate(state->internal_temperature, state->soc_nominal, params) * span;
+      state->_aging_step = 0;
+    }
+  }
+  return lion_slv_update_degradation_steps(sim, state, params, 1, state->soc_nominal, calendar);
+}
+
+lion_status_t lion_slv_update_degradation_steps(
+    lion_sim_t *sim, lion_sim_state_t *state, lion_params_t *params, uint64_t steps, double soc_last, double calendar
+) {
+  // Update SoC statistics, with the state of charge moving linearly from the
+  // first step to the last one
+  double soc_first = state->soc_nominal;
+  double weight    = (double)steps;
+  state->_soc_mean = ((double)state->_cycle_step * state->_soc_mean + weight * 0.5 * (soc_first + soc_last)) / ((double)state->_cycle_step + weight);
+  state->_soc_max  = GSL_MAX_DBL(state->_soc_max, GSL_MAX_DBL(soc_first, soc_last));
+  state->_soc_min  = GSL_MIN_DBL(state->_soc_min, GSL_MIN_DBL(soc_first, soc_last));
+
+  // Calendar aging applies whether the cell is used or not
+  if (calendar > 0.0) {
+    state->soh *= exp(-calendar);
+  }
+
+  // Update the degradation state of the cell
+  state->_acc_discharge += GSL_MAX_DBL(state->current * sim->conf->sim_step_seconds, 0.0) * weight;
+  if (state->_acc_discharge >= state->capacity_nominal) {
+    // A cycle has been completed so we update the SoH
+    logi_debug("Old SoH: %lf", state->soh);
+    logi_debug("ASSR: %lf", state->_soc_mean);
+    logi_debug("SR: %lf", state->_soc_max - state->_soc_min);
+    state->_acc_discharge = fmod(state->_acc_discharge, state->capacity_nominal);
+    state->soh = lion_soh_next(sim, state->soh, state->_soc_mean, state->_soc_max, state->_soc_min, state->internal_temperature, params);
+    logi_debug("New SoH: %lf", state->soh);
+
+    // Restart placeholder values
+    state->_soc_mean   = 0.0;
+    state->_soc_max    = 0.0;
+    state->_soc_min    = 1.0;
+    state->_cycle_step = 0;
 
-  sim->state.generated_heat =
-      lion_generated_heat(sim->state.current, sim->state.internal_temperature, sim->state.internal_resistance, sim->state.ehc, sim->params);
-  sim->state.surface_temperature = lion_surface_temperature(sim->state.internal_temperature, sim->state.ambient_temperature, sim->params);
+    state->cycle++;
+  } else {
+    state->_cycle_step += steps;
+  }
   return LION_STATUS_SUCCESS;
 }
@@ -4,3 +4,17 @@
 #include <lion/status.h>
 
 lion_status_t lion_slv_update(lion_sim_t *sim);
+
+void          lion_slv_update_open_circuit(lion_sim_state_t *state, lion_params_t *params);
+// The two halves of the open circuit update, the capacity only depending on
+// the temperature and state of health and the rest on the state of charge
+void          lion_slv_update_capacity(lion_sim_state_t *state, lion_params_t *params);
+void          lion_slv_update_charge(lion_sim_state_t *state, lion_params_t *params);
+void          lion_slv_update_thermal(lion_sim_state_t *state, lion_params_t *params);
+lion_status_t lion_slv_update_degradation(lion_sim_t *sim, lion_sim_state_t *state, lion_params_t *params);
+// Degradation over `steps` steps starting at `state`, with the state of charge
+// reaching `soc_last` at the start of the last one and `calendar` being the
+// integral of the calendar aging rate over them
+lion_status_t lion_slv_update_degradation_steps(
+    lion_sim_t *sim, lion_sim_state_t *state, lion_params_t *params, uint64_t steps, double soc_last, double calendar
+);
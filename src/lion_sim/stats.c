@@ -0,0 +1,160 @@
+#include "mem.h"
+#include "sim_run.h"
+
+#include <lion/lion.h>
+#include <lion/stats.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+#include <string.h>
+
+static void stat_clear(lion_stat_t *stat) {
+  stat->count     = 0;
+  stat->mean      = 0.0;
+  stat->m2        = 0.0;
+  stat->min       = INFINITY;
+  stat->max       = -INFINITY;
+  stat->integral  = 0.0;
+  stat->positive  = 0.0;
+  stat->negative  = 0.0;
+  stat->above     = 0.0;
+  stat->below     = 0.0;
+  stat->underflow = 0;
+  stat->overflow  = 0;
+  stat->nan       = 0;
+  if (stat->bins != NULL) {
+    memset(stat->bins, 0, stat->n_bins * sizeof(uint64_t));
+  }
+}
+
+lion_status_t lion_sim_stats_add(lion_sim_t *sim, const lion_stat_config_t *conf, size_t *out) {
+  double *field = lion_sim_state_field(&sim->state, conf->field);
+  if (field == NULL) {
+    logi_error("Unknown state field '%s'", conf->field);
+    return LION_STATUS_FAILURE;
+  }
+  if (conf->kind == LION_STAT_HISTOGRAM && (conf->n_bins == 0 || !(conf->high > conf->low))) {
+    logi_error("Histograms require at least one bin and an increasing range");
+    return LION_STATUS_FAILURE;
+  }
+
+  lion_stat_t stat = {
+    .kind   = conf->kind,
+    .offset = (size_t)((char *)field - (char *)&sim->state),
+    .low    = conf->low,
+    .high   = conf->high,
+    .n_bins = (conf->kind == LION_STAT_HISTOGRAM) ? conf->n_bins : 0,
+    .bins   = NULL,
+  };
+  if (stat.n_bins > 0) {
+    stat.bins = lion_calloc(sim, stat.n_bins, sizeof(uint64_t));
+    if (stat.bins == NULL) {
+      logi_error("Could not allocate histogram bins");
+      return LION_STATUS_FAILURE;
+    }
+  }
+  stat_clear(&stat);
+
+  lion_stat_t *stats = lion_realloc(sim, sim->stats, (sim->n_stats + 1) * sizeof(lion_stat_t));
+  if (stats == NULL) {
+    logi_error("Could not allocate accumulator");
+    lion_free(sim, stat.bins);
+    return LION_STATUS_FAILURE;
+  }
+  logi_debug("Accumulating '%s' at index %zu", conf->field, sim->n_stats);
+  stats[sim->n_stats] = stat;
+  sim->stats          = stats;
+  if (out != NULL) {
+    *out = sim->n_stats;
+  }
+  sim->n_stats++;
+  return LION_STATUS_SUCCESS;
+}
+
+const lion_stat_t *lion_sim_stat(const lion_sim_t *sim, size_t index) {
+  if (index >= sim->n_stats) {
+    return NULL;
+  }
+  return &sim->stats[index];
+}
+
+void lion_sim_stats_reset(lion_sim_t *sim) {
+  for (size_t i = 0; i < sim->n_stats; i++) {
+    stat_clear(&sim->stats[i]);
+  }
+}
+
+lion_status_t lion_sim_stats_cleanup(lion_sim_t *sim) {
+  for (size_t i = 0; i < sim->n_stats; i++) {
+    if (sim->stats[i].bins != NULL) {
+      lion_free(sim, sim->stats[i].bins);
+    }
+  }
+  if (sim->stats != NULL) {
+    lion_free(sim, sim->stats);
+  }
+  sim->stats   = NULL;
+  sim->n_stats = 0;
+  return LION_STATUS_SUCCESS;
+}
+
+double lion_stat_variance(const lion_stat_t *stat) {
+  if (stat->count < 2) {
+    return NAN;
+  }
+  return stat->m2 / (double)(stat->count - 1);
+}
+
+void lion_sim_stats_update(lion_sim_t *sim) { lion_sim_stats_update_steps(sim, 1); }
+
+void lion_sim_stats_update_steps(lion_sim_t *sim, uint64_t steps) {
+  // Every step sees the same outputs, which weighs them by the number of steps
+  double weight = (double)steps;
+  double h      = sim->conf->sim_step_seconds * weight;
+  for (size_t i = 0; i < sim->n_stats; i++) {
+    lion_stat_t *stat  = &sim->stats[i];
+    double       value = *(const double *)((const char *)&sim->state + stat->offset);
+
+    // Welford's update of the moments
+    stat->count  += steps;
+    double delta  = value - stat->mean;
+    stat->mean   += delta * weight / (double)stat->count;
+    stat->m2     += weight * delta * (value - stat->mean);
+    stat->min     = fmin(stat->min, value);
+    stat->max     = fmax(stat->max, value);
+
+    switch (stat->kind) {
+    case LION_STAT_HISTOGRAM:
+      // NaN fails every comparison, and would reach the cast to an index
+      if (isnan(value)) {
+        stat->nan += steps;
+      } else if (value < stat->low) {
+        stat->underflow += steps;
+      } else if (value >= stat->high) {
+        stat->overflow += steps;
+      } else {
+        size_t bin = (size_t)((value - stat->low) / (stat->high - stat->low) * (double)stat->n_bins);
+        // Rounding can push values right below the upper edge into the last bin + 1
+        stat->bins[(bin < stat->n_bins) ? bin : stat->n_bins - 1] += steps;
+      }
+      break;
+    case LION_STAT_INTEGRAL:
+      stat->integral += value * h;
+      if (value > 0.0) {
+        stat->positive += value * h;
+      } else {
+        stat->negative += value * h;
+      }
+      break;
+    case LION_STAT_DWELL:
+      if (value > stat->low) {
+        stat->above += h;
+      } else {
+        stat->below += h;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
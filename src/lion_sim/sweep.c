@@ -0,0 +1,274 @@
+#include "mem.h"
+#include "parallel.h"
+#include "sim_run.h"
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_odeiv2.h>
+#include <gsl/gsl_rng.h>
+#include <limits.h>
+#include <lion/lion.h>
+#include <lion/sweep.h>
+#include <lion_utils/macros.h>
+#include <lion_utils/vendor/log.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+typedef struct lion_sweep_acc {
+  double   voltage_min;
+  double   voltage_max;
+  double   voltage_sum;
+  double   temperature_max;
+  double   throughput;
+  uint64_t steps;
+} lion_sweep_acc_t;
+
+static double *sweep_field(lion_sim_config_t *conf, lion_params_t *params, const char *name) {
+  double *field = lion_params_field(params, name);
+  return (field != NULL) ? field : lion_sim_config_field(conf, name);
+}
+
+size_t lion_sweep_variants(const lion_sweep_t *sweep) {
+  switch (sweep->method) {
+  case LION_SWEEP_GRID: {
+    size_t total = 1;
+    for (size_t a = 0; a < sweep->n_axes; a++) {
+      total *= sweep->axes[a].num;
+    }
+    return total;
+  }
+  case LION_SWEEP_LHS:
+    return sweep->n_samples;
+  default:
+    return 0;
+  }
+}
+
+static lion_status_t sweep_sample_grid(const lion_sweep_t *sweep, size_t n_variants, double *values) {
+  // The last axis changes the fastest
+  for (size_t k = 0; k < n_variants; k++) {
+    size_t idx = k;
+    for (size_t a = sweep->n_axes; a-- > 0;) {
+      const lion_sweep_axis_t *axis = &sweep->axes[a];
+      size_t                   j    = idx % axis->num;
+
+      idx                           /= axis->num;
+      values[k * sweep->n_axes + a]  = (axis->num > 1) ? axis->low + (axis->high - axis->low) * (double)j / (double)(axis->num - 1) : axis->low;
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t sweep_sample_lhs(lion_sim_t *sim, const lion_sweep_t *sweep, size_t n_variants, double *values) {
+  size_t *strata = lion_malloc(sim, n_variants * sizeof(size_t));
+  if (strata == NULL) {
+    logi_error("Could not allocate strata");
+    return LION_STATUS_FAILURE;
+  }
+  gsl_rng *rng = gsl_rng_alloc(gsl_rng_mt19937);
+  if (rng == NULL) {
+    logi_error("Could not allocate random number generator");
+    lion_free(sim, strata);
+    return LION_STATUS_FAILURE;
+  }
+  gsl_rng_set(rng, sweep->seed);
+
+  // Each axis is split in n_variants strata, and every stratum is sampled
+  // exactly once in a random order
+  for (size_t a = 0; a < sweep->n_axes; a++) {
+    const lion_sweep_axis_t *axis = &sweep->axes[a];
+    for (size_t k = 0; k < n_variants; k++) {
+      strata[k] = k;
+    }
+    for (size_t k = n_variants; k-- > 1;) {
+      size_t j  = gsl_rng_uniform_int(rng, k + 1);
+      size_t t  = strata[k];
+      strata[k] = strata[j];
+      strata[j] = t;
+    }
+    for (size_t k = 0; k < n_variants; k++) {
+      double u                      = ((double)strata[k] + gsl_rng_uniform(rng)) / (double)n_variants;
+      values[k * sweep->n_axes + a] = axis->low + (axis->high - axis->low) * u;
+    }
+  }
+
+  gsl_rng_free(rng);
+  lion_free(sim, strata);
+  return LION_STATUS_SUCCESS;
+}
+
+static double sweep_metric(lion_sim_t *sim, const lion_sweep_acc_t *acc, lion_sweep_metric_t metric) {
+  switch (metric) {
+  case LION_SWEEP_FINAL_SOC:
+    return sim->state._next_soc_nominal;
+  case LION_SWEEP_FINAL_SOH:
+    return sim->state.soh;
+  case LION_SWEEP_FINAL_TEMPERATURE:
+    return sim->state._next_internal_temperature;
+  case LION_SWEEP_MAX_TEMPERATURE:
+    return acc->temperature_max;
+  case LION_SWEEP_MIN_VOLTAGE:
+    return acc->voltage_min;
+  case LION_SWEEP_MAX_VOLTAGE:
+    return acc->voltage_max;
+  case LION_SWEEP_MEAN_VOLTAGE:
+    return (acc->steps > 0) ? acc->voltage_sum / (double)acc->steps : NAN;
+  case LION_SWEEP_CHARGE_THROUGHPUT:
+    return acc->throughput;
+  case LION_SWEEP_CYCLES:
+    return (double)sim->state.cycle;
+  default:
+    return NAN;
+  }
+}
+
+static lion_status_t sweep_variant(
+    lion_sim_t         *base,
+    const lion_sweep_t *sweep,
+    unsigned long       seed,
+    const double       *values,
+    const double       *power,
+    const double       *amb,
+    uint64_t            max_iters,
+    double             *metrics
+) {
+  lion_sim_config_t conf   = *base->conf;
+  lion_params_t     params = *base->params;
+  for (size_t a = 0; a < sweep->n_axes; a++) {
+    *sweep_field(&conf, &params, sweep->axes[a].name) = values[a];
+  }
+
+  // Forking counts the forks of the base, so it is serialized and the
+  // variant is reseeded to keep results independent of scheduling
+  lion_sim_t    sim;
+  lion_status_t status;
+#ifdef _OPENMP
+  #pragma omp critical(lion_sweep_fork)
+#endif
+  status = lion_sim_fork(base, &sim);
+  LION_CALL_I(status, "Failed forking variant");
+  gsl_rng_set(sim.rng, seed);
+
+  // The inputs cached from the configuration and parameters of the base, and
+  // the first step of the driver, are recomputed for the variant
+  sim.conf          = &conf;
+  sim.params        = &params;
+  sim.init_hook     = NULL;
+  sim.update_hook   = NULL;
+  sim.finished_hook = NULL;
+  lion_sim_refresh_inputs(&sim);
+  status = (gsl_odeiv2_driver_reset_hstart(sim.driver, conf.sim_step_seconds) == GSL_SUCCESS) ? lion_sim_reset(&sim) : LION_STATUS_FAILURE;
+
+  lion_sweep_acc_t acc = {
+    .voltage_min     = INFINITY,
+    .voltage_max     = -INFINITY,
+    .voltage_sum     = 0.0,
+    .temperature_max = -INFINITY,
+    .throughput      = 0.0,
+    .steps           = 0,
+  };
+  // Stop events end the variant like they end lion_sim_run
+  for (uint64_t i = 1; i < max_iters && status == LION_STATUS_SUCCESS && !lion_sim_should_close(&sim); i++) {
+    status = lion_sim_step(&sim, power[i], amb[i]);
+
+    acc.voltage_min      = fmin(acc.voltage_min, sim.state.voltage);
+    acc.voltage_max      = fmax(acc.voltage_max, sim.state.voltage);
+    acc.voltage_sum     += sim.state.voltage;
+    acc.temperature_max  = fmax(acc.temperature_max, sim.state.internal_temperature);
+    acc.throughput      += fabs(sim.state.current) * conf.sim_step_seconds;
+    acc.steps++;
+  }
+
+  for (size_t m = 0; m < sweep->n_metrics; m++) {
+    metrics[m] = (status == LION_STATUS_SUCCESS) ? sweep_metric(&sim, &acc, sweep->metrics[m]) : NAN;
+  }
+  LION_CALL_I(lion_sim_cleanup(&sim), "Failed cleaning up variant");
+  return status;
+}
+
+lion_status_t lion_sweep_run(
+    lion_sim_t *base, const lion_sweep_t *sweep, lion_vector_t *power, lion_vector_t *ambient_temperature, lion_vector_t *out
+) {
+  if (base->driver == NULL) {
+    logi_error("Sweeps require an initialized base simulation");
+    return LION_STATUS_FAILURE;
+  }
+  if (sweep->n_axes == 0) {
+    logi_error("Sweep has no parameters");
+    return LION_STATUS_FAILURE;
+  }
+  if (base->conf->sim_jump != LION_JUMP_NONE) {
+    // The metrics are gathered after every step, which jumps would skip
+    logi_error("Sweeps step every sample, so they cannot jump over intervals (%s)", lion_jump_name(base->conf->sim_jump));
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t a = 0; a < sweep->n_axes; a++) {
+    if (sweep_field(base->conf, base->params, sweep->axes[a].name) == NULL) {
+      logi_error("Unknown parameter '%s'", sweep->axes[a].name);
+      return LION_STATUS_FAILURE;
+    }
+    if (sweep->method == LION_SWEEP_GRID && sweep->axes[a].num == 0) {
+      logi_error("Grid axis '%s' has no values", sweep->axes[a].name);
+      return LION_STATUS_FAILURE;
+    }
+  }
+
+  size_t n_variants = lion_sweep_variants(sweep);
+  if (n_variants == 0 || n_variants > INT_MAX) {
+    logi_error("Invalid number of variants (%zu)", n_variants);
+    return LION_STATUS_FAILURE;
+  }
+  size_t n_cols = sweep->n_axes + sweep->n_metrics;
+  LION_CALL_I(lion_vector_zero(base, n_variants * n_cols, sizeof(double), out), "Failed allocating results table");
+  double *table = out->data;
+
+  // The parameter values are sampled up front into the results table
+  double *values = lion_malloc(base, n_variants * sweep->n_axes * sizeof(double));
+  if (values == NULL) {
+    logi_error("Could not allocate parameter values");
+    return LION_STATUS_FAILURE;
+  }
+  lion_status_t sampled = (sweep->method == LION_SWEEP_LHS) ? sweep_sample_lhs(base, sweep, n_variants, values)
+                                                             : sweep_sample_grid(sweep, n_variants, values);
+  if (sampled != LION_STATUS_SUCCESS) {
+    lion_free(base, values);
+    logi_error("Failed sampling parameter space");
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t k = 0; k < n_variants; k++) {
+    memcpy(&table[k * n_cols], &values[k * sweep->n_axes], sweep->n_axes * sizeof(double));
+  }
+  lion_free(base, values);
+
+  uint64_t      max_iters = (power->len < ambient_temperature->len) ? power->len : ambient_temperature->len;
+  const double *p         = power->data;
+  const double *amb       = ambient_temperature->data;
+  int           n         = (int)n_variants;
+  int           failures  = 0;
+  logi_info("Running sweep of %d variants", n);
+
+#ifdef _OPENMP
+  int        threads = (sweep->n_threads > 0) ? sweep->n_threads : omp_get_max_threads();
+  lion_log_lock_t log_lock;
+  lion_log_lock_begin(&log_lock);
+  #pragma omp parallel for schedule(dynamic) num_threads(threads) reduction(+ : failures)
+#endif
+  for (int k = 0; k < n; k++) {
+    double *row = &table[(size_t)k * n_cols];
+    if (sweep_variant(base, sweep, sweep->seed + (unsigned long)k + 1, row, p, amb, max_iters, row + sweep->n_axes) != LION_STATUS_SUCCESS) {
+      failures++;
+    }
+  }
+#ifdef _OPENMP
+  lion_log_lock_end(&log_lock);
+#endif
+
+  if (failures > 0) {
+    logi_warn("%d of %d variants failed", failures, n);
+  }
+  logi_info("Finished sweep");
+  return LION_STATUS_SUCCESS;
+}
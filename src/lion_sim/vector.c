@@ -4,6 +4,7 @@
 #include <lion_sim/files.h>
 #include <lion_utils/macros.h>
 #include <lion_utils/vendor/log.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -154,6 +155,10 @@ lion_status_t lion_vector_to_csv(lion_sim_t *sim, lion_vector_t *vec, const char
 }
 
 lion_status_t lion_vector_cleanup(lion_sim_t *sim, const lion_vector_t *const vec) {
+  if (vec->mapped) {
+    logi_error("Mapped vectors must be released with lion_vector_unmap");
+    return LION_STATUS_FAILURE;
+  }
   lion_free(sim, vec->data);
   return LION_STATUS_SUCCESS;
 }
@@ -202,6 +207,10 @@ double lion_vector_get_d(lion_sim_t *sim, const lion_vector_t *vec, const size_t
 void *lion_vector_get_p(lion_sim_t *sim, const lion_vector_t *vec, const size_t i) { return (void *)((char *)vec->data + i * vec->data_size); }
 
 lion_status_t lion_vector_set(lion_sim_t *sim, lion_vector_t *vec, const size_t i, const void *src) {
+  if (vec->mapped) {
+    logi_error("Mapped vectors are read-only");
+    return LION_STATUS_FAILURE;
+  }
   if (vec->data == NULL || i >= vec->len || src == NULL) {
     logi_error("Out of bounds or source is NULL");
     return LION_STATUS_FAILURE;
@@ -211,6 +220,20 @@ lion_status_t lion_vector_set(lion_sim_t *sim, lion_vector_t *vec, const size_t
 }
 
 lion_status_t lion_vector_resize(lion_sim_t *sim, lion_vector_t *vec, const size_t new_capacity) {
+  if (vec->mapped) {
+    logi_error("Mapped vectors cannot be resized");
+    return LION_STATUS_FAILURE;
+  }
+  if (new_capacity == 0) {
+    // realloc with a zero size is implementation defined, so release the
+    // storage explicitly
+    lion_free(sim, vec->data);
+    vec->data     = NULL;
+    vec->len      = 0;
+    vec->capacity = 0;
+    return LION_STATUS_SUCCESS;
+  }
+
   void *data = lion_realloc(sim, vec->data, new_capacity * vec->data_size);
   if (data == NULL) {
     logi_error("Could not allocate enough data");
@@ -225,36 +248,41 @@ lion_status_t lion_vector_resize(lion_sim_t *sim, lion_vector_t *vec, const size
   return LION_STATUS_SUCCESS;
 }
 
+lion_status_t lion_vector_reserve(lion_sim_t *sim, lion_vector_t *vec, const size_t additional) {
+  size_t required = vec->len + additional;
+  if (required <= vec->capacity) {
+    return LION_STATUS_SUCCESS;
+  }
+  // Doubling keeps the number of reallocations logarithmic in the final
+  // length, while a large request is served in a single one
+  size_t new_capacity = 2 * vec->capacity;
+  if (new_capacity < required) {
+    new_capacity = required;
+  }
+  logi_debug("Reallocating for %d elements", new_capacity);
+  return lion_vector_resize(sim, vec, new_capacity);
+}
+
+lion_status_t lion_vector_shrink_to_fit(lion_sim_t *sim, lion_vector_t *vec) {
+  if (vec->capacity == vec->len) {
+    return LION_STATUS_SUCCESS;
+  }
+  return lion_vector_resize(sim, vec, vec->len);
+}
+
 lion_status_t lion_vector_push(lion_sim_t *sim, lion_vector_t *vec, const void *src) {
+  if (vec->mapped) {
+    logi_error("Mapped vectors cannot be pushed to");
+    return LION_STATUS_FAILURE;
+  }
   if (src == NULL) {
     logi_error("Source is NULL");
     return LION_STATUS_FAILURE;
   }
 
-  if (vec->len == vec->capacity) {
-    // The vector is full so we have to reallocate
-    // Default strategy is duplicate the current capacity
-    // Perhaps the user can customize the behaviour?
-    size_t new_size = 2 * vec->capacity * vec->data_size;
-    if (new_size == 0) {
-      new_size = vec->data_size;
-    }
-    logi_debug("Reallocating for %d B", new_size);
-    void *new_data = lion_realloc(sim, vec->data, new_size);
-    if (new_data == NULL) {
-      logi_error("Could not allocate enough data");
-      return LION_STATUS_FAILURE;
-    }
-    memcpy((char *)new_data + vec->len * vec->data_size, src, vec->data_size);
-    vec->data = new_data;
-    vec->len++;
-    vec->capacity = new_size / vec->data_size;
-  } else {
-    // It can be assumed that vec->len < vec->capacity, so this
-    // means we dont have to allocate more memory.
-    memcpy((char *)vec->data + vec->len * vec->data_size, src, vec->data_size);
-    vec->len++;
-  }
+  LION_CALL_I(lion_vector_reserve(sim, vec, 1), "Could not allocate enough data");
+  memcpy((char *)vec->data + vec->len * vec->data_size, src, vec->data_size);
+  vec->len++;
   return LION_STATUS_SUCCESS;
 }
 
@@ -268,38 +296,151 @@ lion_status_t lion_vector_extend_array(lion_sim_t *sim, lion_vector_t *vec, cons
     return LION_STATUS_FAILURE;
   }
 
-  // size_t delta = vec->len + len - vec->capacity;
-  int64_t _delta = (int64_t)(vec->len + len - vec->capacity);
-  size_t  delta  = 0;
-  if (_delta > 0) {
-    delta = (size_t)_delta;
-  }
-  if (delta > 0) {
-    // The vector does not have enough space so we have to allocate more
-    // memory
-    logi_info("Allocating memory for extension of vector");
-    logi_debug("Allocating %d more bytes", delta * vec->data_size);
-    void *new_data = lion_realloc(sim, vec->data, (vec->capacity + delta) * vec->data_size);
-    if (new_data == NULL) {
-      logi_error("Reallocation failed");
-      return LION_STATUS_FAILURE;
-    }
-    logi_debug("Copying new memory");
-    memcpy((char *)new_data + vec->len * vec->data_size, src, len * vec->data_size);
-    vec->data      = new_data;
-    vec->len      += len;
-    vec->capacity += delta;
-    logi_debug("New len is %d", vec->len);
-    logi_debug("New capacity is %d", vec->capacity);
-  } else {
-    // It can be assumed that vec->len < vec->capacity, so this
-    // means we dont have to allocate more memory.
-    memcpy((char *)vec->data + vec->len * vec->data_size, src, len * vec->data_size);
-    vec->len += len;
-  }
+  LION_VCALL_I(lion_vector_reserve(sim, vec, len), "Could not allocate space for %d more elements", len);
+  memcpy((char *)vec->data + vec->len * vec->data_size, src, len * vec->data_size);
+  vec->len += len;
   return LION_STATUS_SUCCESS;
 }
 
 extern inline size_t lion_vector_total_size(lion_sim_t *sim, const lion_vector_t *vec) { return vec->len * vec->data_size; }
 
 extern inline size_t lion_vector_alloc_size(lion_sim_t *sim, const lion_vector_t *vec) { return vec->capacity * vec->data_size; }
+
+lion_status_t lion_vector_view_d(lion_sim_t *sim, const lion_vector_t *vec, lion_vector_view_d_t *out) {
+  return lion_vector_slice_d(sim, vec, 0, vec->len, out);
+}
+
+lion_status_t lion_vector_view_f(lion_sim_t *sim, const lion_vector_t *vec, lion_vector_view_f_t *out) {
+  return lion_vector_slice_f(sim, vec, 0, vec->len, out);
+}
+
+lion_status_t lion_vector_slice_d(lion_sim_t *sim, const lion_vector_t *vec, const size_t start, const size_t len, lion_vector_view_d_t *out) {
+  if (vec->data_size != sizeof(double)) {
+    logi_error("Vector holds elements of %d B, not doubles", vec->data_size);
+    return LION_STATUS_FAILURE;
+  }
+  if (start > vec->len || len > vec->len - start) {
+    logi_error("Slice [%d, %d) is out of bounds for length %d", start, start + len, vec->len);
+    return LION_STATUS_FAILURE;
+  }
+  lion_vector_view_d_t result = {
+    .data = (double *)vec->data + start,
+    .len  = len,
+  };
+  *out = result;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_vector_slice_f(lion_sim_t *sim, const lion_vector_t *vec, const size_t start, const size_t len, lion_vector_view_f_t *out) {
+  if (vec->data_size != sizeof(float)) {
+    logi_error("Vector holds elements of %d B, not floats", vec->data_size);
+    return LION_STATUS_FAILURE;
+  }
+  if (start > vec->len || len > vec->len - start) {
+    logi_error("Slice [%d, %d) is out of bounds for length %d", start, start + len, vec->len);
+    return LION_STATUS_FAILURE;
+  }
+  lion_vector_view_f_t result = {
+    .data = (float *)vec->data + start,
+    .len  = len,
+  };
+  *out = result;
+  return LION_STATUS_SUCCESS;
+}
+
+void lion_vector_fill_d(lion_sim_t *sim, lion_vector_view_d_t x, double value) {
+  for (size_t i = 0; i < x.len; i++) {
+    x.data[i] = value;
+  }
+}
+
+void lion_vector_scale_d(lion_sim_t *sim, lion_vector_view_d_t x, double alpha) {
+  for (size_t i = 0; i < x.len; i++) {
+    x.data[i] *= alpha;
+  }
+}
+
+lion_status_t lion_vector_axpy_d(lion_sim_t *sim, double alpha, lion_vector_view_d_t x, lion_vector_view_d_t y) {
+  if (x.len != y.len) {
+    logi_error("Views have different lengths (%d and %d)", x.len, y.len);
+    return LION_STATUS_FAILURE;
+  }
+  const double *restrict xd = x.data;
+  double *restrict yd       = y.data;
+  for (size_t i = 0; i < x.len; i++) {
+    yd[i] += alpha * xd[i];
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t lion_vector_map_d(lion_sim_t *sim, double (*fn)(double, void *), void *ctx, lion_vector_view_d_t x, lion_vector_view_d_t out) {
+  if (x.len != out.len) {
+    logi_error("Views have different lengths (%d and %d)", x.len, out.len);
+    return LION_STATUS_FAILURE;
+  }
+  for (size_t i = 0; i < x.len; i++) {
+    out.data[i] = fn(x.data[i], ctx);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+// Reductions keep four independent accumulators so consecutive additions
+// do not wait on each other, which also lets them map onto vector lanes
+// without reassociating a single running sum.
+
+double lion_vector_sum_d(lion_sim_t *sim, lion_vector_view_d_t x) {
+  double acc[4] = {0.0, 0.0, 0.0, 0.0};
+  size_t i      = 0;
+  for (; i + 4 <= x.len; i += 4) {
+    acc[0] += x.data[i];
+    acc[1] += x.data[i + 1];
+    acc[2] += x.data[i + 2];
+    acc[3] += x.data[i + 3];
+  }
+  for (; i < x.len; i++) {
+    acc[0] += x.data[i];
+  }
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+double lion_vector_min_d(lion_sim_t *sim, lion_vector_view_d_t x) {
+  if (x.len == 0) {
+    return NAN;
+  }
+  double result = x.data[0];
+  for (size_t i = 1; i < x.len; i++) {
+    result = x.data[i] < result ? x.data[i] : result;
+  }
+  return result;
+}
+
+double lion_vector_max_d(lion_sim_t *sim, lion_vector_view_d_t x) {
+  if (x.len == 0) {
+    return NAN;
+  }
+  double result = x.data[0];
+  for (size_t i = 1; i < x.len; i++) {
+    result = x.data[i] > result ? x.data[i] : result;
+  }
+  return result;
+}
+
+lion_status_t lion_vector_dot_d(lion_sim_t *sim, lion_vector_view_d_t x, lion_vector_view_d_t y, double *out) {
+  if (x.len != y.len) {
+    logi_error("Views have different lengths (%d and %d)", x.len, y.len);
+    return LION_STATUS_FAILURE;
+  }
+  double acc[4] = {0.0, 0.0, 0.0, 0.0};
+  size_t i      = 0;
+  for (; i + 4 <= x.len; i += 4) {
+    acc[0] += x.data[i] * y.data[i];
+    acc[1] += x.data[i + 1] * y.data[i + 1];
+    acc[2] += x.data[i + 2] * y.data[i + 2];
+    acc[3] += x.data[i + 3] * y.data[i + 3];
+  }
+  for (; i < x.len; i++) {
+    acc[0] += x.data[i] * y.data[i];
+  }
+  *out = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+  return LION_STATUS_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include <gsl/gsl_math.h>
 #include <lionu/fuzzy.h>
+#include <lionu/vmath.h>
 #include <math.h>
 
 double lion_mf_gaussian(double x, lion_mf_gaussian_params_t *params) {
@@ -7,3 +8,21 @@ double lion_mf_gaussian(double x, lion_mf_gaussian_params_t *params) {
   double den = gsl_pow_2(params->sigma);
   return exp(-num / den);
 }
+
+void lion_mf_gaussian_batch(const double *x, size_t count, lion_mf_gaussian_params_t *params, double *out) {
+  double den = gsl_pow_2(params->sigma);
+  for (size_t i = 0; i < count; i++) {
+    out[i] = -0.5 * gsl_pow_2(x[i] - params->mean) / den;
+  }
+  lion_vexp(out, count, out);
+}
+
+void lion_mf_gaussian_batch_f(const float *x, size_t count, lion_mf_gaussian_params_t *params, float *out) {
+  float mean  = (float)params->mean;
+  float scale = (float)(-0.5 / gsl_pow_2(params->sigma));
+  for (size_t i = 0; i < count; i++) {
+    float diff = x[i] - mean;
+    out[i]     = scale * diff * diff;
+  }
+  lion_vexpf(out, count, out);
+}
@@ -1,4 +1,5 @@
 #include <lionu/fuzzy.h>
+#include <lionu/vmath.h>
 #include <math.h>
 
 double lion_mf_sigmoid(double x, lion_mf_sigmoid_params_t *params) {
@@ -6,3 +7,19 @@ double lion_mf_sigmoid(double x, lion_mf_sigmoid_params_t *params) {
   double denominator = 1 + exp(exp_term);
   return 1 / denominator;
 }
+
+void lion_mf_sigmoid_batch(const double *x, size_t count, lion_mf_sigmoid_params_t *params, double *out) {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = params->a * (x[i] - params->c);
+  }
+  lion_vsigmoid(out, count, out);
+}
+
+void lion_mf_sigmoid_batch_f(const float *x, size_t count, lion_mf_sigmoid_params_t *params, float *out) {
+  float a = (float)params->a;
+  float c = (float)params->c;
+  for (size_t i = 0; i < count; i++) {
+    out[i] = a * (x[i] - c);
+  }
+  lion_vsigmoidf(out, count, out);
+}
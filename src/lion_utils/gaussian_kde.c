@@ -49,9 +49,11 @@ lion_status_t lion_gaussian_kde_cleanup(lion_gaussian_kde_t *kde) {
   return LION_STATUS_SUCCESS;
 }
 
-double lion_gaussian_kde_sample(const lion_gaussian_kde_t *kde) {
-  double            sample = gsl_ran_gaussian(kde->rng, kde->std);
-  unsigned long int idx    = gsl_rng_uniform_int(kde->rng, kde->len);
+double lion_gaussian_kde_sample(const lion_gaussian_kde_t *kde) { return lion_gaussian_kde_sample_rng(kde, kde->rng); }
+
+double lion_gaussian_kde_sample_rng(const lion_gaussian_kde_t *kde, gsl_rng *rng) {
+  double            sample = gsl_ran_gaussian(rng, kde->std);
+  unsigned long int idx    = gsl_rng_uniform_int(rng, kde->len);
   double            mean   = kde->data[idx];
   return mean + sample;
 }
@@ -0,0 +1,471 @@
+#include <lionu/vmath.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define LION_VMATH_X86
+  #include <immintrin.h>
+#endif
+
+/*
+   The vector backends evaluate exp the same way. With x = k ln2 + r and
+   |r| <= ln2 / 2, exp(x) = 2^k exp(r) where expm1(r) comes from its Taylor
+   series up to r^13, whose truncation error is below 1e-17. Applying the
+   power of two in two halves keeps results in the subnormal range and the
+   largest finite results exact before rounding
+*/
+
+#define VM_LOG2E  1.4426950408889634074
+#define VM_LN2_HI 6.93147180369123816490e-01 // Trailing zeros keep k * VM_LN2_HI exact
+#define VM_LN2_LO 1.90821492927058770002e-10
+#define VM_SHIFT  6755399441055744.0 // 1.5 * 2^52, rounds to integers when added
+
+#define VM_EXP_MIN   -746.0
+#define VM_EXP_MAX   710.0
+#define VM_EXPM1_MIN -60.0 // expm1(x) rounds to -1 below this
+
+#define VM_C2  (1.0 / 2.0)
+#define VM_C3  (1.0 / 6.0)
+#define VM_C4  (1.0 / 24.0)
+#define VM_C5  (1.0 / 120.0)
+#define VM_C6  (1.0 / 720.0)
+#define VM_C7  (1.0 / 5040.0)
+#define VM_C8  (1.0 / 40320.0)
+#define VM_C9  (1.0 / 362880.0)
+#define VM_C10 (1.0 / 3628800.0)
+#define VM_C11 (1.0 / 39916800.0)
+#define VM_C12 (1.0 / 479001600.0)
+#define VM_C13 (1.0 / 6227020800.0)
+
+/*
+   Single precision follows the same steps, with the series of expm1(r)
+   stopping at r^7, whose truncation error is below 1e-8
+*/
+
+#define VMF_LOG2E  1.44269504f
+#define VMF_LN2_HI 0.693359375f // Nine significant bits keep k * VMF_LN2_HI exact
+#define VMF_LN2_LO -2.12194440e-4f
+#define VMF_SHIFT  12582912.0f // 1.5 * 2^23, rounds to integers when added
+
+#define VMF_EXP_MIN -104.0f
+#define VMF_EXP_MAX 89.0f
+
+typedef void (*vm_kernel_t)(const double *vals, size_t count, double *out);
+typedef void (*vm_kernelf_t)(const float *vals, size_t count, float *out);
+
+typedef struct vm_backend {
+  lion_vmath_backend_t id;
+  vm_kernel_t          exp;
+  vm_kernel_t          expm1;
+  vm_kernel_t          sqrt;
+  vm_kernel_t          sigmoid;
+  vm_kernelf_t         expf;
+  vm_kernelf_t         sqrtf;
+  vm_kernelf_t         sigmoidf;
+} vm_backend_t;
+
+/* Scalar backend, libm is faster than the vector algorithm one lane at a time */
+
+static double vm_sigmoid(double x) { return 1.0 / (1.0 + exp(-x)); }
+static float  vm_sigmoidf(float x) { return 1.0f / (1.0f + expf(-x)); }
+
+#define _VM_SCALAR_GENERATOR(name, fn, T)                                                                                                          \
+  static void name(const T *vals, size_t count, T *out) {                                                                                            \
+    for (size_t i = 0; i < count; i++) {                                                                                                             \
+      out[i] = fn(vals[i]);                                                                                                                          \
+    }                                                                                                                                                \
+  }
+
+_VM_SCALAR_GENERATOR(vm_scalar_exp, exp, double)
+_VM_SCALAR_GENERATOR(vm_scalar_expm1, expm1, double)
+_VM_SCALAR_GENERATOR(vm_scalar_sqrt, sqrt, double)
+_VM_SCALAR_GENERATOR(vm_scalar_sigmoid, vm_sigmoid, double)
+_VM_SCALAR_GENERATOR(vm_scalar_expf, expf, float)
+_VM_SCALAR_GENERATOR(vm_scalar_sqrtf, sqrtf, float)
+_VM_SCALAR_GENERATOR(vm_scalar_sigmoidf, vm_sigmoidf, float)
+
+static const vm_backend_t VM_SCALAR = {
+  .id       = LION_VMATH_SCALAR,
+  .exp      = &vm_scalar_exp,
+  .expm1    = &vm_scalar_expm1,
+  .sqrt     = &vm_scalar_sqrt,
+  .sigmoid  = &vm_scalar_sigmoid,
+  .expf     = &vm_scalar_expf,
+  .sqrtf    = &vm_scalar_sqrtf,
+  .sigmoidf = &vm_scalar_sigmoidf,
+};
+
+#ifdef LION_VMATH_X86
+
+  /* AVX2 backend, 4 lanes */
+
+  #define VM_AVX2 __attribute__((target("avx2,fma")))
+
+VM_AVX2 static inline __m256d vm_avx2_expm1_reduced(__m256d r) {
+  __m256d p = _mm256_set1_pd(VM_C13);
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C12));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C11));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C10));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C9));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C8));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C7));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C6));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C5));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C4));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C3));
+  p         = _mm256_fmadd_pd(p, r, _mm256_set1_pd(VM_C2));
+  return _mm256_fmadd_pd(_mm256_mul_pd(r, r), p, r);
+}
+
+VM_AVX2 static inline __m256d vm_avx2_pow2(__m256d k) {
+  // The low bits of k + VM_SHIFT hold k as an integer
+  __m256d shift = _mm256_set1_pd(VM_SHIFT);
+  __m256i bits  = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(k, shift)), _mm256_castpd_si256(shift));
+  bits          = _mm256_slli_epi64(_mm256_add_epi64(bits, _mm256_set1_epi64x(1023)), 52);
+  return _mm256_castsi256_pd(bits);
+}
+
+VM_AVX2 static inline __m256d vm_avx2_reduce(__m256d x, __m256d *r) {
+  __m256d shift = _mm256_set1_pd(VM_SHIFT);
+  __m256d k     = _mm256_sub_pd(_mm256_fmadd_pd(x, _mm256_set1_pd(VM_LOG2E), shift), shift);
+  *r            = _mm256_fnmadd_pd(k, _mm256_set1_pd(VM_LN2_HI), x);
+  *r            = _mm256_fnmadd_pd(k, _mm256_set1_pd(VM_LN2_LO), *r);
+  return k;
+}
+
+VM_AVX2 static inline __m256d vm_avx2_exp(__m256d x) {
+  __m256d nan = _mm256_cmp_pd(x, x, _CMP_UNORD_Q);
+  __m256d xc  = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(VM_EXP_MIN)), _mm256_set1_pd(VM_EXP_MAX));
+  __m256d r;
+  __m256d k  = vm_avx2_reduce(xc, &r);
+  __m256d p  = _mm256_add_pd(_mm256_set1_pd(1.0), vm_avx2_expm1_reduced(r));
+  __m256d kh = _mm256_round_pd(_mm256_mul_pd(k, _mm256_set1_pd(0.5)), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  __m256d y  = _mm256_mul_pd(_mm256_mul_pd(p, vm_avx2_pow2(kh)), vm_avx2_pow2(_mm256_sub_pd(k, kh)));
+  return _mm256_blendv_pd(y, x, nan);
+}
+
+VM_AVX2 static inline __m256d vm_avx2_expm1(__m256d x) {
+  // NaN and signed zeros pass through
+  __m256d pass = _mm256_or_pd(_mm256_cmp_pd(x, x, _CMP_UNORD_Q), _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_EQ_OQ));
+  __m256d xc   = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(VM_EXPM1_MIN)), _mm256_set1_pd(VM_EXP_MAX));
+  __m256d r;
+  __m256d k = vm_avx2_reduce(xc, &r);
+  __m256d h = vm_avx2_pow2(_mm256_sub_pd(k, _mm256_set1_pd(1.0)));
+  __m256d y = _mm256_fmadd_pd(h, vm_avx2_expm1_reduced(r), _mm256_sub_pd(h, _mm256_set1_pd(0.5)));
+  y         = _mm256_mul_pd(y, _mm256_set1_pd(2.0));
+  return _mm256_blendv_pd(y, x, pass);
+}
+
+VM_AVX2 static inline __m256d vm_avx2_sqrt(__m256d x) { return _mm256_sqrt_pd(x); }
+
+VM_AVX2 static inline __m256d vm_avx2_sigmoid(__m256d x) {
+  __m256d one = _mm256_set1_pd(1.0);
+  __m256d e   = vm_avx2_exp(_mm256_sub_pd(_mm256_setzero_pd(), x));
+  return _mm256_div_pd(one, _mm256_add_pd(one, e));
+}
+
+  // The tail goes through a padded copy, so every element of an array is
+  // computed by the same kernel
+  #define _VM_AVX2_GENERATOR(name, fn)                                                                                                             \
+    VM_AVX2 static void name(const double *vals, size_t count, double *out) {                                                                        \
+      size_t i = 0;                                                                                                                                  \
+      for (; i + 4 <= count; i += 4) {                                                                                                               \
+        _mm256_storeu_pd(out + i, fn(_mm256_loadu_pd(vals + i)));                                                                                    \
+      }                                                                                                                                              \
+      if (i < count) {                                                                                                                               \
+        double buf[4] = {0.0, 0.0, 0.0, 0.0};                                                                                                        \
+        memcpy(buf, vals + i, (count - i) * sizeof(double));                                                                                         \
+        _mm256_storeu_pd(buf, fn(_mm256_loadu_pd(buf)));                                                                                             \
+        memcpy(out + i, buf, (count - i) * sizeof(double));                                                                                          \
+      }                                                                                                                                              \
+    }
+
+  /* AVX2 single precision, 8 lanes */
+
+VM_AVX2 static inline __m256 vm_avx2_expm1f_reduced(__m256 r) {
+  __m256 p = _mm256_set1_ps((float)VM_C7);
+  p        = _mm256_fmadd_ps(p, r, _mm256_set1_ps((float)VM_C6));
+  p        = _mm256_fmadd_ps(p, r, _mm256_set1_ps((float)VM_C5));
+  p        = _mm256_fmadd_ps(p, r, _mm256_set1_ps((float)VM_C4));
+  p        = _mm256_fmadd_ps(p, r, _mm256_set1_ps((float)VM_C3));
+  p        = _mm256_fmadd_ps(p, r, _mm256_set1_ps((float)VM_C2));
+  return _mm256_fmadd_ps(_mm256_mul_ps(r, r), p, r);
+}
+
+VM_AVX2 static inline __m256 vm_avx2_pow2f(__m256 k) {
+  __m256  shift = _mm256_set1_ps(VMF_SHIFT);
+  __m256i bits  = _mm256_sub_epi32(_mm256_castps_si256(_mm256_add_ps(k, shift)), _mm256_castps_si256(shift));
+  bits          = _mm256_slli_epi32(_mm256_add_epi32(bits, _mm256_set1_epi32(127)), 23);
+  return _mm256_castsi256_ps(bits);
+}
+
+VM_AVX2 static inline __m256 vm_avx2_expf(__m256 x) {
+  __m256 nan   = _mm256_cmp_ps(x, x, _CMP_UNORD_Q);
+  __m256 xc    = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(VMF_EXP_MIN)), _mm256_set1_ps(VMF_EXP_MAX));
+  __m256 shift = _mm256_set1_ps(VMF_SHIFT);
+  __m256 k     = _mm256_sub_ps(_mm256_fmadd_ps(xc, _mm256_set1_ps(VMF_LOG2E), shift), shift);
+  __m256 r     = _mm256_fnmadd_ps(k, _mm256_set1_ps(VMF_LN2_HI), xc);
+  r            = _mm256_fnmadd_ps(k, _mm256_set1_ps(VMF_LN2_LO), r);
+  __m256 p     = _mm256_add_ps(_mm256_set1_ps(1.0f), vm_avx2_expm1f_reduced(r));
+  __m256 kh    = _mm256_round_ps(_mm256_mul_ps(k, _mm256_set1_ps(0.5f)), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  __m256 y     = _mm256_mul_ps(_mm256_mul_ps(p, vm_avx2_pow2f(kh)), vm_avx2_pow2f(_mm256_sub_ps(k, kh)));
+  return _mm256_blendv_ps(y, x, nan);
+}
+
+VM_AVX2 static inline __m256 vm_avx2_sqrtf(__m256 x) { return _mm256_sqrt_ps(x); }
+
+VM_AVX2 static inline __m256 vm_avx2_sigmoidf(__m256 x) {
+  __m256 one = _mm256_set1_ps(1.0f);
+  __m256 e   = vm_avx2_expf(_mm256_sub_ps(_mm256_setzero_ps(), x));
+  return _mm256_div_ps(one, _mm256_add_ps(one, e));
+}
+
+  #define _VM_AVX2_GENERATORF(name, fn)                                                                                                            \
+    VM_AVX2 static void name(const float *vals, size_t count, float *out) {                                                                          \
+      size_t i = 0;                                                                                                                                  \
+      for (; i + 8 <= count; i += 8) {                                                                                                               \
+        _mm256_storeu_ps(out + i, fn(_mm256_loadu_ps(vals + i)));                                                                                    \
+      }                                                                                                                                              \
+      if (i < count) {                                                                                                                               \
+        float buf[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};                                                                             \
+        memcpy(buf, vals + i, (count - i) * sizeof(float));                                                                                          \
+        _mm256_storeu_ps(buf, fn(_mm256_loadu_ps(buf)));                                                                                             \
+        memcpy(out + i, buf, (count - i) * sizeof(float));                                                                                           \
+      }                                                                                                                                              \
+    }
+
+_VM_AVX2_GENERATOR(vm_avx2_exp_array, vm_avx2_exp)
+_VM_AVX2_GENERATOR(vm_avx2_expm1_array, vm_avx2_expm1)
+_VM_AVX2_GENERATOR(vm_avx2_sqrt_array, vm_avx2_sqrt)
+_VM_AVX2_GENERATOR(vm_avx2_sigmoid_array, vm_avx2_sigmoid)
+_VM_AVX2_GENERATORF(vm_avx2_expf_array, vm_avx2_expf)
+_VM_AVX2_GENERATORF(vm_avx2_sqrtf_array, vm_avx2_sqrtf)
+_VM_AVX2_GENERATORF(vm_avx2_sigmoidf_array, vm_avx2_sigmoidf)
+
+static const vm_backend_t VM_AVX2_BACKEND = {
+  .id       = LION_VMATH_AVX2,
+  .exp      = &vm_avx2_exp_array,
+  .expm1    = &vm_avx2_expm1_array,
+  .sqrt     = &vm_avx2_sqrt_array,
+  .sigmoid  = &vm_avx2_sigmoid_array,
+  .expf     = &vm_avx2_expf_array,
+  .sqrtf    = &vm_avx2_sqrtf_array,
+  .sigmoidf = &vm_avx2_sigmoidf_array,
+};
+
+  /* AVX-512 backend, 8 lanes */
+
+  #define VM_AVX512 __attribute__((target("avx512f")))
+
+VM_AVX512 static inline __m512d vm_avx512_expm1_reduced(__m512d r) {
+  __m512d p = _mm512_set1_pd(VM_C13);
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C12));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C11));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C10));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C9));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C8));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C7));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C6));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C5));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C4));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C3));
+  p         = _mm512_fmadd_pd(p, r, _mm512_set1_pd(VM_C2));
+  return _mm512_fmadd_pd(_mm512_mul_pd(r, r), p, r);
+}
+
+VM_AVX512 static inline __m512d vm_avx512_reduce(__m512d x, __m512d *r) {
+  __m512d k = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(VM_LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  *r        = _mm512_fnmadd_pd(k, _mm512_set1_pd(VM_LN2_HI), x);
+  *r        = _mm512_fnmadd_pd(k, _mm512_set1_pd(VM_LN2_LO), *r);
+  return k;
+}
+
+VM_AVX512 static inline __m512d vm_avx512_exp(__m512d x) {
+  // scalef applies the power of two with a single rounding
+  __mmask8 nan = _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q);
+  __m512d  xc  = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(VM_EXP_MIN)), _mm512_set1_pd(VM_EXP_MAX));
+  __m512d  r;
+  __m512d  k = vm_avx512_reduce(xc, &r);
+  __m512d  p = _mm512_add_pd(_mm512_set1_pd(1.0), vm_avx512_expm1_reduced(r));
+  return _mm512_mask_blend_pd(nan, _mm512_scalef_pd(p, k), x);
+}
+
+VM_AVX512 static inline __m512d vm_avx512_expm1(__m512d x) {
+  // NaN and signed zeros pass through
+  __mmask8 pass = _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q) | _mm512_cmp_pd_mask(x, _mm512_setzero_pd(), _CMP_EQ_OQ);
+  __m512d  xc   = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(VM_EXPM1_MIN)), _mm512_set1_pd(VM_EXP_MAX));
+  __m512d  r;
+  __m512d  k = vm_avx512_reduce(xc, &r);
+  __m512d  h = _mm512_scalef_pd(_mm512_set1_pd(1.0), _mm512_sub_pd(k, _mm512_set1_pd(1.0)));
+  __m512d  y = _mm512_fmadd_pd(h, vm_avx512_expm1_reduced(r), _mm512_sub_pd(h, _mm512_set1_pd(0.5)));
+  y          = _mm512_mul_pd(y, _mm512_set1_pd(2.0));
+  return _mm512_mask_blend_pd(pass, y, x);
+}
+
+VM_AVX512 static inline __m512d vm_avx512_sqrt(__m512d x) { return _mm512_sqrt_pd(x); }
+
+VM_AVX512 static inline __m512d vm_avx512_sigmoid(__m512d x) {
+  __m512d one = _mm512_set1_pd(1.0);
+  __m512d e   = vm_avx512_exp(_mm512_sub_pd(_mm512_setzero_pd(), x));
+  return _mm512_div_pd(one, _mm512_add_pd(one, e));
+}
+
+  // Masked loads and stores handle the tail without reading past the arrays
+  #define _VM_AVX512_GENERATOR(name, fn)                                                                                                           \
+    VM_AVX512 static void name(const double *vals, size_t count, double *out) {                                                                      \
+      size_t i = 0;                                                                                                                                  \
+      for (; i + 8 <= count; i += 8) {                                                                                                               \
+        _mm512_storeu_pd(out + i, fn(_mm512_loadu_pd(vals + i)));                                                                                    \
+      }                                                                                                                                              \
+      if (i < count) {                                                                                                                               \
+        __mmask8 mask = (__mmask8)((1u << (count - i)) - 1u);                                                                                        \
+        _mm512_mask_storeu_pd(out + i, mask, fn(_mm512_maskz_loadu_pd(mask, vals + i)));                                                             \
+      }                                                                                                                                              \
+    }
+
+  /* AVX-512 single precision, 16 lanes */
+
+VM_AVX512 static inline __m512 vm_avx512_expm1f_reduced(__m512 r) {
+  __m512 p = _mm512_set1_ps((float)VM_C7);
+  p        = _mm512_fmadd_ps(p, r, _mm512_set1_ps((float)VM_C6));
+  p        = _mm512_fmadd_ps(p, r, _mm512_set1_ps((float)VM_C5));
+  p        = _mm512_fmadd_ps(p, r, _mm512_set1_ps((float)VM_C4));
+  p        = _mm512_fmadd_ps(p, r, _mm512_set1_ps((float)VM_C3));
+  p        = _mm512_fmadd_ps(p, r, _mm512_set1_ps((float)VM_C2));
+  return _mm512_fmadd_ps(_mm512_mul_ps(r, r), p, r);
+}
+
+VM_AVX512 static inline __m512 vm_avx512_expf(__m512 x) {
+  __mmask16 nan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+  __m512    xc  = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(VMF_EXP_MIN)), _mm512_set1_ps(VMF_EXP_MAX));
+  __m512    k   = _mm512_roundscale_ps(_mm512_mul_ps(xc, _mm512_set1_ps(VMF_LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m512    r   = _mm512_fnmadd_ps(k, _mm512_set1_ps(VMF_LN2_HI), xc);
+  r             = _mm512_fnmadd_ps(k, _mm512_set1_ps(VMF_LN2_LO), r);
+  __m512 p      = _mm512_add_ps(_mm512_set1_ps(1.0f), vm_avx512_expm1f_reduced(r));
+  return _mm512_mask_blend_ps(nan, _mm512_scalef_ps(p, k), x);
+}
+
+VM_AVX512 static inline __m512 vm_avx512_sqrtf(__m512 x) { return _mm512_sqrt_ps(x); }
+
+VM_AVX512 static inline __m512 vm_avx512_sigmoidf(__m512 x) {
+  __m512 one = _mm512_set1_ps(1.0f);
+  __m512 e   = vm_avx512_expf(_mm512_sub_ps(_mm512_setzero_ps(), x));
+  return _mm512_div_ps(one, _mm512_add_ps(one, e));
+}
+
+  #define _VM_AVX512_GENERATORF(name, fn)                                                                                                          \
+    VM_AVX512 static void name(const float *vals, size_t count, float *out) {                                                                        \
+      size_t i = 0;                                                                                                                                  \
+      for (; i + 16 <= count; i += 16) {                                                                                                             \
+        _mm512_storeu_ps(out + i, fn(_mm512_loadu_ps(vals + i)));                                                                                    \
+      }                                                                                                                                              \
+      if (i < count) {                                                                                                                               \
+        __mmask16 mask = (__mmask16)((1u << (count - i)) - 1u);                                                                                      \
+        _mm512_mask_storeu_ps(out + i, mask, fn(_mm512_maskz_loadu_ps(mask, vals + i)));                                                             \
+      }                                                                                                                                              \
+    }
+
+_VM_AVX512_GENERATOR(vm_avx512_exp_array, vm_avx512_exp)
+_VM_AVX512_GENERATOR(vm_avx512_expm1_array, vm_avx512_expm1)
+_VM_AVX512_GENERATOR(vm_avx512_sqrt_array, vm_avx512_sqrt)
+_VM_AVX512_GENERATOR(vm_avx512_sigmoid_array, vm_avx512_sigmoid)
+_VM_AVX512_GENERATORF(vm_avx512_expf_array, vm_avx512_expf)
+_VM_AVX512_GENERATORF(vm_avx512_sqrtf_array, vm_avx512_sqrtf)
+_VM_AVX512_GENERATORF(vm_avx512_sigmoidf_array, vm_avx512_sigmoidf)
+
+static const vm_backend_t VM_AVX512_BACKEND = {
+  .id       = LION_VMATH_AVX512,
+  .exp      = &vm_avx512_exp_array,
+  .expm1    = &vm_avx512_expm1_array,
+  .sqrt     = &vm_avx512_sqrt_array,
+  .sigmoid  = &vm_avx512_sigmoid_array,
+  .expf     = &vm_avx512_expf_array,
+  .sqrtf    = &vm_avx512_sqrtf_array,
+  .sigmoidf = &vm_avx512_sigmoidf_array,
+};
+
+#endif
+
+/* Runtime dispatch */
+
+static const vm_backend_t *vm_backend_find(lion_vmath_backend_t backend) {
+#ifdef LION_VMATH_X86
+  __builtin_cpu_init();
+  switch (backend) {
+  case LION_VMATH_AVX512:
+    return __builtin_cpu_supports("avx512f") ? &VM_AVX512_BACKEND : NULL;
+  case LION_VMATH_AVX2:
+    return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? &VM_AVX2_BACKEND : NULL;
+  default:
+    break;
+  }
+#endif
+  return (backend == LION_VMATH_SCALAR) ? &VM_SCALAR : NULL;
+}
+
+static const vm_backend_t *vm_backend_best(void) {
+  const lion_vmath_backend_t order[] = {LION_VMATH_AVX512, LION_VMATH_AVX2, LION_VMATH_SCALAR};
+  for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+    const vm_backend_t *found = vm_backend_find(order[i]);
+    if (found != NULL) {
+      return found;
+    }
+  }
+  return &VM_SCALAR;
+}
+
+// Chosen on first use, racing threads pick the same backend
+static const vm_backend_t *vm_active = NULL;
+
+#if defined(__GNUC__) || defined(__clang__)
+  #define VM_LOAD(p)     __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+  #define VM_STORE(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#else
+  #define VM_LOAD(p)     (p)
+  #define VM_STORE(p, v) ((p) = (v))
+#endif
+
+static const vm_backend_t *vm_backend(void) {
+  const vm_backend_t *active = VM_LOAD(vm_active);
+  if (active == NULL) {
+    active = vm_backend_best();
+    VM_STORE(vm_active, active);
+  }
+  return active;
+}
+
+void lion_vexp(const double *vals, size_t count, double *out) { vm_backend()->exp(vals, count, out); }
+void lion_vexpm1(const double *vals, size_t count, double *out) { vm_backend()->expm1(vals, count, out); }
+void lion_vsqrt(const double *vals, size_t count, double *out) { vm_backend()->sqrt(vals, count, out); }
+void lion_vsigmoid(const double *vals, size_t count, double *out) { vm_backend()->sigmoid(vals, count, out); }
+void lion_vexpf(const float *vals, size_t count, float *out) { vm_backend()->expf(vals, count, out); }
+void lion_vsqrtf(const float *vals, size_t count, float *out) { vm_backend()->sqrtf(vals, count, out); }
+void lion_vsigmoidf(const float *vals, size_t count, float *out) { vm_backend()->sigmoidf(vals, count, out); }
+
+lion_vmath_backend_t lion_vmath_backend(void) { return vm_backend()->id; }
+
+const char *lion_vmath_backend_name(lion_vmath_backend_t backend) {
+  switch (backend) {
+  case LION_VMATH_AUTO:
+    return "LION_VMATH_AUTO";
+  case LION_VMATH_SCALAR:
+    return "LION_VMATH_SCALAR";
+  case LION_VMATH_AVX2:
+    return "LION_VMATH_AVX2";
+  case LION_VMATH_AVX512:
+    return "LION_VMATH_AVX512";
+  default:
+    return "N/A";
+  }
+}
+
+int lion_vmath_set_backend(lion_vmath_backend_t backend) {
+  const vm_backend_t *found = (backend == LION_VMATH_AUTO) ? vm_backend_best() : vm_backend_find(backend);
+  if (found == NULL) {
+    return 0;
+  }
+  VM_STORE(vm_active, found);
+  return 1;
+}
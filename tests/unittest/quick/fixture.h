@@ -0,0 +1,23 @@
+#pragma once
+#include <lion/lion.h>
+#include <lionu/log.h>
+
+/* Shared setup of the quick tests */
+
+// Configuration of the tests, with one second steps and the current solved to
+// convergence. Nothing is logged to file, so the tests leave no logs behind
+static inline lion_sim_config_t test_config(void) {
+  lion_sim_config_t conf = lion_sim_config_default();
+  conf.log_dir           = NULL;
+  conf.log_stdlvl        = LOG_INFO;
+  conf.sim_min_maxiter   = 100;
+  conf.sim_step_seconds  = 1.0;
+  return conf;
+}
+
+// Default parameters of the cell, starting at `soc`
+static inline lion_params_t test_params(double soc) {
+  lion_params_t params = lion_params_default();
+  params.init.soc      = soc;
+  return params;
+}
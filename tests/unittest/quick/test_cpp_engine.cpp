@@ -0,0 +1,86 @@
+#include "fixture.h"
+
+#include <cmath>
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionpp/engine.hpp>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+
+#define STEPS 1800
+
+using Engine = lion::Engine<lion::rint::Fixed, lion::soh::Vendor, lion::stepper::RK4>;
+
+// Discharge pulses with rests in between
+static double power_at(int i) { return ((i / 300) % 3 == 2) ? 0.0 : 4.0 + 2.0 * std::sin(static_cast<double>(i) / 50.0); }
+
+lion_status_t test_engine_matches_sim(void) {
+  // The engine follows lion_sim_step with the same stepper, up to the current
+  // solved in closed form instead of with the minimizer
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+  conf.sim_stepper         = LION_STEPPER_NATIVE_RK4;
+  conf.sim_epsabs          = 1e-12;
+  conf.sim_epsrel          = 1e-12;
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  Engine engine = Engine::from(conf, params);
+
+  double max_soc = 0.0, max_temp = 0.0, max_voltage = 0.0;
+  for (int i = 1; i <= STEPS; i++) {
+    double ambient = 298.0 + 3.0 * std::sin(static_cast<double>(i) / 600.0);
+    LION_CALL(lion_sim_step(&sim, power_at(i), ambient), "Failed stepping sim");
+    LION_ASSERT(engine.step(power_at(i), ambient) == lion::Status::SUCCESS);
+
+    lion_sim_state_t const &s = engine.state();
+    max_soc                   = std::fmax(max_soc, std::fabs(s._next_soc_nominal - sim.state._next_soc_nominal));
+    max_temp                  = std::fmax(max_temp, std::fabs(s._next_internal_temperature - sim.state._next_internal_temperature));
+    if (power_at(i) != 0.0) {
+      // At rest lion_sim_step takes the power over the current left by the
+      // minimizer, while the engine reports the open circuit voltage
+      max_voltage = std::fmax(max_voltage, std::fabs(s.voltage - sim.state.voltage));
+    }
+  }
+  log_debug("Engine against sim: soc %e, temperature %e, voltage %e", max_soc, max_temp, max_voltage);
+  LION_ASSERT(max_soc < 1e-10);
+  LION_ASSERT(max_temp < 1e-8);
+  LION_ASSERT(max_voltage < 1e-8);
+  LION_ASSERT_EQI(static_cast<int>(engine.state().step), static_cast<int>(sim.state.step));
+  LION_ASSERT(std::fabs(engine.state().time - sim.state.time) < 1e-9);
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_engine_failures(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  // Past the maximum power point the current stays at the point
+  Engine engine = Engine::from(conf, params);
+  LION_ASSERT(engine.step(1e6, 298.0) == lion::Status::SUCCESS);
+  lion_sim_state_t const &s = engine.state();
+  double                  r = params.rint.params.fixed.internal_resistance;
+  LION_ASSERT(std::fabs(s.current - s.open_circuit_voltage / (2.0 * r)) < 1e-9);
+
+  // States that are not finite fail the step and leave the state untouched
+  engine.reset();
+  LION_ASSERT(engine.step(4.0, 298.0) == lion::Status::SUCCESS);
+  lion_sim_state_t before    = engine.state();
+  auto             unchanged = [&]() {
+    return s.step == before.step && s.time == before.time && s.power == before.power && s.current == before.current &&
+           s._next_soc_nominal == before._next_soc_nominal && s._next_internal_temperature == before._next_internal_temperature;
+  };
+  LION_ASSERT(engine.step(4.0, NAN) == lion::Status::FAILURE);
+  LION_ASSERT(unchanged());
+  LION_ASSERT(engine.step(NAN, 298.0) == lion::Status::FAILURE);
+  LION_ASSERT(unchanged());
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  LION_CALL(test_engine_matches_sim(), "Failed matching lion_sim_step");
+  LION_CALL(test_engine_failures(), "Failed propagating failures");
+  return TEST_PASS;
+}
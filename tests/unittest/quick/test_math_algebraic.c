@@ -1,5 +1,129 @@
+#include "fixture.h"
+
 // TODO: Add tests for algebraic equations
 
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_min.h>
+#include <lion/lion.h>
+#include <lion_math/lion_math.h>
 #include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#define CELLS 37
+
+typedef struct current_case {
+  lion_params_t      *params;
+  gsl_min_fminimizer *s;
+} current_case_t;
+
+static void fill_cells(lion_params_t *params, double power[], double soc[], double voc[], double guess[]) {
+  // Cells spread over the state of charge, charging and discharging
+  for (size_t c = 0; c < CELLS; c++) {
+    soc[c]   = 0.1 + 0.85 * (double)c / (CELLS - 1);
+    power[c] = 20.0 * sin(0.7 * (double)c);
+    voc[c]   = lion_voc(soc[c], params);
+    guess[c] = 0.0;
+  }
+}
+
+static lion_status_t check_lanes(current_case_t *cc, const double guess[]) {
+  double power[CELLS], soc[CELLS], voc[CELLS], ignored[CELLS], current[CELLS];
+  fill_cells(cc->params, power, soc, voc, ignored);
+  for (size_t c = 0; c < CELLS; c++) {
+    current[c] = guess[c];
+  }
+  size_t fallbacks;
+  int    status = lion_current_solve_lanes(cc->s, CELLS, power, soc, voc, 1e-10, 1e-10, 100, cc->params, current, &fallbacks);
+  LION_ASSERT_EQI(status, GSL_SUCCESS);
+  log_debug("Solved %d cells with %zu fallbacks", CELLS, fallbacks);
+
+  // Every current delivers its power and matches the scalar solver
+  for (size_t c = 0; c < CELLS; c++) {
+    double r        = lion_resistance(soc[c], current[c], 1.0, cc->params);
+    double expected = lion_current_optimize(cc->s, power[c], soc[c], voc[c], 0.0, 1e-10, 1e-10, 200, cc->params);
+    LION_ASSERT(fabs((voc[c] - r * current[c]) * current[c] - power[c]) < 1e-6);
+    LION_ASSERT(fabs(current[c] - expected) < 1e-5);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_current_lanes_slope(current_case_t *cc) {
+  // The derivative of the resistance matches a scalar central difference
+  double power[CELLS], soc[CELLS], voc[CELLS], guess[CELLS];
+  fill_cells(cc->params, power, soc, voc, guess);
+  for (size_t first = 0; first < CELLS; first += LION_CURRENT_LANES) {
+    size_t lanes = (CELLS - first < LION_CURRENT_LANES) ? CELLS - first : LION_CURRENT_LANES;
+    double current[LION_CURRENT_LANES], r[LION_CURRENT_LANES], dr[LION_CURRENT_LANES];
+    for (size_t i = 0; i < lanes; i++) {
+      current[i] = power[first + i] / voc[first + i];
+    }
+    lion_current_resistance_lanes(lanes, &soc[first], current, cc->params, r, dr);
+    for (size_t i = 0; i < lanes; i++) {
+      double h        = 1e-4 * fmax(fabs(current[i]), 1.0);
+      double r_plus   = lion_resistance(soc[first + i], current[i] + h, 1.0, cc->params);
+      double r_minus  = lion_resistance(soc[first + i], current[i] - h, 1.0, cc->params);
+      double expected = (r_plus - r_minus) / (2.0 * h);
+      LION_ASSERT(fabs(r[i] - lion_resistance(soc[first + i], current[i], 1.0, cc->params)) < 1e-12);
+      LION_ASSERT(fabs(dr[i] - expected) < 1e-6 * fmax(fabs(expected), 1e-3));
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_current_lanes(current_case_t *cc) {
+  double power[CELLS], soc[CELLS], voc[CELLS], guess[CELLS];
+  fill_cells(cc->params, power, soc, voc, guess);
+  return check_lanes(cc, guess);
+}
+
+lion_status_t test_current_lanes_fallback(current_case_t *cc) {
+  // Guesses past the maximum power point make their lanes diverge, and the
+  // bracketing minimizer recovers them
+  double power[CELLS], soc[CELLS], voc[CELLS], guess[CELLS];
+  fill_cells(cc->params, power, soc, voc, guess);
+  for (size_t c = 0; c < CELLS; c += 5) {
+    guess[c] = 500.0;
+  }
+  LION_CALL(check_lanes(cc, guess), "Fallback lanes did not converge");
+
+  double current[CELLS];
+  size_t fallbacks;
+  for (size_t c = 0; c < CELLS; c++) {
+    current[c] = guess[c];
+  }
+  LION_ASSERT_EQI(lion_current_solve_lanes(cc->s, CELLS, power, soc, voc, 1e-10, 1e-10, 100, cc->params, current, &fallbacks), GSL_SUCCESS);
+  LION_ASSERT(fallbacks > 0);
+
+  log_debug("Checking lanes keep their guess without a minimizer");
+  for (size_t c = 0; c < CELLS; c++) {
+    current[c] = guess[c];
+  }
+  LION_ASSERT_NEI(lion_current_solve_lanes(NULL, CELLS, power, soc, voc, 1e-10, 1e-10, 100, cc->params, current, &fallbacks), GSL_SUCCESS);
+  LION_ASSERT_EQF(current[0], 500.0);
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = lion_params_default();
+  lion_sim_t        sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  current_case_t cc = {.params = sim.params, .s = sim.sys_min};
+
+  LION_CALL_TEST(&cc, test_current_lanes);
+  LION_CALL_TEST(&cc, test_current_lanes_fallback);
+
+  log_info("Repeating with the polarization resistance");
+  sim.params->rint.model               = LION_RINT_MODEL_POLARIZATION;
+  sim.params->rint.params.polarization = lion_params_default_rint_polarization();
+  LION_CALL_TEST(&cc, test_current_lanes_slope);
+  LION_CALL_TEST(&cc, test_current_lanes);
+  LION_CALL_TEST(&cc, test_current_lanes_fallback);
 
-int main() { return TEST_PASS; }
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
@@ -1,3 +1,5 @@
+#include "fixture.h"
+
 #include <lion/lion.h>
 #include <lion_utils/test.h>
 #include <lionu/log.h>
@@ -13,8 +15,7 @@ lion_status_t test_current(lion_sim_t *sim) {
 }
 
 lion_status_t setup_test(lion_sim_t *sim) {
-  lion_sim_config_t conf = lion_sim_config_default();
-  conf.log_dir           = "logs";
+  lion_sim_config_t conf = test_config();
   conf.log_stdlvl        = LOG_DEBUG;
 
   lion_params_t params = lion_params_default();
@@ -0,0 +1,282 @@
+#include <lion/lion.h>
+#include <lion_math/lion_math.h>
+#include <lion_utils/test.h>
+#include <lionu/fuzzy.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <lionu/vmath.h>
+#include <math.h>
+#include <stddef.h>
+
+#define SAMPLES 100003
+#define CELLS   37
+
+static double samples[SAMPLES];
+static double results[SAMPLES];
+static float  samplesf[SAMPLES];
+static float  resultsf[SAMPLES];
+
+// Distance to the reference in units in the last place of the rounded reference
+static double ulp_error(double value, long double reference) {
+  double rounded = (double)reference;
+  if (isnan(rounded) || isinf(rounded)) {
+    return (value == rounded || (isnan(value) && isnan(rounded))) ? 0.0 : INFINITY;
+  }
+  double ulp = nextafter(fabs(rounded), INFINITY) - fabs(rounded);
+  return (double)(fabsl((long double)value - reference) / ulp);
+}
+
+static double ulp_errorf(float value, long double reference) {
+  float rounded = (float)reference;
+  if (isnan(rounded) || isinf(rounded)) {
+    return (value == rounded || (isnan(value) && isnan(rounded))) ? 0.0 : INFINITY;
+  }
+  float ulp = nextafterf(fabsf(rounded), INFINITY) - fabsf(rounded);
+  return (double)(fabsl((long double)value - reference) / ulp);
+}
+
+static void fill_samples(double low, double high) {
+  for (size_t i = 0; i < SAMPLES; i++) {
+    samples[i]  = low + (high - low) * (double)i / (SAMPLES - 1);
+    samplesf[i] = (float)samples[i];
+  }
+}
+
+static lion_status_t check_bound(const char *name, void (*fn)(const double *, size_t, double *), long double (*reference)(long double), double bound) {
+  fn(samples, SAMPLES, results);
+  double worst = 0.0;
+  for (size_t i = 0; i < SAMPLES; i++) {
+    worst = fmax(worst, ulp_error(results[i], reference(samples[i])));
+  }
+  log_info(" * %-8s max error = %.3f ULP (bound %.1f)", name, worst, bound);
+  LION_ASSERT(worst <= bound);
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t check_boundf(const char *name, void (*fn)(const float *, size_t, float *), long double (*reference)(long double), double bound) {
+  fn(samplesf, SAMPLES, resultsf);
+  double worst = 0.0;
+  for (size_t i = 0; i < SAMPLES; i++) {
+    worst = fmax(worst, ulp_errorf(resultsf[i], reference(samplesf[i])));
+  }
+  log_info(" * %-8s max error = %.3f ULP (bound %.1f)", name, worst, bound);
+  LION_ASSERT(worst <= bound);
+  return LION_STATUS_SUCCESS;
+}
+
+static long double sigmoidl(long double x) { return 1.0L / (1.0L + expl(-x)); }
+
+static lion_status_t check_backend(void) {
+  fill_samples(-745.0, 709.7);
+  LION_CALL(check_bound("exp", &lion_vexp, &expl, 1.0), "exp is out of its bound");
+  fill_samples(-40.0, 40.0);
+  LION_CALL(check_bound("exp", &lion_vexp, &expl, 1.0), "exp is out of its bound near zero");
+  LION_CALL(check_bound("expm1", &lion_vexpm1, &expm1l, 2.0), "expm1 is out of its bound");
+  LION_CALL(check_bound("sigmoid", &lion_vsigmoid, &sigmoidl, 3.0), "sigmoid is out of its bound");
+  fill_samples(-1e-3, 1e-3);
+  LION_CALL(check_bound("expm1", &lion_vexpm1, &expm1l, 2.0), "expm1 is out of its bound near zero");
+  fill_samples(0.0, 1e6);
+  // Half a ULP, with room for the rounding of the reference itself
+  LION_CALL(check_bound("sqrt", &lion_vsqrt, &sqrtl, 0.5 + 1e-6), "sqrt is not correctly rounded");
+  LION_CALL(check_boundf("sqrtf", &lion_vsqrtf, &sqrtl, 0.5 + 1e-6), "sqrtf is not correctly rounded");
+  fill_samples(-103.0, 88.7);
+  LION_CALL(check_boundf("expf", &lion_vexpf, &expl, 1.5), "expf is out of its bound");
+  fill_samples(-20.0, 20.0);
+  LION_CALL(check_boundf("expf", &lion_vexpf, &expl, 1.5), "expf is out of its bound near zero");
+  LION_CALL(check_boundf("sigmoidf", &lion_vsigmoidf, &sigmoidl, 3.0), "sigmoidf is out of its bound");
+
+  // Special values, with an odd count to go through the tail
+  double special[7] = {NAN, INFINITY, -INFINITY, 710.0, -746.0, 0.0, -0.0};
+  double out[7];
+  lion_vexp(special, 7, out);
+  LION_ASSERT(isnan(out[0]));
+  LION_ASSERT(isinf(out[1]) && out[1] > 0.0);
+  LION_ASSERT_EQF(out[2], 0.0);
+  LION_ASSERT(isinf(out[3]));
+  LION_ASSERT_EQF(out[4], 0.0);
+  LION_ASSERT_EQF(out[5], 1.0);
+  lion_vexpm1(special, 7, out);
+  LION_ASSERT(isnan(out[0]));
+  LION_ASSERT_EQF(out[2], -1.0);
+  LION_ASSERT(signbit(out[6]));
+
+  float specialf[7] = {NAN, INFINITY, -INFINITY, 89.0f, -105.0f, 0.0f, -0.0f};
+  float outf[7];
+  lion_vexpf(specialf, 7, outf);
+  LION_ASSERT(isnan(outf[0]));
+  LION_ASSERT(isinf(outf[1]) && outf[1] > 0.0f);
+  LION_ASSERT_EQF(outf[2], 0.0f);
+  LION_ASSERT(isinf(outf[3]));
+  LION_ASSERT_EQF(outf[4], 0.0f);
+  LION_ASSERT_EQF(outf[5], 1.0f);
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t assert_close(const char *name, const double batch[], const double scalar[]) {
+  for (size_t c = 0; c < CELLS; c++) {
+    if (fabs(batch[c] - scalar[c]) > 1e-13 * fmax(fabs(scalar[c]), 1.0)) {
+      log_error("Batched %s differs at cell %zu (%.17g, expected %.17g)", name, c, batch[c], scalar[c]);
+      return LION_STATUS_FAILURE;
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_vmath_backends(lion_params_t *params) {
+  const lion_vmath_backend_t backends[] = {LION_VMATH_SCALAR, LION_VMATH_AVX2, LION_VMATH_AVX512};
+  for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+    if (!lion_vmath_set_backend(backends[b])) {
+      log_info("Skipping %s, not supported by this CPU", lion_vmath_backend_name(backends[b]));
+      continue;
+    }
+    log_info("Checking %s", lion_vmath_backend_name(lion_vmath_backend()));
+    LION_VCALL(check_backend(), "Backend %s failed", lion_vmath_backend_name(backends[b]));
+  }
+  LION_ASSERT(lion_vmath_set_backend(LION_VMATH_AUTO));
+  LION_ASSERT_NEI(lion_vmath_backend(), LION_VMATH_AUTO);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_vmath_batches(lion_params_t *params) {
+  // Every batched function matches its scalar version
+  double soc[CELLS], temp[CELLS], amb[CELLS], current[CELLS], power[CELLS], soh[CELLS], capacity[CELLS];
+  double voc[CELLS], res[CELLS], ehc[CELLS], kappa[CELLS], batch[CELLS], scalar[CELLS];
+  for (size_t c = 0; c < CELLS; c++) {
+    soc[c]      = 0.05 + 0.9 * (double)c / (CELLS - 1);
+    temp[c]     = 280.0 + (double)c;
+    amb[c]      = 298.0 - 0.5 * (double)c;
+    current[c]  = -20.0 + 40.0 * (double)c / (CELLS - 1);
+    power[c]    = 10.0 * sin((double)c);
+    soh[c]      = 1.0 - 0.005 * (double)c;
+    capacity[c] = 3600.0 * (1.0 + 0.01 * (double)c);
+    voc[c]      = lion_voc(soc[c], params);
+    ehc[c]      = lion_ehc(soc[c], params);
+    kappa[c]    = lion_kappa(temp[c], params);
+    res[c]      = lion_resistance(soc[c], current[c], soh[c], params);
+  }
+
+#define CHECK_BATCH(name, call, expected)                                                                                                            \
+  call;                                                                                                                                              \
+  for (size_t c = 0; c < CELLS; c++) {                                                                                                               \
+    scalar[c] = expected;                                                                                                                            \
+  }                                                                                                                                                  \
+  LION_CALL(assert_close(name, batch, scalar), "Batched " name " does not match")
+
+  CHECK_BATCH("voc", lion_voc_batch(soc, CELLS, params, batch), lion_voc(soc[c], params));
+  CHECK_BATCH("voc_grad", lion_voc_grad_batch(soc, CELLS, params, batch), lion_voc_grad(soc[c], params));
+  CHECK_BATCH("ehc", lion_ehc_batch(soc, CELLS, params, batch), lion_ehc(soc[c], params));
+  CHECK_BATCH("kappa", lion_kappa_batch(temp, CELLS, params, batch), lion_kappa(temp[c], params));
+  CHECK_BATCH("kappa_grad", lion_kappa_grad_batch(temp, CELLS, params, batch), lion_kappa_grad(temp[c], params));
+  CHECK_BATCH("soc_usable", lion_soc_usable_batch(soc, kappa, CELLS, params, batch), lion_soc_usable(soc[c], kappa[c], params));
+  CHECK_BATCH(
+      "capacity_usable", lion_capacity_usable_batch(capacity, kappa, CELLS, params, batch), lion_capacity_usable(capacity[c], kappa[c], params)
+  );
+  CHECK_BATCH(
+      "capacity_nominal", lion_capacity_nominal_batch(capacity, soh, CELLS, params, batch), lion_capacity_nominal(capacity[c], soh[c], params)
+  );
+  CHECK_BATCH(
+      "generated_heat",
+      lion_generated_heat_batch(current, temp, res, ehc, CELLS, params, batch),
+      lion_generated_heat(current[c], temp[c], res[c], ehc[c], params)
+  );
+  CHECK_BATCH("current", lion_current_batch(power, voc, res, CELLS, params, batch), lion_current(power[c], voc[c], res[c], params));
+  CHECK_BATCH(
+      "current_grad_voc", lion_current_grad_voc_batch(power, voc, res, CELLS, params, batch), lion_current_grad_voc(power[c], voc[c], res[c], params)
+  );
+  CHECK_BATCH("voltage", lion_voltage_batch(power, voc, res, CELLS, params, batch), lion_voltage(power[c], voc[c], res[c], params));
+  CHECK_BATCH("soc_d", lion_soc_d_batch(current, capacity, CELLS, params, batch), lion_soc_d(current[c], capacity[c], params));
+  CHECK_BATCH(
+      "internal_temperature_d",
+      lion_internal_temperature_d_batch(temp, power, amb, CELLS, params, batch),
+      lion_internal_temperature_d(temp[c], power[c], amb[c], params)
+  );
+  CHECK_BATCH(
+      "surface_temperature", lion_surface_temperature_batch(temp, amb, CELLS, params, batch), lion_surface_temperature(temp[c], amb[c], params)
+  );
+  CHECK_BATCH("resistance", lion_resistance_batch(soc, current, soh, CELLS, params, batch), lion_resistance(soc[c], current[c], soh[c], params));
+
+  log_debug("Checking the polarization resistance");
+  lion_params_t polarization            = *params;
+  polarization.rint.model               = LION_RINT_MODEL_POLARIZATION;
+  polarization.rint.params.polarization = lion_params_default_rint_polarization();
+  CHECK_BATCH(
+      "polarization resistance",
+      lion_resistance_batch(soc, current, soh, CELLS, &polarization, batch),
+      lion_resistance(soc[c], current[c], soh[c], &polarization)
+  );
+  lion_params_rint_polarization_t *p = &polarization.rint.params.polarization;
+  CHECK_BATCH("sigmoid membership", lion_mf_sigmoid_batch(current, CELLS, &p->c40, batch), lion_mf_sigmoid(current[c], &p->c40));
+  CHECK_BATCH("gaussian membership", lion_mf_gaussian_batch(current, CELLS, &p->d10, batch), lion_mf_gaussian(current[c], &p->d10));
+#undef CHECK_BATCH
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t assert_closef(const char *name, const float batch[], const double scalar[]) {
+  for (size_t c = 0; c < CELLS; c++) {
+    if (fabs((double)batch[c] - scalar[c]) > 1e-5 * fmax(fabs(scalar[c]), 1.0)) {
+      log_error("Single precision %s differs at cell %zu (%.9g, expected %.17g)", name, c, batch[c], scalar[c]);
+      return LION_STATUS_FAILURE;
+    }
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_vmath_batches_f(lion_params_t *params) {
+  // Every single precision batch stays close to the double precision scalar version
+  float  soc[CELLS], temp[CELLS], current[CELLS], power[CELLS], soh[CELLS];
+  float  voc[CELLS], res[CELLS], ehc[CELLS], batch[CELLS];
+  double scalar[CELLS];
+  for (size_t c = 0; c < CELLS; c++) {
+    soc[c]     = 0.05f + 0.9f * (float)c / (CELLS - 1);
+    temp[c]    = 280.0f + (float)c;
+    current[c] = -20.0f + 40.0f * (float)c / (CELLS - 1);
+    power[c]   = 10.0f * sinf((float)c);
+    soh[c]     = 1.0f - 0.005f * (float)c;
+    voc[c]     = (float)lion_voc(soc[c], params);
+    ehc[c]     = (float)lion_ehc(soc[c], params);
+    res[c]     = (float)lion_resistance(soc[c], current[c], soh[c], params);
+  }
+
+#define CHECK_BATCH_F(name, call, expected)                                                                                                          \
+  call;                                                                                                                                              \
+  for (size_t c = 0; c < CELLS; c++) {                                                                                                               \
+    scalar[c] = expected;                                                                                                                            \
+  }                                                                                                                                                  \
+  LION_CALL(assert_closef(name, batch, scalar), "Single precision " name " does not match")
+
+  CHECK_BATCH_F("voc", lion_voc_batch_f(soc, CELLS, params, batch), lion_voc(soc[c], params));
+  CHECK_BATCH_F("ehc", lion_ehc_batch_f(soc, CELLS, params, batch), lion_ehc(soc[c], params));
+  CHECK_BATCH_F("kappa", lion_kappa_batch_f(temp, CELLS, params, batch), lion_kappa(temp[c], params));
+  CHECK_BATCH_F(
+      "generated_heat",
+      lion_generated_heat_batch_f(current, temp, res, ehc, CELLS, params, batch),
+      lion_generated_heat(current[c], temp[c], res[c], ehc[c], params)
+  );
+  CHECK_BATCH_F("current", lion_current_batch_f(power, voc, res, CELLS, params, batch), lion_current(power[c], voc[c], res[c], params));
+  CHECK_BATCH_F("resistance", lion_resistance_batch_f(soc, current, soh, CELLS, params, batch), lion_resistance(soc[c], current[c], soh[c], params));
+
+  log_debug("Checking the single precision polarization resistance");
+  lion_params_t polarization            = *params;
+  polarization.rint.model               = LION_RINT_MODEL_POLARIZATION;
+  polarization.rint.params.polarization = lion_params_default_rint_polarization();
+  CHECK_BATCH_F(
+      "polarization resistance",
+      lion_resistance_batch_f(soc, current, soh, CELLS, &polarization, batch),
+      lion_resistance(soc[c], current[c], soh[c], &polarization)
+  );
+  lion_params_rint_polarization_t *p = &polarization.rint.params.polarization;
+  CHECK_BATCH_F("sigmoid membership", lion_mf_sigmoid_batch_f(current, CELLS, &p->c40, batch), lion_mf_sigmoid(current[c], &p->c40));
+  CHECK_BATCH_F("gaussian membership", lion_mf_gaussian_batch_f(current, CELLS, &p->d10, batch), lion_mf_gaussian(current[c], &p->d10));
+#undef CHECK_BATCH_F
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_params_t params = lion_params_default();
+  log_set_level(LOG_INFO);
+
+  LION_CALL_TEST(&params, test_vmath_backends);
+  LION_CALL_TEST(&params, test_vmath_batches);
+  LION_CALL_TEST(&params, test_vmath_batches_f);
+  return TEST_PASS;
+}
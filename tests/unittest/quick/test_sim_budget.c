@@ -0,0 +1,105 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#define STEPS 100
+#define POWER 6.0
+
+static lion_status_t budget_sim(lion_sim_t *sim, uint64_t current_budget, uint64_t ode_budget, lion_sim_config_t *conf, lion_sim_t *out) {
+  *conf                    = *sim->conf;
+  conf->sim_current_budget = current_budget;
+  conf->sim_ode_budget     = ode_budget;
+  LION_CALL(lion_sim_new(conf, sim->params, out), "Failed creating budget simulation");
+  LION_CALL(lion_sim_init(out), "Failed initializing budget simulation");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_budget_unbounded(lion_sim_t *sim) {
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, POWER, 298.0), "Failed stepping simulation");
+    LION_ASSERT_EQI((int)sim->state.step_flags, 0);
+    LION_ASSERT(sim->state.step_evaluations > 0);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_budget_current(lion_sim_t *sim) {
+  lion_sim_config_t conf;
+  lion_sim_t        bounded;
+  LION_CALL(budget_sim(sim, 2, 0, &conf, &bounded), "Failed creating budget simulation");
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+
+  // With a fixed internal resistance the one-shot estimate is exact
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, POWER, 298.0), "Failed stepping simulation");
+    LION_CALL(lion_sim_step(&bounded, POWER, 298.0), "Failed stepping bounded simulation");
+    LION_ASSERT(bounded.state.step_flags & LION_STEP_CURRENT_UNCONVERGED);
+    LION_ASSERT(bounded.state.step_flags & LION_STEP_CURRENT_ANALYTIC);
+    LION_ASSERT(fabs(bounded.state.current - sim->state.current) < 1e-6);
+  }
+
+  log_debug("Checking the current is held when the estimate has no solution");
+  double previous = bounded.state.current;
+  LION_CALL(lion_sim_step(&bounded, 1e4, 298.0), "Failed stepping bounded simulation");
+  LION_ASSERT(bounded.state.step_flags & LION_STEP_CURRENT_HOLD);
+  LION_ASSERT_EQF(bounded.state.current, previous);
+  LION_CALL(lion_sim_cleanup(&bounded), "Failed cleaning up bounded simulation");
+
+  log_debug("Checking a budget too small to set up the optimizer is not exceeded");
+  LION_CALL(budget_sim(sim, 2, 2, &conf, &bounded), "Failed creating budget simulation");
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(&bounded, POWER, 298.0), "Failed stepping bounded simulation");
+    // Budget of each stage plus one evaluation for each fallback
+    LION_ASSERT(bounded.state.step_evaluations <= 2 + 1 + 2 + 1);
+  }
+  LION_CALL(lion_sim_cleanup(&bounded), "Failed cleaning up bounded simulation");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_budget_ode(lion_sim_t *sim) {
+  lion_sim_config_t conf;
+  lion_sim_t        bounded;
+  LION_CALL(budget_sim(sim, 10, 2, &conf, &bounded), "Failed creating budget simulation");
+
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(&bounded, POWER, 298.0), "Failed stepping bounded simulation");
+    LION_ASSERT(bounded.state.step_flags & LION_STEP_ODE_FALLBACK);
+    // Budget of each stage plus one evaluation for each fallback
+    LION_ASSERT(bounded.state.step_evaluations <= 10 + 1 + 2 + 1);
+  }
+  LION_ASSERT(fabs(bounded.state.time - (STEPS - 1) * conf.sim_step_seconds) < 1e-9);
+
+  // The Euler fallback stays close to the full stepper over a short run
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, POWER, 298.0), "Failed stepping simulation");
+  }
+  log_info("SoC = %f (full) vs %f (fallback)", sim->state._next_soc_nominal, bounded.state._next_soc_nominal);
+  LION_ASSERT(fabs(bounded.state._next_soc_nominal - sim->state._next_soc_nominal) < 1e-4);
+  LION_ASSERT(fabs(bounded.state._next_internal_temperature - sim->state._next_internal_temperature) < 1e-2);
+
+  LION_CALL(lion_sim_cleanup(&bounded), "Failed cleaning up bounded simulation");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_budget_unbounded);
+  LION_CALL_TEST(&sim, test_budget_current);
+  LION_CALL_TEST(&sim, test_budget_ode);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
@@ -0,0 +1,131 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+
+#define STEPS 600
+#define RATE  10
+
+static lion_status_t fill(lion_sim_t *sim, lion_vector_t *vec, const double *values, size_t n) {
+  LION_CALL(lion_vector_from_array(sim, values, n, sizeof(double), vec), "Failed creating vector");
+  return LION_STATUS_SUCCESS;
+}
+
+static double power_at(size_t i) { return 6.0 + 2.0 * sin(0.05 * (double)i); }
+
+lion_status_t test_channels_lookup(lion_sim_t *sim) {
+  double        t[]    = {0.0, 1.0, 3.0, 6.0, 10.0};
+  double        y[]    = {1.0, 3.0, 7.0, 13.0, 21.0};
+  lion_vector_t times, values;
+  LION_CALL(fill(sim, &times, t, 5), "Failed creating times");
+  LION_CALL(fill(sim, &values, y, 5), "Failed creating values");
+
+  lion_input_channel_t zoh, linear, cubic;
+  LION_CALL(lion_input_channel_new_timed(sim, &values, &times, LION_INTERP_ZOH, &zoh), "Failed creating channel");
+  LION_CALL(lion_input_channel_new_timed(sim, &values, &times, LION_INTERP_LINEAR, &linear), "Failed creating channel");
+  LION_CALL(lion_input_channel_new_timed(sim, &values, &times, LION_INTERP_CUBIC, &cubic), "Failed creating channel");
+  LION_ASSERT_EQF(lion_input_channel_end(&zoh), 10.0);
+
+  // The samples lie on y = 2 t + 1, which every interpolation between samples follows
+  LION_ASSERT_EQF(lion_input_channel_at(&zoh, 2.5), 3.0);
+  LION_ASSERT_EQF(lion_input_channel_at(&zoh, 3.0), 7.0);
+  LION_ASSERT_EQF(lion_input_channel_at(&linear, 4.5), 10.0);
+  LION_ASSERT(fabs(lion_input_channel_at(&cubic, 4.5) - 10.0) < 1e-12);
+  LION_ASSERT(fabs(lion_input_channel_at(&cubic, 0.5) - 2.0) < 1e-12);
+  LION_ASSERT_EQI(linear.cursor, 2);
+
+  // Going back in time, and holding outside of the samples
+  LION_ASSERT_EQF(lion_input_channel_at(&linear, 0.5), 2.0);
+  LION_ASSERT_EQI(linear.cursor, 0);
+  LION_ASSERT_EQF(lion_input_channel_at(&linear, -1.0), 1.0);
+  LION_ASSERT_EQF(lion_input_channel_at(&linear, 12.0), 21.0);
+  LION_ASSERT_EQI(linear.cursor, 4);
+
+  // Cubic interpolation is exact for quadratics between samples at a fixed rate
+  double q[8];
+  for (size_t i = 0; i < 8; i++) {
+    q[i] = 0.5 * (double)(i * i);
+  }
+  lion_vector_t quadratic;
+  LION_CALL(fill(sim, &quadratic, q, 8), "Failed creating values");
+  LION_CALL(lion_input_channel_new(sim, &quadratic, 0.0, 0.5, LION_INTERP_CUBIC, &cubic), "Failed creating channel");
+  LION_ASSERT(fabs(lion_input_channel_at(&cubic, 1.25) - 0.5 * 2.5 * 2.5) < 1e-12);
+  LION_ASSERT_EQF(lion_input_channel_end(&cubic), 3.5);
+
+  log_debug("Checking invalid channels");
+  double        bad[] = {0.0, 1.0, 1.0, 2.0, 3.0};
+  lion_vector_t unordered;
+  LION_CALL(fill(sim, &unordered, bad, 5), "Failed creating times");
+  LION_ASSERT_FAILS(lion_input_channel_new_timed(sim, &values, &unordered, LION_INTERP_ZOH, &zoh));
+  LION_ASSERT_FAILS(lion_input_channel_new_timed(sim, &quadratic, &times, LION_INTERP_ZOH, &zoh));
+  LION_ASSERT_FAILS(lion_input_channel_new(sim, &values, 0.0, 0.0, LION_INTERP_ZOH, &zoh));
+
+  LION_CALL(lion_vector_cleanup(sim, &times), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &values), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &quadratic), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &unordered), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_channels_multirate(lion_sim_t *sim) {
+  // Power at 10 Hz and two hourly temperatures, against profiles expanded to the step
+  static double power_samples[STEPS * RATE + 1];
+  static double power_steps[STEPS + 1];
+  static double amb_steps[STEPS + 1];
+  double        amb_samples[] = {298.0, 300.0};
+  double        hourly[]      = {0.0, 3600.0};
+  for (size_t i = 0; i <= STEPS * RATE; i++) {
+    power_samples[i] = (i % RATE == 0) ? power_at(i / RATE) : -1.0;
+  }
+  for (size_t i = 0; i <= STEPS; i++) {
+    power_steps[i] = power_at(i);
+    amb_steps[i]   = 298.0 + 2.0 * (double)i / 3600.0;
+  }
+
+  lion_vector_t power, amb_temp;
+  LION_CALL(fill(sim, &power, power_steps, STEPS + 1), "Failed creating power");
+  LION_CALL(fill(sim, &amb_temp, amb_steps, STEPS + 1), "Failed creating ambient temperature");
+  LION_CALL(lion_sim_run(sim, &power, &amb_temp), "Failed running expanded profiles");
+  lion_sim_state_t expected = sim->state;
+  LION_CALL(lion_vector_cleanup(sim, &power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &amb_temp), "Failed to clean up");
+
+  lion_vector_t        amb_times;
+  lion_input_channel_t power_channel, amb_channel;
+  LION_CALL(fill(sim, &power, power_samples, STEPS * RATE + 1), "Failed creating power");
+  LION_CALL(fill(sim, &amb_temp, amb_samples, 2), "Failed creating ambient temperature");
+  LION_CALL(fill(sim, &amb_times, hourly, 2), "Failed creating times");
+  LION_CALL(lion_input_channel_new(sim, &power, 0.0, 1.0 / RATE, LION_INTERP_ZOH, &power_channel), "Failed creating power channel");
+  LION_CALL(lion_input_channel_new_timed(sim, &amb_temp, &amb_times, LION_INTERP_LINEAR, &amb_channel), "Failed creating temperature channel");
+  LION_CALL(lion_sim_run_inputs(sim, &power_channel, &amb_channel), "Failed running input channels");
+
+  // The run ends with the power channel
+  LION_ASSERT_EQI(sim->state.step, STEPS);
+  LION_ASSERT_EQF(sim->state.power, expected.power);
+  LION_ASSERT(fabs(sim->state.ambient_temperature - expected.ambient_temperature) < 1e-12);
+  LION_ASSERT(fabs(sim->state.soc_nominal - expected.soc_nominal) < 1e-12);
+  LION_ASSERT(fabs(sim->state.internal_temperature - expected.internal_temperature) < 1e-9);
+  LION_ASSERT(fabs(sim->state.voltage - expected.voltage) < 1e-9);
+
+  LION_CALL(lion_vector_cleanup(sim, &power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &amb_temp), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &amb_times), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+
+  LION_CALL_TEST(&sim, test_channels_lookup);
+  LION_CALL_TEST(&sim, test_channels_multirate);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
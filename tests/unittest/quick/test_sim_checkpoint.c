@@ -0,0 +1,169 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WARMUP_STEPS 50
+#define BRANCH_STEPS 50
+#define ETA_VALUES   32
+
+static lion_status_t run_steps(lion_sim_t *sim, size_t steps) {
+  for (size_t i = 0; i < steps; i++) {
+    LION_CALL(lion_sim_step(sim, 5.0 + (double)(i % 7), 298.0), "Failed stepping simulation");
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+// Charges and discharges the cell, completing a cycle every few tens of steps
+static lion_status_t run_cycles(lion_sim_t *sim, size_t steps) {
+  for (size_t i = 0; i < steps; i++) {
+    LION_CALL(lion_sim_step(sim, ((sim->state.step / 10) % 2 == 0) ? 8.0 : -8.0, 298.0), "Failed cycling simulation");
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_checkpoint_roundtrip(lion_sim_t *sim) {
+  LION_CALL(run_steps(sim, WARMUP_STEPS), "Failed warming up");
+
+  lion_vector_t checkpoint;
+  LION_CALL(lion_sim_checkpoint(sim, &checkpoint), "Failed creating checkpoint");
+
+  log_debug("Running first branch");
+  LION_CALL(run_steps(sim, BRANCH_STEPS), "Failed running first branch");
+  lion_sim_state_t first = sim->state;
+
+  log_debug("Restoring and running second branch");
+  LION_CALL(lion_sim_restore(sim, &checkpoint), "Failed restoring checkpoint");
+  LION_ASSERT_EQI((int)sim->state.step, WARMUP_STEPS);
+  LION_CALL(run_steps(sim, BRANCH_STEPS), "Failed running second branch");
+
+  LION_ASSERT_EQI((int)sim->state.step, (int)first.step);
+  LION_ASSERT_EQF(sim->state.soc_nominal, first.soc_nominal);
+  LION_ASSERT_EQF(sim->state.internal_temperature, first.internal_temperature);
+  LION_ASSERT_EQF(sim->state.voltage, first.voltage);
+  LION_ASSERT_EQF(sim->state.time, first.time);
+
+  log_debug("Checking corrupted checkpoints are rejected");
+  char magic                   = ((char *)checkpoint.data)[0];
+  ((char *)checkpoint.data)[0] = 'X';
+  LION_ASSERT_FAILS(lion_sim_restore(sim, &checkpoint));
+  ((char *)checkpoint.data)[0] = magic;
+  checkpoint.len              -= 1;
+  LION_ASSERT_FAILS(lion_sim_restore(sim, &checkpoint));
+  checkpoint.len += 1;
+  LION_CALL(lion_sim_restore(sim, &checkpoint), "Failed restoring the repaired checkpoint");
+
+  LION_CALL(lion_vector_cleanup(sim, &checkpoint), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+// Steps until the simulation closes, at most `steps` times
+static lion_status_t run_until_close(lion_sim_t *sim, size_t steps) {
+  for (size_t i = 0; i < steps && !lion_sim_should_close(sim); i++) {
+    LION_CALL(lion_sim_step(sim, 5.0 + (double)(i % 7), 298.0), "Failed stepping simulation");
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_checkpoint_stop(lion_sim_t *sim) {
+  // A branch stopped by an event runs again from the checkpoint
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_CALL(run_steps(sim, WARMUP_STEPS), "Failed warming up");
+  lion_event_config_t event = {.field = "soc_nominal", .kind = LION_EVENT_BELOW, .threshold = sim->state.soc_nominal - 1e-3, .action = LION_EVENT_STOP};
+  lion_stat_config_t  stat  = {.kind = LION_STAT_MOMENTS, .field = "voltage"};
+  LION_CALL(lion_sim_events_add(sim, &event, NULL), "Failed adding event");
+  LION_CALL(lion_sim_stats_add(sim, &stat, NULL), "Failed adding statistic");
+
+  lion_vector_t checkpoint;
+  LION_CALL(lion_sim_checkpoint(sim, &checkpoint), "Failed creating checkpoint");
+  LION_CALL(run_until_close(sim, 10 * BRANCH_STEPS), "Failed running first branch");
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_EVENT);
+  lion_sim_state_t first = sim->state;
+  uint64_t         count = lion_sim_stat(sim, 0)->count;
+
+  LION_CALL(lion_sim_restore(sim, &checkpoint), "Failed restoring checkpoint");
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_NONE);
+  LION_ASSERT_EQI((int)lion_sim_event(sim, 0)->count, 0);
+  LION_ASSERT_EQI((int)lion_sim_stat(sim, 0)->count, 0);
+  LION_CALL(run_until_close(sim, 10 * BRANCH_STEPS), "Failed running second branch");
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_EVENT);
+  LION_ASSERT_EQI((int)sim->state.step, (int)first.step);
+  LION_ASSERT_EQF(sim->state.soc_nominal, first.soc_nominal);
+  LION_ASSERT_EQI((int)lion_sim_stat(sim, 0)->count, (int)count);
+
+  log_debug("Restoring a cancelled branch");
+  lion_sim_cancel(sim);
+  LION_CALL(lion_sim_restore(sim, &checkpoint), "Failed restoring checkpoint");
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_NONE);
+
+  LION_CALL(lion_sim_events_cleanup(sim), "Failed cleaning up events");
+  LION_CALL(lion_sim_stats_cleanup(sim), "Failed cleaning up statistics");
+  LION_CALL(lion_vector_cleanup(sim, &checkpoint), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_checkpoint_rng(void) {
+  // The Masserano model draws its noise from the generator of the simulation,
+  // which the checkpoint carries along with the state
+  lion_sim_config_t conf      = test_config();
+  lion_params_t     params    = test_params(0.9);
+  params.init.capacity        = 40.0;
+  params.soh.model            = LION_SOH_MODEL_MASSERANO;
+  params.soh.params.masserano = lion_params_default_soh_masserano();
+
+  lion_vector_t eta_values;
+  LION_CALL(lion_vector_zero(NULL, ETA_VALUES, sizeof(double), &eta_values), "Failed creating eta values");
+  for (size_t i = 0; i < ETA_VALUES; i++) {
+    double eta = 0.9992 + 2e-4 * sin((double)i);
+    LION_CALL(lion_vector_set(NULL, &eta_values, i, &eta), "Failed setting eta value");
+  }
+  params.soh.params.masserano.kde_params.eta_values = eta_values;
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  LION_CALL(run_cycles(&sim, WARMUP_STEPS), "Failed warming up");
+
+  lion_vector_t checkpoint;
+  LION_CALL(lion_sim_checkpoint(&sim, &checkpoint), "Failed creating checkpoint");
+  uint64_t cycles = sim.state.cycle;
+  LION_CALL(run_cycles(&sim, BRANCH_STEPS), "Failed running first branch");
+  lion_sim_state_t first = sim.state;
+  LION_CALL(lion_sim_restore(&sim, &checkpoint), "Failed restoring checkpoint");
+  LION_CALL(run_cycles(&sim, BRANCH_STEPS), "Failed running second branch");
+
+  // Both branches complete cycles and draw the same noise
+  log_debug("Masserano from %" PRIu64 " to %" PRIu64 " cycles: %f", cycles, first.cycle, first.soh);
+  LION_ASSERT(first.cycle > cycles);
+  LION_ASSERT(first.soh < 1.0);
+  LION_ASSERT_EQI((int)sim.state.cycle, (int)first.cycle);
+  LION_ASSERT_EQF(sim.state.soh, first.soh);
+  LION_ASSERT_EQF(sim.state.soc_nominal, first.soc_nominal);
+
+  LION_CALL(lion_vector_cleanup(&sim, &checkpoint), "Failed to clean up");
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  LION_CALL(lion_vector_cleanup(NULL, &eta_values), "Failed cleaning up eta values");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = lion_params_default();
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_checkpoint_roundtrip);
+  LION_CALL_TEST(&sim, test_checkpoint_stop);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  LION_CALL(test_checkpoint_rng(), "Failed restoring the generator of the simulation");
+  return TEST_PASS;
+}
@@ -0,0 +1,152 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#define MEASUREMENTS 600
+
+static lion_status_t measure(
+    lion_sim_t *sim, lion_vector_t *power, lion_vector_t *amb, lion_vector_t *voltage, lion_vector_t *temperature
+) {
+  LION_CALL(lion_vector_zero(sim, MEASUREMENTS, sizeof(double), power), "Failed allocating power");
+  LION_CALL(lion_vector_zero(sim, MEASUREMENTS, sizeof(double), amb), "Failed allocating ambient temperature");
+  LION_CALL(lion_vector_zero(sim, MEASUREMENTS, sizeof(double), voltage), "Failed allocating voltage");
+  LION_CALL(lion_vector_zero(sim, MEASUREMENTS, sizeof(double), temperature), "Failed allocating temperature");
+
+  double *p = power->data;
+  double *a = amb->data;
+  double *v = voltage->data;
+  double *t = temperature->data;
+  for (size_t i = 0; i < MEASUREMENTS; i++) {
+    p[i] = 8.0 + 4.0 * sin((double)i / 40.0);
+    a[i] = 298.0 + 15.0 * sin((double)i / 150.0);
+  }
+
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  v[0] = NAN;
+  t[0] = NAN;
+  for (size_t i = 1; i < MEASUREMENTS; i++) {
+    LION_CALL(lion_sim_step(sim, p[i], a[i]), "Failed stepping simulation");
+    v[i] = sim->state.voltage;
+    t[i] = sim->state.surface_temperature;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_estimate_thermal(lion_sim_t *sim) {
+  lion_vector_t power, amb, voltage, temperature;
+  LION_CALL(measure(sim, &power, &amb, &voltage, &temperature), "Failed generating measurements");
+
+  double cp   = sim->params->temp.cp;
+  double rout = sim->params->temp.rout;
+  sim->params->temp.cp   = 1.3 * cp;
+  sim->params->temp.rout = 0.8 * rout;
+
+  const char            *names[] = {"temp.cp", "temp.rout"};
+  lion_estimate_t        est     = lion_estimate_default();
+  lion_estimate_result_t result;
+  est.names    = names;
+  est.n_params = 2;
+  LION_CALL(lion_estimate_run(sim, &est, &power, &amb, &voltage, &temperature, &result), "Failed estimating parameters");
+  log_info("Estimated cp = %f (%f), rout = %f (%f)", sim->params->temp.cp, cp, sim->params->temp.rout, rout);
+
+  LION_ASSERT(result.final_cost < result.initial_cost);
+  LION_ASSERT(fabs(sim->params->temp.cp - cp) < 1e-2 * cp);
+  LION_ASSERT(fabs(sim->params->temp.rout - rout) < 1e-2 * rout);
+  LION_ASSERT(result.simulations < 100);
+
+  log_debug("Checking unknown parameters are rejected");
+  const char *unknown[] = {"temp.unknown"};
+  est.names             = unknown;
+  est.n_params          = 1;
+  LION_ASSERT_FAILS(lion_estimate_run(sim, &est, &power, &amb, &voltage, &temperature, NULL));
+
+  LION_CALL(lion_vector_cleanup(sim, &power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &amb), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &voltage), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &temperature), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_estimate_ocv(lion_sim_t *sim) {
+  // The open circuit voltage and its entropic term shape the terminal voltage,
+  // so they are recovered from the voltage alone as the temperature moves
+  lion_vector_t power, amb, voltage, temperature;
+  LION_CALL(measure(sim, &power, &amb, &voltage, &temperature), "Failed generating measurements");
+
+  double v0           = sim->params->ocv.v0;
+  double vl           = sim->params->ocv.vl;
+  double b            = sim->params->ehc.b;
+  sim->params->ocv.v0 = 1.02 * v0;
+  sim->params->ehc.b  = 3.0 * b;
+
+  const char            *names[] = {"ocv.v0", "ehc.b"};
+  lion_estimate_t        est     = lion_estimate_default();
+  lion_estimate_result_t result;
+  est.names    = names;
+  est.n_params = 2;
+  LION_CALL(lion_estimate_run(sim, &est, &power, &amb, &voltage, NULL, &result), "Failed estimating parameters");
+  log_info("Estimated v0 = %f (%f), b = %e (%e)", sim->params->ocv.v0, v0, sim->params->ehc.b, b);
+
+  LION_ASSERT(result.final_cost < 1e-6 * result.initial_cost);
+  LION_ASSERT(fabs(sim->params->ocv.v0 - v0) < 1e-4 * v0);
+  LION_ASSERT(fabs(sim->params->ehc.b - b) < 1e-2 * b);
+  LION_ASSERT_EQF(sim->params->ocv.vl, vl);
+
+  LION_CALL(lion_vector_cleanup(sim, &power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &amb), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &voltage), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &temperature), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_estimate_multirate(void) {
+  // The thermal decay of the multirate steps follows the estimated heat capacity
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+  conf.sim_thermal_steps   = 10;
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  lion_vector_t power, amb, voltage, temperature;
+  LION_CALL(measure(&sim, &power, &amb, &voltage, &temperature), "Failed generating measurements");
+  double cp      = params.temp.cp;
+  params.temp.cp = 1.3 * cp;
+
+  const char            *names[] = {"temp.cp"};
+  lion_estimate_t        est     = lion_estimate_default();
+  lion_estimate_result_t result;
+  est.names    = names;
+  est.n_params = 1;
+  LION_CALL(lion_estimate_run(&sim, &est, &power, &amb, &voltage, &temperature, &result), "Failed estimating parameters");
+  log_info("Estimated cp = %f (%f) with multirate thermal steps", params.temp.cp, cp);
+  LION_ASSERT(fabs(params.temp.cp - cp) < 1e-2 * cp);
+
+  LION_CALL(lion_vector_cleanup(&sim, &power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(&sim, &amb), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(&sim, &voltage), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(&sim, &temperature), "Failed to clean up");
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_estimate_thermal);
+  LION_CALL_TEST(&sim, test_estimate_ocv);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  LION_CALL(test_estimate_multirate(), "Failed estimating with multirate thermal steps");
+  return TEST_PASS;
+}
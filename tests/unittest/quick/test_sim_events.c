@@ -0,0 +1,168 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_sim/sim_run.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#define STEPS  300
+#define CUTOFF 120
+
+static double   recorded_voltage[STEPS + 1];
+static uint64_t recorded       = 0;
+static uint64_t triggered      = 0;
+static uint64_t cancel_at_step = 0;
+
+static lion_status_t record_hook(lion_sim_t *sim) {
+  if (recorded <= STEPS) {
+    recorded_voltage[recorded++] = sim->state.voltage;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t cancel_hook(lion_sim_t *sim) {
+  if (sim->state.step + 1 == cancel_at_step) {
+    lion_sim_cancel(sim);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t count_hook(lion_sim_t *sim, size_t event) {
+  triggered++;
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t run_discharge(lion_sim_t *sim) {
+  // The simulation skips the first sample of the profile
+  lion_vector_t power, amb_temp;
+  LION_CALL(lion_vector_zero(sim, STEPS + 1, sizeof(double), &power), "Failed creating power");
+  LION_CALL(lion_vector_zero(sim, STEPS + 1, sizeof(double), &amb_temp), "Failed creating ambient temperature");
+  for (size_t i = 0; i <= STEPS; i++) {
+    double p = 8.0;
+    double t = 298.0;
+    LION_CALL(lion_vector_set(sim, &power, i, &p), "Failed setting power");
+    LION_CALL(lion_vector_set(sim, &amb_temp, i, &t), "Failed setting ambient temperature");
+  }
+  recorded = 0;
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_CALL(lion_sim_simulate(sim, &power, &amb_temp), "Failed running simulation");
+  LION_CALL(lion_vector_cleanup(sim, &power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &amb_temp), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_events_stop(lion_sim_t *sim) {
+  // Reference run, to place a cutoff inside a known step
+  sim->update_hook = record_hook;
+  LION_CALL(run_discharge(sim), "Failed running reference");
+  LION_ASSERT_EQI(recorded, STEPS);
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_NONE);
+  LION_ASSERT(recorded_voltage[CUTOFF] < recorded_voltage[CUTOFF - 1]);
+  double cutoff = 0.5 * (recorded_voltage[CUTOFF - 1] + recorded_voltage[CUTOFF]);
+
+  size_t              stop;
+  lion_event_config_t conf = {.field = "voltage", .kind = LION_EVENT_BELOW, .threshold = cutoff, .action = LION_EVENT_STOP};
+  LION_CALL(lion_sim_events_add(sim, &conf, &stop), "Failed adding cutoff");
+  LION_CALL(run_discharge(sim), "Failed running with cutoff");
+  sim->update_hook = NULL;
+
+  // The run stops at the step that crossed the cutoff, moved back to the crossing
+  const lion_event_t *event = lion_sim_event(sim, stop);
+  double              h     = sim->conf->sim_step_seconds;
+  log_debug("Cutoff %f reached at t = %f with %f V", cutoff, event->first_time, sim->state.voltage);
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_EVENT);
+  LION_ASSERT_EQI(event->count, 1);
+  LION_ASSERT_EQI(recorded, CUTOFF + 1);
+  LION_ASSERT(event->first_time > (CUTOFF - 1) * h && event->first_time < CUTOFF * h);
+  LION_ASSERT_EQF(sim->state.time, event->first_time);
+  LION_ASSERT(fabs(sim->state.voltage - cutoff) < 1e-6);
+
+  log_debug("Checking that resetting clears the stop");
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_NONE);
+  LION_ASSERT_EQI(lion_sim_event(sim, stop)->count, 0);
+  LION_ASSERT(isnan(lion_sim_event(sim, stop)->first_time));
+  LION_CALL(lion_sim_events_cleanup(sim), "Failed cleaning up events");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_events_trigger(lion_sim_t *sim) {
+  size_t              soc, always;
+  lion_event_config_t crossing = {.field = "soc_nominal", .kind = LION_EVENT_CROSSING, .threshold = 0.899, .action = LION_EVENT_TRIGGER, .hook = count_hook};
+  lion_event_config_t level    = {.field = "ambient_temperature", .kind = LION_EVENT_ABOVE, .threshold = 290.0, .action = LION_EVENT_TRIGGER};
+  triggered                    = 0;
+  LION_CALL(lion_sim_events_add(sim, &crossing, &soc), "Failed adding trigger");
+  LION_CALL(lion_sim_events_add(sim, &level, &always), "Failed adding level trigger");
+  LION_CALL(run_discharge(sim), "Failed running with trigger");
+
+  // Triggers do not stop the run
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_NONE);
+  LION_ASSERT_EQI(sim->state.step, STEPS);
+  LION_ASSERT_EQI(lion_sim_event(sim, soc)->count, 1);
+  LION_ASSERT_EQI(triggered, 1);
+  LION_ASSERT(lion_sim_event(sim, soc)->first_time > 0.0);
+  // Level conditions fire once when they start true
+  LION_ASSERT_EQI(lion_sim_event(sim, always)->count, 1);
+  LION_ASSERT_EQF(lion_sim_event(sim, always)->first_time, 0.0);
+  LION_CALL(lion_sim_events_cleanup(sim), "Failed cleaning up events");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_events_cancel(lion_sim_t *sim) {
+  cancel_at_step   = 25;
+  sim->update_hook = cancel_hook;
+  LION_CALL(run_discharge(sim), "Failed running cancelled simulation");
+  sim->update_hook = NULL;
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_CANCELLED);
+  LION_ASSERT_EQI(sim->state.step, cancel_at_step);
+
+  LION_ASSERT_FAILS(lion_sim_events_add(sim, &(lion_event_config_t){.field = "temperature"}, NULL));
+  LION_ASSERT(lion_sim_event(sim, 0) == NULL);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_events_passive(lion_stepper_t stepper) {
+  // An event that never fires leaves the history of multistep drivers alone
+  lion_sim_config_t   conf   = test_config();
+  lion_params_t       params = test_params(0.9);
+  lion_event_config_t never  = {.field = "voltage", .kind = LION_EVENT_ABOVE, .threshold = 100.0, .action = LION_EVENT_TRIGGER};
+  lion_sim_state_t    states[2];
+  conf.sim_stepper = stepper;
+  for (int watched = 0; watched < 2; watched++) {
+    lion_sim_t sim;
+    LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+    LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+    if (watched) {
+      LION_CALL(lion_sim_events_add(&sim, &never, NULL), "Failed adding event");
+    }
+    LION_CALL(run_discharge(&sim), "Failed running discharge");
+    states[watched] = sim.state;
+    LION_CALL(lion_sim_events_cleanup(&sim), "Failed cleaning up events");
+    LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  }
+  LION_ASSERT_EQF(states[1].soc_nominal, states[0].soc_nominal);
+  LION_ASSERT_EQF(states[1].internal_temperature, states[0].internal_temperature);
+  LION_ASSERT_EQF(states[1].voltage, states[0].voltage);
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_events_stop);
+  LION_CALL_TEST(&sim, test_events_trigger);
+  LION_CALL_TEST(&sim, test_events_cancel);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  LION_CALL(test_events_passive(LION_STEPPER_MSADAMS), "Failed watching a passive event with Adams steps");
+  LION_CALL(test_events_passive(LION_STEPPER_MSBDF), "Failed watching a passive event with BDF steps");
+  return TEST_PASS;
+}
@@ -0,0 +1,121 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#define CELLS 13
+#define STEPS 120
+
+static double cell_power(size_t i, size_t t) {
+  // Different charge and discharge levels for every cell, switching halfway
+  double level = -3.0 + 0.6 * (double)i;
+  return (t < STEPS / 2) ? level : -0.5 * level;
+}
+
+static void fill_power(double *power) {
+  for (size_t t = 0; t < STEPS; t++) {
+    for (size_t i = 0; i < CELLS; i++) {
+      power[t * CELLS + i] = cell_power(i, t);
+    }
+  }
+}
+
+lion_status_t test_fleet_f64(lion_sim_t *sim) {
+  double power[STEPS * CELLS];
+  fill_power(power);
+
+  lion_fleet_t       fleet;
+  lion_fleet_drift_t drift;
+  LION_CALL(lion_fleet_new(sim, CELLS, LION_FLEET_F64, &fleet), "Failed creating fleet");
+  LION_ASSERT_EQI(fleet.soc.data_size, sizeof(double));
+  LION_CALL(lion_fleet_validate(&fleet, power, STEPS, 298.0, &drift), "Failed validating fleet");
+  LION_ASSERT_EQI(fleet.step, STEPS);
+  LION_ASSERT(drift.soc_max < 1e-6);
+  LION_ASSERT(drift.temperature_max < 1e-6);
+  LION_ASSERT(drift.soc_rms <= drift.soc_max);
+
+  log_debug("Checking that cells with the same input evolve the same");
+  LION_CALL(lion_fleet_reset(&fleet), "Failed resetting fleet");
+  LION_ASSERT_EQF(lion_fleet_soc(&fleet, 0), sim->state._next_soc_nominal);
+  lion_vector_t        step_power;
+  lion_vector_view_d_t view;
+  LION_CALL(lion_vector_zero(sim, CELLS, sizeof(double), &step_power), "Failed creating power");
+  LION_CALL(lion_vector_view_d(sim, &step_power, &view), "Failed viewing power");
+  lion_vector_fill_d(sim, view, 2.0);
+  LION_CALL(lion_fleet_step(&fleet, &step_power, 298.0), "Failed stepping fleet");
+  for (size_t i = 1; i < CELLS; i++) {
+    LION_ASSERT_EQF(lion_fleet_soc(&fleet, i), lion_fleet_soc(&fleet, 0));
+  }
+  LION_ASSERT(lion_fleet_soc(&fleet, 0) < sim->state._next_soc_nominal);
+
+  LION_CALL(lion_vector_cleanup(sim, &step_power), "Failed to clean up");
+  LION_CALL(lion_fleet_cleanup(&fleet), "Failed cleaning up fleet");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_fleet_f32(lion_sim_t *sim) {
+  double power[STEPS * CELLS];
+  fill_power(power);
+
+  lion_fleet_t       fleet;
+  lion_fleet_drift_t drift;
+  LION_CALL(lion_fleet_new(sim, CELLS, LION_FLEET_F32, &fleet), "Failed creating fleet");
+  LION_ASSERT_EQI(fleet.soc.data_size, sizeof(float));
+  LION_CALL(lion_fleet_validate(&fleet, power, STEPS, 298.0, &drift), "Failed validating fleet");
+  log_debug("Single precision drift: soc %g, temperature %g", drift.soc_max, drift.temperature_max);
+  LION_ASSERT(drift.soc_max < 1e-5);
+  LION_ASSERT(drift.temperature_max < 1e-2);
+  LION_ASSERT(drift.worst_cell < CELLS);
+  LION_CALL(lion_fleet_cleanup(&fleet), "Failed cleaning up fleet");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_fleet_errors(lion_sim_t *sim) {
+  lion_fleet_t  fleet;
+  lion_vector_t step_power;
+  LION_ASSERT_FAILS(lion_fleet_new(sim, 0, LION_FLEET_F64, &fleet));
+
+  log_debug("Checking that inputs must match the precision of the fleet");
+  LION_CALL(lion_fleet_new(sim, CELLS, LION_FLEET_F32, &fleet), "Failed creating fleet");
+  LION_CALL(lion_vector_zero(sim, CELLS, sizeof(double), &step_power), "Failed creating power");
+  LION_ASSERT_FAILS(lion_fleet_step(&fleet, &step_power, 298.0));
+  LION_CALL(lion_vector_cleanup(sim, &step_power), "Failed to clean up");
+  LION_CALL(lion_vector_zero(sim, CELLS - 1, sizeof(float), &step_power), "Failed creating power");
+  LION_ASSERT_FAILS(lion_fleet_step(&fleet, &step_power, 298.0));
+  LION_CALL(lion_vector_cleanup(sim, &step_power), "Failed to clean up");
+  LION_CALL(lion_fleet_cleanup(&fleet), "Failed cleaning up fleet");
+
+  log_debug("Checking that fleets require an initialized simulation");
+  lion_sim_t uninit;
+  LION_CALL(lion_sim_new(sim->conf, sim->params, &uninit), "Failed creating simulation");
+  LION_ASSERT_FAILS(lion_fleet_new(&uninit, CELLS, LION_FLEET_F64, &fleet));
+  LION_CALL(lion_sim_cleanup(&uninit), "Failed cleaning up simulation");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_fleet_f64);
+  LION_CALL_TEST(&sim, test_fleet_f32);
+  LION_CALL_TEST(&sim, test_fleet_errors);
+
+  log_info("Repeating with the polarization resistance");
+  sim.params->rint.model               = LION_RINT_MODEL_POLARIZATION;
+  sim.params->rint.params.polarization = lion_params_default_rint_polarization();
+  LION_CALL(lion_sim_reset(&sim), "Failed resetting sim for test");
+  LION_CALL_TEST(&sim, test_fleet_f64);
+  LION_CALL_TEST(&sim, test_fleet_f32);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
@@ -0,0 +1,107 @@
+#include "fixture.h"
+
+#include <gsl/gsl_rng.h>
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WARMUP_STEPS 50
+#define BRANCH_STEPS 50
+
+lion_status_t test_fork_matches_parent(lion_sim_t *sim) {
+  for (size_t i = 0; i < WARMUP_STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, 8.0, 298.0), "Failed warming up");
+  }
+
+  lion_sim_t fork;
+  LION_CALL(lion_sim_fork(sim, &fork), "Failed forking simulation");
+  LION_ASSERT(fork.parent == sim);
+  LION_ASSERT(fork.params == sim->params);
+  LION_ASSERT(fork.driver != sim->driver);
+  LION_ASSERT(fork.inputs.sys_inputs == &fork.state);
+  LION_ASSERT_EQI((int)fork.state.step, WARMUP_STEPS);
+
+  log_debug("Stepping parent and fork with the same inputs");
+  for (size_t i = 0; i < BRANCH_STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, 4.0, 300.0), "Failed stepping parent");
+    LION_CALL(lion_sim_step(&fork, 4.0, 300.0), "Failed stepping fork");
+  }
+  LION_ASSERT_EQF(fork.state.soc_nominal, sim->state.soc_nominal);
+  LION_ASSERT_EQF(fork.state.internal_temperature, sim->state.internal_temperature);
+  LION_ASSERT_EQF(fork.state.voltage, sim->state.voltage);
+
+  log_debug("Stepping the fork on a different input");
+  LION_CALL(lion_sim_step(sim, 4.0, 300.0), "Failed stepping parent");
+  LION_CALL(lion_sim_step(&fork, 12.0, 300.0), "Failed stepping fork");
+  LION_ASSERT_NEF(fork.state._next_soc_nominal, sim->state._next_soc_nominal);
+
+  LION_CALL(lion_sim_cleanup(&fork), "Failed cleaning up fork");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_fork_streams(lion_sim_t *sim) {
+  // Forking leaves the stream of the parent untouched, and every fork starts
+  // its own stream
+  gsl_rng   *expected = gsl_rng_clone(sim->rng);
+  lion_sim_t first, second;
+  LION_CALL(lion_sim_fork(sim, &first), "Failed forking simulation");
+  LION_CALL(lion_sim_fork(sim, &second), "Failed forking simulation");
+  LION_ASSERT(gsl_rng_get(sim->rng) == gsl_rng_get(expected));
+  LION_ASSERT(gsl_rng_get(first.rng) != gsl_rng_get(second.rng));
+  gsl_rng_free(expected);
+  LION_CALL(lion_sim_cleanup(&first), "Failed cleaning up fork");
+  LION_CALL(lion_sim_cleanup(&second), "Failed cleaning up fork");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_fork_bookkeeping(lion_sim_t *sim) {
+  // Events and accumulators carry on in the fork, apart from the parent
+  lion_event_config_t event = {.field = "voltage", .kind = LION_EVENT_BELOW, .threshold = 0.0, .action = LION_EVENT_TRIGGER};
+  lion_stat_config_t  stat  = {.field = "voltage", .kind = LION_STAT_HISTOGRAM, .low = 3.0, .high = 4.5, .n_bins = 15};
+  LION_CALL(lion_sim_events_add(sim, &event, NULL), "Failed adding event");
+  LION_CALL(lion_sim_stats_add(sim, &stat, NULL), "Failed adding accumulator");
+  for (size_t i = 0; i < WARMUP_STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, 8.0, 298.0), "Failed stepping parent");
+  }
+
+  lion_sim_t fork;
+  LION_CALL(lion_sim_fork(sim, &fork), "Failed forking simulation");
+  LION_ASSERT_EQI((int)fork.n_events, 1);
+  LION_ASSERT_EQI((int)fork.n_stats, 1);
+  LION_ASSERT(fork.stats[0].bins != sim->stats[0].bins);
+  LION_ASSERT_EQI((int)fork.stats[0].count, WARMUP_STEPS);
+  LION_CALL(lion_sim_step(&fork, 8.0, 298.0), "Failed stepping fork");
+  LION_ASSERT_EQI((int)fork.stats[0].count, WARMUP_STEPS + 1);
+  LION_ASSERT_EQI((int)sim->stats[0].count, WARMUP_STEPS);
+
+  // A closed simulation forks closed
+  lion_sim_cancel(sim);
+  lion_sim_t closed;
+  LION_CALL(lion_sim_fork(sim, &closed), "Failed forking simulation");
+  LION_ASSERT(lion_sim_should_close(&closed));
+
+  LION_CALL(lion_sim_cleanup(&closed), "Failed cleaning up fork");
+  LION_CALL(lion_sim_cleanup(&fork), "Failed cleaning up fork");
+  LION_CALL(lion_sim_stats_cleanup(sim), "Failed cleaning up accumulators");
+  LION_CALL(lion_sim_events_cleanup(sim), "Failed cleaning up events");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = lion_params_default();
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_fork_matches_parent);
+  LION_CALL_TEST(&sim, test_fork_streams);
+  LION_CALL_TEST(&sim, test_fork_bookkeeping);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
@@ -0,0 +1,90 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+
+#define DURATION 1200.0
+#define COARSE   60.0
+
+static double power_at(double t) { return 4.0 + 8.0 * t / DURATION; }
+
+static double ambient_at(double t) { return 298.0 + 10.0 * t / DURATION; }
+
+static lion_status_t run_ramp(double step, lion_input_hold_t hold, lion_sim_state_t *out) {
+  lion_sim_config_t conf = test_config();
+  conf.sim_step_seconds  = step;
+  conf.sim_input_hold    = hold;
+
+  lion_params_t params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  // Every step takes the inputs at the time it ends
+  uint64_t steps = (uint64_t)round(DURATION / step);
+  for (uint64_t i = 1; i <= steps; i++) {
+    double t = (double)i * step;
+    LION_CALL(lion_sim_step(&sim, power_at(t), ambient_at(t)), "Failed stepping simulation");
+  }
+  // The outputs of the last step belong to its start, so the states are taken at its end
+  *out                      = sim.state;
+  out->soc_nominal          = sim.state._next_soc_nominal;
+  out->internal_temperature = sim.state._next_internal_temperature;
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_hold_ramp(void) {
+  lion_sim_state_t reference, zoh, foh;
+  LION_CALL(run_ramp(1.0, LION_HOLD_FIRST, &reference), "Failed running reference");
+  LION_CALL(run_ramp(COARSE, LION_HOLD_ZERO, &zoh), "Failed running zero-order hold");
+  LION_CALL(run_ramp(COARSE, LION_HOLD_FIRST, &foh), "Failed running first-order hold");
+
+  double soc_zoh  = fabs(zoh.soc_nominal - reference.soc_nominal);
+  double soc_foh  = fabs(foh.soc_nominal - reference.soc_nominal);
+  double temp_zoh = fabs(zoh.internal_temperature - reference.internal_temperature);
+  double temp_foh = fabs(foh.internal_temperature - reference.internal_temperature);
+  log_debug("SoC error: %e with zero-order hold, %e with first-order hold", soc_zoh, soc_foh);
+  log_debug("Temperature error: %e with zero-order hold, %e with first-order hold", temp_zoh, temp_foh);
+  LION_ASSERT(soc_foh < soc_zoh / 10.0);
+  LION_ASSERT(temp_foh < temp_zoh / 10.0);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_hold_constant(void) {
+  // Constant inputs do not ramp, so both holds agree
+  lion_sim_state_t zoh, foh;
+  lion_sim_config_t conf = test_config();
+  conf.sim_step_seconds  = COARSE;
+
+  lion_params_t params = test_params(0.9);
+
+  for (int hold = LION_HOLD_ZERO; hold <= LION_HOLD_FIRST; hold++) {
+    lion_sim_t sim;
+    conf.sim_input_hold = (lion_input_hold_t)hold;
+    LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+    LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+    for (int i = 0; i < 10; i++) {
+      LION_CALL(lion_sim_step_input(&sim, LION_INPUT_CURRENT, 2.0, 298.0), "Failed stepping simulation");
+    }
+    if (hold == LION_HOLD_ZERO) {
+      zoh = sim.state;
+    } else {
+      foh = sim.state;
+    }
+    LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  }
+  LION_ASSERT(fabs(zoh._next_soc_nominal - foh._next_soc_nominal) < 1e-12);
+  LION_ASSERT(fabs(zoh._next_internal_temperature - foh._next_internal_temperature) < 1e-9);
+  LION_ASSERT_EQF(foh._hold_input, 2.0);
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  LION_CALL(test_hold_ramp(), "Failed first-order hold over a ramp");
+  LION_CALL(test_hold_constant(), "Failed first-order hold over constant inputs");
+  return TEST_PASS;
+}
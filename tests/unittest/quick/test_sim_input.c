@@ -0,0 +1,177 @@
+#include "fixture.h"
+
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+
+#define STEPS     50
+#define MAX_STEPS 10000
+
+static double   reference_voltage[STEPS];
+static double   reference_current[STEPS];
+static uint64_t reference_evaluations = 0;
+
+static uint64_t cc_steps       = 0;
+static uint64_t cv_steps       = 0;
+static double   cc_max_voltage = 0.0;
+static double   cc_last        = 0.0;
+static double   cv_error       = 0.0;
+static double   cv_current     = -INFINITY;
+static int      cv_monotonic   = 1;
+
+static lion_status_t record_hook(lion_sim_t *sim) {
+  if (sim->state.input_mode == LION_INPUT_CURRENT) {
+    cc_steps++;
+    cc_max_voltage = fmax(cc_max_voltage, sim->state.voltage);
+    cc_last        = sim->state.voltage;
+  } else if (sim->state.input_mode == LION_INPUT_VOLTAGE) {
+    cv_steps++;
+    cv_error      = fmax(cv_error, fabs(sim->state.voltage - 4.3));
+    cv_monotonic &= sim->state.current >= cv_current;
+    cv_current    = sim->state.current;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_input_power(lion_sim_t *sim) {
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  for (size_t i = 0; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, 8.0, 298.0), "Failed stepping simulation");
+    LION_ASSERT_EQI(sim->state.input_mode, LION_INPUT_POWER);
+    reference_voltage[i]   = sim->state.voltage;
+    reference_current[i]   = sim->state.current;
+    reference_evaluations += sim->state.step_evaluations;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_input_current(lion_sim_t *sim) {
+  // Holding the currents of the power run reproduces its voltages without a solve
+  uint64_t evaluations = 0;
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  for (size_t i = 0; i < STEPS; i++) {
+    LION_CALL(lion_sim_step_input(sim, LION_INPUT_CURRENT, reference_current[i], 298.0), "Failed stepping simulation");
+    LION_ASSERT_EQF(sim->state.current, reference_current[i]);
+    LION_ASSERT(fabs(sim->state.voltage - reference_voltage[i]) < 1e-6);
+    LION_ASSERT(fabs(sim->state.power - 8.0) < 1e-5);
+    evaluations += sim->state.step_evaluations;
+  }
+  log_debug("Evaluations: %" PRIu64 " with power, %" PRIu64 " with current", reference_evaluations, evaluations);
+  LION_ASSERT(evaluations < reference_evaluations / 5);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_input_voltage(lion_sim_t *sim) {
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  for (size_t i = 0; i < STEPS; i++) {
+    LION_CALL(lion_sim_step_input(sim, LION_INPUT_VOLTAGE, reference_voltage[i], 298.0), "Failed stepping simulation");
+    LION_ASSERT_EQF(sim->state.voltage, reference_voltage[i]);
+    LION_ASSERT(fabs(sim->state.current - reference_current[i]) < 1e-6);
+    LION_ASSERT(!(sim->state.step_flags & LION_STEP_CURRENT_UNCONVERGED));
+  }
+  LION_ASSERT_FAILS(lion_sim_step_input(sim, (lion_input_mode_t)3, 0.0, 298.0));
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_input_cccv(lion_sim_t *sim) {
+  lion_protocol_step_t steps[LION_PROTOCOL_CCCV_STEPS];
+  lion_protocol_t      protocol;
+  lion_protocol_cccv(4.0, 4.3, 2.0, steps);
+  LION_CALL(lion_protocol_new(steps, LION_PROTOCOL_CCCV_STEPS, 298.0, &protocol), "Failed creating protocol");
+
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  sim->update_hook = record_hook;
+  LION_CALL(lion_sim_run_protocol(sim, &protocol, MAX_STEPS), "Failed running protocol");
+  sim->update_hook = NULL;
+  log_debug("CC for %" PRIu64 " steps, CV for %" PRIu64 " steps, finished at t = %f", cc_steps, cv_steps, sim->state.time);
+
+  // Both steps end at the located crossing of their condition
+  LION_ASSERT_EQI(protocol.active, LION_PROTOCOL_CCCV_STEPS);
+  LION_ASSERT(cc_steps > 0 && cv_steps > 0);
+  LION_ASSERT(cc_max_voltage < 4.3 + 1e-6);
+  LION_ASSERT(fabs(cc_last - 4.3) < 1e-6);
+  LION_ASSERT(cv_error < 1e-12);
+  LION_ASSERT(cv_monotonic);
+  LION_ASSERT(fabs(sim->state.current + 2.0) < 1e-6);
+  LION_ASSERT_EQF(protocol.start_time, sim->state.time);
+  LION_ASSERT_EQI(sim->n_events, 0);
+  LION_ASSERT_EQI(lion_sim_should_close(sim), LION_CLOSE_NONE);
+
+  log_debug("Checking the step limit");
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_CALL(lion_sim_run_protocol(sim, &protocol, 100), "Failed running protocol");
+  LION_ASSERT_EQI(protocol.active, 0);
+  LION_ASSERT_EQI(sim->state.step, 100);
+  LION_ASSERT_EQI(sim->n_events, 0);
+  return LION_STATUS_SUCCESS;
+}
+
+// Adds an event that never fires in the middle of the first protocol step
+static lion_status_t watch_hook(lion_sim_t *sim) {
+  lion_event_config_t event = {.field = "voltage", .kind = LION_EVENT_ABOVE, .threshold = 10.0, .action = LION_EVENT_TRIGGER};
+  if (sim->state.step == 10) {
+    LION_CALL(lion_sim_events_add(sim, &event, NULL), "Failed adding event");
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_input_hook_event(lion_sim_t *sim) {
+  // Steps only drop their own event, even when a hook adds one after it
+  lion_protocol_step_t steps[LION_PROTOCOL_CCCV_STEPS];
+  lion_protocol_t      protocol;
+  lion_protocol_cccv(4.0, 4.3, 2.0, steps);
+  LION_CALL(lion_protocol_new(steps, LION_PROTOCOL_CCCV_STEPS, 298.0, &protocol), "Failed creating protocol");
+
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  sim->update_hook = watch_hook;
+  LION_CALL(lion_sim_run_protocol(sim, &protocol, MAX_STEPS), "Failed running protocol");
+  sim->update_hook = NULL;
+  LION_ASSERT_EQI(protocol.active, LION_PROTOCOL_CCCV_STEPS);
+  LION_ASSERT(fabs(sim->state.current + 2.0) < 1e-6);
+  LION_ASSERT_EQI(sim->n_events, 1);
+  LION_ASSERT_EQF(lion_sim_event(sim, 0)->threshold, 10.0);
+  LION_ASSERT_EQI(lion_sim_event(sim, 0)->count, 0);
+
+  LION_CALL(lion_sim_events_remove(sim, 0), "Failed removing event");
+  LION_ASSERT_EQI(sim->n_events, 0);
+  LION_ASSERT_FAILS(lion_sim_events_remove(sim, 0));
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_input_rest(lion_sim_t *sim) {
+  lion_protocol_step_t rest = {.mode = LION_INPUT_CURRENT, .value = 0.0, .duration = 30.0};
+  lion_protocol_t      protocol;
+  LION_CALL(lion_protocol_new(&rest, 1, 298.0, &protocol), "Failed creating protocol");
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_CALL(lion_sim_run_protocol(sim, &protocol, 0), "Failed running protocol");
+  LION_ASSERT_EQI(protocol.active, 1);
+  LION_ASSERT_EQI(sim->state.step, 30);
+  LION_ASSERT_EQF(sim->state.power, 0.0);
+  LION_ASSERT_EQF(sim->state.voltage, sim->state.open_circuit_voltage);
+
+  rest.duration = 0.0;
+  LION_ASSERT_FAILS(lion_protocol_new(&rest, 1, 298.0, &protocol));
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.5);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_input_power);
+  LION_CALL_TEST(&sim, test_input_current);
+  LION_CALL_TEST(&sim, test_input_voltage);
+  LION_CALL_TEST(&sim, test_input_cccv);
+  LION_CALL_TEST(&sim, test_input_hook_event);
+  LION_CALL_TEST(&sim, test_input_rest);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
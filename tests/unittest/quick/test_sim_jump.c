@@ -0,0 +1,176 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+
+#define LOAD_STEPS 120
+#define REST_STEPS 3600
+
+static lion_params_t jump_params(uint32_t branches) {
+  lion_params_t params     = test_params(0.6);
+  params.init.temp_in      = 310.0;
+  params.rc.n_branches     = branches;
+  params.rc.resistance[0]  = 0.01;
+  params.rc.capacitance[0] = 500.0;
+  params.rc.resistance[1]  = 0.02;
+  params.rc.capacitance[1] = 1500.0;
+  return params;
+}
+
+// Loads the cell and then rests it, stepping or jumping over the rest
+static lion_status_t run_rest(lion_params_t *params, int jump, lion_sim_state_t *out) {
+  lion_sim_config_t conf = test_config();
+  lion_sim_t        sim;
+  LION_CALL(lion_sim_new(&conf, params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  for (int i = 0; i < LOAD_STEPS; i++) {
+    LION_CALL(lion_sim_step(&sim, 8.0, 298.0), "Failed loading cell");
+  }
+  if (jump) {
+    LION_CALL(lion_sim_jump(&sim, 0.0, 298.0, REST_STEPS), "Failed jumping over rest");
+  } else {
+    for (int i = 0; i < REST_STEPS; i++) {
+      LION_CALL(lion_sim_step(&sim, 0.0, 298.0), "Failed stepping over rest");
+    }
+  }
+  *out = sim.state;
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_jump_rest(uint32_t branches) {
+  lion_params_t    params = jump_params(branches);
+  lion_sim_state_t stepped, jumped;
+  LION_CALL(run_rest(&params, 0, &stepped), "Failed stepping");
+  LION_CALL(run_rest(&params, 1, &jumped), "Failed jumping");
+
+  double temp_error = fabs(jumped._next_internal_temperature - stepped._next_internal_temperature);
+  log_debug("Rest with %u branches: temperature %e, rc %e", branches, temp_error, fabs(jumped.rc_voltage[0] - stepped.rc_voltage[0]));
+  LION_ASSERT_EQI((int)jumped.step, (int)stepped.step);
+  LION_ASSERT(fabs(jumped.time - stepped.time) < 1e-9);
+  LION_ASSERT(fabs(jumped._next_soc_nominal - stepped._next_soc_nominal) < 1e-9);
+  LION_ASSERT(temp_error < 1e-4);
+  LION_ASSERT(fabs(jumped.internal_temperature - stepped.internal_temperature) < 1e-4);
+  LION_ASSERT(fabs(jumped.voltage - stepped.voltage) < 1e-6);
+  for (uint32_t k = 0; k < branches; k++) {
+    LION_ASSERT(fabs(jumped._next_rc_voltage[k] - stepped._next_rc_voltage[k]) < 1e-9);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_jump_calendar(void) {
+  // At the reference temperature and state of charge the decay is a plain exponential
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = jump_params(0);
+  params.init.soc          = 0.5;
+  params.init.temp_in      = 298.15;
+  params.calendar.rate     = 1e-9;
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  uint64_t steps = 30 * 86400;
+  LION_CALL(lion_sim_jump(&sim, 0.0, 298.15, steps), "Failed jumping over a month");
+  LION_ASSERT_EQI((int)sim.state.step, (int)steps);
+  LION_ASSERT(fabs(sim.state.soh - exp(-1e-9 * (double)steps)) < 1e-12);
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+
+  // A hot cell cooling down ages faster at first, like when stepping
+  lion_sim_state_t stepped, jumped;
+  params.init.temp_in = 330.0;
+  LION_CALL(run_rest(&params, 0, &stepped), "Failed stepping");
+  LION_CALL(run_rest(&params, 1, &jumped), "Failed jumping");
+  double lost = 1.0 - stepped.soh;
+  log_debug("Calendar aging: stepped %e, jumped %e", lost, 1.0 - jumped.soh);
+  LION_ASSERT(lost > 1e-9 * (double)(LOAD_STEPS + REST_STEPS));
+  LION_ASSERT(fabs(jumped.soh - stepped.soh) < 1e-3 * lost);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_jump_constant(void) {
+  // Frozen coefficients over a minute stay close to stepping every second,
+  // within a fraction of a percent of the charge drawn
+  lion_sim_config_t conf    = test_config();
+  lion_params_t     params  = jump_params(2);
+  conf.sim_jump_max_seconds = 60.0;
+
+  lion_sim_state_t states[2];
+  for (int jump = 0; jump < 2; jump++) {
+    lion_sim_t sim;
+    LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+    LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+    if (jump) {
+      LION_CALL(lion_sim_jump(&sim, 6.0, 298.0, 1800), "Failed jumping at constant power");
+    } else {
+      for (int i = 0; i < 1800; i++) {
+        LION_CALL(lion_sim_step(&sim, 6.0, 298.0), "Failed stepping at constant power");
+      }
+    }
+    states[jump] = sim.state;
+    LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  }
+  double soc_error  = fabs(states[1].soc_nominal - states[0].soc_nominal);
+  double temp_error = fabs(states[1].internal_temperature - states[0].internal_temperature);
+  log_debug("Constant power: soc %e, temperature %e", soc_error, temp_error);
+  LION_ASSERT_EQI((int)states[1].step, (int)states[0].step);
+  LION_ASSERT(soc_error < 5e-4);
+  LION_ASSERT(temp_error < 5e-2);
+  LION_ASSERT(fabs(states[1]._acc_discharge - states[0]._acc_discharge) < 5e-3 * states[0]._acc_discharge);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_jump_run(void) {
+  // lion_sim_run jumps over the rest in the middle of the profile
+  size_t n = 2 * LOAD_STEPS + REST_STEPS;
+  lion_vector_t power, ambient;
+  LION_CALL(lion_vector_zero(NULL, n, sizeof(double), &power), "Failed creating power");
+  LION_CALL(lion_vector_zero(NULL, n, sizeof(double), &ambient), "Failed creating ambient temperature");
+  for (size_t i = 0; i < n; i++) {
+    double p = (i < LOAD_STEPS || i >= LOAD_STEPS + REST_STEPS) ? 8.0 : 0.0;
+    double a = 298.0;
+    LION_CALL(lion_vector_set(NULL, &power, i, &p), "Failed setting power");
+    LION_CALL(lion_vector_set(NULL, &ambient, i, &a), "Failed setting ambient temperature");
+  }
+
+  lion_params_t    params = jump_params(2);
+  lion_sim_state_t states[2];
+  uint64_t         counts[2];
+  double           means[2];
+  for (int jump = 0; jump < 2; jump++) {
+    lion_sim_config_t conf = test_config();
+    conf.sim_jump          = jump ? LION_JUMP_REST : LION_JUMP_NONE;
+    lion_sim_t sim;
+    LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+    lion_stat_config_t stat = {.kind = LION_STAT_INTEGRAL, .field = "power"};
+    lion_stat_config_t temp = {.kind = LION_STAT_MOMENTS, .field = "internal_temperature"};
+    LION_CALL(lion_sim_stats_add(&sim, &stat, NULL), "Failed adding statistic");
+    LION_CALL(lion_sim_stats_add(&sim, &temp, NULL), "Failed adding statistic");
+    LION_CALL(lion_sim_run(&sim, &power, &ambient), "Failed running profile");
+    states[jump] = sim.state;
+    counts[jump] = lion_sim_stat(&sim, 0)->count;
+    means[jump]  = lion_sim_stat(&sim, 1)->mean;
+    LION_ASSERT_EQF(lion_sim_stat(&sim, 0)->integral, 8.0 * (2 * LOAD_STEPS - 1));
+    LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  }
+  LION_ASSERT_EQI((int)states[1].step, (int)states[0].step);
+  LION_ASSERT_EQI((int)counts[1], (int)counts[0]);
+  log_debug("Mean temperature: stepped %f, jumped %f", means[0], means[1]);
+  LION_ASSERT(fabs(means[1] - means[0]) < 0.1);
+  LION_ASSERT(fabs(states[1].soc_nominal - states[0].soc_nominal) < 1e-9);
+  LION_ASSERT(fabs(states[1].internal_temperature - states[0].internal_temperature) < 1e-4);
+  LION_CALL(lion_vector_cleanup(NULL, &power), "Failed cleaning up power");
+  LION_CALL(lion_vector_cleanup(NULL, &ambient), "Failed cleaning up ambient temperature");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  LION_CALL(test_jump_rest(0), "Failed jumping over rest");
+  LION_CALL(test_jump_rest(2), "Failed jumping over rest with RC branches");
+  LION_CALL(test_jump_calendar(), "Failed calendar aging over a jump");
+  LION_CALL(test_jump_constant(), "Failed jumping at constant power");
+  LION_CALL(test_jump_run(), "Failed jumping inside lion_sim_run");
+  return TEST_PASS;
+}
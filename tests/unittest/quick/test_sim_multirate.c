@@ -0,0 +1,139 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+
+#define LOAD_STEPS     1800
+#define REST_STEPS     600
+#define THERMAL_STEPS  10
+#define AGING_STEPS    60
+
+static lion_sim_config_t multirate_config(uint64_t thermal, uint64_t aging) {
+  lion_sim_config_t conf = test_config();
+  conf.sim_thermal_steps = thermal;
+  conf.sim_aging_steps   = aging;
+  return conf;
+}
+
+static lion_params_t multirate_params(uint32_t branches) {
+  lion_params_t params     = test_params(0.8);
+  params.init.temp_in      = 298.0;
+  params.rc.n_branches     = branches;
+  params.rc.resistance[0]  = 0.01;
+  params.rc.capacitance[0] = 500.0;
+  params.rc.resistance[1]  = 0.02;
+  params.rc.capacitance[1] = 1500.0;
+  params.calendar.rate     = 1e-9;
+  return params;
+}
+
+// Loads the cell and then rests it, counting the steps where the internal
+// temperature seen by the model changed
+static lion_status_t run_profile(lion_params_t *params, uint64_t thermal, uint64_t aging, lion_sim_state_t *out, uint64_t *changes) {
+  lion_sim_config_t conf = multirate_config(thermal, aging);
+  lion_sim_t        sim;
+  LION_CALL(lion_sim_new(&conf, params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  double last = sim.state.internal_temperature;
+  *changes    = 0;
+  for (int i = 0; i < LOAD_STEPS + REST_STEPS; i++) {
+    LION_CALL(lion_sim_step(&sim, (i < LOAD_STEPS) ? 8.0 : 0.0, 298.0), "Failed stepping");
+    if (sim.state.internal_temperature != last) {
+      (*changes)++;
+    }
+    last = sim.state.internal_temperature;
+  }
+  *out = sim.state;
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_multirate_default(void) {
+  // Every step and a single step per thermal and aging step are the same
+  LION_ASSERT_EQI((int)lion_sim_config_default().sim_thermal_steps, 1);
+  LION_ASSERT_EQI((int)lion_sim_config_default().sim_aging_steps, 1);
+
+  lion_params_t    params = multirate_params(2);
+  lion_sim_state_t one, zero;
+  uint64_t         changes;
+  LION_CALL(run_profile(&params, 1, 1, &one, &changes), "Failed running single rate");
+  LION_ASSERT_EQI((int)changes, LOAD_STEPS + REST_STEPS);
+  LION_CALL(run_profile(&params, 0, 0, &zero, &changes), "Failed running single rate");
+  LION_ASSERT_EQF(zero.internal_temperature, one.internal_temperature);
+  LION_ASSERT_EQF(zero.soc_nominal, one.soc_nominal);
+  LION_ASSERT_EQF(zero.soh, one.soh);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_multirate_thermal(uint32_t branches) {
+  lion_params_t    params = multirate_params(branches);
+  lion_sim_state_t single, multi;
+  uint64_t         changes;
+  LION_CALL(run_profile(&params, 1, 1, &single, &changes), "Failed running single rate");
+  LION_CALL(run_profile(&params, THERMAL_STEPS, 1, &multi, &changes), "Failed running multirate");
+
+  // The temperature only moves once per thermal step, and the capacity with it
+  double heating    = single.internal_temperature - params.init.temp_in;
+  double temp_error = fabs(multi._next_internal_temperature - single._next_internal_temperature);
+  double soc_error  = fabs(multi._next_soc_nominal - single._next_soc_nominal);
+  log_debug("Multirate with %u branches: temperature %e of %e, soc %e", branches, temp_error, heating, soc_error);
+  LION_ASSERT(changes <= (LOAD_STEPS + REST_STEPS) / THERMAL_STEPS);
+  LION_ASSERT(heating > 0.1);
+  LION_ASSERT(temp_error < 1e-4 * heating);
+  LION_ASSERT(soc_error < 1e-5);
+  LION_ASSERT(fabs(multi.voltage - single.voltage) < 1e-3);
+  LION_ASSERT(fabs(multi.capacity_use - single.capacity_use) < 1e-3 * single.capacity_use);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_multirate_aging(void) {
+  lion_params_t    params = multirate_params(0);
+  lion_sim_state_t single, multi;
+  uint64_t         changes;
+  LION_CALL(run_profile(&params, 1, 1, &single, &changes), "Failed running single rate");
+  LION_CALL(run_profile(&params, 1, AGING_STEPS, &multi, &changes), "Failed running multirate");
+
+  // The profile is a whole number of aging steps, so no aging is left pending
+  double lost = 1.0 - single.soh;
+  log_debug("Calendar aging: single %e, multirate %e", lost, 1.0 - multi.soh);
+  LION_ASSERT_EQI((int)multi._aging_step, 0);
+  LION_ASSERT(lost > 0.0);
+  LION_ASSERT(fabs(multi.soh - single.soh) < 5e-3 * lost);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_multirate_jump(void) {
+  // Jumping in the middle of a thermal step carries on from the temperature
+  // reached by its steps
+  lion_params_t     params = multirate_params(2);
+  lion_sim_state_t  states[2];
+  for (int multi = 0; multi < 2; multi++) {
+    lion_sim_config_t conf = multirate_config(multi ? THERMAL_STEPS : 1, 1);
+    lion_sim_t        sim;
+    LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+    LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+    for (int i = 0; i < LOAD_STEPS + THERMAL_STEPS / 2; i++) {
+      LION_CALL(lion_sim_step(&sim, 8.0, 298.0), "Failed loading cell");
+    }
+    LION_CALL(lion_sim_jump(&sim, 0.0, 298.0, REST_STEPS), "Failed jumping over rest");
+    states[multi] = sim.state;
+    LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  }
+  double temp_error = fabs(states[1]._next_internal_temperature - states[0]._next_internal_temperature);
+  log_debug("Jump after multirate: temperature %e", temp_error);
+  LION_ASSERT_EQI((int)states[1]._thermal_step, 0);
+  LION_ASSERT(temp_error < 1e-3);
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  LION_CALL(test_multirate_default(), "Failed single rate defaults");
+  LION_CALL(test_multirate_thermal(0), "Failed multirate thermal steps");
+  LION_CALL(test_multirate_thermal(2), "Failed multirate thermal steps with RC branches");
+  LION_CALL(test_multirate_aging(), "Failed multirate aging steps");
+  LION_CALL(test_multirate_jump(), "Failed jumping inside a thermal step");
+  return TEST_PASS;
+}
@@ -0,0 +1,88 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+
+#define STEPS 600
+
+// Discharge at a constant power, with the RC branches in `branches` (0 for none)
+static lion_status_t run_discharge(lion_stepper_t stepper, size_t branches, lion_input_hold_t hold, lion_sim_state_t *out) {
+  lion_sim_config_t conf = test_config();
+  conf.sim_stepper       = stepper;
+  conf.sim_input_hold    = hold;
+
+  lion_params_t params = test_params(0.9);
+  if (branches > 0) {
+    params.rc.n_branches     = branches;
+    params.rc.resistance[0]  = 0.01;
+    params.rc.capacitance[0] = 500.0;
+    params.rc.resistance[1]  = 0.02;
+    params.rc.capacitance[1] = 1500.0;
+  }
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  for (int i = 1; i <= STEPS; i++) {
+    LION_CALL(lion_sim_step(&sim, 4.0 + 4.0 * (double)i / STEPS, 298.0), "Failed stepping simulation");
+  }
+  *out = sim.state;
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+static double state_error(const lion_sim_state_t *a, const lion_sim_state_t *b) {
+  double err = fmax(fabs(a->_next_soc_nominal - b->_next_soc_nominal), fabs(a->_next_internal_temperature - b->_next_internal_temperature) / 100.0);
+  for (size_t i = 0; i < LION_RC_MAX_BRANCHES; i++) {
+    err = fmax(err, fabs(a->rc_voltage[i] - b->rc_voltage[i]));
+  }
+  return err;
+}
+
+lion_status_t test_native_matches_gsl(size_t branches, lion_input_hold_t hold) {
+  lion_sim_state_t reference, rk4, native_rk4, native_rk45, native_ros2;
+  LION_CALL(run_discharge(LION_STEPPER_RK8PD, branches, hold, &reference), "Failed running reference");
+  LION_CALL(run_discharge(LION_STEPPER_RK4, branches, hold, &rk4), "Failed running GSL RK4");
+  LION_CALL(run_discharge(LION_STEPPER_NATIVE_RK4, branches, hold, &native_rk4), "Failed running native RK4");
+  LION_CALL(run_discharge(LION_STEPPER_NATIVE_RK45, branches, hold, &native_rk45), "Failed running native RK45");
+  LION_CALL(run_discharge(LION_STEPPER_NATIVE_ROS2, branches, hold, &native_ros2), "Failed running native ROS2");
+
+  double err_rk4  = state_error(&native_rk4, &rk4);
+  double err_rk45 = state_error(&native_rk45, &reference);
+  double err_ros2 = state_error(&native_ros2, &reference);
+  log_debug("Errors with %zu branches: RK4 %e, RK45 %e, ROS2 %e", branches, err_rk4, err_rk45, err_ros2);
+  // The same tableau as GSL only differs by rounding
+  LION_ASSERT(err_rk4 < 1e-12);
+  LION_ASSERT(err_rk45 < 1e-7);
+  LION_ASSERT(err_ros2 < 1e-5);
+  LION_ASSERT(fabs(native_rk4.voltage - rk4.voltage) < 1e-10);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_native_budget(void) {
+  // A budget too small for a whole step falls back to a single Euler step
+  lion_sim_config_t conf = test_config();
+  conf.sim_stepper       = LION_STEPPER_NATIVE_RK4;
+  conf.sim_ode_budget    = 2;
+
+  lion_params_t params = lion_params_default();
+  lion_sim_t    sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+  LION_CALL(lion_sim_step(&sim, 4.0, 298.0), "Failed stepping simulation");
+  LION_ASSERT(sim.state.step_flags & LION_STEP_ODE_FALLBACK);
+  LION_ASSERT_EQF(sim.state.time, 1.0);
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  LION_CALL(test_native_matches_gsl(0, LION_HOLD_ZERO), "Failed comparing native steppers without branches");
+  LION_CALL(test_native_matches_gsl(2, LION_HOLD_ZERO), "Failed comparing native steppers with RC branches");
+  LION_CALL(test_native_matches_gsl(2, LION_HOLD_FIRST), "Failed comparing native steppers with a first-order hold");
+  LION_CALL(test_native_budget(), "Failed native stepper over budget");
+  return TEST_PASS;
+}
@@ -0,0 +1,147 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#define STEPS 200
+
+static double profile(size_t i) { return 6.0 + 3.0 * sin((double)i / 20.0); }
+
+lion_status_t test_pack_single_cell(lion_sim_t *sim) {
+  lion_pack_config_t conf = {.n_series = 1, .n_parallel = 1};
+  lion_pack_t        pack;
+  LION_CALL(lion_pack_new(sim, &conf, &pack), "Failed creating pack");
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, profile(i), 298.0), "Failed stepping simulation");
+    LION_CALL(lion_pack_step(&pack, profile(i), 298.0), "Failed stepping pack");
+  }
+  log_info("Cell voltage = %f, pack voltage = %f", sim->state.voltage, pack.voltage);
+  LION_ASSERT(fabs(pack.voltage - sim->state.voltage) < 1e-3);
+  LION_ASSERT(fabs(pack.current - sim->state.current) < 1e-3);
+  LION_ASSERT(fabs(pack.cells[0]._next_soc_nominal - sim->state._next_soc_nominal) < 1e-5);
+  LION_ASSERT(fabs(pack.cells[0]._next_internal_temperature - sim->state._next_internal_temperature) < 1e-5);
+
+  LION_CALL(lion_pack_cleanup(&pack), "Failed cleaning up pack");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_pack_current_sharing(lion_sim_t *sim) {
+  lion_pack_variation_t variation[] = {
+    {.name = "rint.params.fixed.internal_resistance", .spread = 0.1},
+    {.name = "init.capacity", .spread = 0.05},
+  };
+  lion_pack_config_t conf = {.n_series = 4, .n_parallel = 3, .variation = variation, .n_variation = 2};
+  lion_pack_t        pack;
+  LION_CALL(lion_pack_new(sim, &conf, &pack), "Failed creating pack");
+  LION_ASSERT_EQI((int)pack.n_cells, 12);
+
+  double pack_power = 4.0 * 3.0 * 6.0;
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_pack_step(&pack, pack_power, 298.0), "Failed stepping pack");
+  }
+
+  // Every string sees the terminal voltage and the power is conserved
+  for (size_t s = 0; s < pack.n_parallel; s++) {
+    double v_s = 0.0;
+    for (size_t i = 0; i < pack.n_series; i++) {
+      v_s += pack.cells[s * pack.n_series + i].voltage;
+    }
+    LION_ASSERT(fabs(v_s - pack.voltage) < 1e-8);
+  }
+  LION_ASSERT(fabs(pack.voltage * pack.current - pack_power) < 1e-8);
+  LION_ASSERT(pack.string_current[0] != pack.string_current[1]);
+
+  log_debug("Checking a resting pack has no net current");
+  LION_CALL(lion_pack_step(&pack, 0.0, 298.0), "Failed stepping pack at rest");
+  LION_ASSERT(fabs(pack.current) < 1e-8);
+
+  LION_CALL(lion_pack_cleanup(&pack), "Failed cleaning up pack");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_pack_thermal_network(lion_sim_t *sim) {
+  lion_thermal_node_t   air     = {.heat_capacity = 50.0, .ambient_conductance = 2.0, .initial_temperature = 298.0};
+  lion_thermal_link_t   links[] = {{.a = 0, .b = 1, .conductance = 0.5}, {.a = 2, .b = 3, .conductance = 0.5}};
+  lion_thermal_config_t network = {.nodes = &air, .n_nodes = 1, .links = links, .n_links = 2};
+  lion_pack_config_t    conf    = {.n_series = 2, .n_parallel = 2, .thermal = &network};
+
+  sim->conf->sim_regime = LION_ONLYSF;
+  lion_pack_t reference;
+  LION_CALL(lion_pack_new(sim, &conf, &reference), "Failed creating reference pack");
+
+  sim->conf->sim_regime = LION_BOTH;
+  lion_pack_t pack;
+  LION_CALL(lion_pack_new(sim, &conf, &pack), "Failed creating pack");
+  LION_ASSERT_EQI((int)pack.thermal.n_total, 5);
+
+  // Backward Euler conserves energy exactly, so the heat stored in the nodes
+  // matches the generated heat minus the heat released to the ambient, also
+  // after the time step of the simulation changes halfway through
+  double step = sim->conf->sim_step_seconds;
+  for (size_t i = 1; i < STEPS; i++) {
+    if (i == STEPS / 2) {
+      sim->conf->sim_step_seconds = 0.5 * step;
+    }
+    double h      = sim->conf->sim_step_seconds;
+    double stored = 0.0;
+    for (size_t k = 0; k < pack.thermal.n_total; k++) {
+      stored -= pack.thermal.capacity[k] * pack.thermal.temperature[k];
+    }
+    LION_CALL(lion_pack_step(&pack, 4.0 * profile(i), 298.0), "Failed stepping pack");
+    LION_CALL(lion_pack_step(&reference, 4.0 * profile(i), 298.0), "Failed stepping reference pack");
+
+    double generated = 0.0;
+    for (size_t c = 0; c < pack.n_cells; c++) {
+      generated += pack.cells[c].generated_heat;
+    }
+    for (size_t k = 0; k < pack.thermal.n_total; k++) {
+      stored += pack.thermal.capacity[k] * pack.thermal.temperature[k];
+    }
+    double released = air.ambient_conductance * (pack.thermal.temperature[pack.n_cells] - 298.0);
+    LION_ASSERT(fabs(stored / h - (generated - released)) < 1e-6);
+  }
+
+  // Heat flows from the cells to the air and from the air to the ambient,
+  // and the air around the cells makes them hotter than in open air
+  double t_air = pack.thermal.temperature[pack.n_cells];
+  log_info("Air temperature = %f K", t_air);
+  LION_ASSERT(t_air > 298.0);
+  for (size_t c = 0; c < pack.n_cells; c++) {
+    LION_ASSERT(pack.cells[c]._next_internal_temperature > t_air);
+    LION_ASSERT(pack.cells[c]._next_internal_temperature > reference.cells[c]._next_internal_temperature);
+    LION_ASSERT(pack.cells[c].ambient_temperature > 298.0);
+  }
+
+  log_debug("Checking the network is required outside of the surface regime");
+  conf.thermal = NULL;
+  lion_pack_t invalid;
+  LION_ASSERT_FAILS(lion_pack_new(sim, &conf, &invalid));
+
+  sim->conf->sim_regime       = LION_ONLYSF;
+  sim->conf->sim_step_seconds = step;
+  LION_CALL(lion_pack_cleanup(&pack), "Failed cleaning up pack");
+  LION_CALL(lion_pack_cleanup(&reference), "Failed cleaning up reference pack");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_pack_single_cell);
+  LION_CALL_TEST(&sim, test_pack_current_sharing);
+  LION_CALL_TEST(&sim, test_pack_thermal_network);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
@@ -0,0 +1,152 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+
+#define PROFILE_LEN 7201
+#define SLICES      8
+
+static lion_vector_t power;
+static lion_vector_t amb;
+
+static int lock_calls = 0;
+static int lock_depth = 0;
+
+// Lock of the caller, which stays in place under the lock of the slices
+static void count_lock(bool lock, void *udata) {
+  (void)udata;
+  lock_depth += lock ? 1 : -1;
+  lock_calls += lock;
+}
+
+static lion_params_t parareal_params(void) {
+  lion_params_t params     = test_params(0.9);
+  params.init.temp_in      = 298.0;
+  params.rc.n_branches     = 2;
+  params.rc.resistance[0]  = 0.01;
+  params.rc.capacitance[0] = 500.0;
+  params.rc.resistance[1]  = 0.02;
+  params.rc.capacitance[1] = 1500.0;
+  return params;
+}
+
+static lion_status_t run_serial(lion_params_t *params, lion_sim_state_t *out) {
+  lion_sim_config_t conf = test_config();
+  lion_sim_t        sim;
+  LION_CALL(lion_sim_new(&conf, params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_run(&sim, &power, &amb), "Failed running serially");
+  *out = sim.state;
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t run_parareal(lion_params_t *params, const lion_parareal_t *parareal, lion_sim_state_t *out, lion_parareal_result_t *result) {
+  lion_sim_config_t conf = test_config();
+  lion_sim_t        sim;
+  LION_CALL(lion_sim_new(&conf, params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_run_parareal(&sim, parareal, &power, &amb, result), "Failed running in parallel in time");
+  *out = sim.state;
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_parareal_converged(void) {
+  // Converged slices end close to the serial run, in fewer corrections than slices
+  lion_params_t    params   = parareal_params();
+  lion_parareal_t  parareal = {.n_slices = SLICES, .coarse_steps = 60, .tolerance = 1e-7};
+  lion_sim_state_t serial, parallel;
+  lion_parareal_result_t result;
+  LION_CALL(run_serial(&params, &serial), "Failed running serially");
+  LION_CALL(run_parareal(&params, &parareal, &parallel, &result), "Failed running in parallel in time");
+
+  double soc_error  = fabs(parallel._next_soc_nominal - serial._next_soc_nominal);
+  double temp_error = fabs(parallel._next_internal_temperature - serial._next_internal_temperature);
+  log_debug("Parareal: %zu corrections, defect %e, soc %e, temperature %e", result.iterations, result.defect, soc_error, temp_error);
+  LION_ASSERT(result.converged);
+  LION_ASSERT(result.iterations < SLICES);
+  LION_ASSERT_EQI((int)parallel.step, (int)serial.step);
+  LION_ASSERT(fabs(parallel.time - serial.time) < 1e-9);
+  LION_ASSERT(soc_error < 1e-6);
+  LION_ASSERT(temp_error < 1e-5);
+  LION_ASSERT(fabs(parallel.voltage - serial.voltage) < 1e-4);
+  for (uint32_t k = 0; k < params.rc.n_branches; k++) {
+    LION_ASSERT(fabs(parallel._next_rc_voltage[k] - serial._next_rc_voltage[k]) < 1e-6);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_parareal_exact(void) {
+  // One correction per slice reproduces the serial run exactly
+  lion_params_t    params   = parareal_params();
+  lion_parareal_t  parareal = {.n_slices = 4, .coarse_steps = 600, .tolerance = 0.0};
+  lion_sim_state_t serial, parallel;
+  lion_parareal_result_t result;
+  LION_CALL(run_serial(&params, &serial), "Failed running serially");
+  log_set_lock(count_lock, NULL);
+  LION_CALL(run_parareal(&params, &parareal, &parallel, &result), "Failed running in parallel in time");
+  int calls = lock_calls;
+  log_info("Checking the lock of the caller is back");
+  log_set_lock(NULL, NULL);
+  LION_ASSERT(calls > 0);
+  LION_ASSERT_EQI(lock_calls, calls + 1);
+  LION_ASSERT_EQI(lock_depth, 0);
+  LION_ASSERT(result.converged);
+  LION_ASSERT_EQI((int)result.iterations, 4);
+  LION_ASSERT_EQF(parallel._next_soc_nominal, serial._next_soc_nominal);
+  LION_ASSERT_EQF(parallel._next_internal_temperature, serial._next_internal_temperature);
+  LION_ASSERT_EQF(parallel.voltage, serial.voltage);
+  LION_ASSERT_EQF(parallel.soh, serial.soh);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_parareal_events(void) {
+  // Events need the steps in order, so they are rejected
+  lion_sim_config_t   conf     = test_config();
+  lion_params_t       params   = parareal_params();
+  lion_parareal_t     parareal = {.n_slices = SLICES};
+  lion_event_config_t event    = {.field = "voltage", .kind = LION_EVENT_BELOW, .threshold = 3.0, .action = LION_EVENT_STOP};
+  lion_sim_t          sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_events_add(&sim, &event, NULL), "Failed adding event");
+  LION_ASSERT(lion_sim_run_parareal(&sim, &parareal, &power, &amb, NULL) != LION_STATUS_SUCCESS);
+  LION_CALL(lion_sim_events_cleanup(&sim), "Failed cleaning up events");
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_parareal_jump(void) {
+  // Jumps would be cut at the slice boundaries, so they are rejected too
+  lion_sim_config_t conf     = test_config();
+  lion_params_t     params   = parareal_params();
+  lion_parareal_t   parareal = {.n_slices = SLICES};
+  lion_sim_t        sim;
+  conf.sim_jump = LION_JUMP_REST;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_ASSERT(lion_sim_run_parareal(&sim, &parareal, &power, &amb, NULL) != LION_STATUS_SUCCESS);
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  // Discharge pulses with rests in between, under a slowly changing ambient temperature
+  LION_CALL(lion_vector_zero(NULL, PROFILE_LEN, sizeof(double), &power), "Failed creating power");
+  LION_CALL(lion_vector_zero(NULL, PROFILE_LEN, sizeof(double), &amb), "Failed creating ambient temperature");
+  for (size_t i = 0; i < PROFILE_LEN; i++) {
+    double p = ((i / 300) % 3 == 2) ? 0.0 : 4.0 + 2.0 * sin((double)i / 50.0);
+    double a = 298.0 + 3.0 * sin((double)i / 1800.0);
+    LION_CALL(lion_vector_set(NULL, &power, i, &p), "Failed setting power");
+    LION_CALL(lion_vector_set(NULL, &amb, i, &a), "Failed setting ambient temperature");
+  }
+
+  LION_CALL(test_parareal_converged(), "Failed converging the slices");
+  LION_CALL(test_parareal_exact(), "Failed matching the serial run exactly");
+  LION_CALL(test_parareal_events(), "Failed rejecting events");
+  LION_CALL(test_parareal_jump(), "Failed rejecting jumps");
+
+  LION_CALL(lion_vector_cleanup(NULL, &power), "Failed cleaning up power");
+  LION_CALL(lion_vector_cleanup(NULL, &amb), "Failed cleaning up ambient temperature");
+  return TEST_PASS;
+}
@@ -0,0 +1,99 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#define STEPS 300
+#define POWER 8.0
+
+lion_status_t test_rc_without_branches(lion_sim_t *sim) {
+  // Without branches the system keeps the original two states
+  LION_ASSERT_EQI((int)sim->sys.dimension, 2);
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_CALL(lion_sim_step(sim, POWER, 298.0), "Failed stepping simulation");
+  LION_ASSERT_EQF(sim->state.polarization_voltage, 0.0);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_rc_two_branches(lion_sim_t *sim) {
+  lion_params_t params     = *sim->params;
+  params.rc.n_branches     = 2;
+  params.rc.resistance[0]  = 0.01;
+  params.rc.capacitance[0] = 500.0;
+  params.rc.resistance[1]  = 0.02;
+  params.rc.capacitance[1] = 1500.0;
+
+  lion_sim_t rc;
+  LION_CALL(lion_sim_new(sim->conf, &params, &rc), "Failed creating RC simulation");
+  LION_CALL(lion_sim_init(&rc), "Failed initializing RC simulation");
+  LION_ASSERT_EQI((int)rc.sys.dimension, 4);
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(sim, POWER, 298.0), "Failed stepping simulation");
+    LION_CALL(lion_sim_step(&rc, POWER, 298.0), "Failed stepping RC simulation");
+  }
+
+  // Each branch settles to the drop of its resistance, which is taken
+  // from the terminal voltage and adds to the generated heat
+  double current = rc.state.current;
+  log_info("Current = %f A, branch voltages = {%f, %f} V", current, rc.state.rc_voltage[0], rc.state.rc_voltage[1]);
+  LION_ASSERT(fabs(rc.state.rc_voltage[0] - current * params.rc.resistance[0]) < 1e-3 * current * params.rc.resistance[0]);
+  LION_ASSERT(fabs(rc.state.rc_voltage[1] - current * params.rc.resistance[1]) < 1e-2 * current * params.rc.resistance[1]);
+  LION_ASSERT(fabs(rc.state.polarization_voltage - rc.state.rc_voltage[0] - rc.state.rc_voltage[1]) < 1e-12);
+  LION_ASSERT(rc.state.voltage < sim->state.voltage);
+  LION_ASSERT(rc.state.current > sim->state.current);
+  LION_ASSERT(rc.state.generated_heat > sim->state.generated_heat);
+
+  // Branches relax once the cell rests
+  for (size_t i = 1; i < STEPS; i++) {
+    LION_CALL(lion_sim_step(&rc, 0.0, 298.0), "Failed stepping RC simulation at rest");
+  }
+  log_info("Branch voltages at rest = {%f, %f} V", rc.state.rc_voltage[0], rc.state.rc_voltage[1]);
+  LION_ASSERT(fabs(rc.state.rc_voltage[0]) < 1e-6);
+  LION_ASSERT(fabs(rc.state.rc_voltage[1]) < 0.01 * current * params.rc.resistance[1]);
+
+  LION_CALL(lion_sim_cleanup(&rc), "Failed cleaning up RC simulation");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_rc_invalid(lion_sim_t *sim) {
+  lion_params_t params     = *sim->params;
+  params.rc.n_branches     = 1;
+  params.rc.capacitance[0] = 0.0;
+
+  lion_sim_t rc;
+  LION_CALL(lion_sim_new(sim->conf, &params, &rc), "Failed creating RC simulation");
+  LION_ASSERT_FAILS(lion_sim_init(&rc));
+
+  log_debug("Checking packs reject RC branches");
+  params.rc.capacitance[0] = 500.0;
+  lion_sim_t valid;
+  LION_CALL(lion_sim_new(sim->conf, &params, &valid), "Failed creating RC simulation");
+  LION_CALL(lion_sim_init(&valid), "Failed initializing RC simulation");
+  lion_pack_config_t conf = {.n_series = 1, .n_parallel = 1};
+  lion_pack_t        pack;
+  LION_ASSERT_FAILS(lion_pack_new(&valid, &conf, &pack));
+  LION_CALL(lion_sim_cleanup(&valid), "Failed cleaning up RC simulation");
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_rc_without_branches);
+  LION_CALL_TEST(&sim, test_rc_two_branches);
+  LION_CALL_TEST(&sim, test_rc_invalid);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
@@ -0,0 +1,154 @@
+#include "fixture.h"
+
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#ifdef __linux__
+  #include <pthread.h>
+  #include <time.h>
+#endif
+
+#define PERIOD_NS  2000000
+#define INPUTS     100
+#define OUTPUTS    50
+#define TIMEOUT_NS 10000000000LL
+
+lion_status_t test_rt_queue(lion_sim_t *sim) {
+  lion_rt_queue_t queue;
+  LION_CALL(lion_rt_queue_new(sim, 3, sizeof(int), &queue), "Failed creating queue");
+  LION_ASSERT_EQI((int)queue.capacity, 4);
+
+  // Push and pop many more elements than slots so the indices wrap around
+  int next_in  = 0;
+  int next_out = 0;
+  for (int round = 0; round < 100; round++) {
+    while (lion_rt_queue_push(&queue, &next_in)) {
+      next_in++;
+    }
+    LION_ASSERT_EQI((int)lion_rt_queue_size(&queue), 4);
+    int elem;
+    for (int i = 0; i < 3; i++) {
+      LION_ASSERT(lion_rt_queue_pop(&queue, &elem));
+      LION_ASSERT_EQI(elem, next_out);
+      next_out++;
+    }
+  }
+  int elem;
+  LION_ASSERT(lion_rt_queue_pop(&queue, &elem));
+  LION_ASSERT(!lion_rt_queue_pop(&queue, &elem));
+  LION_ASSERT_EQI(elem, next_in - 1);
+
+  LION_CALL(lion_rt_queue_cleanup(sim, &queue), "Failed cleaning up queue");
+  return LION_STATUS_SUCCESS;
+}
+
+#ifdef __linux__
+
+static int bench_stop = 0;
+
+static int64_t now_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// Stand-in for the test bench, which sends inputs at its own pace
+static void *bench(void *udata) {
+  lion_rt_t      *rt    = udata;
+  struct timespec pause = {.tv_sec = 0, .tv_nsec = PERIOD_NS / 2};
+  for (size_t i = 0; i < INPUTS; i++) {
+    lion_rt_input_t in = {.power = 4.0 + 4.0 * (double)(i % 2), .ambient_temperature = 298.0};
+    while (!lion_rt_queue_push(&rt->inputs, &in)) {
+      if (__atomic_load_n(&bench_stop, __ATOMIC_ACQUIRE)) {
+        return NULL;
+      }
+    }
+    nanosleep(&pause, NULL);
+  }
+  return NULL;
+}
+
+lion_status_t test_rt_runner(lion_sim_t *sim) {
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  lion_rt_config_t conf = lion_rt_config_default();
+  conf.period_ns        = PERIOD_NS;
+  conf.max_iter         = 20;
+
+  // The runner caps the iterations on its own copy of the configuration
+  lion_sim_config_t *caller = sim->conf;
+  lion_rt_t          rt;
+  LION_CALL(lion_rt_new(sim, &conf, &rt), "Failed creating runner");
+  LION_CALL(lion_rt_start(&rt), "Failed starting runner");
+  LION_ASSERT_EQI(sim->conf->sim_min_maxiter, 20);
+  LION_ASSERT_EQI(caller->sim_min_maxiter, 100);
+  LION_ASSERT_FAILS(lion_rt_start(&rt));
+
+  pthread_t thread;
+  LION_ASSERT(pthread_create(&thread, NULL, &bench, &rt) == 0);
+
+  // A runner that stops producing outputs fails the test instead of hanging it
+  lion_rt_output_t out;
+  uint64_t         last      = 0;
+  size_t           seen      = 0;
+  int64_t          timeout   = now_ns() + TIMEOUT_NS;
+  int              timed_out = 0;
+  while (seen < OUTPUTS && !timed_out) {
+    if (!lion_rt_queue_pop(&rt.outputs, &out)) {
+      timed_out = now_ns() > timeout;
+      continue;
+    }
+    LION_ASSERT(out.step > last || seen == 0);
+    LION_ASSERT(out.power == 0.0 || out.power == 4.0 || out.power == 8.0);
+    LION_ASSERT(isfinite(out.voltage));
+    LION_ASSERT(out.elapsed_ns >= 0);
+    last = out.step;
+    seen++;
+  }
+  __atomic_store_n(&bench_stop, 1, __ATOMIC_RELEASE);
+  pthread_join(thread, NULL);
+  LION_CALL(lion_rt_stop(&rt), "Failed stopping runner");
+  LION_ASSERT(!timed_out);
+  LION_ASSERT(sim->conf == caller);
+  LION_ASSERT_EQI(sim->conf->sim_min_maxiter, 100);
+
+  lion_rt_stats_t stats = lion_rt_get_stats(&rt);
+  log_info(
+      "Steps = %" PRIu64 ", misses = %" PRIu64 ", stale = %" PRIu64 ", worst step = %" PRId64 " ns",
+      stats.steps,
+      stats.deadline_misses,
+      stats.stale_inputs,
+      stats.max_elapsed_ns
+  );
+  LION_ASSERT(stats.steps >= OUTPUTS);
+  LION_ASSERT(stats.steps == sim->state.step);
+  LION_ASSERT(stats.deadline_misses <= stats.steps);
+  LION_ASSERT(stats.dropped_outputs == 0);
+  LION_ASSERT(stats.max_elapsed_ns > 0);
+
+  LION_CALL(lion_rt_cleanup(&rt), "Failed cleaning up runner");
+  return LION_STATUS_SUCCESS;
+}
+
+#endif
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_rt_queue);
+#ifdef __linux__
+  LION_CALL_TEST(&sim, test_rt_runner);
+#endif
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
@@ -0,0 +1,174 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+#include <time.h>
+
+#define HORIZON    60
+#define CANDIDATES 11
+#define WARMUP     20
+
+static double candidate_power(size_t c, size_t t) {
+  // Constant, ramped and alternating trajectories around a few levels
+  double level = -4.0 + 1.5 * (double)c;
+  switch (c % 3) {
+  case 0:
+    return level;
+  case 1:
+    return level * (double)t / HORIZON;
+  default:
+    return (t % 2 == 0) ? level : -0.5 * level;
+  }
+}
+
+static lion_status_t check_against_steps(lion_sim_t *sim, const double *power, const lion_rollout_result_t *res) {
+  lion_sim_t fork;
+  LION_CALL(lion_sim_fork(sim, &fork), "Failed forking simulation");
+  double min_voltage     = INFINITY;
+  double max_temperature = fork.state._next_internal_temperature;
+  double energy          = 0.0;
+  for (size_t t = 0; t < HORIZON; t++) {
+    LION_CALL(lion_sim_step(&fork, power[t], sim->state.ambient_temperature), "Failed stepping fork");
+    double voltage  = fork.state.open_circuit_voltage - fork.state.polarization_voltage - fork.state.internal_resistance * fork.state.current;
+    min_voltage     = fmin(min_voltage, voltage);
+    max_temperature = fmax(max_temperature, fork.state._next_internal_temperature);
+    energy         += fork.state.current * voltage * sim->conf->sim_step_seconds;
+  }
+  log_debug(
+      "Rollout soc = %f (step %f), temperature = %f (step %f), voltage = %f (step %f)",
+      res->final_soc,
+      fork.state._next_soc_nominal,
+      res->final_temperature,
+      fork.state._next_internal_temperature,
+      res->min_voltage,
+      min_voltage
+  );
+  LION_ASSERT(res->feasible);
+  LION_ASSERT(fabs(res->final_soc - fork.state._next_soc_nominal) < 1e-6);
+  LION_ASSERT(fabs(res->final_temperature - fork.state._next_internal_temperature) < 1e-6);
+  LION_ASSERT(fabs(res->max_temperature - max_temperature) < 1e-6);
+  LION_ASSERT(fabs(res->min_voltage - min_voltage) < 1e-6);
+  LION_ASSERT(fabs(res->energy - energy) < 1e-6 * (1.0 + fabs(energy)));
+  LION_CALL(lion_sim_cleanup(&fork), "Failed cleaning up fork");
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t check_rollout(lion_sim_t *sim) {
+  for (size_t i = 0; i < WARMUP; i++) {
+    LION_CALL(lion_sim_step(sim, 3.0, 298.0), "Failed warming up simulation");
+  }
+  double soc         = sim->state._next_soc_nominal;
+  double temperature = sim->state._next_internal_temperature;
+
+  double                power[CANDIDATES * HORIZON];
+  lion_rollout_result_t res[CANDIDATES];
+  for (size_t c = 0; c < CANDIDATES; c++) {
+    for (size_t t = 0; t < HORIZON; t++) {
+      power[c * HORIZON + t] = candidate_power(c, t);
+    }
+  }
+  LION_CALL(lion_rollout(sim, power, CANDIDATES, HORIZON, res), "Failed rolling out candidates");
+
+  // The simulation is left untouched
+  LION_ASSERT_EQF(sim->state._next_soc_nominal, soc);
+  LION_ASSERT_EQF(sim->state._next_internal_temperature, temperature);
+
+  // Candidates on both sides of a group of lanes match stepping the simulation
+  const size_t checked[] = {0, 4, 7, 8, CANDIDATES - 1};
+  for (size_t i = 0; i < sizeof(checked) / sizeof(checked[0]); i++) {
+    size_t c = checked[i];
+    LION_VCALL(check_against_steps(sim, &power[c * HORIZON], &res[c]), "Rollout of candidate %zu does not match the simulation", c);
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_rollout_matches_steps(lion_sim_t *sim) {
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  return check_rollout(sim);
+}
+
+lion_status_t test_rollout_rc(lion_sim_t *sim) {
+  lion_params_t params     = *sim->params;
+  params.rc.n_branches     = 2;
+  params.rc.resistance[0]  = 0.01;
+  params.rc.capacitance[0] = 500.0;
+  params.rc.resistance[1]  = 0.02;
+  params.rc.capacitance[1] = 1500.0;
+
+  lion_sim_t rc;
+  LION_CALL(lion_sim_new(sim->conf, &params, &rc), "Failed creating RC simulation");
+  LION_CALL(lion_sim_init(&rc), "Failed initializing RC simulation");
+  LION_CALL(check_rollout(&rc), "Rollout with RC branches does not match the simulation");
+  LION_CALL(lion_sim_cleanup(&rc), "Failed cleaning up RC simulation");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_rollout_infeasible(lion_sim_t *sim) {
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  double power[2 * HORIZON];
+  for (size_t t = 0; t < HORIZON; t++) {
+    power[t]           = 2.0;
+    power[HORIZON + t] = (t == HORIZON / 2) ? 1e6 : 2.0;
+  }
+  lion_rollout_result_t res[2];
+  LION_CALL(lion_rollout(sim, power, 2, HORIZON, res), "Failed rolling out candidates");
+  LION_ASSERT(res[0].feasible);
+  LION_ASSERT(!res[1].feasible);
+  LION_ASSERT(res[1].max_current > res[0].max_current);
+
+  log_debug("Checking rollouts require an initialized simulation");
+  lion_sim_t uninit;
+  LION_CALL(lion_sim_new(sim->conf, sim->params, &uninit), "Failed creating simulation");
+  LION_ASSERT_FAILS(lion_rollout(&uninit, power, 2, HORIZON, res));
+  LION_CALL(lion_sim_cleanup(&uninit), "Failed cleaning up simulation");
+
+  log_debug("Checking rollouts reject thermal models they cannot follow");
+  sim->conf->sim_regime = LION_BOTH;
+  LION_ASSERT_FAILS(lion_rollout(sim, power, 2, HORIZON, res));
+  sim->conf->sim_regime        = LION_ONLYSF;
+  sim->conf->sim_thermal_steps = 10;
+  LION_ASSERT_FAILS(lion_rollout(sim, power, 2, HORIZON, res));
+  sim->conf->sim_thermal_steps = 1;
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_rollout_timing(lion_sim_t *sim) {
+  // Typical controller workload, timed for information only
+  enum { n = 256, horizon = 100 };
+  static double                power[n * horizon];
+  static lion_rollout_result_t res[n];
+  for (size_t c = 0; c < n; c++) {
+    for (size_t t = 0; t < horizon; t++) {
+      power[c * horizon + t] = 4.0 * sin((double)(c + t) / 10.0);
+    }
+  }
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  struct timespec start, end;
+  timespec_get(&start, TIME_UTC);
+  LION_CALL(lion_rollout(sim, power, n, horizon, res), "Failed rolling out candidates");
+  timespec_get(&end, TIME_UTC);
+  double elapsed = (double)(end.tv_sec - start.tv_sec) * 1e3 + (double)(end.tv_nsec - start.tv_nsec) / 1e6;
+  log_info("Rolled out %d candidates over %d steps in %f ms", n, horizon, elapsed);
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_rollout_matches_steps);
+  LION_CALL_TEST(&sim, test_rollout_rc);
+  LION_CALL_TEST(&sim, test_rollout_infeasible);
+  LION_CALL_TEST(&sim, test_rollout_timing);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
@@ -0,0 +1,153 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_sim/sim_run.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+
+#define STEPS 200
+
+// Trajectories recorded through the update hook, to check the accumulators against
+static double   recorded_temperature[STEPS];
+static double   recorded_current[STEPS];
+static double   recorded_voltage[STEPS];
+static uint64_t recorded = 0;
+
+static lion_status_t record_hook(lion_sim_t *sim) {
+  if (recorded < STEPS) {
+    recorded_temperature[recorded] = sim->state.internal_temperature;
+    recorded_current[recorded]     = sim->state.current;
+    recorded_voltage[recorded]     = sim->state.voltage;
+    recorded++;
+  }
+  return LION_STATUS_SUCCESS;
+}
+
+static lion_status_t run_profile(lion_sim_t *sim) {
+  // The simulation skips the first sample of the profile
+  lion_vector_t power, amb_temp;
+  LION_CALL(lion_vector_zero(sim, STEPS + 1, sizeof(double), &power), "Failed creating power");
+  LION_CALL(lion_vector_zero(sim, STEPS + 1, sizeof(double), &amb_temp), "Failed creating ambient temperature");
+  for (size_t i = 0; i <= STEPS; i++) {
+    double p = (i < STEPS / 2) ? 6.0 : -3.0;
+    double t = 298.0;
+    LION_CALL(lion_vector_set(sim, &power, i, &p), "Failed setting power");
+    LION_CALL(lion_vector_set(sim, &amb_temp, i, &t), "Failed setting ambient temperature");
+  }
+  recorded = 0;
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_CALL(lion_sim_simulate(sim, &power, &amb_temp), "Failed running simulation");
+  LION_CALL(lion_vector_cleanup(sim, &power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &amb_temp), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_stats_summaries(lion_sim_t *sim) {
+  size_t temperature, current, voltage, hot;
+  LION_CALL(
+      lion_sim_stats_add(sim, &(lion_stat_config_t){.kind = LION_STAT_MOMENTS, .field = "internal_temperature"}, &temperature),
+      "Failed adding temperature accumulator"
+  );
+  LION_CALL(lion_sim_stats_add(sim, &(lion_stat_config_t){.kind = LION_STAT_INTEGRAL, .field = "current"}, &current), "Failed adding current accumulator");
+  LION_CALL(
+      lion_sim_stats_add(sim, &(lion_stat_config_t){.kind = LION_STAT_HISTOGRAM, .field = "voltage", .low = 3.0, .high = 4.5, .n_bins = 15}, &voltage),
+      "Failed adding voltage accumulator"
+  );
+  LION_CALL(
+      lion_sim_stats_add(sim, &(lion_stat_config_t){.kind = LION_STAT_DWELL, .field = "internal_temperature", .low = 298.05}, &hot),
+      "Failed adding dwell accumulator"
+  );
+  sim->update_hook = record_hook;
+  LION_CALL(run_profile(sim), "Failed running profile");
+  sim->update_hook = NULL;
+  LION_ASSERT_EQI(recorded, STEPS);
+
+  double h    = sim->conf->sim_step_seconds;
+  double mean = 0.0, min = INFINITY, max = -INFINITY, charge = 0.0, discharged = 0.0, above = 0.0;
+  for (size_t i = 0; i < STEPS; i++) {
+    mean       += recorded_temperature[i] / STEPS;
+    min         = fmin(min, recorded_temperature[i]);
+    max         = fmax(max, recorded_temperature[i]);
+    charge     += recorded_current[i] * h;
+    discharged += fmax(recorded_current[i], 0.0) * h;
+    above      += (recorded_temperature[i] > 298.05) ? h : 0.0;
+  }
+  double m2 = 0.0;
+  for (size_t i = 0; i < STEPS; i++) {
+    m2 += (recorded_temperature[i] - mean) * (recorded_temperature[i] - mean);
+  }
+
+  const lion_stat_t *s = lion_sim_stat(sim, temperature);
+  LION_ASSERT(s != NULL);
+  LION_ASSERT_EQI(s->count, STEPS);
+  LION_ASSERT(fabs(s->mean - mean) < 1e-9);
+  LION_ASSERT(fabs(lion_stat_variance(s) - m2 / (STEPS - 1)) < 1e-9);
+  LION_ASSERT_EQF(s->min, min);
+  LION_ASSERT_EQF(s->max, max);
+
+  s = lion_sim_stat(sim, current);
+  LION_ASSERT(fabs(s->integral - charge) < 1e-9);
+  LION_ASSERT(fabs(s->positive - discharged) < 1e-9);
+  LION_ASSERT(fabs(s->positive + s->negative - s->integral) < 1e-9);
+
+  s                 = lion_sim_stat(sim, voltage);
+  uint64_t in_range = s->underflow + s->overflow + s->nan;
+  for (size_t b = 0; b < s->n_bins; b++) {
+    in_range += s->bins[b];
+  }
+  LION_ASSERT_EQI(in_range, STEPS);
+
+  s = lion_sim_stat(sim, hot);
+  LION_ASSERT(fabs(s->above - above) < 1e-9);
+  LION_ASSERT(fabs(s->above + s->below - STEPS * h) < 1e-9);
+
+  log_debug("Checking that resetting clears the accumulators");
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_ASSERT_EQI(lion_sim_stat(sim, temperature)->count, 0);
+  LION_ASSERT_EQI(lion_sim_stat(sim, voltage)->underflow + lion_sim_stat(sim, voltage)->bins[0], 0);
+  LION_ASSERT(isnan(lion_stat_variance(lion_sim_stat(sim, temperature))));
+  LION_ASSERT(lion_sim_stat(sim, hot + 1) == NULL);
+
+  log_debug("Checking that NaN falls in no bin of a histogram");
+  double previous    = sim->state.voltage;
+  sim->state.voltage = NAN;
+  lion_sim_stats_update_steps(sim, 3);
+  sim->state.voltage = previous;
+  s                  = lion_sim_stat(sim, voltage);
+  LION_ASSERT_EQI(s->nan, 3);
+  LION_ASSERT_EQI(s->underflow + s->overflow, 0);
+  for (size_t b = 0; b < s->n_bins; b++) {
+    LION_ASSERT_EQI(s->bins[b], 0);
+  }
+
+  LION_CALL(lion_sim_stats_cleanup(sim), "Failed cleaning up accumulators");
+  LION_ASSERT(lion_sim_stat(sim, temperature) == NULL);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_stats_errors(lion_sim_t *sim) {
+  LION_ASSERT_FAILS(lion_sim_stats_add(sim, &(lion_stat_config_t){.kind = LION_STAT_MOMENTS, .field = "temperature"}, NULL));
+  LION_ASSERT_FAILS(lion_sim_stats_add(sim, &(lion_stat_config_t){.kind = LION_STAT_HISTOGRAM, .field = "voltage", .low = 3.0, .high = 4.5}, NULL));
+  LION_ASSERT_FAILS(lion_sim_stats_add(sim, &(lion_stat_config_t){.kind = LION_STAT_HISTOGRAM, .field = "voltage", .low = 4.5, .high = 3.0, .n_bins = 4}, NULL));
+  LION_ASSERT_EQI(sim->n_stats, 0);
+  LION_ASSERT(lion_sim_state_field(&sim->state, "rc_voltage[1]") == &sim->state.rc_voltage[1]);
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_stats_summaries);
+  LION_CALL_TEST(&sim, test_stats_errors);
+
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
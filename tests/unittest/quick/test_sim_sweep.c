@@ -0,0 +1,195 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROFILE_LEN 100
+
+static lion_vector_t power;
+static lion_vector_t amb;
+
+static const lion_sweep_metric_t METRICS[] = {LION_SWEEP_FINAL_SOC, LION_SWEEP_MAX_TEMPERATURE, LION_SWEEP_MIN_VOLTAGE};
+
+lion_status_t test_sweep_grid(lion_sim_t *sim) {
+  lion_sweep_axis_t axes[] = {
+    {.name = "temp.cp", .low = 50.0, .high = 150.0, .num = 3},
+    {.name = "sim_step_seconds", .low = 1.0, .high = 2.0, .num = 2},
+  };
+  lion_sweep_t sweep = {
+    .method    = LION_SWEEP_GRID,
+    .axes      = axes,
+    .n_axes    = 2,
+    .metrics   = METRICS,
+    .n_metrics = 3,
+  };
+  LION_ASSERT_EQI((int)lion_sweep_variants(&sweep), 6);
+
+  lion_vector_t results;
+  LION_CALL(lion_sweep_run(sim, &sweep, &power, &amb, &results), "Failed running sweep");
+  LION_ASSERT_EQI((int)results.len, 6 * 5);
+
+  double *table = results.data;
+  LION_ASSERT_EQF(table[0 * 5 + 0], 50.0);
+  LION_ASSERT_EQF(table[0 * 5 + 1], 1.0);
+  LION_ASSERT_EQF(table[1 * 5 + 1], 2.0);
+  LION_ASSERT_EQF(table[2 * 5 + 0], 100.0);
+  LION_ASSERT_EQF(table[5 * 5 + 0], 150.0);
+
+  log_debug("Comparing a variant against a standalone simulation");
+  lion_sim_config_t conf   = *sim->conf;
+  lion_params_t     params = *sim->params;
+  conf.sim_step_seconds    = 2.0;
+  params.temp.cp           = 100.0;
+  lion_sim_t single;
+  LION_CALL(lion_sim_new(&conf, &params, &single), "Failed creating standalone sim");
+  LION_CALL(lion_sim_init(&single), "Failed initializing standalone sim");
+  for (size_t i = 1; i < PROFILE_LEN; i++) {
+    LION_CALL(lion_sim_step(&single, lion_vector_get_d(NULL, &power, i), lion_vector_get_d(NULL, &amb, i)), "Failed stepping");
+  }
+  LION_ASSERT_EQF(table[3 * 5 + 2], single.state._next_soc_nominal);
+  LION_CALL(lion_sim_cleanup(&single), "Failed cleaning up standalone sim");
+
+  LION_CALL(lion_vector_cleanup(sim, &results), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_sweep_lhs(lion_sim_t *sim) {
+  lion_sweep_axis_t axes[] = {
+    {.name = "temp.rin", .low = 1.0, .high = 3.0},
+    {.name = "ocv.v0", .low = 4.0, .high = 4.2},
+  };
+  lion_sweep_t sweep = {
+    .method    = LION_SWEEP_LHS,
+    .axes      = axes,
+    .n_axes    = 2,
+    .n_samples = 8,
+    .seed      = 42,
+    .metrics   = METRICS,
+    .n_metrics = 3,
+    .n_threads = 2,
+  };
+
+  lion_vector_t results;
+  LION_CALL(lion_sweep_run(sim, &sweep, &power, &amb, &results), "Failed running sweep");
+
+  // Every stratum of every axis must be sampled exactly once
+  double *table = results.data;
+  for (size_t a = 0; a < 2; a++) {
+    int seen[8] = {0};
+    for (size_t k = 0; k < 8; k++) {
+      double u = (table[k * 5 + a] - axes[a].low) / (axes[a].high - axes[a].low);
+      seen[(int)(u * 8.0)]++;
+      LION_ASSERT_FALSE(isnan(table[k * 5 + 2]));
+    }
+    for (size_t s = 0; s < 8; s++) {
+      LION_ASSERT_EQI(seen[s], 1);
+    }
+  }
+
+  lion_sweep_axis_t bad = {.name = "temp.unknown", .low = 0.0, .high = 1.0, .num = 2};
+  sweep.axes            = &bad;
+  sweep.n_axes          = 1;
+  LION_ASSERT_FAILS(lion_sweep_run(sim, &sweep, &power, &amb, &results));
+
+  LION_CALL(lion_vector_cleanup(sim, &results), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_sweep_multirate(void) {
+  // The thermal decay of the variants follows their own heat capacity
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = lion_params_default();
+  conf.sim_thermal_steps   = 10;
+  lion_sim_t base;
+  LION_CALL(lion_sim_new(&conf, &params, &base), "Failed creating base sim");
+  LION_CALL(lion_sim_init(&base), "Failed initializing base sim");
+
+  lion_sweep_axis_t         axis   = {.name = "temp.cp", .low = 50.0, .high = 150.0, .num = 3};
+  lion_sweep_metric_t       metric = LION_SWEEP_FINAL_TEMPERATURE;
+  lion_sweep_t              sweep  = {.method = LION_SWEEP_GRID, .axes = &axis, .n_axes = 1, .metrics = &metric, .n_metrics = 1};
+  lion_vector_t             results;
+  LION_CALL(lion_sweep_run(&base, &sweep, &power, &amb, &results), "Failed running sweep");
+  double *table = results.data;
+  LION_ASSERT(table[0 * 2 + 1] != table[2 * 2 + 1]);
+
+  params.temp.cp = 50.0;
+  lion_sim_t single;
+  LION_CALL(lion_sim_new(&conf, &params, &single), "Failed creating standalone sim");
+  LION_CALL(lion_sim_init(&single), "Failed initializing standalone sim");
+  for (size_t i = 1; i < PROFILE_LEN; i++) {
+    LION_CALL(lion_sim_step(&single, lion_vector_get_d(NULL, &power, i), lion_vector_get_d(NULL, &amb, i)), "Failed stepping");
+  }
+  LION_ASSERT_EQF(table[0 * 2 + 1], single.state._next_internal_temperature);
+  LION_CALL(lion_sim_cleanup(&single), "Failed cleaning up standalone sim");
+
+  LION_CALL(lion_vector_cleanup(&base, &results), "Failed to clean up");
+  LION_CALL(lion_sim_cleanup(&base), "Failed cleaning up base sim");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_sweep_events(lion_sim_t *sim) {
+  // A stop event ends the variant where it ends lion_sim_run
+  lion_event_config_t event  = {.field = "soc_nominal", .kind = LION_EVENT_BELOW, .threshold = 0.5, .action = LION_EVENT_STOP};
+  lion_sweep_axis_t   axis   = {.name = "temp.cp", .low = 100.0, .high = 100.0, .num = 1};
+  lion_sweep_metric_t metric = LION_SWEEP_FINAL_SOC;
+  lion_sweep_t        sweep  = {.method = LION_SWEEP_GRID, .axes = &axis, .n_axes = 1, .metrics = &metric, .n_metrics = 1};
+  lion_vector_t       results;
+  LION_CALL(lion_sim_events_add(sim, &event, NULL), "Failed adding event");
+  LION_CALL(lion_sweep_run(sim, &sweep, &power, &amb, &results), "Failed running sweep");
+  LION_CALL(lion_sim_events_cleanup(sim), "Failed cleaning up events");
+
+  lion_sim_config_t conf   = *sim->conf;
+  lion_params_t     params = *sim->params;
+  params.temp.cp           = 100.0;
+  lion_sim_t single;
+  LION_CALL(lion_sim_new(&conf, &params, &single), "Failed creating standalone sim");
+  LION_CALL(lion_sim_events_add(&single, &event, NULL), "Failed adding event");
+  LION_CALL(lion_sim_run(&single, &power, &amb), "Failed running standalone sim");
+  LION_ASSERT_EQI(lion_sim_should_close(&single), LION_CLOSE_EVENT);
+  LION_ASSERT(single.state.step < PROFILE_LEN - 1);
+  LION_ASSERT_EQF(((double *)results.data)[1], single.state._next_soc_nominal);
+  LION_CALL(lion_sim_events_cleanup(&single), "Failed cleaning up events");
+  LION_CALL(lion_sim_cleanup(&single), "Failed cleaning up standalone sim");
+  LION_CALL(lion_vector_cleanup(sim, &results), "Failed to clean up");
+
+  log_debug("Checking jumps are rejected");
+  lion_sim_config_t jump = *sim->conf;
+  jump.sim_jump          = LION_JUMP_CONSTANT;
+  lion_sim_config_t *own = sim->conf;
+  sim->conf              = &jump;
+  lion_status_t status   = lion_sweep_run(sim, &sweep, &power, &amb, &results);
+  sim->conf              = own;
+  LION_ASSERT(status != LION_STATUS_SUCCESS);
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = lion_params_default();
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL(lion_vector_zero(NULL, PROFILE_LEN, sizeof(double), &power), "Failed creating power");
+  LION_CALL(lion_vector_zero(NULL, PROFILE_LEN, sizeof(double), &amb), "Failed creating ambient temperature");
+  for (size_t i = 0; i < PROFILE_LEN; i++) {
+    ((double *)power.data)[i] = 5.0 + (double)(i % 10);
+    ((double *)amb.data)[i]   = 298.0;
+  }
+
+  LION_CALL_TEST(&sim, test_sweep_grid);
+  LION_CALL_TEST(&sim, test_sweep_lhs);
+  LION_CALL(test_sweep_multirate(), "Failed sweeping with multirate thermal steps");
+  LION_CALL_TEST(&sim, test_sweep_events);
+
+  LION_CALL(lion_vector_cleanup(NULL, &power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(NULL, &amb), "Failed to clean up");
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
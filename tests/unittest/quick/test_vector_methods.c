@@ -2,6 +2,7 @@
 #include <lion_utils/test.h>
 #include <lionu/log.h>
 #include <lionu/macros.h>
+#include <math.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -77,8 +78,68 @@ lion_status_t test_methods_set(lion_sim_t *sim) {
   return LION_STATUS_SUCCESS;
 }
 
+static double square(double x, void *ctx) { return x * x; }
+
+lion_status_t test_methods_views(lion_sim_t *sim) {
+  lion_vector_t vec;
+  LION_CALL(lion_vector_linspace_d(sim, 1.0, 10.0, 10, &vec), "Failed creating vector");
+
+  log_debug("Checking that views share the storage of the vector");
+  lion_vector_view_d_t all, tail;
+  LION_CALL(lion_vector_view_d(sim, &vec, &all), "Failed viewing vector");
+  LION_ASSERT_EQI(all.len, 10);
+  LION_CALL(lion_vector_slice_d(sim, &vec, 7, 3, &tail), "Failed slicing vector");
+  LION_ASSERT_EQI(tail.len, 3);
+  tail.data[0] = -8.0;
+  LION_ASSERT_EQF(lion_vector_get_d(sim, &vec, 7), -8.0);
+  tail.data[0] = 8.0;
+
+  log_debug("Checking reductions");
+  double dot;
+  LION_ASSERT_EQF(lion_vector_sum_d(sim, all), 55.0);
+  LION_ASSERT_EQF(lion_vector_sum_d(sim, tail), 27.0);
+  LION_ASSERT_EQF(lion_vector_min_d(sim, tail), 8.0);
+  LION_ASSERT_EQF(lion_vector_max_d(sim, all), 10.0);
+  LION_CALL(lion_vector_dot_d(sim, all, all, &dot), "Failed computing dot product");
+  LION_ASSERT_EQF(dot, 385.0);
+
+  log_debug("Checking element-wise operations");
+  lion_vector_view_d_t head;
+  LION_CALL(lion_vector_slice_d(sim, &vec, 0, 3, &head), "Failed slicing vector");
+  LION_CALL(lion_vector_axpy_d(sim, 2.0, head, tail), "Failed computing axpy");
+  LION_ASSERT_EQF(tail.data[0], 10.0);
+  LION_ASSERT_EQF(tail.data[2], 16.0);
+  LION_CALL(lion_vector_map_d(sim, &square, NULL, head, head), "Failed mapping");
+  LION_ASSERT_EQF(head.data[2], 9.0);
+  lion_vector_scale_d(sim, head, 0.5);
+  LION_ASSERT_EQF(head.data[1], 2.0);
+  lion_vector_fill_d(sim, all, 1.5);
+  LION_ASSERT_EQF(lion_vector_sum_d(sim, all), 15.0);
+
+  log_debug("Checking border scenarios");
+  lion_vector_view_d_t empty;
+  LION_CALL(lion_vector_slice_d(sim, &vec, 10, 0, &empty), "Failed slicing at the end");
+  LION_ASSERT_EQF(lion_vector_sum_d(sim, empty), 0.0);
+  LION_ASSERT(isnan(lion_vector_min_d(sim, empty)));
+  LION_ASSERT_FAILS(lion_vector_slice_d(sim, &vec, 8, 3, &empty));
+  LION_ASSERT_FAILS(lion_vector_axpy_d(sim, 1.0, head, all));
+  LION_ASSERT_FAILS(lion_vector_dot_d(sim, head, all, &dot));
+
+  lion_vector_t        floats;
+  lion_vector_view_f_t fview;
+  LION_CALL(lion_vector_linspace_f(sim, 0.0f, 1.0f, 5, &floats), "Failed creating float vector");
+  LION_ASSERT_FAILS(lion_vector_view_d(sim, &floats, &all));
+  LION_CALL(lion_vector_view_f(sim, &floats, &fview), "Failed viewing float vector");
+  LION_ASSERT_EQF(fview.data[4], 1.0f);
+
+  LION_CALL(lion_vector_cleanup(sim, &floats), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &vec), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
 int main(void) {
   LION_CALL_TEST(NULL, test_methods_get);
   LION_CALL_TEST(NULL, test_methods_set);
+  LION_CALL_TEST(NULL, test_methods_views);
   return TEST_PASS;
 }
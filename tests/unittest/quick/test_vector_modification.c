@@ -76,13 +76,13 @@ lion_status_t test_modification_extend_array(lion_sim_t *sim) {
 
   log_debug("Checking that the dimensions changed properly");
   LION_ASSERT_EQI(vec.len, 11);
-  LION_ASSERT_EQI(vec.capacity, 11);
+  LION_ASSERT_EQI(vec.capacity, 16);
 
   log_debug("Checking border scenario");
   LION_ASSERT_FAILS(lion_vector_extend_array(sim, &vec, NULL, 10010));
   log_debug("Checking that the failed extend does not modify the vector");
   LION_ASSERT_EQI(vec.len, 11);
-  LION_ASSERT_EQI(vec.capacity, 11);
+  LION_ASSERT_EQI(vec.capacity, 16);
 
   log_debug("Checking that the extend hsimened fine");
   uint32_t contained_val;
@@ -102,9 +102,53 @@ lion_status_t test_modification_extend_array(lion_sim_t *sim) {
   return LION_STATUS_SUCCESS;
 }
 
+lion_status_t test_modification_reserve(lion_sim_t *sim) {
+  lion_vector_t vec;
+  LION_CALL(lion_vector_new(sim, sizeof(double), &vec), "Failed creating vector");
+
+  log_debug("Checking that pushes grow the capacity geometrically");
+  size_t reallocations = 0;
+  size_t last_capacity = vec.capacity;
+  for (int i = 0; i < 1000; i++) {
+    LION_VCALL(lion_vector_push_d(sim, &vec, (double)i), "Failed pushing %d-th element", i);
+    if (vec.capacity != last_capacity) {
+      reallocations++;
+      last_capacity = vec.capacity;
+    }
+  }
+  LION_ASSERT_EQI(vec.len, 1000);
+  LION_ASSERT(reallocations <= 11);
+
+  log_debug("Checking that a large reservation is served at once");
+  LION_CALL(lion_vector_reserve(sim, &vec, 5000), "Failed reserving");
+  LION_ASSERT_EQI(vec.capacity, 6000);
+  LION_ASSERT_EQI(vec.len, 1000);
+  LION_CALL(lion_vector_reserve(sim, &vec, 10), "Failed reserving");
+  LION_ASSERT_EQI(vec.capacity, 6000);
+
+  log_debug("Checking that shrinking keeps the elements");
+  LION_CALL(lion_vector_shrink_to_fit(sim, &vec), "Failed shrinking");
+  LION_ASSERT_EQI(vec.capacity, 1000);
+  LION_ASSERT_EQF(lion_vector_get_d(sim, &vec, 999), 999.0);
+
+  log_debug("Checking that resizing below the length truncates");
+  LION_CALL(lion_vector_resize(sim, &vec, 10), "Failed resizing");
+  LION_ASSERT_EQI(vec.len, 10);
+  LION_ASSERT_EQF(lion_vector_get_d(sim, &vec, 9), 9.0);
+  LION_CALL(lion_vector_resize(sim, &vec, 0), "Failed resizing to zero");
+  LION_ASSERT_EQI(vec.len, 0);
+  LION_ASSERT(vec.data == NULL);
+  LION_CALL(lion_vector_push_d(sim, &vec, 1.0), "Failed pushing after releasing");
+  LION_ASSERT_EQI(vec.capacity, 1);
+
+  LION_CALL(lion_vector_cleanup(sim, &vec), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
 int main(void) {
   LION_CALL_TEST(NULL, test_modification_push1);
   LION_CALL_TEST(NULL, test_modification_push2);
   LION_CALL_TEST(NULL, test_modification_extend_array);
+  LION_CALL_TEST(NULL, test_modification_reserve);
   return TEST_PASS;
 }
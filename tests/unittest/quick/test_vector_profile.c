@@ -0,0 +1,154 @@
+#include "fixture.h"
+
+#include <lion/lion.h>
+#include <lion_sim/sim_run.h>
+#include <lion_utils/test.h>
+#include <lionu/log.h>
+#include <lionu/macros.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CSV_FILENAME LION_PROJECT_ROOT_DIR "tests/unittest/quick/resources/profile1.csv"
+#define PROFILE      "test_vector_profile.bin"
+#define SAMPLES      10
+
+static const double power[SAMPLES]    = {0.0, 2.5, 2.5, -1.25, 4.0, 4.0, 0.5, -3.0, -3.0, 1.0};
+static const double amb_temp[SAMPLES] = {298.0, 298.0, 298.1, 298.2, 298.2, 298.3, 298.3, 298.4, 298.4, 298.5};
+
+lion_status_t test_profile_info(lion_sim_t *sim) {
+  LION_CALL(lion_profile_from_csv(sim, CSV_FILENAME, PROFILE, 1.0, LION_PROFILE_F64), "Failed converting CSV file");
+
+  lion_profile_info_t info;
+  LION_CALL(lion_profile_read_info(sim, PROFILE, &info), "Failed reading profile");
+  LION_ASSERT_EQI(info.count, SAMPLES);
+  LION_ASSERT_EQI(info.n_columns, 3);
+  LION_ASSERT_EQI(info.dtype, LION_PROFILE_F64);
+  LION_ASSERT_EQF(info.sample_period, 1.0);
+  LION_ASSERT(strcmp(info.columns[1].name, "power") == 0);
+  LION_ASSERT(strcmp(info.columns[1].unit, "W") == 0);
+  LION_ASSERT(strcmp(info.columns[2].name, "ambient_temperature") == 0);
+  LION_ASSERT(strcmp(info.columns[2].unit, "K") == 0);
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_profile_map(lion_sim_t *sim) {
+  LION_CALL(lion_profile_from_csv(sim, CSV_FILENAME, PROFILE, 1.0, LION_PROFILE_F64), "Failed converting CSV file");
+
+  lion_vector_t mapped_power, mapped_amb_temp;
+  LION_CALL(lion_vector_map_file(sim, PROFILE, "power", &mapped_power), "Failed mapping power");
+  LION_CALL(lion_vector_map_file(sim, PROFILE, "ambient_temperature", &mapped_amb_temp), "Failed mapping ambient temperature");
+  LION_ASSERT_EQI(mapped_power.len, SAMPLES);
+  LION_ASSERT_EQI(mapped_power.data_size, sizeof(double));
+  LION_ASSERT_EQI((uintptr_t)mapped_power.data % LION_PROFILE_ALIGNMENT, 0);
+  for (size_t i = 0; i < SAMPLES; i++) {
+    LION_ASSERT_EQF(lion_vector_get_d(sim, &mapped_power, i), power[i]);
+    LION_ASSERT_EQF(lion_vector_get_d(sim, &mapped_amb_temp, i), amb_temp[i]);
+  }
+
+  log_debug("Checking that mapped inputs drive a simulation like copied ones");
+  lion_vector_t copied_power, copied_amb_temp;
+  LION_CALL(lion_vector_from_array(sim, power, SAMPLES, sizeof(double), &copied_power), "Failed creating power");
+  LION_CALL(lion_vector_from_array(sim, amb_temp, SAMPLES, sizeof(double), &copied_amb_temp), "Failed creating ambient temperature");
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_CALL(lion_sim_simulate(sim, &copied_power, &copied_amb_temp), "Failed running with copied inputs");
+  double soc = sim->state.soc_nominal;
+  LION_CALL(lion_sim_reset(sim), "Failed resetting simulation");
+  LION_CALL(lion_sim_simulate(sim, &mapped_power, &mapped_amb_temp), "Failed running with mapped inputs");
+  LION_ASSERT_EQF(sim->state.soc_nominal, soc);
+
+  log_debug("Checking that mapped vectors cannot be modified or cleaned up");
+  double value = 1.0;
+  LION_ASSERT(mapped_power.mapped);
+  LION_ASSERT(!copied_power.mapped);
+  LION_ASSERT_FAILS(lion_vector_set(sim, &mapped_power, 0, &value));
+  LION_ASSERT_FAILS(lion_vector_push_d(sim, &mapped_power, value));
+  LION_ASSERT_FAILS(lion_vector_resize(sim, &mapped_power, 2 * SAMPLES));
+  LION_ASSERT_FAILS(lion_vector_cleanup(sim, &mapped_power));
+  LION_ASSERT_EQI(mapped_power.len, SAMPLES);
+
+  LION_CALL(lion_vector_unmap(sim, &mapped_power), "Failed unmapping power");
+  LION_CALL(lion_vector_unmap(sim, &mapped_amb_temp), "Failed unmapping ambient temperature");
+  LION_ASSERT(mapped_power.data == NULL);
+  LION_ASSERT(!mapped_power.mapped);
+  LION_CALL(lion_vector_cleanup(sim, &copied_power), "Failed to clean up");
+  LION_CALL(lion_vector_cleanup(sim, &copied_amb_temp), "Failed to clean up");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_profile_f32(lion_sim_t *sim) {
+  LION_CALL(lion_profile_from_csv(sim, CSV_FILENAME, PROFILE, 0.5, LION_PROFILE_F32), "Failed converting CSV file");
+
+  lion_vector_t        vec;
+  lion_vector_view_f_t view;
+  LION_CALL(lion_vector_map_file(sim, PROFILE, "ambient_temperature", &vec), "Failed mapping ambient temperature");
+  LION_ASSERT_EQI(vec.data_size, sizeof(float));
+  LION_CALL(lion_vector_view_f(sim, &vec, &view), "Failed viewing mapped column");
+  for (size_t i = 0; i < SAMPLES; i++) {
+    LION_ASSERT_EQF(view.data[i], (float)amb_temp[i]);
+  }
+  LION_CALL(lion_vector_unmap(sim, &vec), "Failed unmapping");
+  return LION_STATUS_SUCCESS;
+}
+
+lion_status_t test_profile_errors(lion_sim_t *sim) {
+  lion_vector_t       vec;
+  lion_profile_info_t info;
+  LION_CALL(lion_profile_from_csv(sim, CSV_FILENAME, PROFILE, 1.0, LION_PROFILE_F64), "Failed converting CSV file");
+  LION_ASSERT_FAILS(lion_vector_map_file(sim, PROFILE, "current", &vec));
+  LION_ASSERT_FAILS(lion_vector_map_file(sim, CSV_FILENAME, "power", &vec));
+  LION_ASSERT_FAILS(lion_profile_read_info(sim, "does_not_exist.bin", &info));
+
+  log_debug("Checking that malformed CSV files are rejected");
+  const char *bad = "test_vector_profile_bad.csv";
+  FILE       *f   = fopen(bad, "w");
+  LION_ASSERT(f != NULL);
+  fputs("power,ambient_temperature\n1.0,298.0\n2.0\n", f);
+  fclose(f);
+  LION_ASSERT_FAILS(lion_profile_from_csv(sim, bad, PROFILE, 1.0, LION_PROFILE_F64));
+  remove(bad);
+
+  log_debug("Checking that truncated profiles are rejected");
+  LION_CALL(lion_profile_from_csv(sim, CSV_FILENAME, PROFILE, 1.0, LION_PROFILE_F64), "Failed converting CSV file");
+  char buffer[1024];
+  f = fopen(PROFILE, "rb");
+  LION_ASSERT(f != NULL);
+  size_t read = fread(buffer, 1, sizeof(buffer), f);
+  fclose(f);
+  LION_ASSERT(read > 16 && read < sizeof(buffer));
+  f = fopen(PROFILE, "wb");
+  fwrite(buffer, 1, read - 16, f);
+  fclose(f);
+  LION_ASSERT_FAILS(lion_vector_map_file(sim, PROFILE, "ambient_temperature", &vec));
+
+  log_debug("Checking that a count overflowing the size of a column is rejected");
+  // The count follows the magic and the version and type of the samples, and
+  // times eight it wraps around to a single sample
+  uint64_t count = (UINT64_C(1) << 61) + 1;
+  memcpy(buffer + 16, &count, sizeof(count));
+  f = fopen(PROFILE, "wb");
+  fwrite(buffer, 1, read, f);
+  fclose(f);
+  LION_ASSERT_FAILS(lion_vector_map_file(sim, PROFILE, "power", &vec));
+  return LION_STATUS_SUCCESS;
+}
+
+int main(void) {
+  lion_sim_config_t conf   = test_config();
+  lion_params_t     params = test_params(0.9);
+
+  lion_sim_t sim;
+  LION_CALL(lion_sim_new(&conf, &params, &sim), "Failed creating sim for test");
+  LION_CALL(lion_sim_init(&sim), "Failed initializing sim for test");
+
+  LION_CALL_TEST(&sim, test_profile_info);
+  LION_CALL_TEST(&sim, test_profile_map);
+  LION_CALL_TEST(&sim, test_profile_f32);
+  LION_CALL_TEST(&sim, test_profile_errors);
+
+  remove(PROFILE);
+  LION_CALL(lion_sim_cleanup(&sim), "Failed cleaning up sim");
+  return TEST_PASS;
+}
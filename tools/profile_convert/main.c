@@ -0,0 +1,79 @@
+#include <inttypes.h>
+#include <lion/lion.h>
+#include <lionu/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *program) {
+  fprintf(stderr, "Usage: %s [-p PERIOD] [-t f64|f32] INPUT.csv OUTPUT\n", program);
+  fprintf(stderr, "       %s -i PROFILE\n\n", program);
+  fprintf(stderr, "Converts a CSV file into a binary profile that can be mapped with lion_vector_map_file.\n");
+  fprintf(stderr, "  -p PERIOD  Time between samples in seconds (default 1)\n");
+  fprintf(stderr, "  -t TYPE    Type of the samples, f64 or f32 (default f64)\n");
+  fprintf(stderr, "  -i         Print the description of an existing profile\n");
+}
+
+static int print_info(const char *filename) {
+  lion_profile_info_t info;
+  if (lion_profile_read_info(NULL, filename, &info) != LION_STATUS_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  printf("%s\n", filename);
+  printf("  samples : %" PRIu64 " (%s)\n", info.count, (info.dtype == LION_PROFILE_F32) ? "f32" : "f64");
+  printf("  period  : %g s\n", info.sample_period);
+  for (uint32_t c = 0; c < info.n_columns; c++) {
+    printf("  column  : %s [%s]\n", info.columns[c].name, info.columns[c].unit);
+  }
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+  log_set_level(LOG_WARN);
+
+  double               period = 1.0;
+  lion_profile_dtype_t dtype  = LION_PROFILE_F64;
+  const char          *paths[2];
+  int                  n_paths = 0;
+  int                  info    = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-i") == 0) {
+      info = 1;
+    } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      char *end;
+      period = strtod(argv[++i], &end);
+      if (*end != '\0' || period <= 0.0) {
+        fprintf(stderr, "Invalid sample period '%s'\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], "f64") == 0) {
+        dtype = LION_PROFILE_F64;
+      } else if (strcmp(argv[i], "f32") == 0) {
+        dtype = LION_PROFILE_F32;
+      } else {
+        fprintf(stderr, "Invalid sample type '%s'\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    } else if (argv[i][0] != '-' && n_paths < 2) {
+      paths[n_paths++] = argv[i];
+    } else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (info && n_paths == 1) {
+    return print_info(paths[0]);
+  }
+  if (info || n_paths != 2) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (lion_profile_from_csv(NULL, paths[0], paths[1], period, dtype) != LION_STATUS_SUCCESS) {
+    fprintf(stderr, "Failed converting '%s'\n", paths[0]);
+    return EXIT_FAILURE;
+  }
+  return print_info(paths[1]);
+}